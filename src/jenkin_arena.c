@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "jenkin_arena.h"
+
+//----------------------------------------------------------------------------
+// Round size up to alignment of objects
+//----------------------------------------------------------------------------
+static size_t alignSize(size_t size)
+{
+   return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+//----------------------------------------------------------------------------
+// Hash of string for intern table (FNV-1a)
+//----------------------------------------------------------------------------
+static unsigned int hashString(const char* str)
+{
+   unsigned int hash = 2166136261u;
+   for (; *str; str++)
+   {
+      hash = (hash ^ (unsigned char)*str) * 16777619u;
+   }
+   return hash;
+}
+
+//----------------------------------------------------------------------------
+// Create arena whose zones can hold objectBytes of objects and stringBytes
+// of strings without any more allocation. Intern table is sized for
+// stringCount strings, it is freed by arenaSeal().
+// return NULL if memory can not be allocated
+//----------------------------------------------------------------------------
+ArenaT* arenaCreate(size_t objectBytes, size_t stringBytes, unsigned int stringCount)
+{
+   unsigned int internSize = 16;
+   while (internSize < stringCount * 2)
+   {
+      internSize *= 2;
+   }
+   size_t headerBytes = alignSize(sizeof(ArenaT));
+   objectBytes = alignSize(objectBytes);
+   char* p_block = malloc(headerBytes + objectBytes + stringBytes);
+   const char** pp_interned = calloc(internSize, sizeof(const char*));
+   if (!p_block || !pp_interned)
+   {
+      printf("Can not allocate arena of %zu bytes\n", headerBytes + objectBytes + stringBytes);
+      free(p_block);
+      free(pp_interned);
+      return NULL;
+   }
+
+   ArenaT* p_arena = (ArenaT*)p_block;
+   memset(p_arena, 0, sizeof(ArenaT));
+   p_arena->pp_interned = pp_interned;
+   p_arena->internSize = internSize;
+   p_arena->objects.p_cur = p_block + headerBytes;
+   p_arena->objects.p_end = p_arena->objects.p_cur + objectBytes;
+   p_arena->strings.p_cur = p_arena->objects.p_end;
+   p_arena->strings.p_end = p_arena->strings.p_cur + stringBytes;
+   p_arena->refCount = 1;
+   return p_arena;
+}
+
+//----------------------------------------------------------------------------
+// Take size bytes from zone, a chunk is added to arena if zone is full
+// return NULL if memory can not be allocated
+//----------------------------------------------------------------------------
+static void* zoneTake(ArenaT* p_arena, ArenaZoneT* p_zone, size_t size)
+{
+   if ((size_t)(p_zone->p_end - p_zone->p_cur) < size)
+   {
+      size_t chunkBytes = alignSize(sizeof(ArenaChunkT)) + size;
+      if (chunkBytes < ARENA_CHUNK_SIZE)
+      {
+         chunkBytes = ARENA_CHUNK_SIZE;
+      }
+      ArenaChunkT* p_chunk = malloc(chunkBytes);
+      if (!p_chunk)
+      {
+         printf("Can not allocate arena chunk of %zu bytes\n", chunkBytes);
+         return NULL;
+      }
+      p_chunk->p_next = p_arena->p_chunks;
+      p_arena->p_chunks = p_chunk;
+      p_zone->p_cur = (char*)p_chunk + alignSize(sizeof(ArenaChunkT));
+      p_zone->p_end = (char*)p_chunk + chunkBytes;
+   }
+   void* p_mem = p_zone->p_cur;
+   p_zone->p_cur += size;
+   return p_mem;
+}
+
+//----------------------------------------------------------------------------
+// Allocate zeroed object from object zone
+// return NULL if memory can not be allocated
+//----------------------------------------------------------------------------
+void* arenaAlloc(ArenaT* p_arena, size_t size)
+{
+   void* p_mem = zoneTake(p_arena, &p_arena->objects, alignSize(size));
+   if (p_mem)
+   {
+      memset(p_mem, 0, size);
+   }
+   return p_mem;
+}
+
+//----------------------------------------------------------------------------
+// Copy string to string zone, string which is already in intern table is
+// not copied again
+// return NULL if str is NULL or memory can not be allocated
+//----------------------------------------------------------------------------
+char* arenaIntern(ArenaT* p_arena, const char* str)
+{
+   if (!str)
+   {
+      return NULL;
+   }
+
+   unsigned int slot = 0;
+   unsigned int mask = p_arena->internSize - 1;
+   if (p_arena->pp_interned)
+   {
+      for (slot = hashString(str) & mask; p_arena->pp_interned[slot];
+           slot = (slot + 1) & mask)
+      {
+         if (!strcmp(p_arena->pp_interned[slot], str))
+         {
+            return (char*)p_arena->pp_interned[slot];
+         }
+      }
+   }
+
+   size_t len = strlen(str) + 1;
+   char* p_str = zoneTake(p_arena, &p_arena->strings, len);
+   if (!p_str)
+   {
+      return NULL;
+   }
+   memcpy(p_str, str, len);
+
+   // Table is kept at most half full, other strings are only copied
+   if (p_arena->pp_interned && (p_arena->internCount * 2 < p_arena->internSize))
+   {
+      p_arena->pp_interned[slot] = p_str;
+      p_arena->internCount++;
+   }
+   return p_str;
+}
+
+//----------------------------------------------------------------------------
+// Finish building arena: strings which are added later are only copied
+//----------------------------------------------------------------------------
+void arenaSeal(ArenaT* p_arena)
+{
+   free(p_arena->pp_interned);
+   p_arena->pp_interned = NULL;
+   p_arena->internSize = 0;
+   p_arena->internCount = 0;
+}
+
+//----------------------------------------------------------------------------
+// Add reference of an object which lives in arena
+//----------------------------------------------------------------------------
+void arenaRef(ArenaT* p_arena)
+{
+   p_arena->refCount++;
+}
+
+//----------------------------------------------------------------------------
+// Drop reference, arena and all its chunks are freed with the last one
+//----------------------------------------------------------------------------
+void arenaUnref(ArenaT* p_arena)
+{
+   if (!p_arena || (--p_arena->refCount > 0))
+   {
+      return;
+   }
+   ArenaChunkT* p_chunk = p_arena->p_chunks;
+   while (p_chunk)
+   {
+      ArenaChunkT* p_next = p_chunk->p_next;
+      free(p_chunk);
+      p_chunk = p_next;
+   }
+   free(p_arena->pp_interned);
+   free(p_arena);
+}
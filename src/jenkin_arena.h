@@ -0,0 +1,61 @@
+#ifndef JENKIN_ARENA_H
+#define JENKIN_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Alignment of objects in arena
+#define ARENA_ALIGN       16
+
+// Minimum size of chunk which is added when a zone of arena is full
+#define ARENA_CHUNK_SIZE  4096
+
+//----------------------------------------------------------------
+// Bump zone: memory is taken from p_cur up to p_end
+//----------------------------------------------------------------
+typedef struct arenaZone
+{
+   char* p_cur;
+   char* p_end;
+}ArenaZoneT;
+
+//----------------------------------------------------------------
+// Chunk which is added when a zone is full
+//----------------------------------------------------------------
+typedef struct arenaChunk
+{
+   struct arenaChunk* p_next;
+}ArenaChunkT;
+
+//----------------------------------------------------------------
+// Arena of a loaded config: objects (groups, jobs) are packed in one zone
+// in the order they are allocated, strings are packed in another zone, so
+// loops over objects do not walk over strings. Both zones are in the same
+// block as arena itself when arena is created with the size of whole config,
+// then whole config is freed by one free().
+// Strings are interned while arena is built (same string is stored once),
+// arenaSeal() frees the intern table when building is finished.
+// Objects are not freed one by one: each object holds a reference and the
+// arena is freed when the last reference is dropped, so objects of
+// different arenas can be mixed in one list (e.g. after reloading config).
+// Arena is not thread safe, it is built and referenced by one thread.
+//----------------------------------------------------------------
+typedef struct arena
+{
+   ArenaZoneT objects;
+   ArenaZoneT strings;
+   ArenaChunkT* p_chunks;           // chunks which are added when a zone is full
+   const char** pp_interned;        // open addressing, NULL if arena is sealed
+   unsigned int internSize;         // power of 2
+   unsigned int internCount;
+   unsigned int refCount;
+}ArenaT;
+
+ArenaT* arenaCreate(size_t objectBytes, size_t stringBytes, unsigned int stringCount);
+void* arenaAlloc(ArenaT* p_arena, size_t size);
+char* arenaIntern(ArenaT* p_arena, const char* str);
+void arenaSeal(ArenaT* p_arena);
+void arenaRef(ArenaT* p_arena);
+void arenaUnref(ArenaT* p_arena);
+
+#endif
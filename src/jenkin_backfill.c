@@ -0,0 +1,675 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include "jenkin_mon.h"
+#include "jenkin_scan.h"
+#include "jenkin_history.h"
+
+//--------------------------------------------------------------------------------------------------
+// Backfill of history from JENKINS_HOME: every build of every job (and of
+// jobs in folders) is read from jobs/<name>/builds/<n>/build.xml and written
+// to index of builds of history directory, which jenkin_mon --history DIR
+// loads at start and jenkin_hist --builds lists.
+//    $./jenkin_backfill --home /var/lib/jenkins -d /var/lib/jenkin_mon/history [-t 8]
+// It is run before jenkin_mon is started (names file of history is locked
+// by one process). Builds which are deleted from JENKINS_HOME since the last
+// backfill are kept in index and marked as removed.
+//
+// Jobs are listed by one thread, then builds of jobs are listed and read by
+// all threads: a thread takes the next job (listing) or the next chunk of
+// builds (reading) from a shared counter, results are written to slots of
+// the job or build, so nothing is locked. build.xml is scanned by chunks and
+// reading stops at the last needed field, a huge test report is not read.
+// Builds of old jenkins (before 1.597) are directories named by build id
+// (2014-12-09_18-11-41) with number symlinks, numbers of them are taken from
+// builds/legacyIds or from <number> of build.xml.
+//--------------------------------------------------------------------------------------------------
+
+// Builds which a thread takes at once from shared counter
+#define BACKFILL_CHUNK_BUILDS 64
+
+//----------------------------------------------------------------
+// Build directory which is read
+//----------------------------------------------------------------
+typedef struct backfillBuild
+{
+   u_int32 jobIdx;
+   u_int32 number;                  // 0 if it is taken from build.xml
+   char* idName;                    // name of directory if it is a build id, else NULL
+}BackfillBuildT;
+
+//----------------------------------------------------------------
+// Job directory of JENKINS_HOME
+//----------------------------------------------------------------
+typedef struct backfillJob
+{
+   char* dir;
+   char* name;                      // path and name as in config, e.g. /job/folder/job/name
+   u_int32 id;                      // id in names file of history
+   BackfillBuildT* p_builds;        // listed by a thread
+   u_int32 buildCount;
+}BackfillJobT;
+
+typedef struct backfill
+{
+   BackfillJobT* p_jobs;
+   u_int32 jobCount;
+   u_int32 jobSize;
+   BackfillBuildT* p_builds;        // builds of all jobs
+   size_t buildCount;
+   HistoryBuildT* p_index;          // slot of each build, number 0 if it is not read
+   u_int64 nextIdx;                 // atomic, next job or build which is taken by a thread
+   u_int64 legacyCount;             // atomic, builds with build id directory
+   bool isVerbose;
+}BackfillT;
+
+typedef void* (*BackfillWorkerT)(void* p_arg);
+
+//----------------------------------------------------------------------------
+// Get monotonic time in second
+//----------------------------------------------------------------------------
+static double nowSecond(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//----------------------------------------------------------------------------
+// Check that path is a directory (symlinks are followed)
+//----------------------------------------------------------------------------
+static bool isDir(const char* path)
+{
+   struct stat st;
+   return !stat(path, &st) && S_ISDIR(st.st_mode);
+}
+
+//----------------------------------------------------------------------------
+// Add job to list
+// return false if memory can not be allocated
+//----------------------------------------------------------------------------
+static bool addJob(BackfillT* p_fill, const char* dir, const char* name)
+{
+   if (p_fill->jobCount == p_fill->jobSize)
+   {
+      u_int32 newSize = p_fill->jobSize ? p_fill->jobSize * 2 : 256;
+      BackfillJobT* p_jobs = realloc(p_fill->p_jobs, newSize * sizeof(BackfillJobT));
+      if (!p_jobs)
+      {
+         return false;
+      }
+      p_fill->p_jobs = p_jobs;
+      p_fill->jobSize = newSize;
+   }
+   BackfillJobT* p_job = &p_fill->p_jobs[p_fill->jobCount];
+   memset(p_job, 0, sizeof(BackfillJobT));
+   p_job->dir = strdup(dir);
+   p_job->name = strdup(name);
+   if (!p_job->dir || !p_job->name)
+   {
+      free(p_job->dir);
+      free(p_job->name);
+      return false;
+   }
+   p_fill->jobCount++;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Add jobs of jobs/ directory of root or folder, folders are walked into
+//    <home>/jobs/name              -> /job/name
+//    <home>/jobs/folder/jobs/name  -> /job/folder/job/name
+// return false if memory can not be allocated
+//----------------------------------------------------------------------------
+static bool addJobs(BackfillT* p_fill, const char* jobsDir, const char* containerPath)
+{
+   DIR* p_dir = opendir(jobsDir);
+   if (!p_dir)
+   {
+      return true;
+   }
+   bool isOk = true;
+   struct dirent* p_ent = NULL;
+   while (isOk && ((p_ent = readdir(p_dir)) != NULL))
+   {
+      if (p_ent->d_name[0] == '.')
+      {
+         continue;
+      }
+      char jobDir[PATH_MAX];
+      char name[PATH_MAX];
+      char path[PATH_MAX];
+      snprintf(jobDir, sizeof(jobDir), "%s/%s", jobsDir, p_ent->d_name);
+      snprintf(name, sizeof(name), "%s/job/%s", containerPath, p_ent->d_name);
+      snprintf(path, sizeof(path), "%s/builds", jobDir);
+      if (isDir(path))
+      {
+         isOk = addJob(p_fill, jobDir, name);
+      }
+      // Folder, multibranch project
+      snprintf(path, sizeof(path), "%s/jobs", jobDir);
+      if (isOk && isDir(path))
+      {
+         isOk = addJobs(p_fill, path, name);
+      }
+   }
+   closedir(p_dir);
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Check that name is a build number, return the number or 0
+//----------------------------------------------------------------------------
+static u_int32 parseBuildNumber(const char* name)
+{
+   if (!isdigit((unsigned char)*name))
+   {
+      return 0;
+   }
+   char* p_end = NULL;
+   unsigned long number = strtoul(name, &p_end, 10);
+   return (*p_end || (number > UINT32_MAX)) ? 0 : (u_int32)number;
+}
+
+//----------------------------------------------------------------------------
+// Order of builds of a job by build id, numbered builds first
+//----------------------------------------------------------------------------
+static int compareIdName(const void* p_left, const void* p_right)
+{
+   const BackfillBuildT* p_a = p_left;
+   const BackfillBuildT* p_b = p_right;
+   if (!p_a->idName || !p_b->idName)
+   {
+      return (p_a->idName != NULL) - (p_b->idName != NULL);
+   }
+   return strcmp(p_a->idName, p_b->idName);
+}
+
+//----------------------------------------------------------------------------
+// Set numbers of build id directories from builds/legacyIds of job, lines are
+//    <build id> <number>
+// Builds of job are sorted by build id, so each line is found by binary
+// search
+//----------------------------------------------------------------------------
+static void setLegacyNumbers(BackfillJobT* p_job, u_int32 idCount)
+{
+   qsort(p_job->p_builds, p_job->buildCount, sizeof(BackfillBuildT), compareIdName);
+   BackfillBuildT* p_idBuilds = p_job->p_builds + p_job->buildCount - idCount;
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/builds/legacyIds", p_job->dir);
+   FILE* p_file = fopen(path, "r");
+   if (!p_file)
+   {
+      return;
+   }
+   char line[256];
+   while (fgets(line, sizeof(line), p_file))
+   {
+      line[strcspn(line, "\r\n")] = 0;
+      char* p_number = strchr(line, ' ');
+      if (!p_number)
+      {
+         continue;
+      }
+      *p_number++ = 0;
+      BackfillBuildT key;
+      memset(&key, 0, sizeof(key));
+      key.idName = line;
+      BackfillBuildT* p_build = bsearch(&key, p_idBuilds, idCount, sizeof(BackfillBuildT),
+                                        compareIdName);
+      if (p_build && !p_build->number)
+      {
+         p_build->number = parseBuildNumber(p_number);
+      }
+   }
+   fclose(p_file);
+}
+
+//----------------------------------------------------------------------------
+// List build directories of job: numbered directories, and build id
+// directories of old jenkins. Symlinks (lastStableBuild, numbers of old
+// jenkins) are skipped so no build is listed twice.
+//----------------------------------------------------------------------------
+static void listBuilds(BackfillT* p_fill, u_int32 jobIdx)
+{
+   BackfillJobT* p_job = &p_fill->p_jobs[jobIdx];
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/builds", p_job->dir);
+   DIR* p_dir = opendir(path);
+   if (!p_dir)
+   {
+      return;
+   }
+   u_int32 buildSize = 0;
+   u_int32 idCount = 0;
+   struct dirent* p_ent = NULL;
+   while ((p_ent = readdir(p_dir)) != NULL)
+   {
+      if ((p_ent->d_name[0] == '.') ||
+          ((p_ent->d_type != DT_DIR) && (p_ent->d_type != DT_UNKNOWN)))
+      {
+         continue;
+      }
+      if (p_ent->d_type == DT_UNKNOWN)
+      {
+         struct stat st;
+         snprintf(path, sizeof(path), "%s/builds/%s", p_job->dir, p_ent->d_name);
+         if (lstat(path, &st) || !S_ISDIR(st.st_mode))
+         {
+            continue;
+         }
+      }
+      u_int32 number = parseBuildNumber(p_ent->d_name);
+      char* idName = NULL;
+      if (!number)
+      {
+         idName = strdup(p_ent->d_name);
+         if (!idName)
+         {
+            continue;
+         }
+         idCount++;
+      }
+      if (p_job->buildCount == buildSize)
+      {
+         buildSize = buildSize ? buildSize * 2 : 64;
+         BackfillBuildT* p_builds = realloc(p_job->p_builds, buildSize * sizeof(BackfillBuildT));
+         if (!p_builds)
+         {
+            free(idName);
+            break;
+         }
+         p_job->p_builds = p_builds;
+      }
+      BackfillBuildT* p_build = &p_job->p_builds[p_job->buildCount++];
+      p_build->jobIdx = jobIdx;
+      p_build->number = number;
+      p_build->idName = idName;
+   }
+   closedir(p_dir);
+   if (idCount)
+   {
+      setLegacyNumbers(p_job, idCount);
+      __atomic_add_fetch(&p_fill->legacyCount, idCount, __ATOMIC_RELAXED);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Convert result of build.xml to BuildResultE
+//----------------------------------------------------------------------------
+static u_int8 parseResult(const char* result)
+{
+   static const char* results[] = {"", "SUCCESS", "UNSTABLE", "FAILURE", "NOT_BUILT", "ABORTED"};
+   u_int8 idx;
+   for (idx = SUCCESS_RESULT; idx <= ABORTED_RESULT; idx++)
+   {
+      if (!strcmp(result, results[idx]))
+      {
+         return idx;
+      }
+   }
+   return NO_RESULT;
+}
+
+//----------------------------------------------------------------------------
+// Read build.xml of build to its slot of index, start time is taken from
+// build id or directory if build.xml does not have it
+//----------------------------------------------------------------------------
+static void readBuild(BackfillT* p_fill, size_t buildIdx)
+{
+   const BackfillBuildT* p_build = &p_fill->p_builds[buildIdx];
+   const BackfillJobT* p_job = &p_fill->p_jobs[p_build->jobIdx];
+   HistoryBuildT* p_entry = &p_fill->p_index[buildIdx];
+   char buildDir[PATH_MAX];
+   char path[PATH_MAX];
+   if (p_build->idName)
+   {
+      snprintf(buildDir, sizeof(buildDir), "%s/builds/%s", p_job->dir, p_build->idName);
+   }
+   else
+   {
+      snprintf(buildDir, sizeof(buildDir), "%s/builds/%u", p_job->dir, p_build->number);
+   }
+   snprintf(path, sizeof(path), "%s/build.xml", buildDir);
+
+   // <number> is searched only if it is needed, build.xml of new jenkins does
+   // not have it and scanning stops when all fields are found
+   char result[32];
+   char timestamp[32];
+   char duration[32];
+   char number[32];
+   XmlFieldT fields[] =
+   {
+      {"result", result, sizeof(result), false},
+      {"timestamp", timestamp, sizeof(timestamp), false},
+      {"duration", duration, sizeof(duration), false},
+      {"number", number, sizeof(number), false},
+   };
+   int fieldCount = sizeof(fields) / sizeof(fields[0]) - (p_build->number ? 1 : 0);
+   if (!scanXmlFile(path, fields, fieldCount))
+   {
+      // Build is started but build.xml is not written yet
+      timestamp[0] = 0;
+      number[0] = 0;
+   }
+
+   memset(p_entry, 0, sizeof(HistoryBuildT));
+   p_entry->jobId = p_job->id;
+   p_entry->number = p_build->number ? p_build->number : parseBuildNumber(number);
+   p_entry->result = parseResult(result);
+   long long durationMs = atoll(duration);
+   p_entry->durationMs = (durationMs > UINT32_MAX) ? UINT32_MAX :
+                         (durationMs > 0) ? (u_int32)durationMs : 0;
+   p_entry->timeMs = atoll(timestamp);
+   if (p_entry->timeMs <= 0)
+   {
+      struct tm tm;
+      struct stat st;
+      memset(&tm, 0, sizeof(tm));
+      tm.tm_isdst = -1;
+      const char* p_end = p_build->idName ? strptime(p_build->idName, "%Y-%m-%d_%H-%M-%S", &tm)
+                                          : NULL;
+      if (p_end && !*p_end)
+      {
+         p_entry->timeMs = (int64)mktime(&tm) * 1000;
+      }
+      else if (!stat(buildDir, &st))
+      {
+         p_entry->timeMs = (int64)st.st_mtime * 1000;
+      }
+   }
+   if (p_fill->isVerbose && !p_entry->number)
+   {
+      printf("Number of build %s is not known, it is skipped\n", buildDir);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Thread which lists builds of jobs, one job at a time
+//----------------------------------------------------------------------------
+static void* listBuildsWorker(void* p_arg)
+{
+   BackfillT* p_fill = p_arg;
+   while (1)
+   {
+      u_int64 jobIdx = __atomic_fetch_add(&p_fill->nextIdx, 1, __ATOMIC_RELAXED);
+      if (jobIdx >= p_fill->jobCount)
+      {
+         return NULL;
+      }
+      listBuilds(p_fill, (u_int32)jobIdx);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Thread which reads builds, BACKFILL_CHUNK_BUILDS at a time, so a job with
+// many builds is shared by all threads
+//----------------------------------------------------------------------------
+static void* readBuildsWorker(void* p_arg)
+{
+   BackfillT* p_fill = p_arg;
+   while (1)
+   {
+      u_int64 firstIdx = __atomic_fetch_add(&p_fill->nextIdx, BACKFILL_CHUNK_BUILDS,
+                                            __ATOMIC_RELAXED);
+      if (firstIdx >= p_fill->buildCount)
+      {
+         return NULL;
+      }
+      u_int64 endIdx = firstIdx + BACKFILL_CHUNK_BUILDS;
+      u_int64 idx;
+      for (idx = firstIdx; (idx < endIdx) && (idx < p_fill->buildCount); idx++)
+      {
+         readBuild(p_fill, idx);
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Run worker in threadCount threads and wait for all of them
+// return false if no thread can be created
+//----------------------------------------------------------------------------
+static bool runWorkers(BackfillT* p_fill, u_int32 threadCount, BackfillWorkerT worker)
+{
+   pthread_t* p_threads = calloc(threadCount, sizeof(pthread_t));
+   if (!p_threads)
+   {
+      return false;
+   }
+   p_fill->nextIdx = 0;
+   u_int32 startCount = 0;
+   for (; startCount < threadCount; startCount++)
+   {
+      if (pthread_create(&p_threads[startCount], NULL, worker, p_fill))
+      {
+         printf("Can not create thread: %s\n", strerror(errno));
+         break;
+      }
+   }
+   u_int32 idx;
+   for (idx = 0; idx < startCount; idx++)
+   {
+      pthread_join(p_threads[idx], NULL);
+   }
+   free(p_threads);
+   return startCount > 0;
+}
+
+//----------------------------------------------------------------------------
+// Order of builds in index: by job id, then number
+//----------------------------------------------------------------------------
+static int compareBuild(const void* p_left, const void* p_right)
+{
+   const HistoryBuildT* p_a = p_left;
+   const HistoryBuildT* p_b = p_right;
+   if (p_a->jobId != p_b->jobId)
+   {
+      return (p_a->jobId < p_b->jobId) ? -1 : 1;
+   }
+   return (p_a->number < p_b->number) ? -1 : (p_a->number > p_b->number);
+}
+
+//----------------------------------------------------------------------------
+// Merge sorted builds which are read now with old index: builds which are
+// deleted from JENKINS_HOME since are kept and marked as removed, a build
+// which is in both is taken from JENKINS_HOME (it may be finished since)
+// return merged builds, NULL if memory can not be allocated
+//----------------------------------------------------------------------------
+static HistoryBuildT* mergeBuilds(const HistoryBuildT* p_new, size_t newCount,
+                                  const HistoryBuildsT* p_old, size_t* p_count,
+                                  size_t* p_removedCount)
+{
+   HistoryBuildT* p_merged = malloc((newCount + p_old->count + 1) * sizeof(HistoryBuildT));
+   if (!p_merged)
+   {
+      return NULL;
+   }
+   size_t count = 0;
+   size_t newIdx = 0;
+   size_t oldIdx = 0;
+   *p_removedCount = 0;
+   while ((newIdx < newCount) || (oldIdx < p_old->count))
+   {
+      int order = (newIdx == newCount) ? 1 :
+                  (oldIdx == p_old->count) ? -1 :
+                  compareBuild(&p_new[newIdx], &p_old->p_builds[oldIdx]);
+      if (order > 0)
+      {
+         p_merged[count] = p_old->p_builds[oldIdx++];
+         p_merged[count++].flags |= HISTORY_REMOVED;
+         (*p_removedCount)++;
+         continue;
+      }
+      p_merged[count++] = p_new[newIdx++];
+      if (order == 0)
+      {
+         oldIdx++;
+      }
+   }
+   *p_count = count;
+   return p_merged;
+}
+
+//----------------------------------------------------------------------------
+// Main function
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+   const char* homeDir = NULL;
+   const char* dir = NULL;
+   long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+   bool isOk = true;
+   BackfillT fill;
+   memset(&fill, 0, sizeof(fill));
+   struct option longOptions[] =
+   {
+      {"home"       ,required_argument ,0 ,'j'},
+      {"dir"        ,required_argument ,0 ,'d'},
+      {"threads"    ,required_argument ,0 ,'t'},
+      {"verbose"    ,no_argument       ,0 ,'v'},
+      {0            ,0                 ,0 ,0  }
+   };
+
+   int returnCharacter;
+   while ((returnCharacter = getopt_long(argc, argv, "j:d:t:v", longOptions, NULL)) != -1)
+   {
+      switch (returnCharacter)
+      {
+         case 'j': homeDir = optarg; break;
+         case 'd': dir = optarg; break;
+         case 't': threadCount = atol(optarg); break;
+         case 'v': fill.isVerbose = true; break;
+         default: isOk = false; break;
+      }
+   }
+   if (!isOk || !homeDir || !dir || (threadCount < 1) || (optind < argc))
+   {
+      printf("usage:\n"
+             "index all builds of JENKINS_HOME to history of jenkin_mon --history DIR\n"
+             "./jenkin_backfill --home JENKINS_HOME -d DIR [--threads N] [-v]\n"
+             "it is run while jenkin_mon is stopped, threads are number of cpus by default\n");
+      return 1;
+   }
+
+   HistoryLogT log;
+   if (!historyOpenNames(&log, dir))
+   {
+      return 1;
+   }
+
+   double startTime = nowSecond();
+   char jobsDir[PATH_MAX];
+   snprintf(jobsDir, sizeof(jobsDir), "%s/jobs", homeDir);
+   if (!isDir(jobsDir))
+   {
+      printf("%s is not a JENKINS_HOME, it does not have jobs/\n", homeDir);
+      historyClose(&log);
+      return 1;
+   }
+   if (!addJobs(&fill, jobsDir, ""))
+   {
+      printf("Can not allocate jobs\n");
+      historyClose(&log);
+      return 1;
+   }
+   u_int32 jobIdx;
+   for (jobIdx = 0; jobIdx < fill.jobCount; jobIdx++)
+   {
+      fill.p_jobs[jobIdx].id = historyIdOf(&log, HISTORY_JOB, fill.p_jobs[jobIdx].name);
+   }
+   double jobTime = nowSecond();
+
+   // Builds of all jobs are flattened so that threads share big jobs
+   runWorkers(&fill, (u_int32)threadCount, listBuildsWorker);
+   for (jobIdx = 0; jobIdx < fill.jobCount; jobIdx++)
+   {
+      fill.buildCount += fill.p_jobs[jobIdx].buildCount;
+   }
+   fill.p_builds = malloc((fill.buildCount + 1) * sizeof(BackfillBuildT));
+   fill.p_index = malloc((fill.buildCount + 1) * sizeof(HistoryBuildT));
+   if (!fill.p_builds || !fill.p_index)
+   {
+      printf("Can not allocate %zu builds\n", fill.buildCount);
+      historyClose(&log);
+      return 1;
+   }
+   size_t buildIdx = 0;
+   for (jobIdx = 0; jobIdx < fill.jobCount; jobIdx++)
+   {
+      BackfillJobT* p_job = &fill.p_jobs[jobIdx];
+      memcpy(&fill.p_builds[buildIdx], p_job->p_builds, p_job->buildCount * sizeof(BackfillBuildT));
+      buildIdx += p_job->buildCount;
+   }
+   double listTime = nowSecond();
+
+   runWorkers(&fill, (u_int32)threadCount, readBuildsWorker);
+   double readTime = nowSecond();
+
+   // Builds whose number is not known are dropped
+   size_t indexCount = 0;
+   for (buildIdx = 0; buildIdx < fill.buildCount; buildIdx++)
+   {
+      if (fill.p_index[buildIdx].number)
+      {
+         fill.p_index[indexCount++] = fill.p_index[buildIdx];
+      }
+   }
+   qsort(fill.p_index, indexCount, sizeof(HistoryBuildT), compareBuild);
+
+   HistoryBuildsT oldIndex;
+   if (!historyBuildsOpen(&oldIndex, dir))
+   {
+      memset(&oldIndex, 0, sizeof(oldIndex));
+   }
+   size_t mergedCount = 0;
+   size_t removedCount = 0;
+   HistoryBuildT* p_merged = mergeBuilds(fill.p_index, indexCount, &oldIndex,
+                                         &mergedCount, &removedCount);
+   isOk = p_merged && historyWriteBuilds(dir, p_merged, mergedCount);
+   historyBuildsClose(&oldIndex);
+   double endTime = nowSecond();
+
+   if (isOk)
+   {
+      double seconds = endTime - startTime;
+      printf("Indexed %zu builds of %u jobs by %ld threads in %.3f s: %.0f builds/s\n",
+             indexCount, fill.jobCount, threadCount, seconds,
+             (seconds > 0) ? indexCount / seconds : 0);
+      printf("   jobs %.3f s, list builds %.3f s, read builds %.3f s, write %.3f s\n",
+             jobTime - startTime, listTime - jobTime, readTime - listTime, endTime - readTime);
+      printf("   %zu builds without number, %llu build id directories, "
+             "%zu deleted builds are kept, %zu builds in %s/%s\n",
+             fill.buildCount - indexCount, (unsigned long long)fill.legacyCount, removedCount,
+             mergedCount, dir, HISTORY_BUILDS_FILE);
+   }
+
+   free(p_merged);
+   for (buildIdx = 0; buildIdx < fill.buildCount; buildIdx++)
+   {
+      free(fill.p_builds[buildIdx].idName);
+   }
+   for (jobIdx = 0; jobIdx < fill.jobCount; jobIdx++)
+   {
+      free(fill.p_jobs[jobIdx].dir);
+      free(fill.p_jobs[jobIdx].name);
+      free(fill.p_jobs[jobIdx].p_builds);
+   }
+   free(fill.p_jobs);
+   free(fill.p_builds);
+   free(fill.p_index);
+   historyClose(&log);
+   return isOk ? 0 : 1;
+}
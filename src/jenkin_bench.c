@@ -0,0 +1,537 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include "jenkin_json.h"
+#include "jenkin_pool.h"
+#include "jenkin_sched.h"
+#include "jenkin_gpio.h"
+#include "jenkin_pwm.h"
+
+//--------------------------------------------------------------------------------------------------
+// Benchmark for hot code of jenkin_mon
+//    $make bench
+//--------------------------------------------------------------------------------------------------
+
+// Size of chunk that is fed to json extractor, the same as receive buffer of HttpConnT
+#define BENCH_CHUNK_SIZE 4096
+
+// Simulated poll cycles of groups: each cycle waits for network, then parses
+// response of a group with BENCH_GROUP_JOBS jobs and evaluates it
+#define BENCH_FETCH_WAIT_NS 1000000L   // 1 ms
+#define BENCH_GROUP_JOBS    20
+#define BENCH_POLL_CYCLES   10
+
+// Software pwm runs on mock gpio for this time, frames are logged to file
+#define BENCH_PWM_RUN_MS    1500
+#define BENCH_PWM_LOG       "/tmp/jenkin_bench_pwm.log"
+
+//----------------------------------------------------------------------------
+// Get monotonic time in nano second
+//----------------------------------------------------------------------------
+static long long nowNs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------------
+// Build synthetic response of /api/json?tree=jobs[name,color,lastBuild[timestamp,result]]
+// in the same format as jenkins server
+// Note: need to free pointer to string that are return from this function
+//----------------------------------------------------------------------------
+static char* buildJobsTreePayload(unsigned int jobCount, size_t* p_len)
+{
+   static const char* colors[] = {"blue", "red", "yellow", "blue_anime", "notbuilt", "disabled"};
+   static const char* results[] = {"\"SUCCESS\"", "\"FAILURE\"", "\"UNSTABLE\"", "null",
+                                   "\"NOT_BUILT\"", "\"ABORTED\""};
+   size_t size = 200 + (size_t)jobCount * 300;
+   char* p_payload = malloc(size);
+   size_t len = snprintf(p_payload, size, "{\"_class\":\"hudson.model.Hudson\",\"jobs\":[");
+   unsigned int idx;
+   for (idx = 0; idx < jobCount; idx++)
+   {
+      unsigned int kind = idx % 6;
+      len += snprintf(p_payload + len, size - len,
+                      "%s{\"_class\":\"hudson.model.FreeStyleProject\","\
+                      "\"name\":\"project_%05u_build_and_test\",\"color\":\"%s\","\
+                      "\"lastBuild\":{\"_class\":\"hudson.model.FreeStyleBuild\","\
+                      "\"result\":%s,\"timestamp\":%llu}}",
+                      idx ? "," : "", idx, colors[kind], results[kind],
+                      1418372173536ULL + idx * 1000ULL);
+   }
+   len += snprintf(p_payload + len, size - len, "]}");
+   *p_len = len;
+   return p_payload;
+}
+
+//----------------------------------------------------------------------------
+// Callback of json extractor for benchmark, only count jobs
+//----------------------------------------------------------------------------
+static void countJobEntry(void* p_arg, const JsonJobEntryT* p_entry)
+{
+   (*(unsigned int*)p_arg)++;
+}
+
+//----------------------------------------------------------------------------
+// Feed payload to json extractor chunk by chunk as we receive from socket
+//----------------------------------------------------------------------------
+static bool extractPayload(const char* p_payload, size_t len, unsigned int* p_jobCount)
+{
+   JsonExtractorT extractor;
+   jsonExtractorInit(&extractor, countJobEntry, p_jobCount);
+   size_t pos;
+   for (pos = 0; pos < len; pos += BENCH_CHUNK_SIZE)
+   {
+      size_t chunk = (len - pos < BENCH_CHUNK_SIZE) ? len - pos : BENCH_CHUNK_SIZE;
+      if (!jsonExtractorFeed(&extractor, p_payload + pos, chunk))
+      {
+         return false;
+      }
+   }
+   return jsonExtractorFinish(&extractor);
+}
+
+//----------------------------------------------------------------------------
+// Benchmark json extractor with synthetic jobs tree
+//----------------------------------------------------------------------------
+static void benchJsonExtractor(unsigned int jobCount, unsigned int loopCount)
+{
+   size_t len;
+   char* p_payload = buildJobsTreePayload(jobCount, &len);
+
+   // Warm up and check result
+   unsigned int foundJobs = 0;
+   if (!extractPayload(p_payload, len, &foundJobs) || (foundJobs != jobCount))
+   {
+      printf("json extractor: wrong result, found %u/%u jobs\n", foundJobs, jobCount);
+      free(p_payload);
+      return;
+   }
+
+   long long startNs = nowNs();
+   unsigned int loop;
+   for (loop = 0; loop < loopCount; loop++)
+   {
+      extractPayload(p_payload, len, &foundJobs);
+   }
+   long long elapsedNs = nowNs() - startNs;
+
+   double nsPerPayload = (double)elapsedNs / loopCount;
+   printf("json extractor (%s): %u jobs, %zu bytes: %.1f us/payload, %.1f ns/job, %.1f MB/s\n",
+#if defined(JSON_NO_SIMD)
+          "scalar",
+#else
+          "simd",
+#endif
+          jobCount, len, nsPerPayload / 1000, nsPerPayload / jobCount,
+          (double)len * loopCount / ((double)elapsedNs / 1e9) / 1e6);
+   free(p_payload);
+}
+
+//----------------------------------------------------------------
+// Simulated group for scaling benchmark
+//----------------------------------------------------------------
+typedef struct benchGroup
+{
+   PoolTaskT fetchTask;
+   PoolTaskT parseTask;
+   PoolTaskT evalTask;
+   SchedTimerT waitTimer;     // fetch of async model waits in dispatcher
+   unsigned int cycleLeft;
+   unsigned int jobCount;
+}BenchGroupT;
+
+static char* s_groupPayload = NULL;
+static size_t s_groupPayloadLen = 0;
+
+// Async model: fetch task does not block its worker, it posts its timer to
+// dispatcher thread which submits parse task when fetch wait is over, like
+// main thread of jenkin_mon does for sockets. NULL in pool model.
+static SchedulerT* s_p_waitSched = NULL;
+static PoolT* s_p_pool = NULL;
+static volatile bool s_isDispatchStop = false;
+
+// Groups of pool model which are not done
+static unsigned int s_groupLeft = 0;
+static pthread_mutex_t s_groupLeftLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_groupLeftCond = PTHREAD_COND_INITIALIZER;
+
+//----------------------------------------------------------------------------
+// Simulate stages of a poll cycle
+//----------------------------------------------------------------------------
+static void simFetch(void)
+{
+   struct timespec waitTime = {0, BENCH_FETCH_WAIT_NS};
+   nanosleep(&waitTime, NULL);
+}
+
+static void simParse(BenchGroupT* p_group)
+{
+   p_group->jobCount = 0;
+   extractPayload(s_groupPayload, s_groupPayloadLen, &p_group->jobCount);
+}
+
+static void simEval(BenchGroupT* p_group)
+{
+   if (p_group->jobCount != BENCH_GROUP_JOBS)
+   {
+      printf("scaling: wrong result, found %u/%u jobs\n", p_group->jobCount, BENCH_GROUP_JOBS);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Thread per group model: each group thread runs all of its cycles
+//----------------------------------------------------------------------------
+static void* groupThread(void* arg)
+{
+   BenchGroupT* p_group = (BenchGroupT*)arg;
+   for (; p_group->cycleLeft; p_group->cycleLeft--)
+   {
+      simFetch();
+      simParse(p_group);
+      simEval(p_group);
+   }
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Pool model: fetch -> parse -> evaluate tasks, then fetch of next cycle
+//----------------------------------------------------------------------------
+static void fetchTask(PoolTaskT* p_task, PoolWorkerT* p_worker)
+{
+   BenchGroupT* p_group = (BenchGroupT*)p_task->p_arg;
+   if (s_p_waitSched)
+   {
+      schedPost(s_p_waitSched, &p_group->waitTimer, schedNowNs() + BENCH_FETCH_WAIT_NS);
+      return;
+   }
+   simFetch();
+   poolSpawn(p_worker, &p_group->parseTask);
+}
+
+static void parseTask(PoolTaskT* p_task, PoolWorkerT* p_worker)
+{
+   BenchGroupT* p_group = (BenchGroupT*)p_task->p_arg;
+   simParse(p_group);
+   poolSpawn(p_worker, &p_group->evalTask);
+}
+
+static void evalTask(PoolTaskT* p_task, PoolWorkerT* p_worker)
+{
+   BenchGroupT* p_group = (BenchGroupT*)p_task->p_arg;
+   simEval(p_group);
+   if (--p_group->cycleLeft)
+   {
+      poolSpawn(p_worker, &p_group->fetchTask);
+      return;
+   }
+   pthread_mutex_lock(&s_groupLeftLock);
+   if (--s_groupLeft == 0)
+   {
+      pthread_cond_signal(&s_groupLeftCond);
+   }
+   pthread_mutex_unlock(&s_groupLeftLock);
+}
+
+//----------------------------------------------------------------------------
+// Dispatcher of async model: submit parse task of group whose fetch wait is
+// over
+//----------------------------------------------------------------------------
+static void* dispatchThread(void* arg)
+{
+   (void)arg;
+   while (!s_isDispatchStop)
+   {
+      SchedTimerT* p_timer;
+      while ((p_timer = schedPopExpired(s_p_waitSched, schedNowNs())))
+      {
+         poolSubmit(s_p_pool, (PoolTaskT*)p_timer->p_arg);
+      }
+      if (!schedWait(s_p_waitSched))
+      {
+         break;
+      }
+   }
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Run all cycles of all groups by thread per group model (workerCount = 0),
+// by pool model, or by async model if isAsync, print wall time, cpu time
+// and context switches
+//----------------------------------------------------------------------------
+static void runScaling(unsigned int groupCount, unsigned int workerCount, bool isAsync)
+{
+   BenchGroupT* p_groups = calloc(groupCount, sizeof(BenchGroupT));
+   pthread_t* p_threads = calloc(groupCount, sizeof(pthread_t));
+   unsigned int idx;
+   for (idx = 0; idx < groupCount; idx++)
+   {
+      p_groups[idx].cycleLeft = BENCH_POLL_CYCLES;
+      p_groups[idx].fetchTask.run = fetchTask;
+      p_groups[idx].parseTask.run = parseTask;
+      p_groups[idx].evalTask.run = evalTask;
+      p_groups[idx].fetchTask.p_arg = &p_groups[idx];
+      p_groups[idx].parseTask.p_arg = &p_groups[idx];
+      p_groups[idx].evalTask.p_arg = &p_groups[idx];
+      schedTimerInit(&p_groups[idx].waitTimer, &p_groups[idx].parseTask);
+   }
+
+   struct rusage startUsage;
+   struct rusage endUsage;
+   getrusage(RUSAGE_SELF, &startUsage);
+   long long startNs = nowNs();
+   unsigned int threadCount = workerCount;
+
+   if (workerCount == 0)
+   {
+      threadCount = 0;
+      for (idx = 0; idx < groupCount; idx++)
+      {
+         if (pthread_create(&p_threads[idx], NULL, groupThread, &p_groups[idx]) == 0)
+         {
+            threadCount++;
+         }
+      }
+      for (idx = 0; idx < threadCount; idx++)
+      {
+         pthread_join(p_threads[idx], NULL);
+      }
+   }
+   else
+   {
+      PoolT pool;
+      SchedulerT waitSched = SCHED_INITIALIZER;
+      pthread_t dispatcher;
+      s_groupLeft = groupCount;
+      poolInit(&pool, workerCount);
+      if (isAsync && schedInit(&waitSched))
+      {
+         s_p_waitSched = &waitSched;
+         s_p_pool = &pool;
+         s_isDispatchStop = false;
+         if (pthread_create(&dispatcher, NULL, dispatchThread, NULL) == 0)
+         {
+            threadCount++;
+         }
+         else
+         {
+            s_p_waitSched = NULL;
+         }
+      }
+      for (idx = 0; idx < groupCount; idx++)
+      {
+         poolSubmit(&pool, &p_groups[idx].fetchTask);
+      }
+      pthread_mutex_lock(&s_groupLeftLock);
+      while (s_groupLeft)
+      {
+         pthread_cond_wait(&s_groupLeftCond, &s_groupLeftLock);
+      }
+      pthread_mutex_unlock(&s_groupLeftLock);
+      if (s_p_waitSched)
+      {
+         s_isDispatchStop = true;
+         schedWake(&waitSched);
+         pthread_join(dispatcher, NULL);
+         s_p_waitSched = NULL;
+         s_p_pool = NULL;
+      }
+      schedFree(&waitSched);
+      poolStop(&pool);
+   }
+
+   long long elapsedNs = nowNs() - startNs;
+   getrusage(RUSAGE_SELF, &endUsage);
+   double cpuMs = (endUsage.ru_utime.tv_sec - startUsage.ru_utime.tv_sec +
+                   endUsage.ru_stime.tv_sec - startUsage.ru_stime.tv_sec) * 1e3 +
+                  (endUsage.ru_utime.tv_usec - startUsage.ru_utime.tv_usec +
+                   endUsage.ru_stime.tv_usec - startUsage.ru_stime.tv_usec) / 1e3;
+   long ctxSwitches = (endUsage.ru_nvcsw - startUsage.ru_nvcsw) +
+                      (endUsage.ru_nivcsw - startUsage.ru_nivcsw);
+   printf("scaling %-15s: %4u groups, %4u threads: %8.1f ms/cycle, cpu %7.1f us/group-cycle, "\
+          "%6.2f ctx switches/group-cycle\n",
+          isAsync ? "async pool" : workerCount ? "worker pool" : "thread/group",
+          groupCount, threadCount,
+          (double)elapsedNs / 1e6 / BENCH_POLL_CYCLES,
+          cpuMs * 1e3 / groupCount / BENCH_POLL_CYCLES,
+          (double)ctxSwitches / groupCount / BENCH_POLL_CYCLES);
+   free(p_threads);
+   free(p_groups);
+}
+
+//----------------------------------------------------------------------------
+// Compare worker pool with thread per group model
+//----------------------------------------------------------------------------
+static void benchScaling(void)
+{
+   s_groupPayload = buildJobsTreePayload(BENCH_GROUP_JOBS, &s_groupPayloadLen);
+   printf("scaling: fetch waits %ld us, %d poll cycles, cores %u\n",
+          BENCH_FETCH_WAIT_NS / 1000, BENCH_POLL_CYCLES, poolDefaultWorkers());
+   unsigned int groupCounts[] = {16, 64, 256};
+   unsigned int idx;
+   for (idx = 0; idx < sizeof(groupCounts) / sizeof(groupCounts[0]); idx++)
+   {
+      runScaling(groupCounts[idx], 0, false);
+      runScaling(groupCounts[idx], 4, false);
+      runScaling(groupCounts[idx], poolDefaultWorkers(), true);
+   }
+   free(s_groupPayload);
+}
+
+//----------------------------------------------------------------------------
+// Measure duty of pins from frames in mock log, only time after skipNs from
+// first frame is counted so that fades are finished
+// p_onNs[pin] is time while pin is 0 (led on)
+//----------------------------------------------------------------------------
+static long long measureDuty(const char* logFile, long long skipNs, long long* p_onNs)
+{
+   FILE* p_file = fopen(logFile, "r");
+   if (!p_file)
+   {
+      return 0;
+   }
+   int values[GPIO_MAX_PIN];
+   long long changedNs[GPIO_MAX_PIN];
+   unsigned int pin;
+   for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+   {
+      values[pin] = 1;
+      changedNs[pin] = 0;
+      p_onNs[pin] = 0;
+   }
+
+   char line[4096];
+   long long firstNs = 0;
+   long long lastNs = 0;
+   while (fgets(line, sizeof(line), p_file))
+   {
+      char* p_pos = line;
+      long long frameNs = strtoll(p_pos, &p_pos, 10);
+      if (!firstNs)
+      {
+         firstNs = frameNs;
+      }
+      long long startNs = firstNs + skipNs;
+      lastNs = frameNs;
+      int value;
+      int len;
+      while (sscanf(p_pos, " %u=%d%n", &pin, &value, &len) == 2)
+      {
+         p_pos += len;
+         if (pin >= GPIO_MAX_PIN)
+         {
+            continue;
+         }
+         if ((values[pin] == 0) && (frameNs > startNs))
+         {
+            p_onNs[pin] += frameNs - ((changedNs[pin] > startNs) ? changedNs[pin] : startNs);
+         }
+         values[pin] = value;
+         changedNs[pin] = frameNs;
+      }
+   }
+   fclose(p_file);
+   return lastNs - firstNs - skipNs;
+}
+
+//----------------------------------------------------------------------------
+// Run software pwm on mock gpio
+// steadyCount pins are dimmed to different levels, fadeCount pins fade up and
+// down all the time, breathCount pins breathe
+//----------------------------------------------------------------------------
+static void runPwm(unsigned int hz, unsigned int steadyCount, unsigned int fadeCount,
+                   unsigned int breathCount)
+{
+   unsigned int pinCount = steadyCount + fadeCount + breathCount;
+   unsigned int pin;
+   if (!gpioInit("mock", BENCH_PWM_LOG, 1000))
+   {
+      return;
+   }
+   for (pin = 0; pin < pinCount; pin++)
+   {
+      gpioRequestPin(pin, NULL);
+   }
+   if (!gpioStart() || !pwmStart(hz))
+   {
+      gpioCleanup();
+      return;
+   }
+
+   pwmResetStats();
+   for (pin = 0; pin < steadyCount; pin++)
+   {
+      pwmSetLevel(pin, PWM_MAX_LEVEL * (pin + 1) / (steadyCount + 1), 0);
+   }
+   for (pin = steadyCount + fadeCount; pin < pinCount; pin++)
+   {
+      pwmSetBreath(pin, PWM_MAX_LEVEL, 1000);
+   }
+   long long endNs = nowNs() + BENCH_PWM_RUN_MS * 1000000LL;
+   unsigned int step = 0;
+   while (nowNs() < endNs)
+   {
+      for (pin = steadyCount; pin < steadyCount + fadeCount; pin++)
+      {
+         pwmSetLevel(pin, (step % 2) ? 0 : PWM_MAX_LEVEL, 200);
+      }
+      step++;
+      struct timespec waitTime = {0, 250000000L};
+      nanosleep(&waitTime, NULL);
+   }
+   pwmStop();
+   gpioCleanup();
+
+   PwmStatsT stats;
+   pwmGetStats(&stats);
+   printf("pwm %4u Hz: %2u steady, %2u fading, %2u breathing pins: %6.1f wakeups/s, "\
+          "jitter avg %5.1f us, p99 < %5u us, max %6.1f us, %llu overruns, cpu %6.3f%%\n",
+          hz, steadyCount, fadeCount, breathCount,
+          stats.runNs ? stats.wakeCount * 1e9 / stats.runNs : 0.0,
+          stats.wakeCount ? (double)stats.jitterSumNs / stats.wakeCount / 1e3 : 0.0,
+          pwmJitterPercentileUs(&stats, 99), stats.jitterMaxNs / 1e3,
+          stats.overrunCount, stats.runNs ? 100.0 * stats.cpuNs / stats.runNs : 0.0);
+
+   // Duty of steady pins is measured after first half second
+   long long onNs[GPIO_MAX_PIN];
+   long long windowNs = measureDuty(BENCH_PWM_LOG, 500000000LL, onNs);
+   for (pin = 0; (pin < steadyCount) && (windowNs > 0); pin++)
+   {
+      unsigned int level = PWM_MAX_LEVEL * (pin + 1) / (steadyCount + 1);
+      printf("   pin %2u level %3u: duty expected %6.2f%%, measured %6.2f%%\n",
+             pin, level, 100.0 * pwmLevelDuty(level) / PWM_DUTY_SCALE,
+             100.0 * onNs[pin] / windowNs);
+   }
+   remove(BENCH_PWM_LOG);
+}
+
+//----------------------------------------------------------------------------
+// Jitter, cpu budget and accuracy of software pwm
+// Pwm thread runs as normal thread unless benchmark has privilege of
+// real time priority
+//----------------------------------------------------------------------------
+static void benchPwm(void)
+{
+   runPwm(100, 3, 0, 0);
+   runPwm(200, 3, 3, 3);
+   runPwm(200, 0, 12, 12);
+   runPwm(1000, 3, 3, 3);
+}
+
+//----------------------------------------------------------------------------
+// Main function
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+   benchJsonExtractor(100, 10000);
+   benchJsonExtractor(10000, 200);
+   benchScaling();
+   benchPwm();
+   return 0;
+}
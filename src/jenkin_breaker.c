@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "jenkin_breaker.h"
+
+// Weight of the newest request in moving average of errors
+#define BREAKER_ERROR_WEIGHT 0.0625
+
+//----------------------------------------------------------------------------
+// Find breaker of server in list, or append new one which is closed and
+// waits the longest time until round trip time is measured
+// return NULL if memory is not enough
+//----------------------------------------------------------------------------
+BreakerT* breakerFind(BreakerT** pp_headBreaker, const char* serverName,
+                      unsigned int maxTimeoutMs)
+{
+   BreakerT** pp_breaker = pp_headBreaker;
+   while (*pp_breaker && strcmp((*pp_breaker)->serverName, serverName))
+   {
+      pp_breaker = &(*pp_breaker)->p_nextBreaker;
+   }
+   if (*pp_breaker)
+   {
+      return *pp_breaker;
+   }
+
+   BreakerT* p_breaker = calloc(1, sizeof(BreakerT));
+   if (!p_breaker)
+   {
+      return NULL;
+   }
+   p_breaker->serverName = strdup(serverName);
+   if (!p_breaker->serverName || pthread_mutex_init(&p_breaker->lock, NULL))
+   {
+      free(p_breaker->serverName);
+      free(p_breaker);
+      return NULL;
+   }
+   p_breaker->state = BREAKER_CLOSED;
+   p_breaker->maxTimeoutMs = (maxTimeoutMs < BREAKER_MIN_TIMEOUT_MS) ? BREAKER_MIN_TIMEOUT_MS :
+                                                                        maxTimeoutMs;
+   p_breaker->timeoutMs = p_breaker->maxTimeoutMs;
+   p_breaker->probeDelayMs = BREAKER_MIN_PROBE_MS;
+
+   // Breaker is published after it is filled, list may be walked meanwhile
+   __atomic_store_n(pp_breaker, p_breaker, __ATOMIC_RELEASE);
+   return p_breaker;
+}
+
+//----------------------------------------------------------------------------
+// Free all breakers of list
+// Note: nobody must use them any more
+//----------------------------------------------------------------------------
+void breakerFreeAll(BreakerT** pp_headBreaker)
+{
+   while (*pp_headBreaker)
+   {
+      BreakerT* p_breaker = *pp_headBreaker;
+      *pp_headBreaker = p_breaker->p_nextBreaker;
+      pthread_mutex_destroy(&p_breaker->lock);
+      free(p_breaker->serverName);
+      free(p_breaker);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Check that a request can be sent to server now. When probe time of open
+// breaker comes, only the first caller sends a request, it is the probe.
+// return false if request must not be sent
+//----------------------------------------------------------------------------
+bool breakerAllow(BreakerT* p_breaker, long long nowNs)
+{
+   bool isAllowed = true;
+   pthread_mutex_lock(&p_breaker->lock);
+   if (p_breaker->state == BREAKER_OPEN && nowNs >= p_breaker->nextProbeNs)
+   {
+      __atomic_store_n(&p_breaker->state, BREAKER_HALF_OPEN, __ATOMIC_RELEASE);
+      p_breaker->probeCount++;
+   }
+   else if (p_breaker->state != BREAKER_CLOSED)
+   {
+      p_breaker->rejectCount++;
+      isAllowed = false;
+   }
+   pthread_mutex_unlock(&p_breaker->lock);
+   return isAllowed;
+}
+
+//----------------------------------------------------------------------------
+// Get timeout of next request to server
+//----------------------------------------------------------------------------
+unsigned int breakerTimeoutMs(BreakerT* p_breaker)
+{
+   pthread_mutex_lock(&p_breaker->lock);
+   unsigned int timeoutMs = p_breaker->timeoutMs;
+   pthread_mutex_unlock(&p_breaker->lock);
+   return timeoutMs;
+}
+
+//----------------------------------------------------------------------------
+// Open breaker, server is probed again after probe delay
+// Note: lock must be held
+//----------------------------------------------------------------------------
+static void openBreaker(BreakerT* p_breaker, long long nowNs)
+{
+   if (p_breaker->state == BREAKER_CLOSED)
+   {
+      p_breaker->tripCount++;
+      printf("Server %s is unreachable, probe it again after %u ms\n",
+             p_breaker->serverName, p_breaker->probeDelayMs);
+   }
+   __atomic_store_n(&p_breaker->state, BREAKER_OPEN, __ATOMIC_RELEASE);
+   p_breaker->nextProbeNs = nowNs + p_breaker->probeDelayMs * 1000000LL;
+}
+
+//----------------------------------------------------------------------------
+// Account result of a request which is allowed by breakerAllow()
+// A request is answered if server sends a whole response which is not a
+// server error, e.g. 404 of job which has never been built is answered.
+// Round trip time of answered request is measured for timeout.
+//----------------------------------------------------------------------------
+void breakerRecord(BreakerT* p_breaker, bool isAnswered, bool isTimedOut,
+                   long long rttNs, long long nowNs)
+{
+   pthread_mutex_lock(&p_breaker->lock);
+   p_breaker->errorRate += ((isAnswered ? 0.0 : 1.0) - p_breaker->errorRate) *
+                           BREAKER_ERROR_WEIGHT;
+   if (isAnswered)
+   {
+      if (p_breaker->srttNs == 0)
+      {
+         p_breaker->srttNs = rttNs;
+         p_breaker->rttVarNs = rttNs / 2;
+      }
+      else
+      {
+         long long deltaNs = llabs(p_breaker->srttNs - rttNs);
+         p_breaker->rttVarNs += (deltaNs - p_breaker->rttVarNs) / 4;
+         p_breaker->srttNs += (rttNs - p_breaker->srttNs) / 8;
+      }
+      long long timeoutMs = (p_breaker->srttNs + 4 * p_breaker->rttVarNs) / 1000000;
+      p_breaker->timeoutMs = (timeoutMs < BREAKER_MIN_TIMEOUT_MS) ? BREAKER_MIN_TIMEOUT_MS :
+                             (timeoutMs > p_breaker->maxTimeoutMs) ? p_breaker->maxTimeoutMs :
+                                                                     (unsigned int)timeoutMs;
+      p_breaker->failureCount = 0;
+      if (p_breaker->state != BREAKER_CLOSED)
+      {
+         printf("Server %s is reachable again\n", p_breaker->serverName);
+         __atomic_store_n(&p_breaker->state, BREAKER_CLOSED, __ATOMIC_RELEASE);
+         p_breaker->probeDelayMs = BREAKER_MIN_PROBE_MS;
+      }
+   }
+   else
+   {
+      p_breaker->failureCount++;
+      if (isTimedOut)
+      {
+         // Server may be slower than it was, give next request more time
+         p_breaker->timeoutMs = (p_breaker->timeoutMs > p_breaker->maxTimeoutMs / 2) ?
+                                p_breaker->maxTimeoutMs : p_breaker->timeoutMs * 2;
+      }
+      if (p_breaker->state == BREAKER_HALF_OPEN)
+      {
+         p_breaker->probeDelayMs = (p_breaker->probeDelayMs > BREAKER_MAX_PROBE_MS / 2) ?
+                                   BREAKER_MAX_PROBE_MS : p_breaker->probeDelayMs * 2;
+         openBreaker(p_breaker, nowNs);
+      }
+      else if ((p_breaker->state == BREAKER_CLOSED) &&
+               (p_breaker->failureCount >= BREAKER_TRIP_FAILURES))
+      {
+         openBreaker(p_breaker, nowNs);
+      }
+   }
+   pthread_mutex_unlock(&p_breaker->lock);
+}
+
+//----------------------------------------------------------------------------
+// Forget request which is allowed by breakerAllow() but canceled before its
+// result is known (e.g. config is reloaded). A canceled probe tells nothing
+// about server, so breaker is opened again and probed at once, otherwise it
+// would wait for result of probe for ever.
+//----------------------------------------------------------------------------
+void breakerCancel(BreakerT* p_breaker, long long nowNs)
+{
+   pthread_mutex_lock(&p_breaker->lock);
+   if (p_breaker->state == BREAKER_HALF_OPEN)
+   {
+      __atomic_store_n(&p_breaker->state, BREAKER_OPEN, __ATOMIC_RELEASE);
+      p_breaker->nextProbeNs = nowNs;
+   }
+   pthread_mutex_unlock(&p_breaker->lock);
+}
+
+//----------------------------------------------------------------------------
+// Check that server is considered down: breaker is open or its probe is not
+// answered yet
+//----------------------------------------------------------------------------
+bool breakerIsOpen(const BreakerT* p_breaker)
+{
+   return __atomic_load_n(&p_breaker->state, __ATOMIC_ACQUIRE) != BREAKER_CLOSED;
+}
+
+//----------------------------------------------------------------------------
+// Get time to try a request which is not allowed now: probe time of open
+// breaker, or time when result of probe which is sent is known
+//----------------------------------------------------------------------------
+long long breakerRetryNs(BreakerT* p_breaker, long long nowNs)
+{
+   pthread_mutex_lock(&p_breaker->lock);
+   long long retryNs = (p_breaker->state == BREAKER_OPEN) ? p_breaker->nextProbeNs :
+                       (p_breaker->state == BREAKER_HALF_OPEN) ?
+                       nowNs + p_breaker->timeoutMs * 1000000LL : nowNs;
+   pthread_mutex_unlock(&p_breaker->lock);
+   return retryNs;
+}
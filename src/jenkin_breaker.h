@@ -0,0 +1,71 @@
+#ifndef JENKIN_BREAKER_H
+#define JENKIN_BREAKER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+// Timeout is never shorter than this even if server answers in 1 ms, a
+// short hiccup of jenkins (e.g. garbage collection) should not trip breaker
+#define BREAKER_MIN_TIMEOUT_MS   1000
+
+// Consecutive failed requests which open breaker
+#define BREAKER_TRIP_FAILURES    3
+
+// Server is probed again after this time when breaker is opened, the time
+// is doubled after every failed probe until the limit
+#define BREAKER_MIN_PROBE_MS     1000
+#define BREAKER_MAX_PROBE_MS     (5 * 60 * 1000)
+
+//----------------------------------------------------------------
+// State of circuit breaker
+//----------------------------------------------------------------
+typedef enum breakerState
+{
+   BREAKER_CLOSED    = 0,        // requests are sent
+   BREAKER_OPEN      = 1,        // server is down, no request until next probe
+   BREAKER_HALF_OPEN = 2         // one probe is sent, others wait for its result
+}BreakerStateE;
+
+//----------------------------------------------------------------
+// Health of one jenkins server, shared by all groups (and jenkin server of
+// aggregate mode) which have the same server name, so that one dead server
+// is found once, not once per group.
+// Timeout of request comes from measured round trip time like tcp does
+// (RFC 6298): smoothed rtt + 4 * its deviation. A timeout doubles the
+// timeout until a request succeeds, so a server which becomes slow is not
+// cut off for ever.
+// Breakers are never removed from list while daemon runs, list is only
+// appended by main thread and can be walked by other threads without lock.
+//----------------------------------------------------------------
+typedef struct breaker
+{
+   struct breaker* p_nextBreaker;
+   char* serverName;
+   pthread_mutex_t lock;
+   BreakerStateE state;          // read without lock by breakerIsOpen()
+   long long srttNs;             // smoothed round trip time, 0 if not measured
+   long long rttVarNs;           // smoothed deviation of round trip time
+   unsigned int timeoutMs;       // timeout of next request
+   unsigned int maxTimeoutMs;
+   double errorRate;             // moving average of failed requests, 0..1
+   unsigned int failureCount;    // consecutive failed requests
+   unsigned int probeDelayMs;    // time from failed probe to next probe
+   long long nextProbeNs;        // CLOCK_MONOTONIC, when breaker is open
+
+   unsigned long long tripCount;       // breaker is opened from closed
+   unsigned long long probeCount;
+   unsigned long long rejectCount;     // requests which are not sent
+}BreakerT;
+
+BreakerT* breakerFind(BreakerT** pp_headBreaker, const char* serverName,
+                      unsigned int maxTimeoutMs);
+void breakerFreeAll(BreakerT** pp_headBreaker);
+bool breakerAllow(BreakerT* p_breaker, long long nowNs);
+unsigned int breakerTimeoutMs(BreakerT* p_breaker);
+void breakerRecord(BreakerT* p_breaker, bool isAnswered, bool isTimedOut,
+                   long long rttNs, long long nowNs);
+void breakerCancel(BreakerT* p_breaker, long long nowNs);
+bool breakerIsOpen(const BreakerT* p_breaker);
+long long breakerRetryNs(BreakerT* p_breaker, long long nowNs);
+
+#endif
@@ -0,0 +1,736 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include "jenkin_gpio.h"
+#include "jenkin_home.h"
+#include "jenkin_breaker.h"
+#include "jenkin_json.h"
+
+//--------------------------------------------------------------------------------------------------
+// Checks of backends of jenkin_mon against fake trees in a temporary directory,
+// no hardware and no root is needed:
+//    sysfs gpio: gpioN/direction and gpioN/value files
+//    led class : <led>/brightness, trigger, delay_on and delay_off files
+// and of JENKINS_HOME data source against jobs of jenkinJobsExample and a fake
+// JENKINS_HOME with a running build and a disabled job, of circuit breaker of
+// servers and of streaming json extractor, whose payloads are fed whole, split
+// in two at every byte and byte by byte, so that chunk boundaries fall inside
+// strings, escapes, tokens and 16 byte blocks of vectorized scanning.
+// jenkin_check_scalar is the same check with scalar scanning (JSON_NO_SIMD).
+//    $make check
+//    $./jenkin_check [jenkinJobsExample]    (default ../jenkinJobsExample)
+//
+// Each check prints "ok" or "FAIL" with what is expected, exit code is number
+// of failed checks, so the check can be run by script.
+// Files of a fake tree are truncated after they are checked, so the next check
+// of a file sees only what is written after the previous check (a real sysfs
+// file does not keep what is written, a fake one does).
+//--------------------------------------------------------------------------------------------------
+
+// Template of temporary directory of fake trees
+#define CHECK_TMP_DIR "/tmp/jenkin_check.XXXXXX"
+
+// JENKINS_HOME which is shipped with jenkin_mon, relative to src
+#define CHECK_EXAMPLE_HOME "../jenkinJobsExample"
+
+// Maximum number of jobs in a json payload of check
+#define CHECK_MAX_JOBS 8
+
+// Half period of blinking which is given to gpio backends
+#define CHECK_BLINK_MS 500
+
+static unsigned int s_failCount = 0;
+
+//----------------------------------------------------------------------------
+// Print result of one check
+//----------------------------------------------------------------------------
+static void checkTrue(bool isOk, const char* what)
+{
+   printf("%s %s\n", isOk ? "ok  " : "FAIL", what);
+   if (!isOk)
+   {
+      s_failCount++;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Check content of file of fake tree and truncate it
+// expected "" checks that nothing is written to file
+//----------------------------------------------------------------------------
+static void checkFile(const char* dir, const char* fileName, const char* expected)
+{
+   char path[512];
+   char content[64] = "";
+   snprintf(path, sizeof(path), "%s/%s", dir, fileName);
+   FILE* p_file = fopen(path, "r+");
+   if (p_file)
+   {
+      size_t len = fread(content, 1, sizeof(content) - 1, p_file);
+      content[len] = '\0';
+      if (ftruncate(fileno(p_file), 0) == -1)
+      {
+         printf("Can not truncate %s\n", path);
+      }
+      fclose(p_file);
+   }
+
+   char what[600];
+   snprintf(what, sizeof(what), "%s is \"%s\" (\"%s\")", fileName, expected, content);
+   checkTrue(p_file && !strcmp(content, expected), what);
+}
+
+//----------------------------------------------------------------------------
+// Create directory and empty files in it, file names are NULL terminated
+//----------------------------------------------------------------------------
+static bool makeFakeDir(const char* dir, const char* subDir, const char* const* fileNames)
+{
+   char path[512];
+   snprintf(path, sizeof(path), "%s/%s", dir, subDir);
+   if (mkdir(path, 0755) == -1)
+   {
+      printf("Can not create %s\n", path);
+      return false;
+   }
+   for (; *fileNames; fileNames++)
+   {
+      snprintf(path, sizeof(path), "%s/%s/%s", dir, subDir, *fileNames);
+      FILE* p_file = fopen(path, "w");
+      if (!p_file)
+      {
+         printf("Can not create %s\n", path);
+         return false;
+      }
+      fclose(p_file);
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Write content to file of fake tree
+//----------------------------------------------------------------------------
+static bool writeFakeFile(const char* dir, const char* fileName, const char* content)
+{
+   char path[512];
+   snprintf(path, sizeof(path), "%s/%s", dir, fileName);
+   FILE* p_file = fopen(path, "w");
+   if (!p_file)
+   {
+      printf("Can not create %s\n", path);
+      return false;
+   }
+   fputs(content, p_file);
+   fclose(p_file);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Callback of nftw() to remove one entry of temporary directory
+//----------------------------------------------------------------------------
+static int removeEntry(const char* path, const struct stat* p_stat, int flag, struct FTW* p_ftw)
+{
+   return remove(path);
+}
+
+//================================================================================================//
+//                                           SYSFS GPIO                                           //
+//================================================================================================//
+
+//----------------------------------------------------------------------------
+// Check sysfs backend: pins are set as output-high at start, only changed
+// pins are written, pin which can not blink is kept on and removed pin is
+// turned off when set of pins is changed
+//----------------------------------------------------------------------------
+static void checkSysfs(const char* dir)
+{
+   static const char* const pinFiles[] = {"direction", "value", NULL};
+   printf("== sysfs gpio\n");
+   if (!makeFakeDir(dir, "gpio5", pinFiles) || !makeFakeDir(dir, "gpio6", pinFiles) ||
+       !makeFakeDir(dir, "gpio7", pinFiles))
+   {
+      checkTrue(false, "fake sysfs tree is created");
+      return;
+   }
+
+   checkTrue(gpioInit("sysfs", dir, CHECK_BLINK_MS) && gpioRequestPin(5, NULL) &&
+             gpioRequestPin(6, NULL) && gpioStart(), "pins are requested");
+   checkFile(dir, "gpio5/direction", "high");
+   checkFile(dir, "gpio6/direction", "high");
+   checkFile(dir, "gpio5/value", "");
+   checkTrue(!gpioCanBlink(), "sysfs can not blink");
+
+   gpioSetValue(5, 0);
+   gpioSetValue(6, 1);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "gpio5/value", "0");
+   checkFile(dir, "gpio6/value", "");
+
+   gpioSetValue(5, 0);
+   gpioSetValue(6, GPIO_BLINK);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "gpio5/value", "");
+   checkFile(dir, "gpio6/value", "0");
+
+   unsigned int pins[] = {6, 7};
+   const char* ledNames[] = {NULL, NULL};
+   checkTrue(gpioUpdatePins(pins, ledNames, 2), "pins are changed");
+   checkFile(dir, "gpio5/value", "1");
+   checkFile(dir, "gpio6/value", "");
+   checkFile(dir, "gpio6/direction", "");
+   checkFile(dir, "gpio7/direction", "high");
+
+   gpioSetValue(5, 0);
+   gpioSetValue(7, 0);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "gpio5/value", "");
+   checkFile(dir, "gpio7/value", "0");
+   gpioCleanup();
+
+   unsigned int missingPins[] = {6, 8};
+   checkTrue(gpioInit("sysfs", dir, CHECK_BLINK_MS) && gpioRequestPin(6, NULL) && gpioStart() &&
+             !gpioUpdatePins(missingPins, ledNames, 2), "pin without gpioN files is refused");
+   gpioSetValue(6, 0);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "gpio6/value", "0");
+   gpioCleanup();
+}
+
+//================================================================================================//
+//                                           LED CLASS                                            //
+//================================================================================================//
+
+//----------------------------------------------------------------------------
+// Check led class backend: leds are turned off at start, brightness is
+// max_brightness (1 if led has no max_brightness), blinking is handed off to
+// timer trigger once and leds of removed pins are turned off
+//----------------------------------------------------------------------------
+static void checkLedClass(const char* dir)
+{
+   static const char* const ledFiles[] = {"brightness", "trigger", "delay_on", "delay_off", NULL};
+   printf("== led class\n");
+   if (!makeFakeDir(dir, "red:status", ledFiles) || !makeFakeDir(dir, "gpio6", ledFiles) ||
+       !writeFakeFile(dir, "red:status/max_brightness", "255\n"))
+   {
+      checkTrue(false, "fake led class tree is created");
+      return;
+   }
+
+   checkTrue(gpioInit("ledclass", dir, CHECK_BLINK_MS) && gpioRequestPin(5, "red:status") &&
+             gpioRequestPin(6, NULL) && gpioStart(), "leds are requested");
+   checkTrue(gpioCanBlink(), "led class can blink");
+   checkFile(dir, "red:status/trigger", "none");
+   checkFile(dir, "red:status/brightness", "0");
+   checkFile(dir, "gpio6/trigger", "none");
+   checkFile(dir, "gpio6/brightness", "0");
+
+   gpioSetValue(5, 0);
+   gpioSetValue(6, 0);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "red:status/brightness", "255");
+   checkFile(dir, "gpio6/brightness", "1");
+
+   gpioSetValue(5, GPIO_BLINK);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "red:status/trigger", "timer");
+   checkFile(dir, "red:status/delay_on", "500");
+   checkFile(dir, "red:status/delay_off", "500");
+   checkFile(dir, "red:status/brightness", "");
+   checkFile(dir, "gpio6/brightness", "");
+
+   // Led keeps blinking without any write
+   gpioSetValue(5, GPIO_BLINK);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "red:status/trigger", "");
+   checkFile(dir, "red:status/delay_on", "");
+
+   gpioSetValue(5, 1);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "red:status/trigger", "none");
+   checkFile(dir, "red:status/brightness", "0");
+
+   gpioSetValue(5, GPIO_BLINK);
+   checkTrue(gpioCommit(), "frame is committed");
+   checkFile(dir, "red:status/trigger", "timer");
+   unsigned int pins[] = {6};
+   const char* ledNames[] = {NULL};
+   checkTrue(gpioUpdatePins(pins, ledNames, 1), "leds are changed");
+   checkFile(dir, "red:status/trigger", "none");
+   checkFile(dir, "red:status/brightness", "0");
+   checkFile(dir, "gpio6/trigger", "");
+   checkFile(dir, "gpio6/brightness", "");
+   gpioCleanup();
+}
+
+//================================================================================================//
+//                                          JENKINS_HOME                                          //
+//================================================================================================//
+
+//----------------------------------------------------------------------------
+// Check color of job which is read from JENKINS_HOME
+// number is number of the latest build, 0 if job does not have any build
+//----------------------------------------------------------------------------
+static void checkHomeJob(const char* homeDir, const char* jobName, const char* color,
+                         long long number)
+{
+   char jobDir[512];
+   JsonJobEntryT entry;
+   char what[600];
+   bool isRead = homeJobDir(homeDir, "/job/", jobName, jobDir, sizeof(jobDir)) &&
+                 homeReadJob(jobDir, &entry);
+   snprintf(what, sizeof(what), "%s is %s #%lld (%s #%lld)", jobName, color, number,
+            isRead ? entry.color : "not read", isRead ? entry.number : 0);
+   checkTrue(isRead && !strcmp(entry.name, jobName) && !strcmp(entry.color, color) &&
+             (entry.number == number), what);
+}
+
+//----------------------------------------------------------------------------
+// Create job of fake JENKINS_HOME with its builds, results[n - 1] is result
+// of build n, "" if build is running
+//----------------------------------------------------------------------------
+static bool makeFakeJob(const char* homeDir, const char* jobName, const char* disabled,
+                        const char* const* results, unsigned int buildCount)
+{
+   char path[512];
+   char content[256];
+   snprintf(path, sizeof(path), "jobs/%s", jobName);
+   if (!makeFakeDir(homeDir, path, (const char* const[]){NULL}))
+   {
+      return false;
+   }
+   snprintf(path, sizeof(path), "jobs/%s/builds", jobName);
+   if (!makeFakeDir(homeDir, path, (const char* const[]){NULL}))
+   {
+      return false;
+   }
+   snprintf(path, sizeof(path), "jobs/%s/config.xml", jobName);
+   snprintf(content, sizeof(content), "<?xml version='1.0' encoding='UTF-8'?>\n<project>\n"
+            "  <disabled>%s</disabled>\n</project>\n", disabled);
+   if (!writeFakeFile(homeDir, path, content))
+   {
+      return false;
+   }
+   snprintf(path, sizeof(path), "jobs/%s/nextBuildNumber", jobName);
+   snprintf(content, sizeof(content), "%u\n", buildCount + 1);
+   if (!writeFakeFile(homeDir, path, content))
+   {
+      return false;
+   }
+
+   unsigned int number;
+   for (number = 1; number <= buildCount; number++)
+   {
+      snprintf(path, sizeof(path), "jobs/%s/builds/%u", jobName, number);
+      if (!makeFakeDir(homeDir, path, (const char* const[]){NULL}))
+      {
+         return false;
+      }
+      snprintf(path, sizeof(path), "jobs/%s/builds/%u/build.xml", jobName, number);
+      snprintf(content, sizeof(content), "<?xml version='1.0' encoding='UTF-8'?>\n<build>\n"
+               "  <timestamp>1449%09u</timestamp>\n%s%s%s</build>\n", number,
+               results[number - 1][0] ? "  <result>" : "", results[number - 1],
+               results[number - 1][0] ? "</result>\n" : "");
+      if (!writeFakeFile(homeDir, path, content))
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Check JENKINS_HOME data source: jobs of example home have the color of
+// their latest build, running build blinks with color of last finished
+// build and disabled job is disabled whatever its builds are
+//----------------------------------------------------------------------------
+static void checkHome(const char* exampleHome, const char* dir)
+{
+   printf("== JENKINS_HOME %s\n", exampleHome);
+   checkHomeJob(exampleHome, "cphw_1", "blue", 23);
+   checkHomeJob(exampleHome, "cphw_2", "blue", 8);
+   checkHomeJob(exampleHome, "cphw_3", "blue", 6);
+   checkHomeJob(exampleHome, "pes_1", "blue", 8);
+   checkHomeJob(exampleHome, "pes_2", "red", 7);
+   checkHomeJob(exampleHome, "plex_1", "blue", 24);
+
+   printf("== JENKINS_HOME %s\n", dir);
+   static const char* const runningResults[] = {"SUCCESS", "FAILURE", ""};
+   static const char* const unstableResults[] = {"UNSTABLE"};
+   static const char* const abortedResults[] = {"ABORTED"};
+   if (!makeFakeDir(dir, "jobs", (const char* const[]){NULL}) ||
+       !makeFakeJob(dir, "running", "false", runningResults, 3) ||
+       !makeFakeJob(dir, "unstable", "false", unstableResults, 1) ||
+       !makeFakeJob(dir, "aborted", "false", abortedResults, 1) ||
+       !makeFakeJob(dir, "disabled", "true", runningResults, 2) ||
+       !makeFakeJob(dir, "notbuilt", "false", NULL, 0))
+   {
+      checkTrue(false, "fake JENKINS_HOME is created");
+      return;
+   }
+   checkHomeJob(dir, "running", "red_anime", 3);
+   checkHomeJob(dir, "unstable", "yellow", 1);
+   checkHomeJob(dir, "aborted", "aborted", 1);
+   checkHomeJob(dir, "disabled", "disabled", 2);
+   checkHomeJob(dir, "notbuilt", "notbuilt", 0);
+}
+
+//================================================================================================//
+//                                         CIRCUIT BREAKER                                        //
+//================================================================================================//
+
+//----------------------------------------------------------------------------
+// Check circuit breaker: it is opened by consecutive failures, lets one probe
+// through at probe time and is closed by answered probe. Canceled probe opens
+// it again with probe time now, so server is probed again at once.
+//----------------------------------------------------------------------------
+static void checkBreaker(void)
+{
+   BreakerT* p_headBreaker = NULL;
+   long long nowNs = 1000000000LL;
+   printf("== circuit breaker\n");
+   BreakerT* p_breaker = breakerFind(&p_headBreaker, "127.0.0.1:8080", 5000);
+   if (!p_breaker)
+   {
+      checkTrue(false, "breaker is created");
+      return;
+   }
+   checkTrue(breakerFind(&p_headBreaker, "127.0.0.1:8080", 5000) == p_breaker,
+             "breaker is shared by server name");
+
+   unsigned int idx;
+   for (idx = 0; idx < BREAKER_TRIP_FAILURES; idx++)
+   {
+      checkTrue(breakerAllow(p_breaker, nowNs), "request is allowed while closed");
+      breakerRecord(p_breaker, false, false, 0, nowNs);
+   }
+   checkTrue(p_breaker->state == BREAKER_OPEN, "breaker is opened by failures");
+   checkTrue(!breakerAllow(p_breaker, nowNs), "request is rejected while open");
+   long long probeNs = breakerRetryNs(p_breaker, nowNs);
+   checkTrue(probeNs == nowNs + BREAKER_MIN_PROBE_MS * 1000000LL, "probe is after probe delay");
+
+   // Probe is canceled, e.g. by reload
+   checkTrue(breakerAllow(p_breaker, probeNs), "probe is allowed at probe time");
+   checkTrue(p_breaker->state == BREAKER_HALF_OPEN, "breaker is half open while probing");
+   checkTrue(!breakerAllow(p_breaker, probeNs), "only one probe is allowed");
+   breakerCancel(p_breaker, probeNs + 10);
+   checkTrue(p_breaker->state == BREAKER_OPEN, "canceled probe opens breaker");
+   checkTrue(breakerRetryNs(p_breaker, probeNs + 20) == probeNs + 10,
+             "server is probed again at once");
+   checkTrue(breakerAllow(p_breaker, probeNs + 20), "new probe is allowed");
+   breakerRecord(p_breaker, true, false, 2000000LL, probeNs + 30);
+   checkTrue(p_breaker->state == BREAKER_CLOSED, "answered probe closes breaker");
+
+   breakerCancel(p_breaker, probeNs + 40);
+   checkTrue(p_breaker->state == BREAKER_CLOSED, "canceled request keeps breaker closed");
+   checkTrue(breakerAllow(p_breaker, probeNs + 40), "request is allowed while closed");
+   breakerFreeAll(&p_headBreaker);
+}
+
+//================================================================================================//
+//                                         JSON EXTRACTOR                                         //
+//================================================================================================//
+
+//----------------------------------------------------------------
+// Jobs which are extracted from a payload
+//----------------------------------------------------------------
+typedef struct checkJobs
+{
+   JsonJobEntryT entries[CHECK_MAX_JOBS];
+   unsigned int count;
+   bool isOverflow;
+}CheckJobsT;
+
+//----------------------------------------------------------------
+// Payload and jobs which must be extracted from it
+//----------------------------------------------------------------
+typedef struct checkJson
+{
+   const char* name;
+   const char* payload;
+   JsonJobEntryT expected[CHECK_MAX_JOBS];
+   unsigned int count;
+}CheckJsonT;
+
+//----------------------------------------------------------------------------
+// Callback of extractor, collect job
+//----------------------------------------------------------------------------
+static void collectJob(void* p_arg, const JsonJobEntryT* p_entry)
+{
+   CheckJobsT* p_jobs = (CheckJobsT*)p_arg;
+   if (p_jobs->count == CHECK_MAX_JOBS)
+   {
+      p_jobs->isOverflow = true;
+      return;
+   }
+   p_jobs->entries[p_jobs->count++] = *p_entry;
+}
+
+//----------------------------------------------------------------------------
+// Compare fields of extracted job with expected one
+// return NULL if they are the same, name of first different field if not
+//----------------------------------------------------------------------------
+static const char* diffJob(const JsonJobEntryT* p_job, const JsonJobEntryT* p_expected)
+{
+   if (strcmp(p_job->name, p_expected->name))           return "name";
+   if (strcmp(p_job->color, p_expected->color))         return "color";
+   if (p_job->timestamp != p_expected->timestamp)       return "timestamp";
+   if (p_job->number != p_expected->number)             return "number";
+   if (strcmp(p_job->result, p_expected->result))       return "result";
+   if (strcmp(p_job->phase, p_expected->phase))         return "phase";
+   if (strcmp(p_job->url, p_expected->url))             return "url";
+   if (strcmp(p_job->fullUrl, p_expected->fullUrl))     return "fullUrl";
+   return NULL;
+}
+
+//----------------------------------------------------------------------------
+// Feed payload to extractor in chunks which end at splits, chunkSize > 0
+// splits payload into chunks of this size instead
+// return NULL if expected jobs are extracted, else what is wrong
+//----------------------------------------------------------------------------
+static const char* extractJobs(const CheckJsonT* p_case, size_t split, size_t chunkSize,
+                               char* what, size_t whatSize)
+{
+   CheckJobsT jobs;
+   JsonExtractorT extractor;
+   memset(&jobs, 0, sizeof(jobs));
+   jsonExtractorInit(&extractor, collectJob, &jobs);
+
+   size_t len = strlen(p_case->payload);
+   size_t pos = 0;
+   bool isFed = true;
+   while (isFed && (pos < len))
+   {
+      size_t end = chunkSize ? pos + chunkSize : ((pos < split) ? split : len);
+      end = (end > len) ? len : end;
+      isFed = jsonExtractorFeed(&extractor, p_case->payload + pos, end - pos);
+      pos = end;
+   }
+   if (!isFed || !jsonExtractorFinish(&extractor))
+   {
+      return "payload is not extracted";
+   }
+   if (jobs.isOverflow || (jobs.count != p_case->count))
+   {
+      snprintf(what, whatSize, "%u jobs are extracted instead of %u", jobs.count,
+               p_case->count);
+      return what;
+   }
+   unsigned int idx;
+   for (idx = 0; idx < jobs.count; idx++)
+   {
+      const char* field = diffJob(&jobs.entries[idx], &p_case->expected[idx]);
+      if (field)
+      {
+         snprintf(what, whatSize, "%s of job %u is wrong (name \"%s\" color \"%s\" "
+                  "result \"%s\" number %lld)", field, idx, jobs.entries[idx].name,
+                  jobs.entries[idx].color, jobs.entries[idx].result, jobs.entries[idx].number);
+         return what;
+      }
+   }
+   return NULL;
+}
+
+//----------------------------------------------------------------------------
+// Check that the same jobs are extracted however payload is split
+//----------------------------------------------------------------------------
+static void checkJsonCase(const CheckJsonT* p_case)
+{
+   char what[600];
+   char detail[400];
+   size_t len = strlen(p_case->payload);
+   const char* p_error = extractJobs(p_case, len, 0, detail, sizeof(detail));
+   snprintf(what, sizeof(what), "%s: whole payload%s%s", p_case->name,
+            p_error ? ", " : "", p_error ? p_error : "");
+   checkTrue(!p_error, what);
+
+   size_t split;
+   p_error = NULL;
+   for (split = 1; !p_error && (split < len); split++)
+   {
+      p_error = extractJobs(p_case, split, 0, detail, sizeof(detail));
+   }
+   snprintf(what, sizeof(what), "%s: split at every byte%s%s%s%zu", p_case->name,
+            p_error ? ", " : "", p_error ? p_error : "", p_error ? " at " : " of ",
+            p_error ? split - 1 : len);
+   checkTrue(!p_error, what);
+
+   p_error = extractJobs(p_case, 0, 1, detail, sizeof(detail));
+   snprintf(what, sizeof(what), "%s: byte by byte%s%s", p_case->name,
+            p_error ? ", " : "", p_error ? p_error : "");
+   checkTrue(!p_error, what);
+}
+
+//----------------------------------------------------------------------------
+// Check json extractor: fields of jobs in responses of tree query, query of
+// one job and build notification, escapes in strings, "result": null of
+// running build, containers which are skipped and broken payloads
+//----------------------------------------------------------------------------
+static void checkJson(void)
+{
+   printf("== json extractor (%s)\n",
+#if defined(JSON_NO_SIMD)
+          "scalar"
+#else
+          "simd"
+#endif
+          );
+
+   static const CheckJsonT cases[] =
+   {
+      {
+         "tree",
+         "{\"_class\":\"hudson.model.Hudson\",\"jobs\":["
+         "{\"_class\":\"hudson.model.FreeStyleProject\",\"name\":\"cphw_1\",\"color\":\"blue\","
+         "\"lastBuild\":{\"_class\":\"hudson.model.FreeStyleBuild\",\"building\":false,"
+         "\"number\":23,\"result\":\"SUCCESS\",\"timestamp\":1449057130000}},"
+         "{\"_class\":\"hudson.model.FreeStyleProject\",\"name\":\"pes_2\",\"color\":\"red_anime\","
+         "\"lastBuild\":{\"_class\":\"hudson.model.FreeStyleBuild\",\"building\":true,"
+         "\"number\":8,\"result\":null,\"timestamp\":1449057230000}},"
+         "{\"name\":\"plex_1\",\"color\":\"notbuilt\",\"lastBuild\":null}"
+         "]}",
+         {
+            {"cphw_1", "blue", 1449057130000LL, 23, "SUCCESS"},
+            {"pes_2", "red_anime", 1449057230000LL, 8, ""},
+            {"plex_1", "notbuilt", 0, 0, ""}
+         },
+         3
+      },
+      {
+         "escapes",
+         " {\"jobs\" : [ {\"name\":\"0123456789abcd\\\"quoted\\\" \\\\back\\\\slash\\\\\","
+         "\"color\":\"yel\\u006cow\",\"lastBuild\":{\"result\":\"FAIL\\\\URE\",\"number\":-1}},"
+         "{\"description\":\"\\\"name\\\":\\\"fake\\\",{[\\\\\",\"name\":\"a\\/b\\tc\","
+         "\"color\":\"\\\\\"}\n]\n}\n",
+         {
+            {"0123456789abcd\"quoted\" \\back\\slash\\", "yel?ow", 0, -1, "FAIL\\URE"},
+            {"a/b\tc", "\\", 0, 0, ""}
+         },
+         2
+      },
+      {
+         "skipped containers",
+         "{\"jobs\":[{\"actions\":[{\"_class\":\"hudson.model.CauseAction\",\"name\":\"fake\","
+         "\"causes\":[{\"shortDescription\":\"Started by \\\"timer\\\" }]\"}]},{},[]],"
+         "\"healthReport\":{\"name\":\"fake\",\"color\":\"red\",\"score\":100},"
+         "\"name\":\"cphw_2\",\"property\":[[[{\"result\":\"FAILURE\"}]]],\"color\":\"aborted\","
+         "\"lastBuild\":{\"changeSet\":{\"items\":[{\"msg\":\"fix {\"}],\"result\":\"FAILURE\"},"
+         "\"number\":9,\"artifacts\":[],\"result\":\"ABORTED\",\"url\":\"http://h/job/x/9/\"}},"
+         "{\"_class\":\"com.cloudbees.hudson.plugins.folder.Folder\",\"jobs\":[{\"name\":\"inner\"}],"
+         "\"name\":\"folder\"}],\"views\":[{\"name\":\"all\",\"color\":\"blue\"}]}",
+         {
+            {"cphw_2", "aborted", 0, 9, "ABORTED"},
+            {"folder", "", 0, 0, ""}
+         },
+         2
+      },
+      {
+         "one job",
+         "{\"_class\":\"hudson.model.FreeStyleProject\",\"name\":\"cphw_3\","
+         "\"url\":\"http://host:8080/job/cphw_3/\",\"color\":\"disabled\"}",
+         {
+            {"cphw_3", "disabled", 0, 0, "", "", "http://host:8080/job/cphw_3/"}
+         },
+         1
+      },
+      {
+         "last build",
+         "{\"_class\":\"hudson.model.FreeStyleBuild\",\"number\":24,\"result\":null,"
+         "\"timestamp\":1449057330000}",
+         {
+            {"", "", 1449057330000LL, 24, ""}
+         },
+         1
+      },
+      {
+         "notification",
+         "{\"name\":\"pes_1\",\"url\":\"job/pes_1/\",\"build\":{\"full_url\":"
+         "\"http://host:8080/job/pes_1/9/\",\"number\":9,\"phase\":\"COMPLETED\","
+         "\"status\":\"FAILURE\",\"url\":\"job/pes_1/9/\",\"timestamp\":1449057430000,"
+         "\"scm\":{\"changes\":[],\"culprits\":[]}}}",
+         {
+            {"pes_1", "", 1449057430000LL, 9, "FAILURE", "COMPLETED", "job/pes_1/",
+             "http://host:8080/job/pes_1/9/"}
+         },
+         1
+      }
+   };
+   unsigned int idx;
+   for (idx = 0; idx < sizeof(cases) / sizeof(cases[0]); idx++)
+   {
+      checkJsonCase(&cases[idx]);
+   }
+
+   static const char* const brokenPayloads[] =
+   {
+      "{\"jobs\":[{\"name\":\"cphw_1\"}]",
+      "{\"jobs\":[{\"name\":\"cphw_1}]}",
+      "{\"jobs\":[{\"name\":\"cphw_1\"]]}",
+      "{\"name\":\"cphw_1\"}{}"
+   };
+   for (idx = 0; idx < sizeof(brokenPayloads) / sizeof(brokenPayloads[0]); idx++)
+   {
+      CheckJobsT jobs;
+      JsonExtractorT extractor;
+      char what[200];
+      memset(&jobs, 0, sizeof(jobs));
+      jsonExtractorInit(&extractor, collectJob, &jobs);
+      bool isExtracted = jsonExtractorFeed(&extractor, brokenPayloads[idx],
+                                           strlen(brokenPayloads[idx])) &&
+                         jsonExtractorFinish(&extractor);
+      snprintf(what, sizeof(what), "broken payload %u is refused", idx);
+      checkTrue(!isExtracted, what);
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   setvbuf(stdout, NULL, _IOLBF, 0);
+
+   char tmpDir[] = CHECK_TMP_DIR;
+   if (!mkdtemp(tmpDir))
+   {
+      printf("Can not create %s\n", tmpDir);
+      return 1;
+   }
+
+   char dir[512];
+   snprintf(dir, sizeof(dir), "%s/gpio", tmpDir);
+   if (mkdir(dir, 0755) == 0)
+   {
+      checkSysfs(dir);
+   }
+   else
+   {
+      checkTrue(false, "fake sysfs tree is created");
+   }
+
+   snprintf(dir, sizeof(dir), "%s/leds", tmpDir);
+   if (mkdir(dir, 0755) == 0)
+   {
+      checkLedClass(dir);
+   }
+   else
+   {
+      checkTrue(false, "fake led class tree is created");
+   }
+
+   snprintf(dir, sizeof(dir), "%s/home", tmpDir);
+   if (mkdir(dir, 0755) == 0)
+   {
+      checkHome((argc > 1) ? argv[1] : CHECK_EXAMPLE_HOME, dir);
+   }
+   else
+   {
+      checkTrue(false, "fake JENKINS_HOME is created");
+   }
+
+   checkBreaker();
+   checkJson();
+
+   nftw(tmpDir, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+   printf("%u checks failed\n", s_failCount);
+   return s_failCount;
+}
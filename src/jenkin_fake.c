@@ -0,0 +1,1219 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <dirent.h>
+#include <signal.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "jenkin_http.h"
+
+//--------------------------------------------------------------------------------------------------
+// Fake jenkins server and end-to-end latency harness of jenkin_mon
+//
+// Server: serves job status like jenkins does, from a JENKINS_HOME tree (e.g.
+// ../jenkinJobsExample) or from synthetic jobs
+//    GET  /job/<name>/api/json                 -> name, color
+//    GET  /job/<name>/lastBuild/api/json       -> timestamp, result (404 if never built)
+//    GET  /api/json?tree=jobs[...]             -> all jobs (aggregate mode of jenkin_mon)
+//    POST /fake/job/<name>?color=red[&result=FAILURE]  -> change job now
+//    POST /fake/server?delay=MS&drop=PERCENT           -> slow or broken server now
+// Api request which is dropped gets no response, its connection is closed.
+// Changes can also be scripted in a file, one change per line:
+//    <ms after start> <job> <color> [result]
+// Each change is printed as "<monotonic ns> change <job> <color>", and posted
+// to hook of jenkin_mon (--notify) like notification plugin of jenkins.
+//    $./jenkin_fake --home ../jenkinJobsExample --port 8080
+//    $./jenkin_fake --jobs 500 --script changes.txt --delay 50 --notify localhost:8081
+//    $./jenkin_fake --home ../jenkinJobsExample --drop 30
+//
+// Harness: runs jenkin_mon against fake server with mock gpio, changes one job
+// of a group at a time and measures time from the change to the led frame in
+// mock gpio log (both are CLOCK_MONOTONIC)
+//    $./jenkin_fake --latency 1,10,100,1000 --mode poll|aggregate|hook
+//--------------------------------------------------------------------------------------------------
+
+#define FAKE_NAME_SIZE      128
+#define FAKE_REQUEST_SIZE   8192
+
+// Harness: leds of at most this number of groups (3 pins per group)
+#define FAKE_MAX_GROUPS     80
+#define FAKE_SETTLE_TIMEOUT 60          // in second, all groups show success
+#define FAKE_CHANGE_TIMEOUT 15          // in second, led shows a change
+
+//----------------------------------------------------------------
+// Job that is served
+//----------------------------------------------------------------
+typedef struct fakeJob
+{
+   char name[FAKE_NAME_SIZE];
+   char color[32];
+   char result[16];                 // "" -> never built, "null" -> building
+   unsigned long long timestamp;    // start of last build in ms
+}FakeJobT;
+
+//----------------------------------------------------------------
+// Fake jenkins server, jobs are sorted by name and protected by lock
+//----------------------------------------------------------------
+typedef struct fakeServer
+{
+   FakeJobT* p_jobs;
+   unsigned int jobCount;
+   pthread_mutex_t lock;
+   unsigned int delayMs;            // before each api response, atomic
+   unsigned int dropPercent;        // api requests which are dropped, atomic
+   const char* notifyAddr;          // hook of jenkin_mon, NULL if not have
+   char rootUrl[64];                // of fake jenkins in notifications, e.g. "http://127.0.0.1:8080"
+   int listenFd;
+   unsigned long long requestCount; // atomic
+}FakeServerT;
+
+static FakeServerT s_server;
+
+//----------------------------------------------------------------------------
+// Get monotonic time in nano second
+//----------------------------------------------------------------------------
+static long long nowNs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------------
+// Get wall clock time in milli second, timestamp of builds
+//----------------------------------------------------------------------------
+static unsigned long long wallMs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   return (unsigned long long)ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+//----------------------------------------------------------------------------
+// Sleep in milli second
+//----------------------------------------------------------------------------
+static void sleepMs(unsigned int ms)
+{
+   struct timespec ts;
+   ts.tv_sec = ms / 1000;
+   ts.tv_nsec = (ms % 1000) * 1000000L;
+   while (nanosleep(&ts, &ts) && (errno == EINTR));
+}
+
+//----------------------------------------------------------------------------
+// Compare jobs by name, for qsort and bsearch
+//----------------------------------------------------------------------------
+static int compareJob(const void* p_left, const void* p_right)
+{
+   return strcmp(((const FakeJobT*)p_left)->name, ((const FakeJobT*)p_right)->name);
+}
+
+//----------------------------------------------------------------------------
+// Find job by name
+// Note: lock must be held
+//----------------------------------------------------------------------------
+static FakeJobT* findJob(const char* name)
+{
+   FakeJobT key;
+   snprintf(key.name, sizeof(key.name), "%s", name);
+   return bsearch(&key, s_server.p_jobs, s_server.jobCount, sizeof(FakeJobT), compareJob);
+}
+
+//----------------------------------------------------------------------------
+// Get result of last build from color of job
+//----------------------------------------------------------------------------
+static const char* resultOfColor(const char* color)
+{
+   if (strstr(color, "_anime"))
+   {
+      return "null";
+   }
+   if (!strcmp(color, "blue"))
+   {
+      return "SUCCESS";
+   }
+   if (!strcmp(color, "red"))
+   {
+      return "FAILURE";
+   }
+   if (!strcmp(color, "yellow"))
+   {
+      return "UNSTABLE";
+   }
+   if (!strcmp(color, "aborted"))
+   {
+      return "ABORTED";
+   }
+   return "";
+}
+
+//----------------------------------------------------------------------------
+// Get color of job from result of its last build
+//----------------------------------------------------------------------------
+static const char* colorOfResult(const char* result)
+{
+   if (!strcmp(result, "SUCCESS"))
+   {
+      return "blue";
+   }
+   if (!strcmp(result, "FAILURE"))
+   {
+      return "red";
+   }
+   if (!strcmp(result, "UNSTABLE"))
+   {
+      return "yellow";
+   }
+   if (!strcmp(result, "ABORTED"))
+   {
+      return "aborted";
+   }
+   return "notbuilt";
+}
+
+//----------------------------------------------------------------------------
+// Get text of xml element in file, "" if element is not found
+//----------------------------------------------------------------------------
+static void xmlElementOfFile(const char* fileName, const char* element, char* value,
+                             size_t valueSize)
+{
+   char line[1024];
+   char startTag[64];
+   snprintf(startTag, sizeof(startTag), "<%s>", element);
+   value[0] = 0;
+   FILE* p_file = fopen(fileName, "r");
+   if (!p_file)
+   {
+      return;
+   }
+   while (fgets(line, sizeof(line), p_file))
+   {
+      char* p_start = strstr(line, startTag);
+      if (p_start)
+      {
+         p_start += strlen(startTag);
+         char* p_end = strchr(p_start, '<');
+         if (p_end)
+         {
+            *p_end = 0;
+         }
+         snprintf(value, valueSize, "%s", p_start);
+         break;
+      }
+   }
+   fclose(p_file);
+}
+
+//----------------------------------------------------------------------------
+// Load jobs from <home>/jobs/<name>/builds/<number>/build.xml, status of job
+// is its build with the highest number
+//----------------------------------------------------------------------------
+static bool loadHomeJobs(const char* homeDir)
+{
+   char path[1024];
+   snprintf(path, sizeof(path), "%s/jobs", homeDir);
+   DIR* p_jobsDir = opendir(path);
+   if (!p_jobsDir)
+   {
+      printf("Can not open %s: %s\n", path, strerror(errno));
+      return false;
+   }
+
+   unsigned int size = 0;
+   struct dirent* p_jobEntry;
+   while ((p_jobEntry = readdir(p_jobsDir)))
+   {
+      if ((p_jobEntry->d_name[0] == '.') || (strlen(p_jobEntry->d_name) >= FAKE_NAME_SIZE))
+      {
+         continue;
+      }
+      if (s_server.jobCount == size)
+      {
+         size = size ? size * 2 : 64;
+         s_server.p_jobs = realloc(s_server.p_jobs, size * sizeof(FakeJobT));
+      }
+      FakeJobT* p_job = &s_server.p_jobs[s_server.jobCount++];
+      memset(p_job, 0, sizeof(FakeJobT));
+      strcpy(p_job->name, p_jobEntry->d_name);
+      strcpy(p_job->color, "notbuilt");
+
+      snprintf(path, sizeof(path), "%s/jobs/%s/builds", homeDir, p_jobEntry->d_name);
+      DIR* p_buildsDir = opendir(path);
+      long lastNumber = 0;
+      struct dirent* p_buildEntry;
+      while (p_buildsDir && (p_buildEntry = readdir(p_buildsDir)))
+      {
+         char* p_end = NULL;
+         long number = strtol(p_buildEntry->d_name, &p_end, 10);
+         if ((p_end != p_buildEntry->d_name) && (*p_end == 0) && (number > lastNumber))
+         {
+            lastNumber = number;
+         }
+      }
+      if (p_buildsDir)
+      {
+         closedir(p_buildsDir);
+      }
+      if (lastNumber == 0)
+      {
+         continue;
+      }
+
+      char value[64];
+      snprintf(path, sizeof(path), "%s/jobs/%s/builds/%ld/build.xml",
+               homeDir, p_jobEntry->d_name, lastNumber);
+      xmlElementOfFile(path, "timestamp", value, sizeof(value));
+      p_job->timestamp = strtoull(value, NULL, 10);
+      xmlElementOfFile(path, "result", value, sizeof(value));
+      if (value[0])
+      {
+         snprintf(p_job->result, sizeof(p_job->result), "%s", value);
+         strcpy(p_job->color, colorOfResult(value));
+      }
+      else
+      {
+         // Build which does not have result is running
+         strcpy(p_job->result, "null");
+         strcpy(p_job->color, "blue_anime");
+      }
+   }
+   closedir(p_jobsDir);
+   qsort(s_server.p_jobs, s_server.jobCount, sizeof(FakeJobT), compareJob);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Make synthetic jobs, all of them are successful
+//----------------------------------------------------------------------------
+static void makeJobs(unsigned int jobCount)
+{
+   s_server.p_jobs = calloc(jobCount ? jobCount : 1, sizeof(FakeJobT));
+   s_server.jobCount = jobCount;
+   unsigned int idx;
+   for (idx = 0; idx < jobCount; idx++)
+   {
+      FakeJobT* p_job = &s_server.p_jobs[idx];
+      snprintf(p_job->name, sizeof(p_job->name), "job_%05u", idx);
+      strcpy(p_job->color, "blue");
+      strcpy(p_job->result, "SUCCESS");
+      p_job->timestamp = wallMs();
+   }
+}
+
+//----------------------------------------------------------------------------
+// Post build notification of job to hook of jenkin_mon, as notification
+// plugin of jenkins does
+//----------------------------------------------------------------------------
+static void notifyHook(const char* name, const char* color, const char* result)
+{
+   char host[256];
+   const char* p_colon = strrchr(s_server.notifyAddr, ':');
+   if (!p_colon || (p_colon - s_server.notifyAddr >= (long)sizeof(host)))
+   {
+      return;
+   }
+   memcpy(host, s_server.notifyAddr, p_colon - s_server.notifyAddr);
+   host[p_colon - s_server.notifyAddr] = 0;
+
+   char body[512];
+   bool isStarted = !strcmp(result, "null");
+   int bodyLen = snprintf(body, sizeof(body),
+                          "{\"name\":\"%s\",\"url\":\"job/%s/\",\"build\":{"
+                          "\"full_url\":\"%s/job/%s/1/\",\"number\":1,"
+                          "\"phase\":\"%s\",%s%s%s\"url\":\"job/%s/1/\"}}",
+                          name, name, s_server.rootUrl, name,
+                          isStarted ? "STARTED" : "COMPLETED",
+                          isStarted ? "" : "\"status\":\"", isStarted ? "" : result,
+                          isStarted ? "" : "\",", name);
+   char request[1024];
+   int len = snprintf(request, sizeof(request),
+                      "POST /jenkins HTTP/1.1\r\nHost: %s\r\n"
+                      "Content-Type: application/json\r\nContent-Length: %d\r\n"
+                      "Connection: close\r\n\r\n%s", s_server.notifyAddr, bodyLen, body);
+   (void)color;
+
+   struct addrinfo hints;
+   struct addrinfo* p_addrInfo = NULL;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   if (getaddrinfo(host, p_colon + 1, &hints, &p_addrInfo))
+   {
+      return;
+   }
+   int fd = socket(p_addrInfo->ai_family, p_addrInfo->ai_socktype | SOCK_CLOEXEC,
+                   p_addrInfo->ai_protocol);
+   if ((fd >= 0) && !connect(fd, p_addrInfo->ai_addr, p_addrInfo->ai_addrlen) &&
+       httpSendAll(fd, request, len))
+   {
+      // Wait for response, so that notification is handled before next one
+      char response[256];
+      ssize_t n = recv(fd, response, sizeof(response), 0);
+      (void)n;
+   }
+   if (fd >= 0)
+   {
+      close(fd);
+   }
+   freeaddrinfo(p_addrInfo);
+}
+
+//----------------------------------------------------------------------------
+// Change color (and result) of job, result is got from color if it is NULL
+// return monotonic time of change, 0 if job is not found
+//----------------------------------------------------------------------------
+static long long changeJob(const char* name, const char* color, const char* result)
+{
+   if (!result || !result[0])
+   {
+      result = resultOfColor(color);
+   }
+   pthread_mutex_lock(&s_server.lock);
+   FakeJobT* p_job = findJob(name);
+   long long changedNs = 0;
+   if (p_job)
+   {
+      snprintf(p_job->color, sizeof(p_job->color), "%s", color);
+      snprintf(p_job->result, sizeof(p_job->result), "%s", result);
+      p_job->timestamp = wallMs();
+      changedNs = nowNs();
+   }
+   pthread_mutex_unlock(&s_server.lock);
+
+   if (p_job && s_server.notifyAddr)
+   {
+      notifyHook(name, color, result);
+   }
+   return changedNs;
+}
+
+//----------------------------------------------------------------------------
+// Append json of last build of job
+//----------------------------------------------------------------------------
+static void appendLastBuild(HttpBufferT* p_body, const FakeJobT* p_job)
+{
+   char str[256];
+   int len;
+   if (!strcmp(p_job->result, "null"))
+   {
+      len = snprintf(str, sizeof(str),
+                     "{\"_class\":\"hudson.model.FreeStyleBuild\",\"result\":null,"
+                     "\"timestamp\":%llu}", p_job->timestamp);
+   }
+   else
+   {
+      len = snprintf(str, sizeof(str),
+                     "{\"_class\":\"hudson.model.FreeStyleBuild\",\"result\":\"%s\","
+                     "\"timestamp\":%llu}", p_job->result, p_job->timestamp);
+   }
+   httpBufferAppend(p_body, str, len);
+}
+
+//----------------------------------------------------------------------------
+// Build body of api request
+// return http status
+//----------------------------------------------------------------------------
+static int buildApiBody(const char* path, HttpBufferT* p_body)
+{
+   char str[512];
+   int len;
+   httpBufferReset(p_body);
+
+   if (!strncmp(path, "/api/json", 9))
+   {
+      pthread_mutex_lock(&s_server.lock);
+      len = snprintf(str, sizeof(str), "{\"_class\":\"hudson.model.Hudson\",\"jobs\":[");
+      httpBufferAppend(p_body, str, len);
+      unsigned int idx;
+      for (idx = 0; idx < s_server.jobCount; idx++)
+      {
+         const FakeJobT* p_job = &s_server.p_jobs[idx];
+         len = snprintf(str, sizeof(str),
+                        "%s{\"_class\":\"hudson.model.FreeStyleProject\","
+                        "\"name\":\"%s\",\"color\":\"%s\",\"lastBuild\":",
+                        idx ? "," : "", p_job->name, p_job->color);
+         httpBufferAppend(p_body, str, len);
+         if (p_job->result[0])
+         {
+            appendLastBuild(p_body, p_job);
+         }
+         else
+         {
+            httpBufferAppend(p_body, "null", 4);
+         }
+         httpBufferAppend(p_body, "}", 1);
+      }
+      httpBufferAppend(p_body, "]}", 2);
+      pthread_mutex_unlock(&s_server.lock);
+      return 200;
+   }
+
+   // /job/<name>/api/json or /job/<name>/lastBuild/api/json
+   if (strncmp(path, "/job/", 5))
+   {
+      return 404;
+   }
+   char name[FAKE_NAME_SIZE];
+   const char* p_name = path + 5;
+   const char* p_slash = strchr(p_name, '/');
+   if (!p_slash || (p_slash - p_name >= FAKE_NAME_SIZE))
+   {
+      return 404;
+   }
+   memcpy(name, p_name, p_slash - p_name);
+   name[p_slash - p_name] = 0;
+   bool isLastBuild = !strncmp(p_slash, "/lastBuild/api/json", 19);
+   if (!isLastBuild && strncmp(p_slash, "/api/json", 9))
+   {
+      return 404;
+   }
+
+   int status = 200;
+   pthread_mutex_lock(&s_server.lock);
+   const FakeJobT* p_job = findJob(name);
+   if (!p_job || (isLastBuild && !p_job->result[0]))
+   {
+      status = 404;
+   }
+   else if (isLastBuild)
+   {
+      appendLastBuild(p_body, p_job);
+   }
+   else
+   {
+      len = snprintf(str, sizeof(str),
+                     "{\"_class\":\"hudson.model.FreeStyleProject\","
+                     "\"name\":\"%s\",\"color\":\"%s\"}", p_job->name, p_job->color);
+      httpBufferAppend(p_body, str, len);
+   }
+   pthread_mutex_unlock(&s_server.lock);
+   return status;
+}
+
+//----------------------------------------------------------------------------
+// Get value of query parameter, "" if it is not found
+//----------------------------------------------------------------------------
+static void queryParam(const char* query, const char* name, char* value, size_t valueSize)
+{
+   size_t nameLen = strlen(name);
+   value[0] = 0;
+   const char* p_param = query;
+   while (p_param && *p_param)
+   {
+      if (!strncmp(p_param, name, nameLen) && (p_param[nameLen] == '='))
+      {
+         const char* p_value = p_param + nameLen + 1;
+         size_t len = strcspn(p_value, "& ");
+         if (len >= valueSize)
+         {
+            len = valueSize - 1;
+         }
+         memcpy(value, p_value, len);
+         value[len] = 0;
+         return;
+      }
+      p_param = strchr(p_param, '&');
+      if (p_param)
+      {
+         p_param++;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Handle control request POST /fake/job/<name>?color=X[&result=Y]
+// return http status, body is monotonic time of change
+//----------------------------------------------------------------------------
+static int handleControl(const char* path, HttpBufferT* p_body)
+{
+   char name[FAKE_NAME_SIZE];
+   char color[32];
+   char result[16];
+   httpBufferReset(p_body);
+   const char* p_name = path + strlen("/fake/job/");
+   size_t nameLen = strcspn(p_name, "?/ ");
+   const char* p_query = strchr(p_name, '?');
+   if ((nameLen == 0) || (nameLen >= sizeof(name)) || !p_query)
+   {
+      return 400;
+   }
+   memcpy(name, p_name, nameLen);
+   name[nameLen] = 0;
+   queryParam(p_query + 1, "color", color, sizeof(color));
+   queryParam(p_query + 1, "result", result, sizeof(result));
+   if (!color[0])
+   {
+      return 400;
+   }
+   long long changedNs = changeJob(name, color, result);
+   if (!changedNs)
+   {
+      return 404;
+   }
+   printf("%lld change %s %s\n", changedNs, name, color);
+   char str[32];
+   int len = snprintf(str, sizeof(str), "%lld\n", changedNs);
+   httpBufferAppend(p_body, str, len);
+   return 200;
+}
+
+//----------------------------------------------------------------------------
+// Handle control request which changes behavior of server:
+//    /fake/server?delay=200&drop=50
+// Parameter which is not given is not changed
+// return http status code
+//----------------------------------------------------------------------------
+static int handleServerControl(const char* path, HttpBufferT* p_body)
+{
+   char delay[16];
+   char drop[16];
+   httpBufferReset(p_body);
+   const char* p_query = strchr(path, '?');
+   if (!p_query)
+   {
+      return 400;
+   }
+   queryParam(p_query + 1, "delay", delay, sizeof(delay));
+   queryParam(p_query + 1, "drop", drop, sizeof(drop));
+   if (delay[0])
+   {
+      __atomic_store_n(&s_server.delayMs, (unsigned int)atoi(delay), __ATOMIC_SEQ_CST);
+   }
+   if (drop[0])
+   {
+      __atomic_store_n(&s_server.dropPercent, (unsigned int)atoi(drop), __ATOMIC_SEQ_CST);
+   }
+   printf("%lld server delay %u ms, drop %u%%\n", nowNs(),
+          __atomic_load_n(&s_server.delayMs, __ATOMIC_SEQ_CST),
+          __atomic_load_n(&s_server.dropPercent, __ATOMIC_SEQ_CST));
+   return 200;
+}
+
+//----------------------------------------------------------------------------
+// Check that api request is dropped: requests are spread by their count, so
+// exactly drop percent of every 100 requests are dropped
+//----------------------------------------------------------------------------
+static bool isDropped(unsigned long long requestCount)
+{
+   return (requestCount * 37) % 100 < __atomic_load_n(&s_server.dropPercent, __ATOMIC_SEQ_CST);
+}
+
+//----------------------------------------------------------------------------
+// Serve requests of one keep-alive connection
+//----------------------------------------------------------------------------
+static void* connectionThread(void* arg)
+{
+   int fd = (int)(intptr_t)arg;
+   char request[FAKE_REQUEST_SIZE + 1];
+   size_t len = 0;
+   HttpBufferT body;
+   memset(&body, 0, sizeof(body));
+
+   while (1)
+   {
+      char* p_headerEnd = NULL;
+      request[len] = 0;
+      while (!(p_headerEnd = strstr(request, "\r\n\r\n")))
+      {
+         if (len == FAKE_REQUEST_SIZE)
+         {
+            goto done;
+         }
+         ssize_t n = recv(fd, request + len, FAKE_REQUEST_SIZE - len, 0);
+         if ((n < 0) && (errno == EINTR))
+         {
+            continue;
+         }
+         if (n <= 0)
+         {
+            goto done;
+         }
+         len += n;
+         request[len] = 0;
+      }
+      size_t requestLen = p_headerEnd + 4 - request;
+
+      // Body of control request is not used, it is skipped
+      const char* p_lenStr = strcasestr(request, "\r\nContent-Length:");
+      if (p_lenStr && (p_lenStr < p_headerEnd))
+      {
+         requestLen += atol(p_lenStr + 17);
+         if (requestLen > FAKE_REQUEST_SIZE)
+         {
+            goto done;
+         }
+         while (len < requestLen)
+         {
+            ssize_t n = recv(fd, request + len, FAKE_REQUEST_SIZE - len, 0);
+            if (n <= 0)
+            {
+               goto done;
+            }
+            len += n;
+         }
+      }
+
+      char method[8];
+      char path[FAKE_REQUEST_SIZE];
+      if (sscanf(request, "%7s %8191s", method, path) != 2)
+      {
+         goto done;
+      }
+      bool isClose = (strcasestr(request, "\r\nConnection: close") != NULL);
+      int status;
+      if (!strcmp(method, "POST") && !strncmp(path, "/fake/job/", 10))
+      {
+         status = handleControl(path, &body);
+      }
+      else if (!strcmp(method, "POST") && !strncmp(path, "/fake/server", 12))
+      {
+         status = handleServerControl(path, &body);
+      }
+      else if (!strcmp(method, "GET"))
+      {
+         if (isDropped(__atomic_add_fetch(&s_server.requestCount, 1, __ATOMIC_SEQ_CST)))
+         {
+            goto done;
+         }
+         unsigned int delayMs = __atomic_load_n(&s_server.delayMs, __ATOMIC_SEQ_CST);
+         if (delayMs)
+         {
+            sleepMs(delayMs);
+         }
+         status = buildApiBody(path, &body);
+      }
+      else
+      {
+         status = 405;
+      }
+
+      char header[256];
+      int headerLen = snprintf(header, sizeof(header),
+                               "HTTP/1.1 %d %s\r\nContent-Type: application/json;charset=utf-8\r\n"
+                               "Content-Length: %zu\r\nConnection: %s\r\n\r\n",
+                               status, (status == 200) ? "OK" : "Error",
+                               (status == 200) ? body.len : 0, isClose ? "close" : "keep-alive");
+      if (!httpSendAll(fd, header, headerLen) ||
+          ((status == 200) && !httpSendAll(fd, body.p_data, body.len)) || isClose)
+      {
+         goto done;
+      }
+
+      // Pipelined request stays in buffer
+      memmove(request, request + requestLen, len - requestLen);
+      len -= requestLen;
+   }
+
+done:
+   httpBufferFree(&body);
+   close(fd);
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Accept connections, one thread per connection
+//----------------------------------------------------------------------------
+static void* acceptThread(void* arg)
+{
+   while (1)
+   {
+      int fd = accept4(s_server.listenFd, NULL, NULL, SOCK_CLOEXEC);
+      if (fd < 0)
+      {
+         if ((errno == EINTR) || (errno == ECONNABORTED))
+         {
+            continue;
+         }
+         break;
+      }
+      pthread_t thread;
+      pthread_attr_t attr;
+      pthread_attr_init(&attr);
+      pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+      if (pthread_create(&thread, &attr, connectionThread, (void*)(intptr_t)fd))
+      {
+         close(fd);
+      }
+      pthread_attr_destroy(&attr);
+   }
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Start fake server thread
+//----------------------------------------------------------------------------
+static bool startServer(const char* listenAddr)
+{
+   s_server.listenFd = httpListen(listenAddr);
+   if (s_server.listenFd < 0)
+   {
+      return false;
+   }
+   pthread_t thread;
+   if (pthread_create(&thread, NULL, acceptThread, NULL))
+   {
+      printf("Can not create accept thread\n");
+      return false;
+   }
+   pthread_detach(thread);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Apply changes of script file at their time, then return
+//----------------------------------------------------------------------------
+static void runScript(const char* scriptFile)
+{
+   FILE* p_file = fopen(scriptFile, "r");
+   if (!p_file)
+   {
+      printf("Can not open script %s: %s\n", scriptFile, strerror(errno));
+      return;
+   }
+   long long startNs = nowNs();
+   char line[512];
+   while (fgets(line, sizeof(line), p_file))
+   {
+      unsigned long long atMs;
+      char name[FAKE_NAME_SIZE];
+      char color[32];
+      char result[16] = "";
+      if ((line[0] == '#') ||
+          (sscanf(line, "%llu %127s %31s %15s", &atMs, name, color, result) < 3))
+      {
+         continue;
+      }
+      long long waitNs = startNs + (long long)atMs * 1000000LL - nowNs();
+      if (waitNs > 0)
+      {
+         sleepMs(waitNs / 1000000);
+      }
+      long long changedNs = changeJob(name, color, result);
+      if (changedNs)
+      {
+         printf("%lld change %s %s\n", changedNs, name, color);
+      }
+      else
+      {
+         printf("Job %s of script is not found\n", name);
+      }
+   }
+   fclose(p_file);
+}
+
+//================================================================================================//
+//                                       LATENCY HARNESS                                          //
+//================================================================================================//
+
+//----------------------------------------------------------------
+// Mock gpio log of jenkin_mon which is read while it is written
+//----------------------------------------------------------------
+typedef struct frameLog
+{
+   FILE* p_file;
+   int values[256];
+   long long frameNs;               // time of last read frame
+}FrameLogT;
+
+//----------------------------------------------------------------------------
+// Read next frame of log, wait at most until deadline
+// return false if there is no new frame
+//----------------------------------------------------------------------------
+static bool readFrame(FrameLogT* p_log, long long deadlineNs)
+{
+   char line[4096];
+   while (1)
+   {
+      long pos = ftell(p_log->p_file);
+      if (fgets(line, sizeof(line), p_log->p_file) && strchr(line, '\n'))
+      {
+         break;
+      }
+      // Line is not written completely yet
+      clearerr(p_log->p_file);
+      fseek(p_log->p_file, pos, SEEK_SET);
+      if (nowNs() > deadlineNs)
+      {
+         return false;
+      }
+      sleepMs(1);
+   }
+
+   char* p_pos = line;
+   p_log->frameNs = strtoll(p_pos, &p_pos, 10);
+   unsigned int pin;
+   int value;
+   int len;
+   while (sscanf(p_pos, " %u=%d%n", &pin, &value, &len) == 2)
+   {
+      p_pos += len;
+      if (pin < 256)
+      {
+         p_log->values[pin] = value;
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Write config of jenkin_mon: groups poll every second, failed group shows
+// red led without blinking, success is always shown
+//----------------------------------------------------------------------------
+static bool writeLatencyConfig(const char* fileName, const char* serverAddr,
+                               unsigned int groupCount)
+{
+   FILE* p_file = fopen(fileName, "w");
+   if (!p_file)
+   {
+      printf("Can not write %s: %s\n", fileName, strerror(errno));
+      return false;
+   }
+   fprintf(p_file, "<config>\n");
+   unsigned int group;
+   for (group = 0; group < groupCount; group++)
+   {
+      fprintf(p_file,
+              "   <group>\n"
+              "      <groupname>group_%02u</groupname>\n"
+              "      <server>%s</server>\n"
+              "      <red_led>%u</red_led>\n"
+              "      <green_led>%u</green_led>\n"
+              "      <blue_led>%u</blue_led>\n"
+              "      <poll_building>1</poll_building>\n"
+              "      <poll_idle>1</poll_idle>\n"
+              "      <poll_max_idle>1</poll_max_idle>\n"
+              "      <display_timeout>65535</display_timeout>\n"
+              "      <last_build_threshold>2000000000</last_build_threshold>\n"
+              "      <rules>\n"
+              "         <led_fail>red</led_fail>\n"
+              "      </rules>\n"
+              "      <jobs>\n",
+              group, serverAddr, group * 3, group * 3 + 1, group * 3 + 2);
+      unsigned int idx;
+      for (idx = group; idx < s_server.jobCount; idx += groupCount)
+      {
+         fprintf(p_file,
+                 "         <job>\n"
+                 "            <jobpath>/job/</jobpath>\n"
+                 "            <jobname>%s</jobname>\n"
+                 "         </job>\n", s_server.p_jobs[idx].name);
+      }
+      fprintf(p_file, "      </jobs>\n   </group>\n");
+   }
+   fprintf(p_file, "</config>\n");
+   fclose(p_file);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Compare latencies, for qsort
+//----------------------------------------------------------------------------
+static int compareNs(const void* p_left, const void* p_right)
+{
+   long long left = *(const long long*)p_left;
+   long long right = *(const long long*)p_right;
+   return (left > right) - (left < right);
+}
+
+//----------------------------------------------------------------------------
+// Run jenkin_mon against fake server with given number of jobs and measure
+// latency of changeCount changes
+// return false if jenkin_mon can not be run
+//----------------------------------------------------------------------------
+static bool runLatency(const char* monPath, const char* mode, unsigned int port,
+                       unsigned int jobCount, unsigned int changeCount)
+{
+   char dir[] = "/tmp/jenkin_latency.XXXXXX";
+   if (!mkdtemp(dir))
+   {
+      printf("Can not create temporary directory: %s\n", strerror(errno));
+      return false;
+   }
+   char cfgFile[64];
+   char logFile[64];
+   char outFile[64];
+   char serverAddr[32];
+   char hookAddr[32];
+   snprintf(cfgFile, sizeof(cfgFile), "%s/config.xml", dir);
+   snprintf(logFile, sizeof(logFile), "%s/frames.log", dir);
+   snprintf(outFile, sizeof(outFile), "%s/jenkin_mon.log", dir);
+   snprintf(serverAddr, sizeof(serverAddr), "127.0.0.1:%u", port);
+   snprintf(hookAddr, sizeof(hookAddr), "127.0.0.1:%u", port + 1);
+
+   pthread_mutex_lock(&s_server.lock);
+   free(s_server.p_jobs);
+   makeJobs(jobCount);
+   pthread_mutex_unlock(&s_server.lock);
+   __atomic_store_n(&s_server.requestCount, 0, __ATOMIC_SEQ_CST);
+   unsigned int groupCount = (jobCount < FAKE_MAX_GROUPS) ? jobCount : FAKE_MAX_GROUPS;
+   bool isHook = !strcmp(mode, "hook");
+   s_server.notifyAddr = isHook ? hookAddr : NULL;
+   if (!writeLatencyConfig(cfgFile, serverAddr, groupCount))
+   {
+      return false;
+   }
+
+   // Log file exists before jenkin_mon truncates it
+   FILE* p_create = fopen(logFile, "w");
+   if (p_create)
+   {
+      fclose(p_create);
+   }
+
+   const char* argv[16];
+   unsigned int argc = 0;
+   argv[argc++] = monPath;
+   argv[argc++] = "-f";
+   argv[argc++] = cfgFile;
+   argv[argc++] = "-r";
+   argv[argc++] = "--gpio";
+   argv[argc++] = "mock";
+   argv[argc++] = "--gpiodev";
+   argv[argc++] = logFile;
+   if (!strcmp(mode, "aggregate"))
+   {
+      argv[argc++] = "-a";
+   }
+   if (isHook)
+   {
+      argv[argc++] = "--hook";
+      argv[argc++] = hookAddr;
+   }
+   argv[argc] = NULL;
+
+   fflush(stdout);
+   pid_t pid = fork();
+   if (pid < 0)
+   {
+      printf("fork failed: %s\n", strerror(errno));
+      return false;
+   }
+   if (pid == 0)
+   {
+      FILE* p_out = freopen(outFile, "w", stdout);
+      (void)p_out;
+      execv(monPath, (char* const*)argv);
+      _exit(127);
+   }
+
+   FrameLogT log;
+   memset(&log, 0, sizeof(log));
+   log.p_file = fopen(logFile, "r");
+   long long* p_latencies = calloc(changeCount ? changeCount : 1, sizeof(long long));
+   unsigned int sampleCount = 0;
+   unsigned int missedCount = 0;
+   unsigned int idx;
+   for (idx = 0; idx < 256; idx++)
+   {
+      log.values[idx] = 1;
+   }
+
+   // All groups show success (blue) first
+   bool isSettled = false;
+   long long deadlineNs = nowNs() + FAKE_SETTLE_TIMEOUT * 1000000000LL;
+   while (log.p_file && !isSettled && readFrame(&log, deadlineNs))
+   {
+      isSettled = true;
+      unsigned int group;
+      for (group = 0; group < groupCount; group++)
+      {
+         if ((log.values[group * 3] != 1) || (log.values[group * 3 + 2] != 0))
+         {
+            isSettled = false;
+            break;
+         }
+      }
+   }
+   if (!isSettled)
+   {
+      printf("latency %-9s %5u jobs: leds are not settled, see %s\n", mode, jobCount, outFile);
+   }
+
+   // Job of a group fails, then it succeeds again: red led of group is turned
+   // on, then off
+   for (idx = 0; isSettled && (idx < changeCount); idx++)
+   {
+      unsigned int group = (idx / 2) % groupCount;
+      bool isFail = !(idx % 2);
+      int expected = isFail ? 0 : 1;
+      while (readFrame(&log, 0));
+      long long changedNs = changeJob(s_server.p_jobs[group].name, isFail ? "red" : "blue", NULL);
+      deadlineNs = changedNs + FAKE_CHANGE_TIMEOUT * 1000000000LL;
+      bool isShown = false;
+      while (!isShown && readFrame(&log, deadlineNs))
+      {
+         isShown = (log.values[group * 3] == expected) && (log.frameNs >= changedNs);
+      }
+      if (isShown)
+      {
+         p_latencies[sampleCount++] = log.frameNs - changedNs;
+      }
+      else
+      {
+         missedCount++;
+      }
+   }
+
+   kill(pid, SIGTERM);
+   waitpid(pid, NULL, 0);
+   if (log.p_file)
+   {
+      fclose(log.p_file);
+   }
+
+   if (sampleCount)
+   {
+      qsort(p_latencies, sampleCount, sizeof(long long), compareNs);
+      long long sumNs = 0;
+      for (idx = 0; idx < sampleCount; idx++)
+      {
+         sumNs += p_latencies[idx];
+      }
+      printf("latency %-9s %5u jobs %3u groups: %3u changes, mean %8.2f ms, min %8.2f ms, "\
+             "p50 %8.2f ms, p90 %8.2f ms, p99 %8.2f ms, max %8.2f ms, %u missed, %llu requests\n",
+             mode, jobCount, groupCount, sampleCount, sumNs / 1e6 / sampleCount,
+             p_latencies[0] / 1e6, p_latencies[sampleCount / 2] / 1e6,
+             p_latencies[sampleCount * 90 / 100] / 1e6, p_latencies[sampleCount * 99 / 100] / 1e6,
+             p_latencies[sampleCount - 1] / 1e6, missedCount,
+             __atomic_load_n(&s_server.requestCount, __ATOMIC_SEQ_CST));
+   }
+   free(p_latencies);
+
+   if (isSettled && !missedCount)
+   {
+      unlink(cfgFile);
+      unlink(logFile);
+      unlink(outFile);
+      rmdir(dir);
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Main function
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+   const char* homeDir = NULL;
+   const char* scriptFile = NULL;
+   const char* jobCounts = NULL;
+   const char* mode = "poll";
+   const char* monPath = "./jenkin_mon";
+   unsigned int jobCount = 0;
+   unsigned int port = 8080;
+   unsigned int changeCount = 20;
+   bool isPortGiven = false;
+   struct option longOptions[] =
+   {
+      {"home"       ,required_argument ,0 ,'H'},
+      {"jobs"       ,required_argument ,0 ,'n'},
+      {"port"       ,required_argument ,0 ,'p'},
+      {"delay"      ,required_argument ,0 ,'D'},
+      {"drop"       ,required_argument ,0 ,'d'},
+      {"script"     ,required_argument ,0 ,'s'},
+      {"notify"     ,required_argument ,0 ,'N'},
+      {"latency"    ,required_argument ,0 ,'l'},
+      {"mode"       ,required_argument ,0 ,'m'},
+      {"mon"        ,required_argument ,0 ,'M'},
+      {"changes"    ,required_argument ,0 ,'c'},
+      {0            ,0                 ,0 ,0  }
+   };
+
+   int returnCharacter;
+   while ((returnCharacter = getopt_long(argc, argv, "H:n:p:D:d:s:N:l:m:M:c:",
+                                         longOptions, NULL)) != -1)
+   {
+      switch (returnCharacter)
+      {
+         case 'H': homeDir = optarg; break;
+         case 'n': jobCount = atoi(optarg); break;
+         case 'p': port = atoi(optarg); isPortGiven = true; break;
+         case 'D': s_server.delayMs = atoi(optarg); break;
+         case 'd': s_server.dropPercent = atoi(optarg); break;
+         case 's': scriptFile = optarg; break;
+         case 'N': s_server.notifyAddr = optarg; break;
+         case 'l': jobCounts = optarg; break;
+         case 'm': mode = optarg; break;
+         case 'M': monPath = optarg; break;
+         case 'c': changeCount = atoi(optarg); break;
+         default:
+            printf("usage:\n"
+                   "fake jenkins server, jobs come from JENKINS_HOME tree or are synthetic\n"
+                   "./jenkin_fake --home ../jenkinJobsExample [--port 8080]\n"
+                   "./jenkin_fake --jobs 500 [--script FILE] [--delay MS] [--drop PERCENT] "
+                   "[--notify HOST:PORT]\n"
+                   "script has one change per line: <ms after start> <job> <color> [result]\n"
+                   "job is changed now by: curl -X POST 'localhost:8080/fake/job/NAME?color=red'\n"
+                   "server is slowed or broken now by: "
+                   "curl -X POST 'localhost:8080/fake/server?delay=MS&drop=PERCENT'\n"
+                   "end-to-end latency of jenkin_mon from change of job to led frame\n"
+                   "./jenkin_fake --latency 1,10,100,1000 [--mode poll|aggregate|hook] "
+                   "[--changes 20] [--mon ./jenkin_mon] [--delay MS]\n");
+            return 1;
+      }
+   }
+
+   signal(SIGPIPE, SIG_IGN);
+   setvbuf(stdout, NULL, _IOLBF, 0);
+   pthread_mutex_init(&s_server.lock, NULL);
+
+   char listenAddr[32];
+   if (jobCounts)
+   {
+      // Fake server and hook of jenkin_mon use two ports
+      if (!isPortGiven)
+      {
+         port = 18480;
+      }
+      snprintf(listenAddr, sizeof(listenAddr), "127.0.0.1:%u", port);
+      snprintf(s_server.rootUrl, sizeof(s_server.rootUrl), "http://%s", listenAddr);
+      if (!startServer(listenAddr))
+      {
+         return 1;
+      }
+      const char* p_count = jobCounts;
+      while (*p_count)
+      {
+         if (!runLatency(monPath, mode, port, atoi(p_count), changeCount))
+         {
+            return 1;
+         }
+         p_count += strcspn(p_count, ",");
+         p_count += (*p_count == ',');
+      }
+      return 0;
+   }
+
+   if (homeDir ? !loadHomeJobs(homeDir) : (makeJobs(jobCount ? jobCount : 10), false))
+   {
+      return 1;
+   }
+   snprintf(listenAddr, sizeof(listenAddr), "%u", port);
+   snprintf(s_server.rootUrl, sizeof(s_server.rootUrl), "http://localhost:%u", port);
+   if (!startServer(listenAddr))
+   {
+      return 1;
+   }
+   printf("Fake jenkins serves %u jobs on port %u\n", s_server.jobCount, port);
+   if (scriptFile)
+   {
+      runScript(scriptFile);
+   }
+   while (1)
+   {
+      pause();
+   }
+   return 0;
+}
@@ -0,0 +1,994 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include "jenkin_gpio.h"
+
+// Sysfs needs some time to create gpioN directory after exporting, and udev
+// needs more time to change permission of its files
+#define GPIO_EXPORT_RETRY     50
+#define GPIO_EXPORT_WAIT_NS   20000000L   // 20 ms
+
+#define GPIO_CONSUMER "jenkin_mon"
+
+//----------------------------------------------------------------
+// Operations of a gpio backend
+//----------------------------------------------------------------
+typedef struct gpioBackend
+{
+   const char* name;
+   const char* defaultDevice;     // NULL if device is optional
+   bool canBlink;                 // backend accepts GPIO_BLINK value
+
+   bool (*open)(const char* device);
+   // Request pins as output with high level, at start or while running,
+   // nothing is requested if any pin fails
+   bool (*requestPins)(const unsigned int* pins, unsigned int pinCount);
+   // Write value in frame[] of changed pins
+   bool (*writeFrame)(const unsigned int* pins, unsigned int pinCount,
+                      const signed char* frame);
+   // Turn off pins and release them while running
+   void (*releasePins)(const unsigned int* pins, unsigned int pinCount);
+   void (*close)(void);
+}GpioBackendT;
+
+static const GpioBackendT* s_backend = NULL;
+
+// Requested pins
+static unsigned int s_pins[GPIO_MAX_PIN];
+static unsigned int s_pinCount = 0;
+static bool s_isRequested[GPIO_MAX_PIN];
+
+// Led name of each requested pin, used by ledclass backend
+static char* s_ledName[GPIO_MAX_PIN];
+
+// Half period of blinking in milli second
+static unsigned int s_blinkMs = 1000;
+
+// Staged value of each pin
+static signed char s_frame[GPIO_MAX_PIN];
+
+// Last value written to each pin, -1 if it is unknown
+static signed char s_shadow[GPIO_MAX_PIN];
+
+// Statistics are kept when gpio is started again
+static GpioStatsT s_stats;
+
+//----------------------------------------------------------------------------
+//                               SYSFS BACKEND
+//----------------------------------------------------------------------------
+static char s_sysfsDir[256];
+
+// Opened value file of each pin, -1 if pin is not exported
+static int s_valueFd[GPIO_MAX_PIN];
+
+//----------------------------------------------------------------------------
+// Write a string to a sysfs file
+//----------------------------------------------------------------------------
+static bool writeSysfsFile(const char* fileName, const char* str)
+{
+   int fd = open(fileName, O_WRONLY | O_CLOEXEC);
+   if (fd < 0)
+   {
+      return false;
+   }
+   ssize_t len = strlen(str);
+   bool isOk = (write(fd, str, len) == len);
+   close(fd);
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Keep directory of sysfs gpio interface
+//----------------------------------------------------------------------------
+static bool sysfsOpen(const char* sysfsDir)
+{
+   if (strlen(sysfsDir) >= sizeof(s_sysfsDir))
+   {
+      printf("gpio directory is too long: %s\n", sysfsDir);
+      return false;
+   }
+   strcpy(s_sysfsDir, sysfsDir);
+
+   unsigned int pin;
+   for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+   {
+      s_valueFd[pin] = -1;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Export pin, set it as output with high level and keep its value file open
+//----------------------------------------------------------------------------
+static bool sysfsExportPin(unsigned int pin)
+{
+   char fileName[300];
+   char pinStr[8];
+   struct stat st;
+   snprintf(fileName, sizeof(fileName), "%s/gpio%u", s_sysfsDir, pin);
+   if (stat(fileName, &st) == -1)
+   {
+      char exportFile[300];
+      snprintf(exportFile, sizeof(exportFile), "%s/export", s_sysfsDir);
+      snprintf(pinStr, sizeof(pinStr), "%u", pin);
+      if (!writeSysfsFile(exportFile, pinStr))
+      {
+         printf("Can not export gpio%u: %s\n", pin, strerror(errno));
+         return false;
+      }
+   }
+
+   // "high" sets direction to output and value to 1 in one write, so that
+   // led does not flash when direction is changed
+   snprintf(fileName, sizeof(fileName), "%s/gpio%u/direction", s_sysfsDir, pin);
+   struct timespec waitTime = {0, GPIO_EXPORT_WAIT_NS};
+   int retry;
+   for (retry = 0; !writeSysfsFile(fileName, "high"); retry++)
+   {
+      if (retry == GPIO_EXPORT_RETRY)
+      {
+         printf("Can not set direction of gpio%u: %s\n", pin, strerror(errno));
+         return false;
+      }
+      nanosleep(&waitTime, NULL);
+   }
+
+   snprintf(fileName, sizeof(fileName), "%s/gpio%u/value", s_sysfsDir, pin);
+   s_valueFd[pin] = open(fileName, O_WRONLY | O_CLOEXEC);
+   if (s_valueFd[pin] < 0)
+   {
+      printf("Can not open value file of gpio%u: %s\n", pin, strerror(errno));
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Turn off pins and close their value files, pins are kept exported
+//----------------------------------------------------------------------------
+static void sysfsReleasePins(const unsigned int* pins, unsigned int pinCount)
+{
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      unsigned int pin = pins[idx];
+      if (s_valueFd[pin] >= 0)
+      {
+         if (pwrite(s_valueFd[pin], "1", 1, 0) != 1)
+         {
+            printf("Can not turn off gpio%u: %s\n", pin, strerror(errno));
+         }
+         close(s_valueFd[pin]);
+         s_valueFd[pin] = -1;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Export all pins
+//----------------------------------------------------------------------------
+static bool sysfsRequestPins(const unsigned int* pins, unsigned int pinCount)
+{
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      if (!sysfsExportPin(pins[idx]))
+      {
+         sysfsReleasePins(pins, idx);
+         return false;
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Write changed pins, one pwrite() per pin
+//----------------------------------------------------------------------------
+static bool sysfsWriteFrame(const unsigned int* pins, unsigned int pinCount,
+                            const signed char* frame)
+{
+   bool isOk = true;
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      unsigned int pin = pins[idx];
+      if (pwrite(s_valueFd[pin], frame[pin] ? "1" : "0", 1, 0) != 1)
+      {
+         printf("Can not set value to gpio%u: %s\n", pin, strerror(errno));
+         isOk = false;
+      }
+   }
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Close all value files, pins are kept exported so led keeps its state
+//----------------------------------------------------------------------------
+static void sysfsClose(void)
+{
+   unsigned int pin;
+   for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+   {
+      if (s_valueFd[pin] >= 0)
+      {
+         close(s_valueFd[pin]);
+         s_valueFd[pin] = -1;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+//                              CHARDEV BACKEND
+//----------------------------------------------------------------------------
+static int s_chipFd = -1;
+
+// Line request which holds line of pin, -1 if line is not held. All pins are
+// requested in one request at start, pins which are added while running get
+// another request. A line request can only be released as a whole, so line
+// of released pin is held (turned off) until all pins of its request are
+// released.
+static int s_lineFd[GPIO_MAX_PIN];
+
+// Line of pin is held and pin is requested
+static bool s_isLineUsed[GPIO_MAX_PIN];
+
+// Index of pin in its line request
+static unsigned char s_lineIdx[GPIO_MAX_PIN];
+
+//----------------------------------------------------------------------------
+// Open gpio chip
+//----------------------------------------------------------------------------
+static bool chardevOpen(const char* chipDev)
+{
+   unsigned int pin;
+   for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+   {
+      s_lineFd[pin] = -1;
+      s_isLineUsed[pin] = false;
+   }
+   s_chipFd = open(chipDev, O_RDWR | O_CLOEXEC);
+   if (s_chipFd < 0)
+   {
+      printf("Can not open gpio chip %s: %s\n", chipDev, strerror(errno));
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Write pins which have line request lineFd by one ioctl()
+//----------------------------------------------------------------------------
+static bool chardevWriteLines(int lineFd, const unsigned int* pins, unsigned int pinCount,
+                              const signed char* frame)
+{
+   struct gpio_v2_line_values values = {0, 0};
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      if (s_lineFd[pins[idx]] != lineFd)
+      {
+         continue;
+      }
+      unsigned int line = s_lineIdx[pins[idx]];
+      values.mask |= 1ULL << line;
+      if (frame[pins[idx]])
+      {
+         values.bits |= 1ULL << line;
+      }
+   }
+
+   if (ioctl(lineFd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) == -1)
+   {
+      printf("Can not set values to gpio chip: %s\n", strerror(errno));
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Write changed pins, one ioctl() per line request (only one if pins are
+// not added while running)
+//----------------------------------------------------------------------------
+static bool chardevWriteFrame(const unsigned int* pins, unsigned int pinCount,
+                              const signed char* frame)
+{
+   bool isOk = true;
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      int lineFd = s_lineFd[pins[idx]];
+      unsigned int prevIdx = 0;
+      while ((prevIdx < idx) && (s_lineFd[pins[prevIdx]] != lineFd))
+      {
+         prevIdx++;
+      }
+      if (prevIdx == idx)
+      {
+         isOk = chardevWriteLines(lineFd, pins, pinCount, frame) && isOk;
+      }
+   }
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Request pins as output with high level, pins whose line is still held
+// are used again, others are requested in one line request
+//----------------------------------------------------------------------------
+static bool chardevRequestPins(const unsigned int* pins, unsigned int pinCount)
+{
+   struct gpio_v2_line_request request;
+   memset(&request, 0, sizeof(request));
+   strncpy(request.consumer, GPIO_CONSUMER, sizeof(request.consumer) - 1);
+   request.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+   request.config.num_attrs = 1;
+   request.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      if (s_lineFd[pins[idx]] >= 0)
+      {
+         continue;
+      }
+      if (request.num_lines == GPIO_V2_LINES_MAX)
+      {
+         printf("gpio chip can not request more than %d pins\n", GPIO_V2_LINES_MAX);
+         return false;
+      }
+      request.offsets[request.num_lines] = pins[idx];
+      request.config.attrs[0].attr.values |= 1ULL << request.num_lines;
+      request.config.attrs[0].mask |= 1ULL << request.num_lines;
+      request.num_lines++;
+   }
+
+   if (request.num_lines && (ioctl(s_chipFd, GPIO_V2_GET_LINE_IOCTL, &request) == -1))
+   {
+      printf("Can not request lines of gpio chip: %s\n", strerror(errno));
+      return false;
+   }
+   unsigned int lineIdx = 0;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      unsigned int pin = pins[idx];
+      if (s_lineFd[pin] < 0)
+      {
+         s_lineFd[pin] = request.fd;
+         s_lineIdx[pin] = lineIdx++;
+      }
+      s_isLineUsed[pin] = true;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Turn off pins, line request is released when none of its pins is used
+// Note: kernel may reset released lines
+//----------------------------------------------------------------------------
+static void chardevReleasePins(const unsigned int* pins, unsigned int pinCount)
+{
+   signed char offFrame[GPIO_MAX_PIN];
+   memset(offFrame, 1, sizeof(offFrame));
+   chardevWriteFrame(pins, pinCount, offFrame);
+
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      s_isLineUsed[pins[idx]] = false;
+   }
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      int lineFd = s_lineFd[pins[idx]];
+      unsigned int pin;
+      bool isUsed = false;
+      for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+      {
+         isUsed = isUsed || ((s_lineFd[pin] == lineFd) && s_isLineUsed[pin]);
+      }
+      if ((lineFd < 0) || isUsed)
+      {
+         continue;
+      }
+      close(lineFd);
+      for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+      {
+         if (s_lineFd[pin] == lineFd)
+         {
+            s_lineFd[pin] = -1;
+         }
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Release lines and close gpio chip
+// Note: kernel may reset released lines, led state is not kept
+//----------------------------------------------------------------------------
+static void chardevClose(void)
+{
+   unsigned int pin;
+   for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+   {
+      int lineFd = s_lineFd[pin];
+      if (lineFd < 0)
+      {
+         continue;
+      }
+      close(lineFd);
+      unsigned int otherPin;
+      for (otherPin = pin; otherPin < GPIO_MAX_PIN; otherPin++)
+      {
+         if (s_lineFd[otherPin] == lineFd)
+         {
+            s_lineFd[otherPin] = -1;
+            s_isLineUsed[otherPin] = false;
+         }
+      }
+   }
+   if (s_chipFd >= 0)
+   {
+      close(s_chipFd);
+      s_chipFd = -1;
+   }
+}
+
+//----------------------------------------------------------------------------
+//                             LEDCLASS BACKEND
+//----------------------------------------------------------------------------
+static char s_ledClassDir[256];
+
+// Opened brightness file of each pin, -1 if led is not opened
+static int s_brightnessFd[GPIO_MAX_PIN];
+
+// Brightness string to turn led on
+static char s_maxBrightness[GPIO_MAX_PIN][12];
+
+// Is "timer" trigger set to led
+static bool s_isTimerTrigger[GPIO_MAX_PIN];
+
+//----------------------------------------------------------------------------
+// Keep directory of kernel led class
+//----------------------------------------------------------------------------
+static bool ledClassOpen(const char* ledClassDir)
+{
+   if (strlen(ledClassDir) >= sizeof(s_ledClassDir))
+   {
+      printf("led class directory is too long: %s\n", ledClassDir);
+      return false;
+   }
+   strcpy(s_ledClassDir, ledClassDir);
+
+   unsigned int pin;
+   for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+   {
+      s_brightnessFd[pin] = -1;
+      s_isTimerTrigger[pin] = false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Write a string to an attribute file of led
+//----------------------------------------------------------------------------
+static bool writeLedAttr(unsigned int pin, const char* attrName, const char* str)
+{
+   char fileName[300];
+   snprintf(fileName, sizeof(fileName), "%s/%s/%s", s_ledClassDir, s_ledName[pin], attrName);
+   if (!writeSysfsFile(fileName, str))
+   {
+      printf("Can not write %s to %s: %s\n", str, fileName, strerror(errno));
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Turn off leds and close their brightness files
+//----------------------------------------------------------------------------
+static void ledClassReleasePins(const unsigned int* pins, unsigned int pinCount)
+{
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      unsigned int pin = pins[idx];
+      if (s_isTimerTrigger[pin])
+      {
+         s_isTimerTrigger[pin] = false;
+         writeLedAttr(pin, "trigger", "none");
+      }
+      if (s_brightnessFd[pin] >= 0)
+      {
+         if (pwrite(s_brightnessFd[pin], "0", 1, 0) != 1)
+         {
+            printf("Can not turn off led %s: %s\n", s_ledName[pin], strerror(errno));
+         }
+         close(s_brightnessFd[pin]);
+         s_brightnessFd[pin] = -1;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Open brightness file of all leds and turn them off
+//----------------------------------------------------------------------------
+static bool ledClassRequestPins(const unsigned int* pins, unsigned int pinCount)
+{
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      unsigned int pin = pins[idx];
+      char fileName[300];
+
+      // Brightness to turn led on, led may be dimmable
+      strcpy(s_maxBrightness[pin], "1");
+      snprintf(fileName, sizeof(fileName), "%s/%s/max_brightness", s_ledClassDir, s_ledName[pin]);
+      FILE* p_file = fopen(fileName, "r");
+      if (p_file)
+      {
+         unsigned int maxBrightness;
+         if (fscanf(p_file, "%u", &maxBrightness) == 1)
+         {
+            snprintf(s_maxBrightness[pin], sizeof(s_maxBrightness[pin]), "%u", maxBrightness);
+         }
+         fclose(p_file);
+      }
+
+      // Led may be left blinking by previous run
+      if (!writeLedAttr(pin, "trigger", "none"))
+      {
+         ledClassReleasePins(pins, idx);
+         return false;
+      }
+
+      snprintf(fileName, sizeof(fileName), "%s/%s/brightness", s_ledClassDir, s_ledName[pin]);
+      s_brightnessFd[pin] = open(fileName, O_WRONLY | O_CLOEXEC);
+      if ((s_brightnessFd[pin] < 0) || (pwrite(s_brightnessFd[pin], "0", 1, 0) != 1))
+      {
+         printf("Can not turn off led %s: %s\n", s_ledName[pin], strerror(errno));
+         ledClassReleasePins(pins, idx + 1);
+         return false;
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Write changed leds, blinking is done by timer trigger of kernel
+//----------------------------------------------------------------------------
+static bool ledClassWriteFrame(const unsigned int* pins, unsigned int pinCount,
+                               const signed char* frame)
+{
+   bool isOk = true;
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      unsigned int pin = pins[idx];
+      if (frame[pin] == GPIO_BLINK)
+      {
+         // delay_on and delay_off files are created by kernel after timer
+         // trigger is set, led starts blinking with on state
+         char delayStr[12];
+         snprintf(delayStr, sizeof(delayStr), "%u", s_blinkMs);
+         s_isTimerTrigger[pin] = true;
+         isOk = writeLedAttr(pin, "trigger", "timer") &&
+                writeLedAttr(pin, "delay_on", delayStr) &&
+                writeLedAttr(pin, "delay_off", delayStr) && isOk;
+         continue;
+      }
+
+      if (s_isTimerTrigger[pin])
+      {
+         s_isTimerTrigger[pin] = false;
+         isOk = writeLedAttr(pin, "trigger", "none") && isOk;
+      }
+      // Pin value is active low, led class brightness is not
+      const char* brightness = frame[pin] ? "0" : s_maxBrightness[pin];
+      ssize_t len = strlen(brightness);
+      if (pwrite(s_brightnessFd[pin], brightness, len, 0) != len)
+      {
+         printf("Can not set brightness of led %s: %s\n", s_ledName[pin], strerror(errno));
+         isOk = false;
+      }
+   }
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Close all brightness files, leds keep their state
+//----------------------------------------------------------------------------
+static void ledClassClose(void)
+{
+   unsigned int pin;
+   for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+   {
+      if (s_brightnessFd[pin] >= 0)
+      {
+         close(s_brightnessFd[pin]);
+         s_brightnessFd[pin] = -1;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+//                                MOCK BACKEND
+//----------------------------------------------------------------------------
+static FILE* s_mockLog = NULL;
+
+//----------------------------------------------------------------------------
+// Open log file of mock chip if it is given
+//----------------------------------------------------------------------------
+static bool mockOpen(const char* logFile)
+{
+   if (!logFile)
+   {
+      return true;
+   }
+   s_mockLog = fopen(logFile, "w");
+   if (!s_mockLog)
+   {
+      printf("Can not open gpio mock log %s: %s\n", logFile, strerror(errno));
+      return false;
+   }
+   setvbuf(s_mockLog, NULL, _IOLBF, 0);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Log a frame with monotonic time
+//----------------------------------------------------------------------------
+static bool mockWriteFrame(const unsigned int* pins, unsigned int pinCount,
+                           const signed char* frame)
+{
+   if (!s_mockLog)
+   {
+      return true;
+   }
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   fprintf(s_mockLog, "%lld", (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec);
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      fprintf(s_mockLog, " %u=%d", pins[idx], frame[pins[idx]]);
+   }
+   fprintf(s_mockLog, "\n");
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Requested pins are logged as the first frame
+//----------------------------------------------------------------------------
+static bool mockRequestPins(const unsigned int* pins, unsigned int pinCount)
+{
+   return mockWriteFrame(pins, pinCount, s_frame);
+}
+
+//----------------------------------------------------------------------------
+// Released pins are logged as a frame which turns them off
+//----------------------------------------------------------------------------
+static void mockReleasePins(const unsigned int* pins, unsigned int pinCount)
+{
+   signed char offFrame[GPIO_MAX_PIN];
+   memset(offFrame, 1, sizeof(offFrame));
+   mockWriteFrame(pins, pinCount, offFrame);
+}
+
+//----------------------------------------------------------------------------
+// Close log file of mock chip
+//----------------------------------------------------------------------------
+static void mockClose(void)
+{
+   if (s_mockLog)
+   {
+      fclose(s_mockLog);
+      s_mockLog = NULL;
+   }
+}
+
+static const GpioBackendT s_allBackends[] =
+{
+   {"sysfs",    GPIO_SYSFS_DIR,    false, sysfsOpen,    sysfsRequestPins,    sysfsWriteFrame,
+                sysfsReleasePins,    sysfsClose},
+   {"chardev",  GPIO_CHARDEV_CHIP, false, chardevOpen,  chardevRequestPins,  chardevWriteFrame,
+                chardevReleasePins,  chardevClose},
+   {"ledclass", GPIO_LEDCLASS_DIR, true,  ledClassOpen, ledClassRequestPins, ledClassWriteFrame,
+                ledClassReleasePins, ledClassClose},
+   {"mock",     NULL,              false, mockOpen,     mockRequestPins,     mockWriteFrame,
+                mockReleasePins,     mockClose},
+   {NULL,       NULL,              false, NULL,         NULL,                NULL,
+                NULL,                NULL}
+};
+
+//----------------------------------------------------------------------------
+//                                 GPIO DRIVER
+//----------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------
+// Init gpio driver with name of backend and its device,
+// default device of backend is used if device is NULL
+// blinkMs is half period of blinking if backend can blink by itself
+//----------------------------------------------------------------------------
+bool gpioInit(const char* backendName, const char* device, unsigned int blinkMs)
+{
+   const GpioBackendT* p_backend = s_allBackends;
+   while (p_backend->name && strcmp(p_backend->name, backendName))
+   {
+      p_backend++;
+   }
+   if (!p_backend->name)
+   {
+      printf("Unknown gpio backend: %s\n", backendName);
+      return false;
+   }
+
+   unsigned int pin;
+   for (pin = 0; pin < GPIO_MAX_PIN; pin++)
+   {
+      s_isRequested[pin] = false;
+      s_ledName[pin] = NULL;
+      s_frame[pin] = 1;
+      s_shadow[pin] = -1;
+   }
+   s_pinCount = 0;
+   s_blinkMs = blinkMs;
+
+   if (!p_backend->open(device ? device : p_backend->defaultDevice))
+   {
+      return false;
+   }
+   s_backend = p_backend;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Add pin to list of pins that will be requested by gpioStart()
+// ledName is name of led class device of pin, NULL -> "gpioN"
+//----------------------------------------------------------------------------
+bool gpioRequestPin(unsigned int pin, const char* ledName)
+{
+   if (pin >= GPIO_MAX_PIN)
+   {
+      printf("gpio%u is out of range\n", pin);
+      return false;
+   }
+   if (!s_isRequested[pin])
+   {
+      // Pin may be shared by many groups
+      s_isRequested[pin] = true;
+      s_pins[s_pinCount++] = pin;
+      if (ledName)
+      {
+         s_ledName[pin] = strdup(ledName);
+      }
+      else
+      {
+         s_ledName[pin] = malloc(16);
+         snprintf(s_ledName[pin], 16, "gpio%u", pin);
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Request all pins from backend, led is turned off
+//----------------------------------------------------------------------------
+bool gpioStart(void)
+{
+   if (!s_backend->requestPins(s_pins, s_pinCount))
+   {
+      return false;
+   }
+   unsigned int idx;
+   for (idx = 0; idx < s_pinCount; idx++)
+   {
+      s_shadow[s_pins[idx]] = 1;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Compare led name of requested pin with given name, NULL -> "gpioN"
+//----------------------------------------------------------------------------
+static bool isSameLedName(unsigned int pin, const char* ledName)
+{
+   char defaultName[16];
+   if (!ledName)
+   {
+      snprintf(defaultName, sizeof(defaultName), "gpio%u", pin);
+      ledName = defaultName;
+   }
+   return !strcmp(s_ledName[pin], ledName);
+}
+
+//----------------------------------------------------------------------------
+// Change set of requested pins while gpio is started: pins which are not
+// requested yet are requested first, then pins which are not in new set are
+// turned off and released. Pins which are kept are not touched, so their
+// leds do not flicker. Led name of kept pin can not be changed.
+// ledNames[idx] is led name of pins[idx], NULL -> "gpioN"
+// Note: nobody must stage or commit frame meanwhile
+// return false if any new pin can not be requested, nothing is changed then
+//----------------------------------------------------------------------------
+bool gpioUpdatePins(const unsigned int* pins, const char* const* ledNames, unsigned int pinCount)
+{
+   bool isInNewSet[GPIO_MAX_PIN];
+   unsigned int addedPins[GPIO_MAX_PIN];
+   unsigned int addedCount = 0;
+   memset(isInNewSet, 0, sizeof(isInNewSet));
+   unsigned int idx;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      unsigned int pin = pins[idx];
+      if (pin >= GPIO_MAX_PIN)
+      {
+         printf("gpio%u is out of range\n", pin);
+         return false;
+      }
+      if (s_isRequested[pin] && !isSameLedName(pin, ledNames[idx]))
+      {
+         printf("Led name of gpio%u can not be changed while running\n", pin);
+         return false;
+      }
+      if (!s_isRequested[pin] && !isInNewSet[pin])
+      {
+         addedPins[addedCount++] = pin;
+      }
+      isInNewSet[pin] = true;
+   }
+
+   // Led names of added pins are needed by backend
+   unsigned int oldCount = s_pinCount;
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      if (!s_isRequested[pins[idx]])
+      {
+         gpioRequestPin(pins[idx], ledNames[idx]);
+      }
+   }
+   if (addedCount && !s_backend->requestPins(addedPins, addedCount))
+   {
+      for (idx = oldCount; idx < s_pinCount; idx++)
+      {
+         s_isRequested[s_pins[idx]] = false;
+         free(s_ledName[s_pins[idx]]);
+         s_ledName[s_pins[idx]] = NULL;
+      }
+      s_pinCount = oldCount;
+      return false;
+   }
+   for (idx = 0; idx < addedCount; idx++)
+   {
+      s_frame[addedPins[idx]] = 1;
+      s_shadow[addedPins[idx]] = 1;
+   }
+
+   unsigned int removedPins[GPIO_MAX_PIN];
+   unsigned int removedCount = 0;
+   unsigned int keptCount = 0;
+   for (idx = 0; idx < s_pinCount; idx++)
+   {
+      unsigned int pin = s_pins[idx];
+      if (isInNewSet[pin])
+      {
+         s_pins[keptCount++] = pin;
+         continue;
+      }
+      removedPins[removedCount++] = pin;
+   }
+   if (removedCount)
+   {
+      s_backend->releasePins(removedPins, removedCount);
+   }
+   for (idx = 0; idx < removedCount; idx++)
+   {
+      unsigned int pin = removedPins[idx];
+      s_isRequested[pin] = false;
+      s_frame[pin] = 1;
+      s_shadow[pin] = -1;
+      free(s_ledName[pin]);
+      s_ledName[pin] = NULL;
+   }
+   s_pinCount = keptCount;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Check if backend can blink led by itself
+//----------------------------------------------------------------------------
+bool gpioCanBlink(void)
+{
+   return s_backend && s_backend->canBlink;
+}
+
+//----------------------------------------------------------------------------
+// Stage value of pin to frame, it is written by gpioCommit()
+//----------------------------------------------------------------------------
+void gpioSetValue(unsigned int pin, int value)
+{
+   if ((pin < GPIO_MAX_PIN) && s_isRequested[pin])
+   {
+      if (value == GPIO_BLINK)
+      {
+         // Backend can not blink -> led is kept on
+         s_frame[pin] = s_backend->canBlink ? GPIO_BLINK : 0;
+      }
+      else
+      {
+         s_frame[pin] = value ? 1 : 0;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Write frame to backend, skip pins which already have the value
+//----------------------------------------------------------------------------
+bool gpioCommit(void)
+{
+   unsigned int changedPins[GPIO_MAX_PIN];
+   unsigned int changedCount = 0;
+   unsigned int idx;
+   for (idx = 0; idx < s_pinCount; idx++)
+   {
+      unsigned int pin = s_pins[idx];
+      if (s_shadow[pin] != s_frame[pin])
+      {
+         changedPins[changedCount++] = pin;
+      }
+   }
+   if (changedCount == 0)
+   {
+      return true;
+   }
+
+   struct timespec startTime;
+   struct timespec endTime;
+   clock_gettime(CLOCK_MONOTONIC, &startTime);
+   bool isOk = s_backend->writeFrame(changedPins, changedCount, s_frame);
+   clock_gettime(CLOCK_MONOTONIC, &endTime);
+   metricsObserve(&s_stats.commit, (endTime.tv_sec - startTime.tv_sec) * 1000000000LL +
+                                   endTime.tv_nsec - startTime.tv_nsec);
+   metricsAdd(&s_stats.commitCount, 1);
+   metricsAdd(&s_stats.pinWriteCount, changedCount);
+   if (!isOk)
+   {
+      metricsAdd(&s_stats.errorCount, 1);
+   }
+   for (idx = 0; idx < changedCount; idx++)
+   {
+      // Value is unknown if writing failed, it will be written again
+      s_shadow[changedPins[idx]] = isOk ? s_frame[changedPins[idx]] : -1;
+   }
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Get statistics, values are read by metricsLoad()
+//----------------------------------------------------------------------------
+const GpioStatsT* gpioStats(void)
+{
+   return &s_stats;
+}
+
+//----------------------------------------------------------------------------
+// Release backend
+//----------------------------------------------------------------------------
+void gpioCleanup(void)
+{
+   if (s_backend)
+   {
+      s_backend->close();
+      s_backend = NULL;
+   }
+   unsigned int idx;
+   for (idx = 0; idx < s_pinCount; idx++)
+   {
+      free(s_ledName[s_pins[idx]]);
+      s_ledName[s_pins[idx]] = NULL;
+   }
+   s_pinCount = 0;
+}
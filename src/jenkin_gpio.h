@@ -0,0 +1,65 @@
+#ifndef JENKIN_GPIO_H
+#define JENKIN_GPIO_H
+
+#include <stdbool.h>
+#include "jenkin_metrics.h"
+
+// Number of gpio pins that can be controlled (pin number is u_int8 in config)
+#define GPIO_MAX_PIN 256
+
+// Default device of each gpio backend
+#define GPIO_SYSFS_DIR    "/sys/class/gpio"
+#define GPIO_CHARDEV_CHIP "/dev/gpiochip0"
+#define GPIO_LEDCLASS_DIR "/sys/class/leds"
+
+// Value of pin to blink it, only for backend that can blink by itself
+#define GPIO_BLINK 2
+
+//----------------------------------------------------------------
+// Gpio driver
+// Value of pins is staged into a frame by gpioSetValue(), then whole frame
+// is written to hardware by gpioCommit(), only pins whose value is changed
+// are written. All pins must be requested before gpioStart(), they are set
+// as output with high level (led is active low -> off). Set of pins can be
+// changed while running by gpioUpdatePins() (e.g. config is reloaded).
+// Staging and committing must be done by one thread.
+//
+// Backends:
+//    sysfs   : <dir>/gpioN/value files, one pwrite() per changed pin.
+//              Directory can be changed to a fake directory tree for testing,
+//              in that case gpioN/value and gpioN/direction files must be
+//              created before.
+//    chardev : line request of /dev/gpiochipN, all pins are requested in one
+//              request at startup and a frame is written by one ioctl()
+//    ledclass: <dir>/<led name>/ of kernel led class, led name of pin is
+//              given when pin is requested (default "gpioN"). Value 0 turns
+//              led on (max_brightness), 1 turns it off and GPIO_BLINK hands
+//              blinking off to "timer" trigger, so led blinks without any
+//              wakeup of daemon. Directory can be changed to a fake tree, in
+//              that case <led name>/brightness, trigger, delay_on and
+//              delay_off files must be created before.
+//    mock    : keep value in memory and append each committed frame to a log
+//              file (if device is given) as "<monotonic ns> <pin>=<value>..."
+//----------------------------------------------------------------
+//----------------------------------------------------------------
+// Statistics of gpio driver, written by thread which commits frames
+//----------------------------------------------------------------
+typedef struct gpioStats
+{
+   unsigned long long commitCount;  // frames which have changed pins
+   unsigned long long pinWriteCount;
+   unsigned long long errorCount;   // frames which can not be written
+   MetricsHistT commit;             // time to write a frame
+}GpioStatsT;
+
+bool gpioInit(const char* backendName, const char* device, unsigned int blinkMs);
+bool gpioRequestPin(unsigned int pin, const char* ledName);
+bool gpioStart(void);
+bool gpioUpdatePins(const unsigned int* pins, const char* const* ledNames, unsigned int pinCount);
+bool gpioCanBlink(void);
+void gpioSetValue(unsigned int pin, int value);
+bool gpioCommit(void);
+void gpioCleanup(void);
+const GpioStatsT* gpioStats(void);
+
+#endif
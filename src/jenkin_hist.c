@@ -0,0 +1,560 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include "jenkin_mon.h"
+#include "jenkin_history.h"
+
+//--------------------------------------------------------------------------------------------------
+// Query tool of history log which is written by jenkin_mon --history DIR
+//
+// List transitions of jobs and groups in a time range:
+//    $./jenkin_hist -d DIR --from 2026-10-01 --to 2026-10-02 [--name cphw]
+// Summary of each group in a time range: time when group is monitored, up
+// (success), red (fail), unknown (server is unreachable or jobs are not found),
+// building, disabled, number of red periods and the longest one. Time when
+// jenkin_mon is not running is not counted, unknown time is not counted as up
+// or red time.
+//    $./jenkin_hist -d DIR --from -7d --summary
+// Builds which are indexed by jenkin_backfill from JENKINS_HOME and started
+// in a time range, in order of job and number:
+//    $./jenkin_hist -d DIR --from 2026-01-01 --builds [--name /job/cphw_1]
+// Time is epoch second, YYYY-MM-DD[THH:MM[:SS]] (local time) or -N[s|m|h|d]
+// before now.
+// Segments are mapped and scanned in place, a summary reads all records
+// before the end of range because state of groups at start of range is
+// needed.
+//--------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------
+// Summary of one group
+//----------------------------------------------------------------
+typedef struct histGroup
+{
+   bool isKnown;                    // status is known (daemon runs, group exists)
+   u_int8 status;                   // packed group status
+   u_int8 color;                    // ColorE of led of group
+   int64 sinceMs;                   // status is set at this time
+   int64 redSinceMs;                // start of current red period
+   int64 monitoredMs;
+   int64 upMs;
+   int64 redMs;
+   int64 unknownMs;
+   int64 buildingMs;
+   int64 disabledMs;
+   int64 longestRedMs;
+   u_int32 redCount;
+   bool isSeen;                     // group is known in range
+}HistGroupT;
+
+typedef struct histSummary
+{
+   HistGroupT* p_groups;            // indexed by id
+   u_int32 groupCount;
+   int64 fromMs;
+   int64 toMs;
+}HistSummaryT;
+
+typedef struct histList
+{
+   const HistoryReaderT* p_reader;
+   const bool* p_isSelected;        // NULL -> all ids
+}HistListT;
+
+static const char* s_colorNames[] =
+{
+   "notbuilt", "disabled", "red", "green", "blue", "yellow", "cyan", "magenta", "white", "noColor"
+};
+
+static const char* s_resultNames[] =
+{
+   "-", "SUCCESS", "UNSTABLE", "FAILURE", "NOT_BUILT", "ABORTED"
+};
+
+//----------------------------------------------------------------------------
+// Get wall clock time in milli second
+//----------------------------------------------------------------------------
+static int64 wallMs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   return (int64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+//----------------------------------------------------------------------------
+// Parse time of command line to milli second
+// return false if time has wrong format
+//----------------------------------------------------------------------------
+static bool parseTime(const char* str, int64* p_timeMs)
+{
+   char* p_end = NULL;
+   if (str[0] == '-')
+   {
+      long long value = strtoll(str + 1, &p_end, 10);
+      long long unitMs = 1000;
+      switch (*p_end)
+      {
+         case 0:
+         case 's': unitMs = 1000; break;
+         case 'm': unitMs = 60 * 1000; break;
+         case 'h': unitMs = 3600 * 1000; break;
+         case 'd': unitMs = 86400 * 1000LL; break;
+         default: return false;
+      }
+      *p_timeMs = wallMs() - value * unitMs;
+      return true;
+   }
+
+   long long value = strtoll(str, &p_end, 10);
+   if ((p_end != str) && !*p_end)
+   {
+      *p_timeMs = value * 1000;
+      return true;
+   }
+
+   static const char* formats[] = {"%Y-%m-%dT%H:%M:%S", "%Y-%m-%dT%H:%M", "%Y-%m-%d"};
+   unsigned int idx;
+   for (idx = 0; idx < sizeof(formats) / sizeof(formats[0]); idx++)
+   {
+      struct tm tm;
+      memset(&tm, 0, sizeof(tm));
+      p_end = strptime(str, formats[idx], &tm);
+      if (p_end && !*p_end)
+      {
+         tm.tm_isdst = -1;
+         *p_timeMs = (int64)mktime(&tm) * 1000;
+         return true;
+      }
+   }
+   return false;
+}
+
+//----------------------------------------------------------------------------
+// Format time in milli second as local time
+//----------------------------------------------------------------------------
+static void formatTime(int64 timeMs, char* str, size_t size)
+{
+   time_t sec = timeMs / 1000;
+   struct tm tm;
+   localtime_r(&sec, &tm);
+   size_t len = strftime(str, size, "%Y-%m-%d %H:%M:%S", &tm);
+   snprintf(str + len, size - len, ".%03lld", (long long)(timeMs % 1000));
+}
+
+//----------------------------------------------------------------------------
+// Format duration in milli second as [Nd]HH:MM:SS
+//----------------------------------------------------------------------------
+static void formatDuration(int64 durationMs, char* str, size_t size)
+{
+   long long sec = durationMs / 1000;
+   if (sec >= 86400)
+   {
+      snprintf(str, size, "%lldd%02lld:%02lld:%02lld", sec / 86400, sec % 86400 / 3600,
+               sec % 3600 / 60, sec % 60);
+   }
+   else
+   {
+      snprintf(str, size, "%02lld:%02lld:%02lld", sec / 3600, sec % 3600 / 60, sec % 60);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Format color of record
+//----------------------------------------------------------------------------
+static void formatColor(const HistoryRecordT* p_record, char* str, size_t size)
+{
+   const char* colorName = (p_record->color <= NON_COLOR) ? s_colorNames[p_record->color] : "?";
+   snprintf(str, size, "%s%s", colorName, (p_record->flags & HISTORY_ANIME) ? "_anime" : "");
+}
+
+//----------------------------------------------------------------------------
+// Print one record of time range
+//----------------------------------------------------------------------------
+static bool printRecord(void* p_arg, const HistoryRecordT* p_record)
+{
+   HistListT* p_list = (HistListT*)p_arg;
+   if (p_list->p_isSelected &&
+       ((p_record->id >= p_list->p_reader->nameCount) || !p_list->p_isSelected[p_record->id]))
+   {
+      return true;
+   }
+   char timeStr[40];
+   char colorStr[32];
+   formatTime(p_record->timeMs, timeStr, sizeof(timeStr));
+   formatColor(p_record, colorStr, sizeof(colorStr));
+   const char* name = historyNameOf(p_list->p_reader, p_record->id);
+   switch (p_record->kind)
+   {
+      case HISTORY_START:
+         printf("%s start\n", timeStr);
+         break;
+      case HISTORY_STOP:
+         printf("%s stop\n", timeStr);
+         break;
+      case HISTORY_JOB:
+      {
+         char buildStr[40] = "";
+         if (p_record->buildTime)
+         {
+            formatTime((int64)p_record->buildTime * 1000, buildStr, sizeof(buildStr));
+            buildStr[19] = 0;
+         }
+         printf("%s job   %-30s %-16s #%-6u %-9s %s\n", timeStr, name, colorStr,
+                p_record->buildNumber,
+                (p_record->state <= ABORTED_RESULT) ? s_resultNames[p_record->state] : "?",
+                buildStr);
+         break;
+      }
+      case HISTORY_GROUP:
+      {
+         if (p_record->flags & HISTORY_REMOVED)
+         {
+            printf("%s group %-30s removed\n", timeStr, name);
+            break;
+         }
+         char statusStr[64];
+         snprintf(statusStr, sizeof(statusStr), "%s%s%s%s%s",
+                  (p_record->state & GROUP_STA_ALL_DISABLE) ? "disabled" :
+                  (p_record->state & GROUP_STA_SUCCESS) ? "success" : "fail",
+                  (p_record->state & GROUP_STA_BUILDING) ? " building" : "",
+                  (p_record->state & GROUP_STA_THRESHOLD) ? " threshold" : "",
+                  (p_record->state & GROUP_STA_SUCCESS_TIMEOUT) ? " success_timeout" : "",
+                  (p_record->state & GROUP_STA_UNREACHABLE) ? " unreachable" : "");
+         printf("%s group %-30s %-16s %s\n", timeStr, name, colorStr, statusStr);
+         break;
+      }
+      default:
+         break;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Check that state of jobs of group is unknown: server is unreachable or led
+// has no color (e.g. jobs are not found in server)
+//----------------------------------------------------------------------------
+static bool isUnknownStatus(u_int8 status, u_int8 color)
+{
+   return (status & GROUP_STA_UNREACHABLE) || (color == NON_COLOR);
+}
+
+//----------------------------------------------------------------------------
+// Check that packed group status is red (fail)
+//----------------------------------------------------------------------------
+static bool isRedStatus(u_int8 status, u_int8 color)
+{
+   return !isUnknownStatus(status, color) &&
+          !(status & (GROUP_STA_ALL_DISABLE | GROUP_STA_SUCCESS));
+}
+
+//----------------------------------------------------------------------------
+// Account status of group from its start to endMs, the part which is in
+// range of summary is counted
+//----------------------------------------------------------------------------
+static void closeGroupSpan(HistSummaryT* p_summary, HistGroupT* p_group, int64 endMs)
+{
+   if (!p_group->isKnown)
+   {
+      return;
+   }
+   int64 startMs = (p_group->sinceMs > p_summary->fromMs) ? p_group->sinceMs : p_summary->fromMs;
+   int64 stopMs = (endMs < p_summary->toMs) ? endMs : p_summary->toMs;
+   if (stopMs > startMs)
+   {
+      int64 spanMs = stopMs - startMs;
+      p_group->isSeen = true;
+      p_group->monitoredMs += spanMs;
+      if (isUnknownStatus(p_group->status, p_group->color))
+      {
+         p_group->unknownMs += spanMs;
+      }
+      else if (p_group->status & GROUP_STA_ALL_DISABLE)
+      {
+         p_group->disabledMs += spanMs;
+      }
+      else if (p_group->status & GROUP_STA_SUCCESS)
+      {
+         p_group->upMs += spanMs;
+      }
+      else
+      {
+         p_group->redMs += spanMs;
+      }
+      if (p_group->status & GROUP_STA_BUILDING)
+      {
+         p_group->buildingMs += spanMs;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Red period of group is finished at endMs
+//----------------------------------------------------------------------------
+static void closeRedPeriod(HistSummaryT* p_summary, HistGroupT* p_group, int64 endMs)
+{
+   int64 startMs = (p_group->redSinceMs > p_summary->fromMs) ? p_group->redSinceMs :
+                   p_summary->fromMs;
+   int64 stopMs = (endMs < p_summary->toMs) ? endMs : p_summary->toMs;
+   if (stopMs > startMs)
+   {
+      p_group->redCount++;
+      if (stopMs - startMs > p_group->longestRedMs)
+      {
+         p_group->longestRedMs = stopMs - startMs;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Status of group becomes unknown at endMs (daemon stops, group is removed)
+//----------------------------------------------------------------------------
+static void forgetGroup(HistSummaryT* p_summary, HistGroupT* p_group, int64 endMs)
+{
+   closeGroupSpan(p_summary, p_group, endMs);
+   if (p_group->isKnown && isRedStatus(p_group->status, p_group->color))
+   {
+      closeRedPeriod(p_summary, p_group, endMs);
+   }
+   p_group->isKnown = false;
+}
+
+//----------------------------------------------------------------------------
+// Account one record to summary of groups
+//----------------------------------------------------------------------------
+static bool summarizeRecord(void* p_arg, const HistoryRecordT* p_record)
+{
+   HistSummaryT* p_summary = (HistSummaryT*)p_arg;
+   if ((p_record->kind == HISTORY_START) || (p_record->kind == HISTORY_STOP))
+   {
+      // Daemon which is not stopped cleanly is counted until it starts again
+      u_int32 id;
+      for (id = 0; id < p_summary->groupCount; id++)
+      {
+         forgetGroup(p_summary, &p_summary->p_groups[id], p_record->timeMs);
+      }
+      return true;
+   }
+   if ((p_record->kind != HISTORY_GROUP) || (p_record->id >= p_summary->groupCount))
+   {
+      return true;
+   }
+
+   HistGroupT* p_group = &p_summary->p_groups[p_record->id];
+   if (p_record->flags & HISTORY_REMOVED)
+   {
+      forgetGroup(p_summary, p_group, p_record->timeMs);
+      return true;
+   }
+   bool wasRed = p_group->isKnown && isRedStatus(p_group->status, p_group->color);
+   bool isRed = isRedStatus(p_record->state, p_record->color);
+   closeGroupSpan(p_summary, p_group, p_record->timeMs);
+   if (wasRed && !isRed)
+   {
+      closeRedPeriod(p_summary, p_group, p_record->timeMs);
+   }
+   else if (!wasRed && isRed)
+   {
+      p_group->redSinceMs = p_record->timeMs;
+   }
+   p_group->isKnown = true;
+   p_group->status = p_record->state;
+   p_group->color = p_record->color;
+   p_group->sinceMs = p_record->timeMs;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Print summary of all groups which are known in time range
+//----------------------------------------------------------------------------
+static void printSummary(const HistoryReaderT* p_reader, HistSummaryT* p_summary,
+                         const bool* p_isSelected)
+{
+   // Groups which are still known are counted until end of range or now
+   int64 nowMs = wallMs();
+   int64 endMs = (p_summary->toMs < nowMs) ? p_summary->toMs : nowMs;
+   u_int32 id;
+   printf("%-20s %12s %12s %12s %12s %12s %12s %6s %12s %7s\n", "group", "monitored", "up",
+          "red", "unknown", "building", "disabled", "reds", "longest_red", "up_pct");
+   for (id = 0; id < p_summary->groupCount; id++)
+   {
+      HistGroupT* p_group = &p_summary->p_groups[id];
+      forgetGroup(p_summary, p_group, endMs);
+      if (!p_group->isSeen || (p_isSelected && !p_isSelected[id]))
+      {
+         continue;
+      }
+      char monitored[24], up[24], red[24], unknown[24], building[24], disabled[24];
+      char longestRed[24];
+      formatDuration(p_group->monitoredMs, monitored, sizeof(monitored));
+      formatDuration(p_group->upMs, up, sizeof(up));
+      formatDuration(p_group->redMs, red, sizeof(red));
+      formatDuration(p_group->unknownMs, unknown, sizeof(unknown));
+      formatDuration(p_group->buildingMs, building, sizeof(building));
+      formatDuration(p_group->disabledMs, disabled, sizeof(disabled));
+      formatDuration(p_group->longestRedMs, longestRed, sizeof(longestRed));
+      int64 countedMs = p_group->upMs + p_group->redMs;
+      printf("%-20s %12s %12s %12s %12s %12s %12s %6u %12s %6.2f%%\n",
+             historyNameOf(p_reader, id), monitored, up, red, unknown, building, disabled,
+             p_group->redCount, longestRed,
+             countedMs ? 100.0 * p_group->upMs / countedMs : 100.0);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Print builds of index of builds which are started in time range
+// return number of builds which are printed
+//----------------------------------------------------------------------------
+static size_t printBuilds(const HistoryReaderT* p_reader, const HistoryBuildsT* p_index,
+                          const bool* p_isSelected, int64 fromMs, int64 toMs)
+{
+   size_t printCount = 0;
+   size_t idx;
+   for (idx = 0; idx < p_index->count; idx++)
+   {
+      const HistoryBuildT* p_build = &p_index->p_builds[idx];
+      if ((p_build->timeMs < fromMs) || (p_build->timeMs >= toMs) ||
+          (p_isSelected &&
+           ((p_build->jobId >= p_reader->nameCount) || !p_isSelected[p_build->jobId])))
+      {
+         continue;
+      }
+      char timeStr[40];
+      char durationStr[32];
+      formatTime(p_build->timeMs, timeStr, sizeof(timeStr));
+      formatDuration(p_build->durationMs, durationStr, sizeof(durationStr));
+      printf("%s build %-30s #%-6u %-9s %s%s\n", timeStr,
+             historyNameOf(p_reader, p_build->jobId), p_build->number,
+             (p_build->result <= ABORTED_RESULT) ? s_resultNames[p_build->result] : "?",
+             durationStr, (p_build->flags & HISTORY_REMOVED) ? " removed" : "");
+      printCount++;
+   }
+   return printCount;
+}
+
+//----------------------------------------------------------------------------
+// Main function
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+   const char* dir = NULL;
+   const char* name = NULL;
+   bool isSummary = false;
+   bool isBuilds = false;
+   int64 fromMs = INT64_MIN;
+   int64 toMs = INT64_MAX;
+   bool isOk = true;
+   struct option longOptions[] =
+   {
+      {"dir"        ,required_argument ,0 ,'d'},
+      {"from"       ,required_argument ,0 ,'f'},
+      {"to"         ,required_argument ,0 ,'t'},
+      {"name"       ,required_argument ,0 ,'n'},
+      {"summary"    ,no_argument       ,0 ,'s'},
+      {"builds"     ,no_argument       ,0 ,'b'},
+      {0            ,0                 ,0 ,0  }
+   };
+
+   int returnCharacter;
+   while ((returnCharacter = getopt_long(argc, argv, "d:f:t:n:sb", longOptions, NULL)) != -1)
+   {
+      switch (returnCharacter)
+      {
+         case 'd': dir = optarg; break;
+         case 'f': isOk = isOk && parseTime(optarg, &fromMs); break;
+         case 't': isOk = isOk && parseTime(optarg, &toMs); break;
+         case 'n': name = optarg; break;
+         case 's': isSummary = true; break;
+         case 'b': isBuilds = true; break;
+         default: isOk = false; break;
+      }
+   }
+   if (!isOk || !dir || (isSummary && isBuilds) || (optind < argc))
+   {
+      printf("usage:\n"
+             "transitions of jobs and groups in history log of jenkin_mon --history DIR\n"
+             "./jenkin_hist -d DIR [--from TIME] [--to TIME] [--name JOB_OR_GROUP]\n"
+             "monitored, up, red, building time of each group\n"
+             "./jenkin_hist -d DIR [--from TIME] [--to TIME] [--name GROUP] --summary\n"
+             "builds which are indexed by jenkin_backfill, by start time\n"
+             "./jenkin_hist -d DIR [--from TIME] [--to TIME] [--name JOB] --builds\n"
+             "TIME is epoch second, YYYY-MM-DD[THH:MM[:SS]] or -N[s|m|h|d] before now\n"
+             "job name is its path and name in config, e.g. /job/cphw_1\n");
+      return 1;
+   }
+
+   HistoryReaderT reader;
+   if (!historyReaderOpen(&reader, dir))
+   {
+      return 1;
+   }
+
+   // Ids of the name, a job and a group may have the same name
+   bool* p_isSelected = NULL;
+   if (name)
+   {
+      p_isSelected = calloc(reader.nameCount ? reader.nameCount : 1, sizeof(bool));
+      u_int32 id;
+      for (id = 0; p_isSelected && (id < reader.nameCount); id++)
+      {
+         p_isSelected[id] = reader.names[id] && !strcmp(reader.names[id], name);
+      }
+   }
+
+   struct timespec startTs, endTs;
+   clock_gettime(CLOCK_MONOTONIC, &startTs);
+   size_t scanCount = 0;
+   if (isBuilds)
+   {
+      HistoryBuildsT index;
+      if (!historyBuildsOpen(&index, dir))
+      {
+         printf("History %s does not have index of builds, it is written by jenkin_backfill\n",
+                dir);
+         free(p_isSelected);
+         historyReaderClose(&reader);
+         return 1;
+      }
+      scanCount = printBuilds(&reader, &index, p_isSelected, fromMs, toMs);
+      clock_gettime(CLOCK_MONOTONIC, &endTs);
+      fprintf(stderr, "printed %zu of %zu builds in %.3f ms\n", scanCount, index.count,
+              (endTs.tv_sec - startTs.tv_sec) * 1e3 + (endTs.tv_nsec - startTs.tv_nsec) / 1e6);
+      historyBuildsClose(&index);
+      free(p_isSelected);
+      historyReaderClose(&reader);
+      return 0;
+   }
+   if (isSummary)
+   {
+      HistSummaryT summary;
+      summary.groupCount = reader.nameCount;
+      summary.p_groups = calloc(summary.groupCount ? summary.groupCount : 1, sizeof(HistGroupT));
+      summary.fromMs = fromMs;
+      summary.toMs = toMs;
+      if (summary.p_groups)
+      {
+         scanCount = historyScan(&reader, INT64_MIN, toMs, summarizeRecord, &summary);
+         printSummary(&reader, &summary, p_isSelected);
+      }
+      free(summary.p_groups);
+   }
+   else
+   {
+      HistListT list;
+      list.p_reader = &reader;
+      list.p_isSelected = p_isSelected;
+      scanCount = historyScan(&reader, fromMs, toMs, printRecord, &list);
+   }
+   clock_gettime(CLOCK_MONOTONIC, &endTs);
+   fprintf(stderr, "scanned %zu of %zu records in %u segments in %.3f ms\n", scanCount,
+           reader.recordCount, reader.segmentCount,
+           (endTs.tv_sec - startTs.tv_sec) * 1e3 + (endTs.tv_nsec - startTs.tv_nsec) / 1e6);
+
+   free(p_isSelected);
+   historyReaderClose(&reader);
+   return 0;
+}
@@ -0,0 +1,814 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include "jenkin_history.h"
+
+// Records are read in place from mapped segments
+_Static_assert(sizeof(HistoryRecordT) == 24, "history record must be 24 bytes");
+_Static_assert(sizeof(HistoryHeaderT) % sizeof(int64_t) == 0, "records must be aligned");
+_Static_assert(sizeof(HistoryBuildT) == 24, "history build must be 24 bytes");
+
+//----------------------------------------------------------------------------
+// Get wall clock time in milli second
+//----------------------------------------------------------------------------
+static int64_t wallMs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+//----------------------------------------------------------------------------
+// Hash of kind and name for name table (FNV-1a)
+//----------------------------------------------------------------------------
+static uint32_t hashName(uint8_t kind, const char* name)
+{
+   uint32_t hash = (2166136261u ^ kind) * 16777619u;
+   for (; *name; name++)
+   {
+      hash = (hash ^ (unsigned char)*name) * 16777619u;
+   }
+   return hash;
+}
+
+//----------------------------------------------------------------------------
+// Find slot of name in name table, empty slot if name is not in table
+//----------------------------------------------------------------------------
+static HistoryNameT* findNameSlot(HistoryLogT* p_log, uint8_t kind, const char* name)
+{
+   uint32_t mask = p_log->nameSize - 1;
+   uint32_t slot;
+   for (slot = hashName(kind, name) & mask; p_log->p_names[slot].name; slot = (slot + 1) & mask)
+   {
+      HistoryNameT* p_name = &p_log->p_names[slot];
+      if ((p_name->kind == kind) && !strcmp(p_name->name, name))
+      {
+         break;
+      }
+   }
+   return &p_log->p_names[slot];
+}
+
+//----------------------------------------------------------------------------
+// Add name to name table, table is kept at most half full
+// return false if memory can not be allocated
+//----------------------------------------------------------------------------
+static bool addName(HistoryLogT* p_log, uint32_t id, uint8_t kind, const char* name)
+{
+   if ((p_log->nameCount + 1) * 2 > p_log->nameSize)
+   {
+      uint32_t oldSize = p_log->nameSize;
+      HistoryNameT* p_oldNames = p_log->p_names;
+      uint32_t newSize = oldSize ? oldSize * 2 : 64;
+      HistoryNameT* p_newNames = calloc(newSize, sizeof(HistoryNameT));
+      if (!p_newNames)
+      {
+         printf("Can not allocate history names\n");
+         return false;
+      }
+      p_log->p_names = p_newNames;
+      p_log->nameSize = newSize;
+      uint32_t idx;
+      for (idx = 0; idx < oldSize; idx++)
+      {
+         if (p_oldNames[idx].name)
+         {
+            *findNameSlot(p_log, p_oldNames[idx].kind, p_oldNames[idx].name) = p_oldNames[idx];
+         }
+      }
+      free(p_oldNames);
+   }
+
+   HistoryNameT* p_name = findNameSlot(p_log, kind, name);
+   if (!p_name->name)
+   {
+      p_name->name = strdup(name);
+      if (!p_name->name)
+      {
+         printf("Can not allocate history name %s\n", name);
+         return false;
+      }
+      p_log->nameCount++;
+   }
+   p_name->id = id;
+   p_name->kind = kind;
+   if (id >= p_log->nextId)
+   {
+      p_log->nextId = id + 1;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Parse one line of names file: <id> <j|g> <name>
+// return false if line is not a name
+//----------------------------------------------------------------------------
+static bool parseNameLine(char* line, uint32_t* p_id, uint8_t* p_kind, char** p_name)
+{
+   char* p_end = NULL;
+   unsigned long id = strtoul(line, &p_end, 10);
+   if ((p_end == line) || (p_end[0] != ' ') || ((p_end[1] != 'j') && (p_end[1] != 'g')) ||
+       (p_end[2] != ' ') || !id)
+   {
+      return false;
+   }
+   *p_id = id;
+   *p_kind = (p_end[1] == 'j') ? HISTORY_JOB : HISTORY_GROUP;
+   *p_name = p_end + 3;
+   (*p_name)[strcspn(*p_name, "\n")] = 0;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Get index of the last segment in history directory
+// return -1 if directory does not have any segment
+//----------------------------------------------------------------------------
+static int64_t lastSegmentIdx(const char* dir)
+{
+   int64_t lastIdx = -1;
+   DIR* p_dir = opendir(dir);
+   if (!p_dir)
+   {
+      return -1;
+   }
+   struct dirent* p_ent = NULL;
+   while ((p_ent = readdir(p_dir)) != NULL)
+   {
+      unsigned int idx;
+      char tail;
+      if ((sscanf(p_ent->d_name, "history-%u.lo%c", &idx, &tail) == 2) && (tail == 'g') &&
+          ((int64_t)idx > lastIdx))
+      {
+         lastIdx = idx;
+      }
+   }
+   closedir(p_dir);
+   return lastIdx;
+}
+
+//----------------------------------------------------------------------------
+// Open segment for appending, it is created with header if it does not
+// exist, partial record at its end (crash while writing) is cut
+// return false if segment can not be opened
+//----------------------------------------------------------------------------
+static bool openSegment(HistoryLogT* p_log, uint32_t segmentIdx)
+{
+   char path[PATH_MAX];
+   char name[64];
+   snprintf(name, sizeof(name), HISTORY_SEGMENT_FORMAT, segmentIdx);
+   snprintf(path, sizeof(path), "%s/%s", p_log->dir, name);
+   int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+   if (fd < 0)
+   {
+      printf("Can not open history segment %s: %s\n", path, strerror(errno));
+      return false;
+   }
+
+   HistoryHeaderT header;
+   struct stat st;
+   if (fstat(fd, &st) < 0)
+   {
+      printf("Can not stat history segment %s: %s\n", path, strerror(errno));
+      close(fd);
+      return false;
+   }
+   if (st.st_size < (off_t)sizeof(HistoryHeaderT))
+   {
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+      header.version = HISTORY_VERSION;
+      header.recordSize = sizeof(HistoryRecordT);
+      header.segmentIdx = segmentIdx;
+      header.createdMs = wallMs();
+      if ((ftruncate(fd, 0) < 0) ||
+          (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)))
+      {
+         printf("Can not write history segment %s: %s\n", path, strerror(errno));
+         close(fd);
+         return false;
+      }
+      st.st_size = sizeof(header);
+   }
+   else if ((pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) ||
+            memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) ||
+            (header.recordSize != sizeof(HistoryRecordT)))
+   {
+      printf("History segment %s has wrong format\n", path);
+      close(fd);
+      return false;
+   }
+
+   size_t count = (st.st_size - sizeof(HistoryHeaderT)) / sizeof(HistoryRecordT);
+   off_t size = sizeof(HistoryHeaderT) + count * sizeof(HistoryRecordT);
+   if ((size != st.st_size) && (ftruncate(fd, size) < 0))
+   {
+      printf("Can not cut history segment %s: %s\n", path, strerror(errno));
+      close(fd);
+      return false;
+   }
+   if (count)
+   {
+      HistoryRecordT lastRecord;
+      if (pread(fd, &lastRecord, sizeof(lastRecord), size - sizeof(lastRecord)) ==
+          (ssize_t)sizeof(lastRecord))
+      {
+         p_log->lastTimeMs = lastRecord.timeMs;
+      }
+   }
+
+   if (p_log->fd >= 0)
+   {
+      close(p_log->fd);
+   }
+   p_log->fd = fd;
+   p_log->segmentIdx = segmentIdx;
+   p_log->recordCount = count;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Load names file of history directory
+// return false if names file can not be opened
+//----------------------------------------------------------------------------
+static bool loadNames(HistoryLogT* p_log)
+{
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/%s", p_log->dir, HISTORY_NAMES_FILE);
+   p_log->namesFd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+   if (p_log->namesFd < 0)
+   {
+      printf("Can not open history names %s: %s\n", path, strerror(errno));
+      return false;
+   }
+   FILE* p_file = fdopen(dup(p_log->namesFd), "r");
+   if (!p_file)
+   {
+      return false;
+   }
+   char line[PATH_MAX];
+   while (fgets(line, sizeof(line), p_file))
+   {
+      uint32_t id;
+      uint8_t kind;
+      char* name = NULL;
+      if (parseNameLine(line, &id, &kind, &name) && !addName(p_log, id, kind, name))
+      {
+         fclose(p_file);
+         return false;
+      }
+   }
+   fclose(p_file);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Create history directory if it does not exist and load names, names file
+// is locked so that only one process assigns ids
+// return false if names can not be loaded
+//----------------------------------------------------------------------------
+static bool openLog(HistoryLogT* p_log, const char* dir)
+{
+   memset(p_log, 0, sizeof(HistoryLogT));
+   pthread_mutex_init(&p_log->lock, NULL);
+   p_log->fd = -1;
+   p_log->namesFd = -1;
+   p_log->nextId = 1;
+   p_log->dir = strdup(dir);
+   if (!p_log->dir)
+   {
+      printf("Can not allocate history directory\n");
+      return false;
+   }
+   if ((mkdir(dir, 0755) < 0) && (errno != EEXIST))
+   {
+      printf("Can not create history directory %s: %s\n", dir, strerror(errno));
+      return false;
+   }
+   if (!loadNames(p_log))
+   {
+      return false;
+   }
+   if (flock(p_log->namesFd, LOCK_EX | LOCK_NB) < 0)
+   {
+      printf("History %s is used by other jenkin_mon or jenkin_backfill\n", dir);
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Open history log in directory, directory is created if it does not exist,
+// records are appended to the last segment. Start of daemon is recorded.
+// return false if log can not be opened
+//----------------------------------------------------------------------------
+bool historyOpen(HistoryLogT* p_log, const char* dir)
+{
+   if (!openLog(p_log, dir))
+   {
+      historyClose(p_log);
+      return false;
+   }
+   int64_t segmentIdx = lastSegmentIdx(dir);
+   if (!openSegment(p_log, (segmentIdx < 0) ? 0 : (uint32_t)segmentIdx))
+   {
+      historyClose(p_log);
+      return false;
+   }
+   p_log->isOpen = true;
+
+   HistoryRecordT record;
+   memset(&record, 0, sizeof(record));
+   record.kind = HISTORY_START;
+   return historyAppend(p_log, &record);
+}
+
+//----------------------------------------------------------------------------
+// Open only names of history log to assign ids of jobs (jenkin_backfill),
+// records can not be appended
+// return false if names can not be opened
+//----------------------------------------------------------------------------
+bool historyOpenNames(HistoryLogT* p_log, const char* dir)
+{
+   if (!openLog(p_log, dir))
+   {
+      historyClose(p_log);
+      return false;
+   }
+   p_log->isOpen = true;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Record stop of daemon and close history log
+//----------------------------------------------------------------------------
+void historyClose(HistoryLogT* p_log)
+{
+   if (p_log->isOpen && (p_log->fd >= 0))
+   {
+      HistoryRecordT record;
+      memset(&record, 0, sizeof(record));
+      record.kind = HISTORY_STOP;
+      historyAppend(p_log, &record);
+      p_log->isOpen = false;
+   }
+   if (p_log->fd >= 0)
+   {
+      close(p_log->fd);
+      p_log->fd = -1;
+   }
+   if (p_log->namesFd >= 0)
+   {
+      close(p_log->namesFd);
+      p_log->namesFd = -1;
+   }
+   uint32_t idx;
+   for (idx = 0; idx < p_log->nameSize; idx++)
+   {
+      free(p_log->p_names[idx].name);
+   }
+   free(p_log->p_names);
+   p_log->p_names = NULL;
+   p_log->nameSize = 0;
+   p_log->nameCount = 0;
+   free(p_log->dir);
+   p_log->dir = NULL;
+   pthread_mutex_destroy(&p_log->lock);
+}
+
+//----------------------------------------------------------------------------
+// Get id of job or group, a new name gets the next id and is written to
+// names file
+// return 0 if log is not open or name can not be added
+//----------------------------------------------------------------------------
+uint32_t historyIdOf(HistoryLogT* p_log, HistoryKindE kind, const char* name)
+{
+   if (!p_log->isOpen)
+   {
+      return 0;
+   }
+   pthread_mutex_lock(&p_log->lock);
+   uint32_t id = 0;
+   HistoryNameT* p_name = p_log->nameSize ? findNameSlot(p_log, kind, name) : NULL;
+   if (p_name && p_name->name)
+   {
+      id = p_name->id;
+   }
+   else if (addName(p_log, p_log->nextId, kind, name))
+   {
+      id = p_log->nextId - 1;
+      char line[PATH_MAX];
+      int len = snprintf(line, sizeof(line), "%u %c %s\n", id,
+                         (kind == HISTORY_JOB) ? 'j' : 'g', name);
+      if ((len >= (int)sizeof(line)) || (write(p_log->namesFd, line, len) != len))
+      {
+         printf("Can not write history name %s\n", name);
+      }
+   }
+   pthread_mutex_unlock(&p_log->lock);
+   return id;
+}
+
+//----------------------------------------------------------------------------
+// Append record, its time is set to now if it is 0, time of records never
+// goes back. A new segment is started when the last one is full.
+// return false if record can not be written
+//----------------------------------------------------------------------------
+bool historyAppend(HistoryLogT* p_log, HistoryRecordT* p_record)
+{
+   if (!p_log->isOpen || (p_log->fd < 0))
+   {
+      return false;
+   }
+   pthread_mutex_lock(&p_log->lock);
+   if (!p_record->timeMs)
+   {
+      p_record->timeMs = wallMs();
+   }
+   if (p_record->timeMs < p_log->lastTimeMs)
+   {
+      p_record->timeMs = p_log->lastTimeMs;
+   }
+   bool isOk = (p_log->recordCount < HISTORY_SEGMENT_RECORDS) ||
+               openSegment(p_log, p_log->segmentIdx + 1);
+   if (isOk && (write(p_log->fd, p_record, sizeof(HistoryRecordT)) != sizeof(HistoryRecordT)))
+   {
+      printf("Can not write history record: %s\n", strerror(errno));
+      isOk = false;
+   }
+   if (isOk)
+   {
+      p_log->lastTimeMs = p_record->timeMs;
+      p_log->recordCount++;
+   }
+   pthread_mutex_unlock(&p_log->lock);
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Map file of history (segment or index of builds) read only and check its
+// header
+// return NULL if file can not be mapped or has wrong format
+//----------------------------------------------------------------------------
+static void* mapHistoryFile(const char* path, const char* magic, uint32_t recordSize,
+                            size_t* p_mapSize)
+{
+   int fd = open(path, O_RDONLY | O_CLOEXEC);
+   if (fd < 0)
+   {
+      printf("Can not open history file %s: %s\n", path, strerror(errno));
+      return NULL;
+   }
+   struct stat st;
+   if ((fstat(fd, &st) < 0) || (st.st_size < (off_t)sizeof(HistoryHeaderT)))
+   {
+      printf("History file %s is too short\n", path);
+      close(fd);
+      return NULL;
+   }
+   void* p_map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (p_map == MAP_FAILED)
+   {
+      printf("Can not map history file %s: %s\n", path, strerror(errno));
+      return NULL;
+   }
+   const HistoryHeaderT* p_header = (const HistoryHeaderT*)p_map;
+   if (memcmp(p_header->magic, magic, sizeof(p_header->magic)) ||
+       (p_header->recordSize != recordSize))
+   {
+      printf("History file %s has wrong format\n", path);
+      munmap(p_map, st.st_size);
+      return NULL;
+   }
+   *p_mapSize = st.st_size;
+   return p_map;
+}
+
+//----------------------------------------------------------------------------
+// Map one segment file read only
+// return false if segment can not be mapped or has wrong format
+//----------------------------------------------------------------------------
+static bool mapSegment(const char* path, HistorySegmentT* p_segment)
+{
+   memset(p_segment, 0, sizeof(HistorySegmentT));
+   size_t mapSize = 0;
+   void* p_map = mapHistoryFile(path, HISTORY_MAGIC, sizeof(HistoryRecordT), &mapSize);
+   if (!p_map)
+   {
+      return false;
+   }
+   // Records are scanned from the start, read ahead as much as possible
+   madvise(p_map, mapSize, MADV_SEQUENTIAL);
+   p_segment->p_map = p_map;
+   p_segment->mapSize = mapSize;
+   p_segment->p_records = (const HistoryRecordT*)((const char*)p_map + sizeof(HistoryHeaderT));
+   p_segment->count = (mapSize - sizeof(HistoryHeaderT)) / sizeof(HistoryRecordT);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Load names file of history directory to array indexed by id
+//----------------------------------------------------------------------------
+static void loadReaderNames(HistoryReaderT* p_reader, const char* dir)
+{
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/%s", dir, HISTORY_NAMES_FILE);
+   FILE* p_file = fopen(path, "r");
+   if (!p_file)
+   {
+      return;
+   }
+   char line[PATH_MAX];
+   while (fgets(line, sizeof(line), p_file))
+   {
+      uint32_t id;
+      uint8_t kind;
+      char* name = NULL;
+      if (!parseNameLine(line, &id, &kind, &name))
+      {
+         continue;
+      }
+      if (id >= p_reader->nameCount)
+      {
+         uint32_t newCount = p_reader->nameCount ? p_reader->nameCount : 64;
+         while (newCount <= id)
+         {
+            newCount *= 2;
+         }
+         char** names = realloc(p_reader->names, newCount * sizeof(char*));
+         uint8_t* nameKinds = realloc(p_reader->nameKinds, newCount);
+         if (names)
+         {
+            p_reader->names = names;
+         }
+         if (nameKinds)
+         {
+            p_reader->nameKinds = nameKinds;
+         }
+         if (!names || !nameKinds)
+         {
+            break;
+         }
+         memset(names + p_reader->nameCount, 0, (newCount - p_reader->nameCount) * sizeof(char*));
+         memset(nameKinds + p_reader->nameCount, 0, newCount - p_reader->nameCount);
+         p_reader->nameCount = newCount;
+      }
+      free(p_reader->names[id]);
+      p_reader->names[id] = strdup(name);
+      p_reader->nameKinds[id] = kind;
+   }
+   fclose(p_file);
+}
+
+//----------------------------------------------------------------------------
+// Select segment files of history directory
+//----------------------------------------------------------------------------
+static int isSegmentFile(const struct dirent* p_ent)
+{
+   unsigned int idx;
+   char tail;
+   return (sscanf(p_ent->d_name, "history-%u.lo%c", &idx, &tail) == 2) && (tail == 'g');
+}
+
+//----------------------------------------------------------------------------
+// Map all segments of history directory in order and load names
+// return false if directory can not be read
+//----------------------------------------------------------------------------
+bool historyReaderOpen(HistoryReaderT* p_reader, const char* dir)
+{
+   memset(p_reader, 0, sizeof(HistoryReaderT));
+   struct dirent** pp_ents = NULL;
+   int entCount = scandir(dir, &pp_ents, isSegmentFile, alphasort);
+   if (entCount < 0)
+   {
+      printf("Can not read history directory %s: %s\n", dir, strerror(errno));
+      return false;
+   }
+   p_reader->p_segments = calloc(entCount ? entCount : 1, sizeof(HistorySegmentT));
+   int idx;
+   for (idx = 0; idx < entCount; idx++)
+   {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), "%s/%s", dir, pp_ents[idx]->d_name);
+      HistorySegmentT* p_segment = &p_reader->p_segments[p_reader->segmentCount];
+      if (p_reader->p_segments && mapSegment(path, p_segment))
+      {
+         p_reader->segmentCount++;
+         p_reader->recordCount += p_segment->count;
+      }
+      free(pp_ents[idx]);
+   }
+   free(pp_ents);
+   if (!p_reader->p_segments)
+   {
+      printf("Can not allocate history segments\n");
+      return false;
+   }
+   loadReaderNames(p_reader, dir);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Unmap all segments and free names
+//----------------------------------------------------------------------------
+void historyReaderClose(HistoryReaderT* p_reader)
+{
+   uint32_t idx;
+   for (idx = 0; idx < p_reader->segmentCount; idx++)
+   {
+      munmap(p_reader->p_segments[idx].p_map, p_reader->p_segments[idx].mapSize);
+   }
+   free(p_reader->p_segments);
+   for (idx = 0; idx < p_reader->nameCount; idx++)
+   {
+      free(p_reader->names[idx]);
+   }
+   free(p_reader->names);
+   free(p_reader->nameKinds);
+   memset(p_reader, 0, sizeof(HistoryReaderT));
+}
+
+//----------------------------------------------------------------------------
+// Get name of job or group, "?" if id is not in names file
+//----------------------------------------------------------------------------
+const char* historyNameOf(const HistoryReaderT* p_reader, uint32_t id)
+{
+   return ((id < p_reader->nameCount) && p_reader->names[id]) ? p_reader->names[id] : "?";
+}
+
+//----------------------------------------------------------------------------
+// Find the first record of segment whose time is not before timeMs
+// (records are in time order), count of segment if there is no such record
+//----------------------------------------------------------------------------
+size_t historyLowerBound(const HistorySegmentT* p_segment, int64_t timeMs)
+{
+   size_t low = 0;
+   size_t high = p_segment->count;
+   while (low < high)
+   {
+      size_t mid = low + (high - low) / 2;
+      if (p_segment->p_records[mid].timeMs < timeMs)
+      {
+         low = mid + 1;
+      }
+      else
+      {
+         high = mid;
+      }
+   }
+   return low;
+}
+
+//----------------------------------------------------------------------------
+// Pass records whose time is in [fromMs, toMs) to callback in time order,
+// segments out of range are skipped and the first record is found by binary
+// search. Scan is stopped when callback returns false.
+// return number of records which are passed to callback
+//----------------------------------------------------------------------------
+size_t historyScan(const HistoryReaderT* p_reader, int64_t fromMs, int64_t toMs,
+                   HistoryRecordCallbackT callback, void* p_arg)
+{
+   size_t scanCount = 0;
+   uint32_t segmentIdx;
+   for (segmentIdx = 0; segmentIdx < p_reader->segmentCount; segmentIdx++)
+   {
+      const HistorySegmentT* p_segment = &p_reader->p_segments[segmentIdx];
+      if (!p_segment->count || (p_segment->p_records[p_segment->count - 1].timeMs < fromMs))
+      {
+         continue;
+      }
+      if (p_segment->p_records[0].timeMs >= toMs)
+      {
+         break;
+      }
+      size_t idx;
+      for (idx = historyLowerBound(p_segment, fromMs); idx < p_segment->count; idx++)
+      {
+         const HistoryRecordT* p_record = &p_segment->p_records[idx];
+         if (p_record->timeMs >= toMs)
+         {
+            return scanCount;
+         }
+         scanCount++;
+         if (!callback(p_arg, p_record))
+         {
+            return scanCount;
+         }
+      }
+   }
+   return scanCount;
+}
+
+//----------------------------------------------------------------------------
+// Write index of builds to history directory, builds must be sorted by job
+// id and number. Index is written to a temporary file which replaces the old
+// index, so a daemon which maps the old one is not disturbed.
+// return false if index can not be written
+//----------------------------------------------------------------------------
+bool historyWriteBuilds(const char* dir, const HistoryBuildT* p_builds, size_t count)
+{
+   char path[PATH_MAX];
+   char tmpPath[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/%s", dir, HISTORY_BUILDS_FILE);
+   snprintf(tmpPath, sizeof(tmpPath), "%s/%s.tmp", dir, HISTORY_BUILDS_FILE);
+   FILE* p_file = fopen(tmpPath, "w");
+   if (!p_file)
+   {
+      printf("Can not create history index %s: %s\n", tmpPath, strerror(errno));
+      return false;
+   }
+   HistoryHeaderT header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, HISTORY_BUILDS_MAGIC, sizeof(header.magic));
+   header.version = HISTORY_VERSION;
+   header.recordSize = sizeof(HistoryBuildT);
+   header.createdMs = wallMs();
+   bool isOk = (fwrite(&header, sizeof(header), 1, p_file) == 1) &&
+               (fwrite(p_builds, sizeof(HistoryBuildT), count, p_file) == count) &&
+               !fflush(p_file) && !fsync(fileno(p_file));
+   isOk = !fclose(p_file) && isOk;
+   if (!isOk || (rename(tmpPath, path) < 0))
+   {
+      printf("Can not write history index %s: %s\n", path, strerror(errno));
+      unlink(tmpPath);
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Map index of builds of history directory read only
+// return false if index does not exist or has wrong format
+//----------------------------------------------------------------------------
+bool historyBuildsOpen(HistoryBuildsT* p_index, const char* dir)
+{
+   char path[PATH_MAX];
+   memset(p_index, 0, sizeof(HistoryBuildsT));
+   snprintf(path, sizeof(path), "%s/%s", dir, HISTORY_BUILDS_FILE);
+   if (access(path, F_OK) < 0)
+   {
+      return false;
+   }
+   p_index->p_map = mapHistoryFile(path, HISTORY_BUILDS_MAGIC, sizeof(HistoryBuildT),
+                                   &p_index->mapSize);
+   if (!p_index->p_map)
+   {
+      return false;
+   }
+   p_index->p_builds = (const HistoryBuildT*)((const char*)p_index->p_map +
+                                              sizeof(HistoryHeaderT));
+   p_index->count = (p_index->mapSize - sizeof(HistoryHeaderT)) / sizeof(HistoryBuildT);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Unmap index of builds
+//----------------------------------------------------------------------------
+void historyBuildsClose(HistoryBuildsT* p_index)
+{
+   if (p_index->p_map)
+   {
+      munmap(p_index->p_map, p_index->mapSize);
+   }
+   memset(p_index, 0, sizeof(HistoryBuildsT));
+}
+
+//----------------------------------------------------------------------------
+// Find builds of job in index by binary search, they are in order of number
+// return number of builds of job
+//----------------------------------------------------------------------------
+size_t historyBuildsOf(const HistoryBuildsT* p_index, uint32_t jobId,
+                       const HistoryBuildT** pp_first)
+{
+   size_t low = 0;
+   size_t high = p_index->count;
+   while (low < high)
+   {
+      size_t mid = low + (high - low) / 2;
+      if (p_index->p_builds[mid].jobId < jobId)
+      {
+         low = mid + 1;
+      }
+      else
+      {
+         high = mid;
+      }
+   }
+   size_t end = low;
+   while ((end < p_index->count) && (p_index->p_builds[end].jobId == jobId))
+   {
+      end++;
+   }
+   *pp_first = p_index->p_builds + low;
+   return end - low;
+}
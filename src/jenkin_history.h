@@ -0,0 +1,174 @@
+#ifndef JENKIN_HISTORY_H
+#define JENKIN_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define HISTORY_MAGIC            "JKHIST01"
+#define HISTORY_VERSION          1
+
+// A new segment is started when segment has this number of records
+// (24 MB of records)
+#define HISTORY_SEGMENT_RECORDS  (1u << 20)
+
+// Segment files and names file in history directory
+#define HISTORY_SEGMENT_FORMAT   "history-%06u.log"
+#define HISTORY_NAMES_FILE       "names"
+
+// Index of builds which is written by jenkin_backfill from JENKINS_HOME
+#define HISTORY_BUILDS_MAGIC     "JKBLDS01"
+#define HISTORY_BUILDS_FILE      "builds.idx"
+
+//----------------------------------------------------------------
+// Kind of record
+//----------------------------------------------------------------
+typedef enum historyKind
+{
+   HISTORY_START = 1,            // daemon is started, states before are unknown
+   HISTORY_STOP  = 2,            // daemon is stopped
+   HISTORY_JOB   = 3,            // state of job is changed
+   HISTORY_GROUP = 4             // status or led of group is changed
+}HistoryKindE;
+
+// Flags of record
+#define HISTORY_ANIME            0x01
+#define HISTORY_REMOVED          0x02     // group is removed from config, build is
+                                          // deleted from JENKINS_HOME
+
+//----------------------------------------------------------------
+// Fixed size record, records are appended in time order (time never goes
+// back in one log even if wall clock does)
+//----------------------------------------------------------------
+typedef struct historyRecord
+{
+   int64_t timeMs;               // wall clock of transition
+   uint32_t id;                  // id of job or group in names file, 0 for start/stop
+   uint32_t buildNumber;         // job: number of last build, 0 if unknown
+   uint32_t buildTime;           // job: start of last build in second, 0 if unknown
+   uint8_t kind;                 // HistoryKindE
+   uint8_t color;                // ColorE of job or led of group
+   uint8_t flags;                // HISTORY_ANIME, HISTORY_REMOVED
+   uint8_t state;                // job: BuildResultE, group: packed group status
+}HistoryRecordT;
+
+//----------------------------------------------------------------
+// Header of segment file, records follow it
+//----------------------------------------------------------------
+typedef struct historyHeader
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t recordSize;
+   uint32_t segmentIdx;
+   uint32_t reserved;
+   int64_t createdMs;
+}HistoryHeaderT;
+
+//----------------------------------------------------------------
+// Name of job or group which is written to names file, one line per name:
+//    <id> <j|g> <name>
+// Ids are never reused, so records of removed jobs keep their names
+//----------------------------------------------------------------
+typedef struct historyName
+{
+   uint32_t id;
+   uint8_t kind;                 // HISTORY_JOB or HISTORY_GROUP
+   char* name;                   // NULL if slot is empty
+}HistoryNameT;
+
+//----------------------------------------------------------------
+// Writer of history log, records are appended to the last segment by one
+// write() each (transitions are rare, a build changes a few records),
+// nothing is kept in memory except names. Thread safe.
+//----------------------------------------------------------------
+typedef struct historyLog
+{
+   pthread_mutex_t lock;
+   bool isOpen;
+   char* dir;
+   int fd;                       // last segment
+   int namesFd;
+   uint32_t segmentIdx;
+   uint32_t recordCount;         // records in last segment
+   int64_t lastTimeMs;
+   HistoryNameT* p_names;        // open addressing by kind and name
+   uint32_t nameSize;            // power of 2
+   uint32_t nameCount;
+   uint32_t nextId;
+}HistoryLogT;
+
+//----------------------------------------------------------------
+// Memory mapped segment for queries
+//----------------------------------------------------------------
+typedef struct historySegment
+{
+   void* p_map;
+   size_t mapSize;
+   const HistoryRecordT* p_records;
+   size_t count;
+}HistorySegmentT;
+
+//----------------------------------------------------------------
+// Reader of history log: all segments are mapped read only, records are
+// scanned in place
+//----------------------------------------------------------------
+typedef struct historyReader
+{
+   HistorySegmentT* p_segments;
+   uint32_t segmentCount;
+   char** names;                 // indexed by id, NULL if id is unknown
+   uint8_t* nameKinds;
+   uint32_t nameCount;           // size of names array
+   size_t recordCount;
+}HistoryReaderT;
+
+//----------------------------------------------------------------
+// Build of index of builds, builds are sorted by job id and number so
+// builds of one job are found by binary search
+//----------------------------------------------------------------
+typedef struct historyBuild
+{
+   int64_t timeMs;               // start of build
+   uint32_t jobId;               // id of job in names file
+   uint32_t number;
+   uint32_t durationMs;          // 0 if build is running
+   uint8_t result;               // BuildResultE
+   uint8_t flags;                // HISTORY_REMOVED
+   uint8_t reserved[2];
+}HistoryBuildT;
+
+//----------------------------------------------------------------
+// Memory mapped index of builds, same header as segment
+//----------------------------------------------------------------
+typedef struct historyBuilds
+{
+   void* p_map;
+   size_t mapSize;
+   const HistoryBuildT* p_builds;
+   size_t count;
+}HistoryBuildsT;
+
+typedef bool (*HistoryRecordCallbackT)(void* p_arg, const HistoryRecordT* p_record);
+
+bool historyOpen(HistoryLogT* p_log, const char* dir);
+bool historyOpenNames(HistoryLogT* p_log, const char* dir);
+void historyClose(HistoryLogT* p_log);
+uint32_t historyIdOf(HistoryLogT* p_log, HistoryKindE kind, const char* name);
+bool historyAppend(HistoryLogT* p_log, HistoryRecordT* p_record);
+
+bool historyReaderOpen(HistoryReaderT* p_reader, const char* dir);
+void historyReaderClose(HistoryReaderT* p_reader);
+const char* historyNameOf(const HistoryReaderT* p_reader, uint32_t id);
+size_t historyLowerBound(const HistorySegmentT* p_segment, int64_t timeMs);
+size_t historyScan(const HistoryReaderT* p_reader, int64_t fromMs, int64_t toMs,
+                   HistoryRecordCallbackT callback, void* p_arg);
+
+bool historyWriteBuilds(const char* dir, const HistoryBuildT* p_builds, size_t count);
+bool historyBuildsOpen(HistoryBuildsT* p_index, const char* dir);
+void historyBuildsClose(HistoryBuildsT* p_index);
+size_t historyBuildsOf(const HistoryBuildsT* p_index, uint32_t jobId,
+                       const HistoryBuildT** pp_first);
+
+#endif
@@ -0,0 +1,738 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include "jenkin_metrics.h"
+#include "jenkin_scan.h"
+#include "jenkin_home.h"
+
+#define HOME_EVENT_BUF_SIZE (64 * 1024)
+
+//----------------------------------------------------------------------------
+// Check that name is a build number, return the number or -1
+//----------------------------------------------------------------------------
+static long parseBuildNumber(const char* name)
+{
+   if (!isdigit((unsigned char)*name))
+   {
+      return -1;
+   }
+   char* p_end = NULL;
+   long number = strtol(name, &p_end, 10);
+   return *p_end ? -1 : number;
+}
+
+//----------------------------------------------------------------------------
+// Get number of the latest build of job: nextBuildNumber - 1 if its
+// directory exists, else the highest build in builds/ (builds may be
+// deleted by discarder or nextBuildNumber may be changed by user)
+// return 0 if job does not have any build
+//----------------------------------------------------------------------------
+static long latestBuildNumber(const char* jobDir)
+{
+   char path[PATH_MAX];
+   struct stat st;
+   snprintf(path, sizeof(path), "%s/nextBuildNumber", jobDir);
+   FILE* p_file = fopen(path, "r");
+   if (p_file)
+   {
+      long nextNumber = 0;
+      if (fscanf(p_file, "%ld", &nextNumber) == 1)
+      {
+         snprintf(path, sizeof(path), "%s/builds/%ld", jobDir, nextNumber - 1);
+         if ((nextNumber > 1) && !stat(path, &st) && S_ISDIR(st.st_mode))
+         {
+            fclose(p_file);
+            return nextNumber - 1;
+         }
+      }
+      fclose(p_file);
+   }
+
+   long latest = 0;
+   snprintf(path, sizeof(path), "%s/builds", jobDir);
+   DIR* p_dir = opendir(path);
+   if (!p_dir)
+   {
+      return 0;
+   }
+   struct dirent* p_ent = NULL;
+   while ((p_ent = readdir(p_dir)) != NULL)
+   {
+      long number = parseBuildNumber(p_ent->d_name);
+      if (number > latest)
+      {
+         snprintf(path, sizeof(path), "%s/builds/%s", jobDir, p_ent->d_name);
+         if (!stat(path, &st) && S_ISDIR(st.st_mode))
+         {
+            latest = number;
+         }
+      }
+   }
+   closedir(p_dir);
+   return latest;
+}
+
+//----------------------------------------------------------------------------
+// Read result and timestamp (in ms) of a build, result is "" if build is
+// running (build.xml is not written yet or does not have result)
+// return false if build does not exist
+//----------------------------------------------------------------------------
+static bool readBuild(const char* jobDir, long number, char* result, size_t resultSize,
+                      long long* p_timestamp)
+{
+   char path[PATH_MAX];
+   char timestamp[32] = "";
+   struct stat st;
+   XmlFieldT fields[] =
+   {
+      {"result", result, resultSize, false},
+      {"timestamp", timestamp, sizeof(timestamp), false},
+   };
+   result[0] = 0;
+   snprintf(path, sizeof(path), "%s/builds/%ld", jobDir, number);
+   if (stat(path, &st) || !S_ISDIR(st.st_mode))
+   {
+      return false;
+   }
+   snprintf(path, sizeof(path), "%s/builds/%ld/build.xml", jobDir, number);
+   scanXmlFile(path, fields, sizeof(fields) / sizeof(fields[0]));
+   *p_timestamp = timestamp[0] ? atoll(timestamp) : (long long)st.st_mtime * 1000;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Get color of job which jenkins shows for result of build
+//----------------------------------------------------------------------------
+static const char* resultColor(const char* result)
+{
+   if (!strcmp(result, "SUCCESS"))
+   {
+      return "blue";
+   }
+   else if (!strcmp(result, "UNSTABLE"))
+   {
+      return "yellow";
+   }
+   else if (!strcmp(result, "FAILURE"))
+   {
+      return "red";
+   }
+   else if (!strcmp(result, "ABORTED"))
+   {
+      return "aborted";
+   }
+   return "notbuilt";
+}
+
+//----------------------------------------------------------------------------
+// Read state of job from its directory in JENKINS_HOME to the same entry
+// as json of jenkins api:
+//    color: color of the latest build, "<color>_anime" if it is running
+//           (color of the last finished build as jenkins does), "disabled"
+//           if job is disabled, "notbuilt" if job does not have any build
+//    timestamp, result: of the latest build
+// return false if job does not exist
+//----------------------------------------------------------------------------
+bool homeReadJob(const char* jobDir, JsonJobEntryT* p_entry)
+{
+   char path[PATH_MAX];
+   char disabled[8] = "";
+   XmlFieldT field = {"disabled", disabled, sizeof(disabled), false};
+
+   memset(p_entry, 0, sizeof(JsonJobEntryT));
+   const char* p_name = strrchr(jobDir, '/');
+   snprintf(p_entry->name, sizeof(p_entry->name), "%s", p_name ? p_name + 1 : jobDir);
+
+   snprintf(path, sizeof(path), "%s/config.xml", jobDir);
+   if (!scanXmlFile(path, &field, 1))
+   {
+      return false;
+   }
+
+   long number = latestBuildNumber(jobDir);
+   if ((number <= 0) ||
+       !readBuild(jobDir, number, p_entry->result, sizeof(p_entry->result), &p_entry->timestamp))
+   {
+      strcpy(p_entry->color, "notbuilt");
+   }
+   else if (p_entry->result[0])
+   {
+      p_entry->number = number;
+      strcpy(p_entry->color, resultColor(p_entry->result));
+   }
+   else
+   {
+      // Build is running, search the last finished build for its color
+      const char* color = "notbuilt";
+      char prevResult[sizeof(p_entry->result)];
+      long long prevTimestamp = 0;
+      long prevNumber;
+      for (prevNumber = number - 1;
+           (prevNumber > 0) && (prevNumber >= number - HOME_MAX_PREV_BUILDS); prevNumber--)
+      {
+         if (readBuild(jobDir, prevNumber, prevResult, sizeof(prevResult), &prevTimestamp) &&
+             prevResult[0])
+         {
+            color = resultColor(prevResult);
+            break;
+         }
+      }
+      snprintf(p_entry->color, sizeof(p_entry->color), "%s_anime", color);
+      p_entry->number = number;
+   }
+
+   if (!strcmp(disabled, "true"))
+   {
+      strcpy(p_entry->color, "disabled");
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Get directory of job in JENKINS_HOME from its path in config
+//    "/job/", "name"            -> "<home>/jobs/name"
+//    "/job/folder/job/", "name" -> "<home>/jobs/folder/jobs/name"
+// return false if job path is not a path of jenkins jobs
+//----------------------------------------------------------------------------
+bool homeJobDir(const char* homeDir, const char* jobPath, const char* jobName,
+                char* dir, size_t dirSize)
+{
+   size_t len = snprintf(dir, dirSize, "%s", homeDir);
+   int segment = 0;
+   const char* p = jobPath;
+   while (*p)
+   {
+      if (*p == '/')
+      {
+         p++;
+         continue;
+      }
+      size_t segLen = strcspn(p, "/");
+      bool isJobSeg = ((segment % 2) == 0);
+      if (isJobSeg && ((segLen != 3) || strncmp(p, "job", 3)))
+      {
+         printf("Job path %s is not a path of jenkins jobs\n", jobPath);
+         return false;
+      }
+      len += snprintf(dir + len, (len < dirSize) ? dirSize - len : 0, "/%.*s%s",
+                      (int)segLen, p, isJobSeg ? "s" : "");
+      segment++;
+      p += segLen;
+   }
+   if (segment % 2 == 0)
+   {
+      printf("Job path %s does not end with /job/\n", jobPath);
+      return false;
+   }
+   len += snprintf(dir + len, (len < dirSize) ? dirSize - len : 0, "/%s", jobName);
+   return len < dirSize;
+}
+
+//----------------------------------------------------------------------------
+// Get container path of job from directory of job relative to JENKINS_HOME
+//    "jobs/name"              -> ""
+//    "jobs/folder/jobs/name"  -> "/job/folder"
+//----------------------------------------------------------------------------
+static void containerPathOfDir(const char* relDir, char* containerPath, size_t pathSize)
+{
+   size_t len = 0;
+   int segment = 0;
+   const char* p_last = strrchr(relDir, '/');
+   const char* p = relDir;
+   containerPath[0] = 0;
+   // Segments before "jobs/name"
+   while (p_last && (p < p_last))
+   {
+      size_t segLen = strcspn(p, "/");
+      if (p + segLen >= p_last)
+      {
+         break;
+      }
+      len += snprintf(containerPath + len, (len < pathSize) ? pathSize - len : 0, "/%.*s",
+                      (segment % 2 == 0) ? (int)segLen - 1 : (int)segLen, p);
+      segment++;
+      p += segLen + 1;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Find watch by its descriptor
+//----------------------------------------------------------------------------
+static HomeWatchT* findWatch(HomeWatcherT* p_home, int wd)
+{
+   HomeWatchT* p_watch = p_home->p_buckets[wd % HOME_WATCH_BUCKETS];
+   while (p_watch && (p_watch->wd != wd))
+   {
+      p_watch = p_watch->p_nextInBucket;
+   }
+   return p_watch;
+}
+
+//----------------------------------------------------------------------------
+// Unlink watch from table and free it, the kernel watch is removed too
+// unless it is already removed (IN_IGNORED)
+//----------------------------------------------------------------------------
+static void removeWatch(HomeWatcherT* p_home, HomeWatchT* p_watch, bool isKernelRemoved)
+{
+   HomeWatchT** pp_watch = &p_home->p_buckets[p_watch->wd % HOME_WATCH_BUCKETS];
+   while (*pp_watch != p_watch)
+   {
+      pp_watch = &(*pp_watch)->p_nextInBucket;
+   }
+   *pp_watch = p_watch->p_nextInBucket;
+   if (p_watch->p_buildWatch)
+   {
+      // Watch of builds/ and watch of its latest build point to each other
+      p_watch->p_buildWatch->p_buildWatch = NULL;
+   }
+   if (!isKernelRemoved)
+   {
+      inotify_rm_watch(p_home->inotifyFd, p_watch->wd);
+   }
+   p_home->watchCount--;
+   free(p_watch);
+}
+
+//----------------------------------------------------------------------------
+// Watch directory which is relative to JENKINS_HOME
+// return NULL if directory can not be watched
+//----------------------------------------------------------------------------
+static HomeWatchT* addWatch(HomeWatcherT* p_home, const char* relPath, HomeWatchKindE kind)
+{
+   static const uint32_t masks[] =
+   {
+      [JOBS_WATCH]   = IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM,
+      [JOB_WATCH]    = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE,
+      [BUILDS_WATCH] = IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM,
+      [BUILD_WATCH]  = IN_CLOSE_WRITE | IN_MOVED_TO
+   };
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/%s", p_home->homeDir, relPath);
+   int wd = inotify_add_watch(p_home->inotifyFd, path, masks[kind] | IN_ONLYDIR);
+   if (wd < 0)
+   {
+      if (errno == ENOSPC)
+      {
+         printf("Can not watch %s: too many watches, raise fs.inotify.max_user_watches\n", path);
+      }
+      return NULL;
+   }
+
+   // The same directory may be added again (e.g. it is created while it is scanned)
+   HomeWatchT* p_watch = findWatch(p_home, wd);
+   if (p_watch)
+   {
+      return p_watch;
+   }
+   size_t pathSize = strlen(relPath) + 1;
+   p_watch = calloc(1, sizeof(HomeWatchT) + pathSize);
+   if (!p_watch)
+   {
+      printf("Can not allocate watch of %s\n", path);
+      inotify_rm_watch(p_home->inotifyFd, wd);
+      return NULL;
+   }
+   p_watch->wd = wd;
+   p_watch->kind = kind;
+   memcpy(p_watch->path, relPath, pathSize);
+   p_watch->p_nextInBucket = p_home->p_buckets[wd % HOME_WATCH_BUCKETS];
+   p_home->p_buckets[wd % HOME_WATCH_BUCKETS] = p_watch;
+   p_home->watchCount++;
+   return p_watch;
+}
+
+//----------------------------------------------------------------------------
+// Move watch of the latest build of a job to build number
+//----------------------------------------------------------------------------
+static void watchBuild(HomeWatcherT* p_home, HomeWatchT* p_buildsWatch, long number)
+{
+   if (p_buildsWatch->p_buildWatch)
+   {
+      removeWatch(p_home, p_buildsWatch->p_buildWatch, false);
+   }
+   if (number <= 0)
+   {
+      return;
+   }
+   char relPath[PATH_MAX];
+   snprintf(relPath, sizeof(relPath), "%s/%ld", p_buildsWatch->path, number);
+   HomeWatchT* p_buildWatch = addWatch(p_home, relPath, BUILD_WATCH);
+   if (p_buildWatch)
+   {
+      p_buildWatch->buildNumber = number;
+      p_buildWatch->p_buildWatch = p_buildsWatch;
+      p_buildsWatch->p_buildWatch = p_buildWatch;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Watch builds/ of job and its latest build
+//----------------------------------------------------------------------------
+static void watchBuilds(HomeWatcherT* p_home, const char* relJobDir)
+{
+   char path[PATH_MAX];
+   snprintf(path, sizeof(path), "%s/builds", relJobDir);
+   HomeWatchT* p_buildsWatch = addWatch(p_home, path, BUILDS_WATCH);
+   if (p_buildsWatch)
+   {
+      snprintf(path, sizeof(path), "%s/%s", p_home->homeDir, relJobDir);
+      watchBuild(p_home, p_buildsWatch, latestBuildNumber(path));
+   }
+}
+
+static void watchJobs(HomeWatcherT* p_home, const char* relJobsDir);
+
+//----------------------------------------------------------------------------
+// Watch directory of job, its builds and jobs in it if it is a folder
+//----------------------------------------------------------------------------
+static void watchJob(HomeWatcherT* p_home, const char* relJobDir)
+{
+   char path[PATH_MAX];
+   struct stat st;
+   if (!addWatch(p_home, relJobDir, JOB_WATCH))
+   {
+      return;
+   }
+   watchBuilds(p_home, relJobDir);
+   snprintf(path, sizeof(path), "%s/%s/jobs", p_home->homeDir, relJobDir);
+   if (!stat(path, &st) && S_ISDIR(st.st_mode))
+   {
+      snprintf(path, sizeof(path), "%s/jobs", relJobDir);
+      watchJobs(p_home, path);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Watch jobs/ directory of root or folder and all jobs in it
+//----------------------------------------------------------------------------
+static void watchJobs(HomeWatcherT* p_home, const char* relJobsDir)
+{
+   char path[PATH_MAX];
+   if (!addWatch(p_home, relJobsDir, JOBS_WATCH))
+   {
+      return;
+   }
+   snprintf(path, sizeof(path), "%s/%s", p_home->homeDir, relJobsDir);
+   DIR* p_dir = opendir(path);
+   if (!p_dir)
+   {
+      return;
+   }
+   struct dirent* p_ent = NULL;
+   while ((p_ent = readdir(p_dir)) != NULL)
+   {
+      if ((p_ent->d_name[0] == '.') ||
+          ((p_ent->d_type != DT_DIR) && (p_ent->d_type != DT_UNKNOWN)))
+      {
+         continue;
+      }
+      snprintf(path, sizeof(path), "%s/%s", relJobsDir, p_ent->d_name);
+      watchJob(p_home, path);
+   }
+   closedir(p_dir);
+}
+
+//----------------------------------------------------------------------------
+// Remove watches of directory and all directories in it, used when directory
+// is moved away (watches of moved directory are not removed by kernel)
+//----------------------------------------------------------------------------
+static void unwatchTree(HomeWatcherT* p_home, const char* relPath)
+{
+   size_t len = strlen(relPath);
+   int bucket;
+   for (bucket = 0; bucket < HOME_WATCH_BUCKETS; bucket++)
+   {
+      HomeWatchT* p_watch = p_home->p_buckets[bucket];
+      while (p_watch)
+      {
+         HomeWatchT* p_next = p_watch->p_nextInBucket;
+         if (!strncmp(p_watch->path, relPath, len) &&
+             ((p_watch->path[len] == 0) || (p_watch->path[len] == '/')))
+         {
+            removeWatch(p_home, p_watch, false);
+         }
+         p_watch = p_next;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Read state of job and pass it to callback
+//----------------------------------------------------------------------------
+static void reportJob(HomeWatcherT* p_home, const char* relJobDir)
+{
+   char path[PATH_MAX];
+   char containerPath[PATH_MAX];
+   JsonJobEntryT entry;
+   snprintf(path, sizeof(path), "%s/%s", p_home->homeDir, relJobDir);
+   if (!homeReadJob(path, &entry))
+   {
+      return;
+   }
+   containerPathOfDir(relJobDir, containerPath, sizeof(containerPath));
+   metricsAdd(&p_home->jobChangeCount, 1);
+   p_home->callback(p_home->p_arg, containerPath, &entry);
+}
+
+//----------------------------------------------------------------------------
+// Report all watched jobs, used when events are lost (queue overflow)
+//----------------------------------------------------------------------------
+static void reportAllJobs(HomeWatcherT* p_home)
+{
+   int bucket;
+   for (bucket = 0; bucket < HOME_WATCH_BUCKETS; bucket++)
+   {
+      HomeWatchT* p_watch = NULL;
+      for (p_watch = p_home->p_buckets[bucket]; p_watch; p_watch = p_watch->p_nextInBucket)
+      {
+         if (p_watch->kind == JOB_WATCH)
+         {
+            reportJob(p_home, p_watch->path);
+         }
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Handle one inotify event
+//----------------------------------------------------------------------------
+static void handleEvent(HomeWatcherT* p_home, const struct inotify_event* p_event)
+{
+   char path[PATH_MAX];
+   HomeWatchT* p_watch = findWatch(p_home, p_event->wd);
+   if (!p_watch)
+   {
+      return;
+   }
+   if (p_event->mask & IN_IGNORED)
+   {
+      // Directory is deleted
+      removeWatch(p_home, p_watch, true);
+      return;
+   }
+
+   const char* name = p_event->len ? p_event->name : "";
+   bool isDir = (p_event->mask & IN_ISDIR) != 0;
+   bool isAdded = (p_event->mask & (IN_CREATE | IN_MOVED_TO)) != 0;
+   bool isWritten = (p_event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0;
+   switch (p_watch->kind)
+   {
+      case JOBS_WATCH:
+         if (!isDir)
+         {
+            break;
+         }
+         snprintf(path, sizeof(path), "%s/%s", p_watch->path, name);
+         if (isAdded)
+         {
+            watchJob(p_home, path);
+            reportJob(p_home, path);
+         }
+         else
+         {
+            unwatchTree(p_home, path);
+         }
+         break;
+
+      case JOB_WATCH:
+         if (isDir && isAdded && !strcmp(name, "builds"))
+         {
+            watchBuilds(p_home, p_watch->path);
+            reportJob(p_home, p_watch->path);
+         }
+         else if (isDir && isAdded && !strcmp(name, "jobs"))
+         {
+            snprintf(path, sizeof(path), "%s/jobs", p_watch->path);
+            watchJobs(p_home, path);
+         }
+         else if (!isDir && isWritten &&
+                  (!strcmp(name, "config.xml") || !strcmp(name, "nextBuildNumber")))
+         {
+            reportJob(p_home, p_watch->path);
+         }
+         break;
+
+      case BUILDS_WATCH:
+      {
+         long number = parseBuildNumber(name);
+         HomeWatchT* p_buildWatch = p_watch->p_buildWatch;
+         if (number <= 0)
+         {
+            break;
+         }
+         // Job directory is builds/ without "/builds"
+         snprintf(path, sizeof(path), "%.*s", (int)(strlen(p_watch->path) - strlen("/builds")),
+                  p_watch->path);
+         if (isAdded && (!p_buildWatch || (number > p_buildWatch->buildNumber)))
+         {
+            // New build is started
+            watchBuild(p_home, p_watch, number);
+            reportJob(p_home, path);
+         }
+         else if (!isAdded && (!p_buildWatch || (number == p_buildWatch->buildNumber)))
+         {
+            // The latest build is deleted, previous build becomes the latest one
+            // (watch of deleted build may be already removed by IN_IGNORED)
+            char jobDir[PATH_MAX];
+            snprintf(jobDir, sizeof(jobDir), "%s/%s", p_home->homeDir, path);
+            watchBuild(p_home, p_watch, latestBuildNumber(jobDir));
+            reportJob(p_home, path);
+         }
+         break;
+      }
+
+      case BUILD_WATCH:
+         if (!isDir && isWritten && !strcmp(name, "build.xml") && p_watch->p_buildWatch)
+         {
+            // Job directory is builds/<n> without "/builds/<n>"
+            const char* p_buildsPath = p_watch->p_buildWatch->path;
+            snprintf(path, sizeof(path), "%.*s", (int)(strlen(p_buildsPath) - strlen("/builds")),
+                     p_buildsPath);
+            reportJob(p_home, path);
+         }
+         break;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Loop of watcher thread, it is stopped by homeStop()
+//----------------------------------------------------------------------------
+static void* homeLoop(void* arg)
+{
+   HomeWatcherT* p_home = (HomeWatcherT*)arg;
+   char* buf = malloc(HOME_EVENT_BUF_SIZE);
+   struct pollfd fds[2];
+   fds[0].fd = p_home->inotifyFd;
+   fds[0].events = POLLIN;
+   fds[1].fd = p_home->wakeFd;
+   fds[1].events = POLLIN;
+
+   while (buf)
+   {
+      if ((poll(fds, 2, -1) == -1) && (errno != EINTR))
+      {
+         printf("Can not poll inotify: %s\n", strerror(errno));
+         break;
+      }
+      if (fds[1].revents & POLLIN)
+      {
+         break;
+      }
+      if (!(fds[0].revents & POLLIN))
+      {
+         continue;
+      }
+
+      ssize_t len = read(p_home->inotifyFd, buf, HOME_EVENT_BUF_SIZE);
+      ssize_t offset = 0;
+      while (offset < len)
+      {
+         const struct inotify_event* p_event = (const struct inotify_event*)(buf + offset);
+         metricsAdd(&p_home->eventCount, 1);
+         if (p_event->mask & IN_Q_OVERFLOW)
+         {
+            printf("Events of %s are lost, read all jobs again\n", p_home->homeDir);
+            reportAllJobs(p_home);
+         }
+         else
+         {
+            handleEvent(p_home, p_event);
+         }
+         offset += sizeof(struct inotify_event) + p_event->len;
+      }
+   }
+   free(buf);
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Watch all jobs of JENKINS_HOME and start watcher thread
+//----------------------------------------------------------------------------
+bool homeStart(HomeWatcherT* p_home, const char* homeDir,
+               HomeJobCallbackT callback, void* p_arg)
+{
+   memset(p_home, 0, sizeof(HomeWatcherT));
+   p_home->callback = callback;
+   p_home->p_arg = p_arg;
+   p_home->wakeFd = -1;
+   p_home->homeDir = strdup(homeDir);
+   p_home->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+   if (!p_home->homeDir || (p_home->inotifyFd < 0))
+   {
+      printf("Can not create inotify: %s\n", strerror(errno));
+      homeStop(p_home);
+      return false;
+   }
+   watchJobs(p_home, "jobs");
+   if (!p_home->watchCount)
+   {
+      printf("Can not watch %s/jobs\n", homeDir);
+      homeStop(p_home);
+      return false;
+   }
+   p_home->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if (p_home->wakeFd < 0)
+   {
+      printf("Can not create eventfd: %s\n", strerror(errno));
+      homeStop(p_home);
+      return false;
+   }
+   if (pthread_create(&p_home->thread, NULL, homeLoop, p_home))
+   {
+      printf("Can not create watcher thread\n");
+      homeStop(p_home);
+      return false;
+   }
+   p_home->isStarted = true;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Stop watcher thread, remove all watches
+//----------------------------------------------------------------------------
+void homeStop(HomeWatcherT* p_home)
+{
+   if (p_home->isStarted)
+   {
+      uint64_t one = 1;
+      ssize_t ret = write(p_home->wakeFd, &one, sizeof(one));
+      (void)ret;
+      pthread_join(p_home->thread, NULL);
+      p_home->isStarted = false;
+   }
+   int bucket;
+   for (bucket = 0; bucket < HOME_WATCH_BUCKETS; bucket++)
+   {
+      while (p_home->p_buckets[bucket])
+      {
+         HomeWatchT* p_watch = p_home->p_buckets[bucket];
+         p_home->p_buckets[bucket] = p_watch->p_nextInBucket;
+         free(p_watch);
+      }
+   }
+   p_home->watchCount = 0;
+   if (p_home->wakeFd >= 0)
+   {
+      close(p_home->wakeFd);
+      p_home->wakeFd = -1;
+   }
+   if (p_home->inotifyFd >= 0)
+   {
+      close(p_home->inotifyFd);
+      p_home->inotifyFd = -1;
+   }
+   free(p_home->homeDir);
+   p_home->homeDir = NULL;
+}
@@ -0,0 +1,82 @@
+#ifndef JENKIN_HOME_H
+#define JENKIN_HOME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "jenkin_json.h"
+
+// Number of buckets of watch table, watches are chained in buckets
+#define HOME_WATCH_BUCKETS 1024
+
+// Number of builds before running build which are searched for color of the
+// last finished build
+#define HOME_MAX_PREV_BUILDS 10
+
+//----------------------------------------------------------------
+// Callback of a changed job, containerPath is path of jenkin root or folder
+// which contains job ("" or "/job/folder"), entry has the same fields as
+// json of jenkins api (name, color, timestamp, result)
+//----------------------------------------------------------------
+typedef void (*HomeJobCallbackT)(void* p_arg, const char* containerPath,
+                                 const JsonJobEntryT* p_entry);
+
+//----------------------------------------------------------------
+// Kind of directory which is watched
+//----------------------------------------------------------------
+typedef enum homeWatchKind
+{
+   JOBS_WATCH,                      // jobs/ of root or folder: jobs are added
+   JOB_WATCH,                       // jobs/<name>/: config.xml, nextBuildNumber
+   BUILDS_WATCH,                    // jobs/<name>/builds/: builds are started
+   BUILD_WATCH                      // jobs/<name>/builds/<n>/: build.xml
+}HomeWatchKindE;
+
+//----------------------------------------------------------------
+// Watched directory, path is relative to JENKINS_HOME
+//----------------------------------------------------------------
+typedef struct homeWatch
+{
+   struct homeWatch* p_nextInBucket;
+   int wd;
+   HomeWatchKindE kind;
+   long buildNumber;                // build of BUILD_WATCH
+   struct homeWatch* p_buildWatch;  // BUILDS_WATCH: watch of the latest build
+   char path[];
+}HomeWatchT;
+
+//----------------------------------------------------------------
+// Data source which reads state of jobs from files of JENKINS_HOME:
+//    jobs/<name>/config.xml             <disabled>
+//    jobs/<name>/nextBuildNumber
+//    jobs/<name>/builds/<n>/build.xml   <result>, <timestamp>, <duration>
+// and folders jobs/<folder>/jobs/<name>/...
+// One thread watches directories of jobs with inotify and passes each job
+// whose files are changed to callback from this thread, nothing is polled.
+// Every job of JENKINS_HOME is watched (about 3 watches per job), so
+// fs.inotify.max_user_watches must be large enough on big servers.
+//----------------------------------------------------------------
+typedef struct homeWatcher
+{
+   int inotifyFd;
+   int wakeFd;                      // eventfd to stop thread
+   pthread_t thread;
+   bool isStarted;
+   char* homeDir;
+   HomeJobCallbackT callback;
+   void* p_arg;
+   HomeWatchT* p_buckets[HOME_WATCH_BUCKETS];
+   unsigned int watchCount;
+   unsigned long long eventCount;
+   unsigned long long jobChangeCount;
+}HomeWatcherT;
+
+bool homeStart(HomeWatcherT* p_home, const char* homeDir,
+               HomeJobCallbackT callback, void* p_arg);
+void homeStop(HomeWatcherT* p_home);
+
+bool homeJobDir(const char* homeDir, const char* jobPath, const char* jobName,
+                char* dir, size_t dirSize);
+bool homeReadJob(const char* jobDir, JsonJobEntryT* p_entry);
+
+#endif
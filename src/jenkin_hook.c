@@ -0,0 +1,419 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include "jenkin_http.h"
+#include "jenkin_metrics.h"
+#include "jenkin_sched.h"
+#include "jenkin_hook.h"
+
+#define HOOK_MAX_BODY    (1024 * 1024)
+
+//----------------------------------------------------------------------------
+// Send response without body, connection is closed after it
+// Response is small, it fits in send buffer of new socket, client which
+// does not take it is not waited for
+//----------------------------------------------------------------------------
+static void sendStatus(int fd, const char* status)
+{
+   char response[200];
+   int len = snprintf(response, sizeof(response),
+                      "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+                      status);
+   ssize_t ret = send(fd, response, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+   (void)ret;
+}
+
+//----------------------------------------------------------------------------
+// Find value of header in header block, NULL if header does not exist
+//----------------------------------------------------------------------------
+static const char* findHeader(const char* headers, const char* name)
+{
+   size_t nameLen = strlen(name);
+   const char* p_line = strstr(headers, "\r\n");
+   while (p_line && (p_line[2] != '\r'))
+   {
+      p_line += 2;
+      if (!strncasecmp(p_line, name, nameLen) && (p_line[nameLen] == ':'))
+      {
+         const char* p_value = p_line + nameLen + 1;
+         while (*p_value == ' ')
+         {
+            p_value++;
+         }
+         return p_value;
+      }
+      p_line = strstr(p_line, "\r\n");
+   }
+   return NULL;
+}
+
+//----------------------------------------------------------------------------
+// Compare token of request with token of listener, time does not depend on
+// where they differ
+//----------------------------------------------------------------------------
+static bool isSameToken(const char* p_given, size_t givenLen, const char* token)
+{
+   size_t tokenLen = strlen(token);
+   unsigned char diff = (givenLen != tokenLen);
+   size_t idx;
+   for (idx = 0; idx < tokenLen; idx++)
+   {
+      diff |= (unsigned char)(token[idx] ^ ((idx < givenLen) ? p_given[idx] : 0));
+   }
+   return !diff;
+}
+
+//----------------------------------------------------------------------------
+// Check token of request: "token" parameter of query or bearer authorization
+//----------------------------------------------------------------------------
+static bool isAuthorized(HookServerT* p_hook, const char* header)
+{
+   if (!p_hook->token)
+   {
+      return true;
+   }
+   const char* p_auth = findHeader(header, "Authorization");
+   if (p_auth && !strncasecmp(p_auth, "Bearer ", strlen("Bearer ")))
+   {
+      p_auth += strlen("Bearer ");
+      return isSameToken(p_auth, strcspn(p_auth, " \r\n"), p_hook->token);
+   }
+
+   // Request line: "POST /path?a=b&token=... HTTP/1.1"
+   const char* p_target = strchr(header, ' ');
+   size_t targetLen = p_target ? strcspn(++p_target, " \r\n") : 0;
+   const char* p_param = p_target ? memchr(p_target, '?', targetLen) : NULL;
+   while (p_param)
+   {
+      p_param++;
+      size_t paramLen = strcspn(p_param, "& \r\n");
+      if (!strncmp(p_param, "token=", strlen("token=")))
+      {
+         return isSameToken(p_param + strlen("token="), paramLen - strlen("token="),
+                            p_hook->token);
+      }
+      p_param = (p_param[paramLen] == '&') ? p_param + paramLen : NULL;
+   }
+   return false;
+}
+
+//----------------------------------------------------------------------------
+// Header of request is received, check it and start parsing of body
+// return http status which is sent to client, NULL if body is expected
+//----------------------------------------------------------------------------
+static const char* beginBody(HookServerT* p_hook, HookClientT* p_client, char* p_headerEnd)
+{
+   p_client->isHeaderDone = true;
+
+   // Headers are searched until empty line, not in body
+   p_headerEnd[3] = 0;
+   if (strncmp(p_client->header, "POST ", 5))
+   {
+      return "405 Method Not Allowed";
+   }
+   if (!isAuthorized(p_hook, p_client->header))
+   {
+      return "403 Forbidden";
+   }
+   const char* p_lenStr = findHeader(p_client->header, "Content-Length");
+   if (!p_lenStr)
+   {
+      // Jenkins always sends Content-Length, chunked body is not supported
+      return "411 Length Required";
+   }
+   long long bodyLen = atoll(p_lenStr);
+   if ((bodyLen < 0) || (bodyLen > HOOK_MAX_BODY))
+   {
+      return "413 Payload Too Large";
+   }
+   jsonExtractorInit(&p_client->extractor, p_hook->callback, p_hook->p_arg);
+
+   // Part of body may be received with header
+   char* p_body = p_headerEnd + 4;
+   size_t recvLen = p_client->header + p_client->headerLen - p_body;
+   if ((long long)recvLen > bodyLen)
+   {
+      recvLen = bodyLen;
+   }
+   p_client->leftLen = bodyLen - recvLen;
+   if (!jsonExtractorFeed(&p_client->extractor, p_body, recvLen))
+   {
+      return "400 Bad Request";
+   }
+   return NULL;
+}
+
+//----------------------------------------------------------------------------
+// Receive what client has sent: header until it is complete, then body
+// which is fed to json extractor
+// return http status which is sent to client, "" if connection is dropped
+// without response, NULL if more data is expected
+//----------------------------------------------------------------------------
+static const char* recvRequest(HookServerT* p_hook, HookClientT* p_client)
+{
+   while (1)
+   {
+      char buf[HOOK_HEADER_SIZE];
+      char* p_dst = p_client->isHeaderDone ? buf : p_client->header + p_client->headerLen;
+      // Left length of body is never negative
+      size_t leftLen = (size_t)p_client->leftLen;
+      size_t size = p_client->isHeaderDone ?
+                    ((leftLen < HOOK_HEADER_SIZE) ? leftLen : HOOK_HEADER_SIZE) :
+                    HOOK_HEADER_SIZE - p_client->headerLen;
+      if (p_client->isHeaderDone && !size)
+      {
+         return jsonExtractorFinish(&p_client->extractor) ? "200 OK" : "400 Bad Request";
+      }
+      if (!size)
+      {
+         return "431 Request Header Fields Too Large";
+      }
+      ssize_t n = recv(p_client->fd, p_dst, size, 0);
+      if ((n < 0) && (errno == EINTR))
+      {
+         continue;
+      }
+      if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+      {
+         return NULL;
+      }
+      if (n <= 0)
+      {
+         return "";
+      }
+
+      if (p_client->isHeaderDone)
+      {
+         p_client->leftLen -= n;
+         if (!jsonExtractorFeed(&p_client->extractor, buf, n))
+         {
+            return "400 Bad Request";
+         }
+         continue;
+      }
+      p_client->headerLen += n;
+      p_client->header[p_client->headerLen] = 0;
+      char* p_headerEnd = strstr(p_client->header, "\r\n\r\n");
+      if (p_headerEnd)
+      {
+         const char* status = beginBody(p_hook, p_client, p_headerEnd);
+         if (status)
+         {
+            return status;
+         }
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Request of client is finished: send status if any and close connection
+//----------------------------------------------------------------------------
+static void closeClient(HookServerT* p_hook, HookClientT* p_client, const char* status)
+{
+   metricsAdd(&p_hook->requestCount, 1);
+   if (strncmp(status, "200", 3))
+   {
+      metricsAdd(&p_hook->badRequestCount, 1);
+   }
+   if (status[0])
+   {
+      sendStatus(p_client->fd, status);
+   }
+   close(p_client->fd);
+   p_client->fd = -1;
+}
+
+//----------------------------------------------------------------------------
+// Accept all waiting connections while there is free slot
+//----------------------------------------------------------------------------
+static void acceptClients(HookServerT* p_hook, long long nowNs)
+{
+   unsigned int idx;
+   for (idx = 0; idx < HOOK_MAX_CLIENTS; idx++)
+   {
+      HookClientT* p_client = &p_hook->p_clients[idx];
+      if (p_client->fd >= 0)
+      {
+         continue;
+      }
+      int fd = accept4(p_hook->listenFd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+      if (fd < 0)
+      {
+         return;
+      }
+      p_client->fd = fd;
+      p_client->deadlineNs = nowNs + HOOK_RECV_TIMEOUT * 1000000000LL;
+      p_client->isHeaderDone = false;
+      p_client->headerLen = 0;
+      p_client->leftLen = 0;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Loop of listener thread, it is stopped by hookStop()
+// fds: wake fd, listen fd (when a slot is free), then clients
+//----------------------------------------------------------------------------
+static void* hookLoop(void* arg)
+{
+   HookServerT* p_hook = (HookServerT*)arg;
+   struct pollfd fds[HOOK_MAX_CLIENTS + 2];
+   HookClientT* p_polled[HOOK_MAX_CLIENTS + 2];
+
+   while (1)
+   {
+      long long nowNs = schedNowNs();
+      long long waitNs = -1;
+      nfds_t fdCount = 0;
+      fds[fdCount].fd = p_hook->wakeFd;
+      fds[fdCount++].events = POLLIN;
+      fds[fdCount].fd = p_hook->listenFd;
+      fds[fdCount++].events = 0;
+
+      // Client which is too slow is dropped, it must not hold slot for ever
+      unsigned int idx;
+      for (idx = 0; idx < HOOK_MAX_CLIENTS; idx++)
+      {
+         HookClientT* p_client = &p_hook->p_clients[idx];
+         if (p_client->fd < 0)
+         {
+            fds[1].events = POLLIN;
+            continue;
+         }
+         if (p_client->deadlineNs <= nowNs)
+         {
+            closeClient(p_hook, p_client, "408 Request Timeout");
+            fds[1].events = POLLIN;
+            continue;
+         }
+         if ((waitNs < 0) || (p_client->deadlineNs - nowNs < waitNs))
+         {
+            waitNs = p_client->deadlineNs - nowNs;
+         }
+         p_polled[fdCount] = p_client;
+         fds[fdCount].fd = p_client->fd;
+         fds[fdCount++].events = POLLIN;
+      }
+
+      int timeoutMs = (waitNs < 0) ? -1 : (int)((waitNs + 999999) / 1000000);
+      if ((poll(fds, fdCount, timeoutMs) == -1) && (errno != EINTR))
+      {
+         printf("Can not poll listener: %s\n", strerror(errno));
+         break;
+      }
+      if (fds[0].revents & POLLIN)
+      {
+         break;
+      }
+      nfds_t fdIdx;
+      for (fdIdx = 2; fdIdx < fdCount; fdIdx++)
+      {
+         if (fds[fdIdx].revents)
+         {
+            const char* status = recvRequest(p_hook, p_polled[fdIdx]);
+            if (status)
+            {
+               closeClient(p_hook, p_polled[fdIdx], status);
+            }
+         }
+      }
+      if (fds[1].revents & POLLIN)
+      {
+         acceptClients(p_hook, schedNowNs());
+      }
+   }
+
+   unsigned int idx;
+   for (idx = 0; idx < HOOK_MAX_CLIENTS; idx++)
+   {
+      if (p_hook->p_clients[idx].fd >= 0)
+      {
+         close(p_hook->p_clients[idx].fd);
+         p_hook->p_clients[idx].fd = -1;
+      }
+   }
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Start listener thread
+//----------------------------------------------------------------------------
+bool hookStart(HookServerT* p_hook, const char* listenAddr, const char* token,
+               JsonJobCallbackT callback, void* p_arg)
+{
+   memset(p_hook, 0, sizeof(HookServerT));
+   p_hook->callback = callback;
+   p_hook->p_arg = p_arg;
+   p_hook->token = (token && token[0]) ? token : NULL;
+   p_hook->wakeFd = -1;
+   p_hook->listenFd = -1;
+   p_hook->p_clients = calloc(HOOK_MAX_CLIENTS, sizeof(HookClientT));
+   if (!p_hook->p_clients)
+   {
+      printf("Can not allocate clients of listener\n");
+      return false;
+   }
+   unsigned int idx;
+   for (idx = 0; idx < HOOK_MAX_CLIENTS; idx++)
+   {
+      p_hook->p_clients[idx].fd = -1;
+   }
+   p_hook->listenFd = httpListen(listenAddr);
+   if (p_hook->listenFd < 0)
+   {
+      hookStop(p_hook);
+      return false;
+   }
+   fcntl(p_hook->listenFd, F_SETFL, fcntl(p_hook->listenFd, F_GETFL) | O_NONBLOCK);
+   p_hook->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if (p_hook->wakeFd < 0)
+   {
+      printf("Can not create eventfd: %s\n", strerror(errno));
+      hookStop(p_hook);
+      return false;
+   }
+   if (pthread_create(&p_hook->thread, NULL, hookLoop, p_hook))
+   {
+      printf("Can not create listener thread\n");
+      hookStop(p_hook);
+      return false;
+   }
+   p_hook->isStarted = true;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Stop listener thread and close its sockets
+//----------------------------------------------------------------------------
+void hookStop(HookServerT* p_hook)
+{
+   if (p_hook->isStarted)
+   {
+      uint64_t one = 1;
+      ssize_t ret = write(p_hook->wakeFd, &one, sizeof(one));
+      (void)ret;
+      pthread_join(p_hook->thread, NULL);
+      p_hook->isStarted = false;
+   }
+   if (p_hook->wakeFd >= 0)
+   {
+      close(p_hook->wakeFd);
+      p_hook->wakeFd = -1;
+   }
+   if (p_hook->listenFd >= 0)
+   {
+      close(p_hook->listenFd);
+      p_hook->listenFd = -1;
+   }
+   free(p_hook->p_clients);
+   p_hook->p_clients = NULL;
+}
@@ -0,0 +1,59 @@
+#ifndef JENKIN_HOOK_H
+#define JENKIN_HOOK_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "jenkin_json.h"
+
+// Client which does not send whole request in this time is dropped
+#define HOOK_RECV_TIMEOUT 2     // in second
+
+// Connections which are received at the same time, more wait in backlog
+#define HOOK_MAX_CLIENTS  32
+
+#define HOOK_HEADER_SIZE  4096
+
+//----------------------------------------------------------------
+// Connection of client, its request is received piece by piece when
+// socket is readable
+//----------------------------------------------------------------
+typedef struct hookClient
+{
+   int fd;                          // -1 if slot is free
+   long long deadlineNs;            // CLOCK_MONOTONIC, whole request is received before it
+   bool isHeaderDone;
+   size_t headerLen;
+   long long leftLen;               // of body which is not received yet
+   JsonExtractorT extractor;
+   char header[HOOK_HEADER_SIZE + 1];
+}HookClientT;
+
+//----------------------------------------------------------------
+// Listener of build notifications which are posted by jenkins
+// (notification plugin, json format, http protocol)
+// One thread accepts connections and receives requests of all clients by
+// one poll(), one request per connection, so a slow client does not hold
+// up others. Body of request is parsed while it is received and each job in
+// it is passed to callback from this thread.
+// If token is given, request must have it in query (?token=...) or in
+// "Authorization: Bearer ..." header.
+//----------------------------------------------------------------
+typedef struct hookServer
+{
+   int listenFd;
+   int wakeFd;                      // eventfd to stop thread
+   pthread_t thread;
+   bool isStarted;
+   JsonJobCallbackT callback;
+   void* p_arg;
+   const char* token;               // NULL if requests are not checked
+   HookClientT* p_clients;          // HOOK_MAX_CLIENTS
+   unsigned long long requestCount;
+   unsigned long long badRequestCount;
+}HookServerT;
+
+bool hookStart(HookServerT* p_hook, const char* listenAddr, const char* token,
+               JsonJobCallbackT callback, void* p_arg);
+void hookStop(HookServerT* p_hook);
+
+#endif
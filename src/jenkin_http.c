@@ -0,0 +1,1009 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "jenkin_http.h"
+
+//----------------------------------------------------------------------------
+// Encode string to base64, used for basic authorization header
+// Note: need to free pointer to string that are return from this function
+//----------------------------------------------------------------------------
+static char* base64Encode(const char* str)
+{
+   static const char table[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+   size_t len = strlen(str);
+   char* p_out = malloc(((len + 2) / 3) * 4 + 1);
+   char* p_cur = p_out;
+   size_t i;
+   for (i = 0; i + 2 < len; i += 3)
+   {
+      *p_cur++ = table[(str[i] >> 2) & 0x3F];
+      *p_cur++ = table[((str[i] & 0x3) << 4) | ((str[i + 1] >> 4) & 0xF)];
+      *p_cur++ = table[((str[i + 1] & 0xF) << 2) | ((str[i + 2] >> 6) & 0x3)];
+      *p_cur++ = table[str[i + 2] & 0x3F];
+   }
+   if (i < len)
+   {
+      *p_cur++ = table[(str[i] >> 2) & 0x3F];
+      if (i + 1 == len)
+      {
+         *p_cur++ = table[(str[i] & 0x3) << 4];
+         *p_cur++ = '=';
+      }
+      else
+      {
+         *p_cur++ = table[((str[i] & 0x3) << 4) | ((str[i + 1] >> 4) & 0xF)];
+         *p_cur++ = table[(str[i + 1] & 0xF) << 2];
+      }
+      *p_cur++ = '=';
+   }
+   *p_cur = 0;
+   return p_out;
+}
+
+//----------------------------------------------------------------------------
+// Resolve address of server, result is cached until connection to server fails
+//----------------------------------------------------------------------------
+static bool httpResolve(HttpConnT* p_conn)
+{
+   struct addrinfo hints;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   int ret = getaddrinfo(p_conn->host, p_conn->port, &hints, &p_conn->p_addrInfo);
+   if (ret)
+   {
+      printf("Can not resolve address of server %s: %s\n", p_conn->host, gai_strerror(ret));
+      p_conn->p_addrInfo = NULL;
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Init connection: split server name to host, port and base path then
+// resolve address of server one time.
+// Server name format: [http://]host[:port][/basePath]
+//----------------------------------------------------------------------------
+bool httpConnInit(HttpConnT* p_conn, const char* serverName,
+                  const char* userName, const char* passWord, unsigned int timeoutMs)
+{
+   memset(p_conn, 0, sizeof(HttpConnT));
+   p_conn->sockFd = -1;
+   p_conn->timeoutMs = timeoutMs;
+
+   if (!strncmp(serverName, "https://", strlen("https://")))
+   {
+      printf("https is not supported: %s\n", serverName);
+      return false;
+   }
+   if (!strncmp(serverName, "http://", strlen("http://")))
+   {
+      serverName += strlen("http://");
+   }
+
+   const char* p_slash = strchr(serverName, '/');
+   size_t hostPortLen = p_slash ? (size_t)(p_slash - serverName) : strlen(serverName);
+   p_conn->basePath = strdup(p_slash ? p_slash : "");
+
+   // Strip trailing '/' of base path, job path always start with '/'
+   size_t baseLen = strlen(p_conn->basePath);
+   while (baseLen && p_conn->basePath[baseLen - 1] == '/')
+   {
+      p_conn->basePath[--baseLen] = 0;
+   }
+
+   const char* p_colon = memchr(serverName, ':', hostPortLen);
+   if (p_colon)
+   {
+      p_conn->host = strndup(serverName, p_colon - serverName);
+      p_conn->port = strndup(p_colon + 1, hostPortLen - (p_colon - serverName) - 1);
+   }
+   else
+   {
+      p_conn->host = strndup(serverName, hostPortLen);
+      p_conn->port = strdup("80");
+   }
+
+   if (userName && passWord)
+   {
+      char* p_userPass = malloc(strlen(userName) + strlen(passWord) + 2);
+      sprintf(p_userPass, "%s:%s", userName, passWord);
+      char* p_encoded = base64Encode(p_userPass);
+      p_conn->authHeader = malloc(strlen(p_encoded) + 32);
+      sprintf(p_conn->authHeader, "Authorization: Basic %s\r\n", p_encoded);
+      free(p_encoded);
+      free(p_userPass);
+   }
+
+   // Line of response is read next to receive buffer
+   p_conn->recvBuf = malloc(HTTP_RECV_BUF_SIZE + HTTP_LINE_SIZE);
+   if (!p_conn->recvBuf)
+   {
+      printf("Can not init connection of server %s: %s\n", serverName, strerror(errno));
+      httpConnFree(p_conn);
+      return false;
+   }
+   p_conn->line = p_conn->recvBuf + HTTP_RECV_BUF_SIZE;
+
+   // Server may be not reachable at startup, address will be resolved again
+   // when we connect to server
+   httpResolve(p_conn);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Cancel request of connection which is in flight or will be sent, e.g. when
+// its group is changed by reload. Request fails when it is resumed next
+// time, so caller which waits for socket must resume it now.
+// It is canceled until httpConnClearAbort().
+// Note: it may be called by another thread than the one which sends request
+//----------------------------------------------------------------------------
+void httpConnAbort(HttpConnT* p_conn)
+{
+   __atomic_store_n(&p_conn->isAborted, true, __ATOMIC_SEQ_CST);
+}
+
+//----------------------------------------------------------------------------
+// Let connection send requests again after httpConnAbort()
+// Note: no request must be in flight meanwhile
+//----------------------------------------------------------------------------
+void httpConnClearAbort(HttpConnT* p_conn)
+{
+   __atomic_store_n(&p_conn->isAborted, false, __ATOMIC_SEQ_CST);
+}
+
+//----------------------------------------------------------------------------
+// Set timeout of next requests, e.g. when latency of server is measured again
+//----------------------------------------------------------------------------
+void httpConnSetTimeout(HttpConnT* p_conn, unsigned int timeoutMs)
+{
+   p_conn->timeoutMs = timeoutMs;
+}
+
+//----------------------------------------------------------------------------
+// Get monotonic time in nano second
+//----------------------------------------------------------------------------
+static long long httpNowNs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------------
+// Close socket of connection, address of server is still kept
+//----------------------------------------------------------------------------
+void httpConnClose(HttpConnT* p_conn)
+{
+   if (p_conn->sockFd >= 0)
+   {
+      close(p_conn->sockFd);
+      p_conn->sockFd = -1;
+   }
+   p_conn->recvStart = 0;
+   p_conn->recvEnd = 0;
+}
+
+//----------------------------------------------------------------------------
+// Free all resource of connection
+//----------------------------------------------------------------------------
+void httpConnFree(HttpConnT* p_conn)
+{
+   httpConnClose(p_conn);
+   if (p_conn->p_addrInfo)
+   {
+      freeaddrinfo(p_conn->p_addrInfo);
+      p_conn->p_addrInfo = NULL;
+   }
+   free(p_conn->p_request);
+   free(p_conn->host);
+   free(p_conn->port);
+   free(p_conn->basePath);
+   free(p_conn->authHeader);
+   free(p_conn->recvBuf);
+   p_conn->host = NULL;
+   p_conn->port = NULL;
+   p_conn->basePath = NULL;
+   p_conn->authHeader = NULL;
+   p_conn->recvBuf = NULL;
+   p_conn->line = NULL;
+   p_conn->p_request = NULL;
+}
+
+//----------------------------------------------------------------
+// Result of one step of request
+//----------------------------------------------------------------
+typedef enum stepResult
+{
+   STEP_NEXT,        // request goes on with its next step
+   STEP_WAIT,        // socket is not ready, waitEvents tells for what
+   STEP_DONE,        // whole response is received
+   STEP_FAIL         // connection fails, socket can not be used any more
+}StepResultE;
+
+//----------------------------------------------------------------------------
+// Connect to addresses of server one by one, address is resolved again if
+// connecting failed last time. Socket is writable when connect() of
+// non-blocking socket is finished.
+//----------------------------------------------------------------------------
+static StepResultE connectStep(HttpConnT* p_conn)
+{
+   if (p_conn->sockFd >= 0)
+   {
+      struct pollfd fds[1];
+      fds[0].fd = p_conn->sockFd;
+      fds[0].events = POLLOUT;
+      if (poll(fds, 1, 0) == 0)
+      {
+         p_conn->waitEvents = POLLOUT;
+         return STEP_WAIT;
+      }
+
+      int sockErr = 0;
+      socklen_t errLen = sizeof(sockErr);
+      getsockopt(p_conn->sockFd, SOL_SOCKET, SO_ERROR, &sockErr, &errLen);
+      if (sockErr == 0)
+      {
+         p_conn->reqState = HTTP_REQ_SEND;
+         return STEP_NEXT;
+      }
+      close(p_conn->sockFd);
+      p_conn->sockFd = -1;
+      p_conn->p_connAddr = p_conn->p_connAddr->ai_next;
+      errno = sockErr;
+   }
+   else
+   {
+      if (!p_conn->p_addrInfo && !httpResolve(p_conn))
+      {
+         return STEP_FAIL;
+      }
+      p_conn->p_connAddr = p_conn->p_addrInfo;
+   }
+
+   for (; p_conn->p_connAddr; p_conn->p_connAddr = p_conn->p_connAddr->ai_next)
+   {
+      struct addrinfo* p_addr = p_conn->p_connAddr;
+      int fd = socket(p_addr->ai_family, p_addr->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                      p_addr->ai_protocol);
+      if (fd < 0)
+      {
+         continue;
+      }
+
+      int noDelay = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+      p_conn->sockFd = fd;
+      p_conn->recvStart = 0;
+      p_conn->recvEnd = 0;
+      if (!connect(fd, p_addr->ai_addr, p_addr->ai_addrlen))
+      {
+         p_conn->reqState = HTTP_REQ_SEND;
+         return STEP_NEXT;
+      }
+      if (errno == EINPROGRESS)
+      {
+         p_conn->waitEvents = POLLOUT;
+         return STEP_WAIT;
+      }
+      close(fd);
+      p_conn->sockFd = -1;
+   }
+   printf("Can not connect to server %s:%s, error: %s\n",
+          p_conn->host, p_conn->port, strerror(errno));
+
+   // Address of server may be changed -> resolve again in next time
+   freeaddrinfo(p_conn->p_addrInfo);
+   p_conn->p_addrInfo = NULL;
+   return STEP_FAIL;
+}
+
+//----------------------------------------------------------------------------
+// Send rest of request to socket
+//----------------------------------------------------------------------------
+static StepResultE sendStep(HttpConnT* p_conn)
+{
+   while (p_conn->sentLen < p_conn->requestLen)
+   {
+      ssize_t n = send(p_conn->sockFd, p_conn->p_request + p_conn->sentLen,
+                       p_conn->requestLen - p_conn->sentLen, MSG_NOSIGNAL);
+      if (n < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         if (errno == EAGAIN)
+         {
+            p_conn->waitEvents = POLLOUT;
+            return STEP_WAIT;
+         }
+         return STEP_FAIL;
+      }
+      p_conn->sentLen += n;
+   }
+   p_conn->reqState = HTTP_REQ_STATUS;
+   return STEP_NEXT;
+}
+
+//----------------------------------------------------------------------------
+// Receive more data into receive buffer
+// return number of received bytes, 0 if server closed connection, -1 if error
+//        or if socket is not readable (errno is EAGAIN)
+//----------------------------------------------------------------------------
+static ssize_t fillRecvBuf(HttpConnT* p_conn)
+{
+   if (p_conn->recvStart == p_conn->recvEnd)
+   {
+      p_conn->recvStart = 0;
+      p_conn->recvEnd = 0;
+   }
+   else if (p_conn->recvEnd == HTTP_RECV_BUF_SIZE)
+   {
+      memmove(p_conn->recvBuf, p_conn->recvBuf + p_conn->recvStart,
+              p_conn->recvEnd - p_conn->recvStart);
+      p_conn->recvEnd -= p_conn->recvStart;
+      p_conn->recvStart = 0;
+   }
+
+   ssize_t n;
+   do
+   {
+      n = recv(p_conn->sockFd, p_conn->recvBuf + p_conn->recvEnd,
+               HTTP_RECV_BUF_SIZE - p_conn->recvEnd, 0);
+   } while ((n < 0) && (errno == EINTR));
+
+   if (n > 0)
+   {
+      p_conn->recvEnd += n;
+   }
+   return n;
+}
+
+//----------------------------------------------------------------------------
+// Get step result of fillRecvBuf() which does not receive any data
+//----------------------------------------------------------------------------
+static StepResultE recvFailStep(HttpConnT* p_conn, ssize_t n)
+{
+   if ((n < 0) && (errno == EAGAIN))
+   {
+      p_conn->waitEvents = POLLIN;
+      return STEP_WAIT;
+   }
+   return STEP_FAIL;
+}
+
+//----------------------------------------------------------------------------
+// Read one line (end by "\r\n") from connection into p_conn->line, line is
+// truncated if it is longer than HTTP_LINE_SIZE. Part of line is kept when
+// socket is not readable.
+//----------------------------------------------------------------------------
+static StepResultE readLineStep(HttpConnT* p_conn)
+{
+   while (1)
+   {
+      char* p_start = p_conn->recvBuf + p_conn->recvStart;
+      size_t avail = p_conn->recvEnd - p_conn->recvStart;
+      char* p_newLine = memchr(p_start, '\n', avail);
+      size_t take = p_newLine ? (size_t)(p_newLine - p_start + 1) : avail;
+
+      size_t copyLen = take;
+      if (p_conn->lineLen + copyLen >= HTTP_LINE_SIZE)
+      {
+         copyLen = HTTP_LINE_SIZE - 1 - p_conn->lineLen;
+      }
+      memcpy(p_conn->line + p_conn->lineLen, p_start, copyLen);
+      p_conn->lineLen += copyLen;
+      p_conn->recvStart += take;
+
+      if (p_newLine)
+      {
+         break;
+      }
+      ssize_t n = fillRecvBuf(p_conn);
+      if (n <= 0)
+      {
+         return recvFailStep(p_conn, n);
+      }
+   }
+
+   // Strip "\r\n", next line is read from start of buffer
+   size_t lineLen = p_conn->lineLen;
+   while (lineLen && (p_conn->line[lineLen - 1] == '\n' || p_conn->line[lineLen - 1] == '\r'))
+   {
+      lineLen--;
+   }
+   p_conn->line[lineLen] = 0;
+   p_conn->lineLen = 0;
+   return STEP_NEXT;
+}
+
+//----------------------------------------------------------------------------
+// Give data to sink of body, data is dropped if we do not have sink
+//----------------------------------------------------------------------------
+static bool sinkData(HttpSinkT sink, void* p_sinkArg, const char* data, size_t len)
+{
+   return sink ? sink(p_sinkArg, data, len) : true;
+}
+
+//----------------------------------------------------------------------------
+// Read rest of body (or of current chunk) from connection, data is given to
+// sink as it arrives from socket
+//----------------------------------------------------------------------------
+static StepResultE readBodyStep(HttpConnT* p_conn)
+{
+   while (p_conn->bodyLeft)
+   {
+      if (p_conn->recvStart == p_conn->recvEnd)
+      {
+         ssize_t n = fillRecvBuf(p_conn);
+         if (n <= 0)
+         {
+            return recvFailStep(p_conn, n);
+         }
+      }
+      size_t avail = p_conn->recvEnd - p_conn->recvStart;
+      size_t take = ((long long)avail < p_conn->bodyLeft) ? avail : (size_t)p_conn->bodyLeft;
+      if (!sinkData(p_conn->sink, p_conn->p_sinkArg, p_conn->recvBuf + p_conn->recvStart, take))
+      {
+         return STEP_FAIL;
+      }
+      p_conn->recvStart += take;
+      p_conn->bodyLeft -= take;
+   }
+   return STEP_NEXT;
+}
+
+//----------------------------------------------------------------------------
+// Read body which is end when server closes connection
+//----------------------------------------------------------------------------
+static StepResultE readUntilCloseStep(HttpConnT* p_conn)
+{
+   while (1)
+   {
+      size_t avail = p_conn->recvEnd - p_conn->recvStart;
+      if (avail && !sinkData(p_conn->sink, p_conn->p_sinkArg,
+                             p_conn->recvBuf + p_conn->recvStart, avail))
+      {
+         return STEP_FAIL;
+      }
+      p_conn->recvStart = p_conn->recvEnd;
+
+      ssize_t n = fillRecvBuf(p_conn);
+      if (n == 0)
+      {
+         p_conn->keepAlive = false;
+         return STEP_DONE;
+      }
+      if (n < 0)
+      {
+         return recvFailStep(p_conn, n);
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Check that response of status code does not have body (RFC 7230 3.3.3),
+// it must not be read until server closes connection
+//----------------------------------------------------------------------------
+static bool isBodilessStatus(int statusCode)
+{
+   return ((statusCode >= 100) && (statusCode < 200)) || (statusCode == 204) ||
+          (statusCode == 304);
+}
+
+//----------------------------------------------------------------------------
+// Parse status line of response. Interim responses (1xx) are skipped, body
+// of final response is only given to sink if status code is 200.
+//----------------------------------------------------------------------------
+static StepResultE parseStatusLine(HttpConnT* p_conn)
+{
+   int minorVersion = 1;
+   int statusCode = 0;
+   if (sscanf(p_conn->line, "HTTP/1.%d %d", &minorVersion, &statusCode) != 2)
+   {
+      p_conn->statusCode = HTTP_BROKEN_RESPONSE;
+      return STEP_FAIL;
+   }
+   p_conn->statusCode = statusCode;
+
+   // Interim response has only headers, final response follows it
+   if ((statusCode >= 100) && (statusCode < 200) && (statusCode != 101))
+   {
+      p_conn->reqState = HTTP_REQ_INTERIM;
+      return STEP_NEXT;
+   }
+   p_conn->keepAlive = (minorVersion >= 1);
+   if (statusCode != 200)
+   {
+      p_conn->sink = NULL;
+   }
+   p_conn->reqState = HTTP_REQ_HEADER;
+   return STEP_NEXT;
+}
+
+//----------------------------------------------------------------------------
+// Take header line of response which tells how body is sent
+//----------------------------------------------------------------------------
+static void parseHeaderLine(HttpConnT* p_conn)
+{
+   const char* line = p_conn->line;
+   if (!strncasecmp(line, "Content-Length:", strlen("Content-Length:")))
+   {
+      p_conn->contentLength = atoll(line + strlen("Content-Length:"));
+   }
+   else if (!strncasecmp(line, "Transfer-Encoding:", strlen("Transfer-Encoding:")))
+   {
+      p_conn->isChunked = (strcasestr(line, "chunked") != NULL);
+   }
+   else if (!strncasecmp(line, "Connection:", strlen("Connection:")))
+   {
+      if (strcasestr(line, "close"))
+      {
+         p_conn->keepAlive = false;
+      }
+      else if (strcasestr(line, "keep-alive"))
+      {
+         p_conn->keepAlive = true;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Choose how body is read when all headers are received
+//----------------------------------------------------------------------------
+static StepResultE startBody(HttpConnT* p_conn)
+{
+   if (isBodilessStatus(p_conn->statusCode))
+   {
+      // Content-Length and Transfer-Encoding of these responses do not
+      // tell size of body, there is no body
+      return STEP_DONE;
+   }
+   if (p_conn->isChunked)
+   {
+      p_conn->reqState = HTTP_REQ_CHUNK_SIZE;
+   }
+   else if (p_conn->contentLength >= 0)
+   {
+      p_conn->bodyLeft = p_conn->contentLength;
+      p_conn->reqState = HTTP_REQ_BODY;
+   }
+   else
+   {
+      p_conn->reqState = HTTP_REQ_UNTIL_CLOSE;
+   }
+   return STEP_NEXT;
+}
+
+//----------------------------------------------------------------------------
+// Do one step of request as far as socket lets it
+//----------------------------------------------------------------------------
+static StepResultE stepRequest(HttpConnT* p_conn)
+{
+   StepResultE result = STEP_FAIL;
+   switch (p_conn->reqState)
+   {
+      case HTTP_REQ_CONNECT:
+      {
+         result = connectStep(p_conn);
+      }
+      break;
+      case HTTP_REQ_SEND:
+      {
+         result = sendStep(p_conn);
+      }
+      break;
+      case HTTP_REQ_STATUS:
+      {
+         result = readLineStep(p_conn);
+         if (result == STEP_NEXT)
+         {
+            result = parseStatusLine(p_conn);
+         }
+      }
+      break;
+      case HTTP_REQ_INTERIM:
+      {
+         result = readLineStep(p_conn);
+         if ((result == STEP_NEXT) && !p_conn->line[0])
+         {
+            p_conn->reqState = HTTP_REQ_STATUS;
+         }
+      }
+      break;
+      case HTTP_REQ_HEADER:
+      {
+         result = readLineStep(p_conn);
+         if ((result == STEP_NEXT) && p_conn->line[0])
+         {
+            parseHeaderLine(p_conn);
+         }
+         else if (result == STEP_NEXT)
+         {
+            result = startBody(p_conn);
+         }
+      }
+      break;
+      case HTTP_REQ_BODY:
+      {
+         result = readBodyStep(p_conn);
+         if (result == STEP_NEXT)
+         {
+            result = STEP_DONE;
+         }
+      }
+      break;
+      case HTTP_REQ_CHUNK_SIZE:
+      {
+         result = readLineStep(p_conn);
+         if (result == STEP_NEXT)
+         {
+            p_conn->bodyLeft = strtoul(p_conn->line, NULL, 16);
+            p_conn->reqState = p_conn->bodyLeft ? HTTP_REQ_CHUNK_DATA : HTTP_REQ_TRAILER;
+         }
+      }
+      break;
+      case HTTP_REQ_CHUNK_DATA:
+      {
+         result = readBodyStep(p_conn);
+         if (result == STEP_NEXT)
+         {
+            p_conn->reqState = HTTP_REQ_CHUNK_END;
+         }
+      }
+      break;
+      case HTTP_REQ_CHUNK_END:
+      {
+         result = readLineStep(p_conn);
+         if (result == STEP_NEXT)
+         {
+            p_conn->reqState = HTTP_REQ_CHUNK_SIZE;
+         }
+      }
+      break;
+      case HTTP_REQ_TRAILER:
+      {
+         // Skip trailer until empty line
+         result = readLineStep(p_conn);
+         if ((result == STEP_NEXT) && !p_conn->line[0])
+         {
+            result = STEP_DONE;
+         }
+      }
+      break;
+      case HTTP_REQ_UNTIL_CLOSE:
+      {
+         result = readUntilCloseStep(p_conn);
+      }
+      break;
+      default:
+      break;
+   }
+   return result;
+}
+
+//----------------------------------------------------------------------------
+// Send request again through a new connection. Server may close idle
+// connection before it reads request, then it is sent one more time, so
+// that sink never receives data of the same response twice.
+//----------------------------------------------------------------------------
+static bool canRetryRequest(HttpConnT* p_conn)
+{
+   if (!p_conn->isReused || p_conn->statusCode)
+   {
+      return false;
+   }
+   httpConnClose(p_conn);
+   p_conn->isReused = false;
+   p_conn->sentLen = 0;
+   p_conn->lineLen = 0;
+   p_conn->reqState = HTTP_REQ_CONNECT;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Finish request, connection is closed if it can not be reused
+//----------------------------------------------------------------------------
+static HttpProgressE finishRequest(HttpConnT* p_conn, StepResultE result)
+{
+   int statusCode = p_conn->statusCode;
+   if (result != STEP_DONE)
+   {
+      statusCode = statusCode ? HTTP_BROKEN_RESPONSE : HTTP_NO_RESPONSE;
+   }
+   if (statusCode < 0 || !p_conn->keepAlive)
+   {
+      httpConnClose(p_conn);
+   }
+   p_conn->statusCode = statusCode;
+   p_conn->reqState = HTTP_REQ_IDLE;
+
+   if (statusCode != 200)
+   {
+      // Job which has never been built does not have last build, 404 is
+      // expected then. Failures are counted by breaker and metrics anyway.
+      if ((statusCode != 404) && !isBodilessStatus(statusCode) && !p_conn->isCanceled)
+      {
+         const char* p_target = p_conn->p_request + strlen("GET ");
+         printf("Http request %s:%s%.*s failed, status: %d\n", p_conn->host, p_conn->port,
+                (int)strcspn(p_target, " "), p_target, statusCode);
+      }
+   }
+   return HTTP_DONE;
+}
+
+//----------------------------------------------------------------------------
+// Go on with request which is started by httpStart(), e.g. when its socket
+// is ready. Request which is aborted or whose deadline is passed fails now.
+// return HTTP_WAIT if socket is not ready, caller waits for waitEvents of
+//        sockFd until deadlineNs then resumes request again
+//        HTTP_DONE if request is finished, statusCode is 200 if it succeeds
+//----------------------------------------------------------------------------
+HttpProgressE httpResume(HttpConnT* p_conn)
+{
+   // Server which sends a byte now and then can not hold request longer
+   // than its timeout
+   StepResultE result = STEP_NEXT;
+   if (__atomic_load_n(&p_conn->isAborted, __ATOMIC_SEQ_CST))
+   {
+      p_conn->isCanceled = true;
+      result = STEP_FAIL;
+   }
+   else if (httpNowNs() >= p_conn->deadlineNs)
+   {
+      p_conn->isTimedOut = true;
+      result = STEP_FAIL;
+   }
+
+   while (result == STEP_NEXT)
+   {
+      result = stepRequest(p_conn);
+      if ((result == STEP_FAIL) && canRetryRequest(p_conn))
+      {
+         result = STEP_NEXT;
+      }
+   }
+   if (result == STEP_WAIT)
+   {
+      return HTTP_WAIT;
+   }
+   return finishRequest(p_conn, result);
+}
+
+//----------------------------------------------------------------------------
+// Start GET request to server, body of response is given to sink chunk by
+// chunk as it arrives from socket.
+// Connection is reused if it is still alive. If server has closed a reused
+// connection before responding, we reconnect and send request one more time.
+// return the same as httpResume()
+//----------------------------------------------------------------------------
+HttpProgressE httpStart(HttpConnT* p_conn, const char* path, HttpSinkT sink, void* p_sinkArg)
+{
+   size_t reqSize = strlen(p_conn->basePath) + strlen(path) + strlen(p_conn->host) +
+                    strlen(p_conn->port) + 256 +
+                    (p_conn->authHeader ? strlen(p_conn->authHeader) : 0);
+   char* p_request = realloc(p_conn->p_request, reqSize);
+   if (!p_request)
+   {
+      printf("Can not allocate memory for http request\n");
+      p_conn->statusCode = HTTP_NO_RESPONSE;
+      return HTTP_DONE;
+   }
+   p_conn->p_request = p_request;
+   p_conn->requestLen = snprintf(p_request, reqSize,
+                                 "GET %s%s HTTP/1.1\r\n"\
+                                 "Host: %s:%s\r\n"\
+                                 "Accept: application/json\r\n"\
+                                 "Connection: keep-alive\r\n"\
+                                 "%s"\
+                                 "\r\n",
+                                 p_conn->basePath, path, p_conn->host, p_conn->port,
+                                 p_conn->authHeader ? p_conn->authHeader : "");
+
+   p_conn->isTimedOut = false;
+   p_conn->isCanceled = false;
+   p_conn->statusCode = 0;
+   p_conn->deadlineNs = httpNowNs() + p_conn->timeoutMs * 1000000LL;
+   p_conn->sentLen = 0;
+   p_conn->lineLen = 0;
+   p_conn->keepAlive = false;
+   p_conn->isChunked = false;
+   p_conn->contentLength = -1;
+   p_conn->bodyLeft = 0;
+   p_conn->sink = sink;
+   p_conn->p_sinkArg = p_sinkArg;
+   p_conn->isReused = (p_conn->sockFd >= 0);
+   p_conn->reqState = p_conn->isReused ? HTTP_REQ_SEND : HTTP_REQ_CONNECT;
+   return httpResume(p_conn);
+}
+
+//----------------------------------------------------------------------------
+// Clear data of buffer, memory is kept to reuse
+//----------------------------------------------------------------------------
+void httpBufferReset(HttpBufferT* p_buf)
+{
+   p_buf->len = 0;
+   if (p_buf->p_data)
+   {
+      p_buf->p_data[0] = 0;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Append data to buffer, buffer is always terminated by '\0'
+//----------------------------------------------------------------------------
+bool httpBufferAppend(HttpBufferT* p_buf, const char* data, size_t len)
+{
+   if (p_buf->len + len + 1 > p_buf->size)
+   {
+      size_t newSize = p_buf->size ? p_buf->size : 4096;
+      while (p_buf->len + len + 1 > newSize)
+      {
+         newSize *= 2;
+      }
+      char* p_newData = realloc(p_buf->p_data, newSize);
+      if (!p_newData)
+      {
+         printf("Can not allocate memory for http buffer\n");
+         return false;
+      }
+      p_buf->p_data = p_newData;
+      p_buf->size = newSize;
+   }
+   memcpy(p_buf->p_data + p_buf->len, data, len);
+   p_buf->len += len;
+   p_buf->p_data[p_buf->len] = 0;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Free memory of buffer
+//----------------------------------------------------------------------------
+void httpBufferFree(HttpBufferT* p_buf)
+{
+   free(p_buf->p_data);
+   p_buf->p_data = NULL;
+   p_buf->len = 0;
+   p_buf->size = 0;
+}
+
+//----------------------------------------------------------------------------
+// Open listening unix socket
+//----------------------------------------------------------------------------
+static int listenUnix(const char* path)
+{
+   struct sockaddr_un addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   if (strlen(path) >= sizeof(addr.sun_path))
+   {
+      printf("Path of unix socket is too long: %s\n", path);
+      return -1;
+   }
+   strcpy(addr.sun_path, path);
+
+   int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+   if (fd < 0)
+   {
+      printf("Can not create unix socket: %s\n", strerror(errno));
+      return -1;
+   }
+   unlink(path);
+   if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(fd, 16))
+   {
+      printf("Can not listen on %s: %s\n", path, strerror(errno));
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+//----------------------------------------------------------------------------
+// Open listening socket
+// Address format: [host:]port, listen on loopback if host is not given and on
+// all interfaces if host is "*", or path of unix socket (begins with '/'),
+// old socket file is replaced
+// return -1 if error
+//----------------------------------------------------------------------------
+int httpListen(const char* listenAddr)
+{
+   if (listenAddr[0] == '/')
+   {
+      return listenUnix(listenAddr);
+   }
+
+   char host[256] = "";
+   const char* port = listenAddr;
+   const char* p_colon = strrchr(listenAddr, ':');
+   if (p_colon)
+   {
+      size_t hostLen = p_colon - listenAddr;
+      if (hostLen >= sizeof(host))
+      {
+         printf("Listen address is too long: %s\n", listenAddr);
+         return -1;
+      }
+      memcpy(host, listenAddr, hostLen);
+      host[hostLen] = 0;
+      port = p_colon + 1;
+   }
+
+   struct addrinfo hints;
+   struct addrinfo* p_addrInfo = NULL;
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags = AI_PASSIVE;
+   if (!host[0])
+   {
+      strcpy(host, "127.0.0.1");
+   }
+   int ret = getaddrinfo(strcmp(host, "*") ? host : NULL, port, &hints, &p_addrInfo);
+   if (ret)
+   {
+      printf("Can not resolve listen address %s: %s\n", listenAddr, gai_strerror(ret));
+      return -1;
+   }
+
+   int fd = -1;
+   struct addrinfo* p_addr;
+   for (p_addr = p_addrInfo; p_addr; p_addr = p_addr->ai_next)
+   {
+      fd = socket(p_addr->ai_family, p_addr->ai_socktype | SOCK_CLOEXEC, p_addr->ai_protocol);
+      if (fd < 0)
+      {
+         continue;
+      }
+      int one = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      if (!bind(fd, p_addr->ai_addr, p_addr->ai_addrlen) && !listen(fd, 16))
+      {
+         break;
+      }
+      close(fd);
+      fd = -1;
+   }
+   if (fd < 0)
+   {
+      printf("Can not listen on %s: %s\n", listenAddr, strerror(errno));
+   }
+   freeaddrinfo(p_addrInfo);
+   return fd;
+}
+
+//----------------------------------------------------------------------------
+// Send whole data to client of a listening socket
+//----------------------------------------------------------------------------
+bool httpSendAll(int fd, const char* data, size_t len)
+{
+   while (len)
+   {
+      ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+      if (n < 0)
+      {
+         if (errno == EINTR)
+         {
+            continue;
+         }
+         return false;
+      }
+      data += n;
+      len -= n;
+   }
+   return true;
+}
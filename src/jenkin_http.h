@@ -0,0 +1,131 @@
+#ifndef JENKIN_HTTP_H
+#define JENKIN_HTTP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <netdb.h>
+
+//----------------------------------------------------------------
+// Growable buffer to build body of http response before it is sent, by
+// servers of this project (metrics endpoint, fake jenkins). Client does not
+// buffer responses, they are streamed to HttpSinkT.
+//----------------------------------------------------------------
+typedef struct httpBuffer
+{
+   char*  p_data;
+   size_t len;
+   size_t size;
+}HttpBufferT;
+
+//----------------------------------------------------------------
+// Sink to receive body of http response chunk by chunk
+// return false to abort the response
+//----------------------------------------------------------------
+typedef bool (*HttpSinkT)(void* p_arg, const char* data, size_t len);
+
+// Status of request which does not get a whole response
+#define HTTP_NO_RESPONSE      -1    // connection fails before status line is received
+#define HTTP_BROKEN_RESPONSE  -2    // connection fails after that
+
+// Size of receive buffer of connection
+#define HTTP_RECV_BUF_SIZE    4096
+
+// Size of status line or header line, longer line is truncated
+#define HTTP_LINE_SIZE        1024
+
+//----------------------------------------------------------------
+// Step of request which is in flight
+//----------------------------------------------------------------
+typedef enum httpReqState
+{
+   HTTP_REQ_IDLE,
+   HTTP_REQ_CONNECT,                // connecting to an address of server
+   HTTP_REQ_SEND,
+   HTTP_REQ_STATUS,                 // status line of response
+   HTTP_REQ_INTERIM,                // headers of interim response (1xx)
+   HTTP_REQ_HEADER,
+   HTTP_REQ_BODY,                   // body by Content-Length
+   HTTP_REQ_CHUNK_SIZE,
+   HTTP_REQ_CHUNK_DATA,
+   HTTP_REQ_CHUNK_END,              // "\r\n" after data of chunk
+   HTTP_REQ_TRAILER,
+   HTTP_REQ_UNTIL_CLOSE             // body which ends when server closes connection
+}HttpReqStateE;
+
+//----------------------------------------------------------------
+// Progress of request which is driven by httpStart() and httpResume()
+//----------------------------------------------------------------
+typedef enum httpProgress
+{
+   HTTP_WAIT,                       // wait for waitEvents of sockFd until deadlineNs
+   HTTP_DONE                        // request is finished, statusCode tells result
+}HttpProgressE;
+
+//----------------------------------------------------------------
+// Persistent connection to a jenkins server
+// Address of server is resolved one time and socket is kept alive
+// between poll cycles, so that we do not need to fork curl process
+// and do tcp handshake for every request
+// Socket is non-blocking, a request never waits: it goes as far as socket
+// lets it, then caller waits for socket (e.g. by epoll of a scheduler) and
+// resumes request. So one thread can keep requests of many servers in flight.
+//----------------------------------------------------------------
+typedef struct httpConn
+{
+   char* host;
+   char* port;
+   char* basePath;                  // path prefix of server, "" if not have
+   char* authHeader;                // NULL if do not use authorization
+   struct addrinfo* p_addrInfo;     // cached DNS result
+   int   sockFd;                    // -1 if not connected, socket is non-blocking
+   unsigned int timeoutMs;          // whole request, connecting included
+   long long deadlineNs;            // CLOCK_MONOTONIC, end of current request
+   bool  isAborted;                 // requests are canceled, it is only accessed atomically
+   bool  isTimedOut;                // last request failed by timeout
+   bool  isCanceled;                // last request failed by httpConnAbort()
+   int   statusCode;                // of last request, HTTP_xxx_RESPONSE if not have
+
+   // Request which is in flight, statusCode is 0 until status line of its
+   // response is received
+   HttpReqStateE reqState;
+   short waitEvents;                // POLLIN or POLLOUT, when HTTP_WAIT is returned
+   char* p_request;                 // request line and headers
+   size_t requestLen;
+   size_t sentLen;
+   struct addrinfo* p_connAddr;     // address which is being connected
+   bool  isReused;                  // request is sent through kept connection
+   bool  keepAlive;
+   bool  isChunked;
+   long long contentLength;         // -1 if response does not have it
+   long long bodyLeft;              // of body or of current chunk
+   HttpSinkT sink;                  // NULL if body is dropped
+   void* p_sinkArg;
+   char*  line;                     // HTTP_LINE_SIZE bytes, line which is being read
+   size_t lineLen;
+
+   // Receive buffer, data after a response may belong to next response.
+   // It is allocated apart, connection is embedded in objects which are
+   // walked by loops that do not read it.
+   char*  recvBuf;                  // HTTP_RECV_BUF_SIZE bytes
+   size_t recvStart;
+   size_t recvEnd;
+}HttpConnT;
+
+bool httpConnInit(HttpConnT* p_conn, const char* serverName,
+                  const char* userName, const char* passWord, unsigned int timeoutMs);
+void httpConnAbort(HttpConnT* p_conn);
+void httpConnClearAbort(HttpConnT* p_conn);
+void httpConnSetTimeout(HttpConnT* p_conn, unsigned int timeoutMs);
+void httpConnClose(HttpConnT* p_conn);
+void httpConnFree(HttpConnT* p_conn);
+HttpProgressE httpStart(HttpConnT* p_conn, const char* path, HttpSinkT sink, void* p_sinkArg);
+HttpProgressE httpResume(HttpConnT* p_conn);
+
+int httpListen(const char* listenAddr);
+bool httpSendAll(int fd, const char* data, size_t len);
+
+void httpBufferReset(HttpBufferT* p_buf);
+bool httpBufferAppend(HttpBufferT* p_buf, const char* data, size_t len);
+void httpBufferFree(HttpBufferT* p_buf);
+
+#endif
@@ -0,0 +1,644 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "jenkin_json.h"
+
+// Define JSON_NO_SIMD to use scalar scanning only (to compare in benchmark)
+#if !defined(JSON_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define JSON_USE_SSE2 1
+#elif !defined(JSON_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define JSON_USE_NEON 1
+#endif
+
+//----------------------------------------------------------------
+// Role of json container, only containers which lead to job fields are
+// tracked, other containers are skipped as a whole
+//----------------------------------------------------------------
+typedef enum jsonRole
+{
+   ROOT_ROLE,           // root object, is job in query for one job
+   JOBS_ROLE,           // "jobs" array of root object
+   JOB_ROLE,            // object in "jobs" array
+   LAST_BUILD_ROLE,     // "lastBuild" object of job, or "build" of notification
+   ARRAY_ROLE           // array which is not "jobs", its elements are skipped
+}JsonRoleE;
+
+typedef enum jsonKey
+{
+   NONE_KEY,
+   NAME_KEY,
+   COLOR_KEY,
+   TIMESTAMP_KEY,
+   RESULT_KEY,
+   JOBS_KEY,
+   LAST_BUILD_KEY,
+   PHASE_KEY,
+   NUMBER_KEY,
+   URL_KEY,
+   FULL_URL_KEY
+}JsonKeyE;
+
+//----------------------------------------------------------------------------
+// Vectorized scanning
+// Most of bytes in jenkins response are inside strings (class names, job
+// names) or inside containers we do not care about, so we find next special
+// character 16 bytes at a time instead of checking byte by byte.
+//----------------------------------------------------------------------------
+#if JSON_USE_NEON
+//----------------------------------------------------------------------------
+// Get index of first non zero byte in mask, 16 if all bytes are zero
+//----------------------------------------------------------------------------
+static inline int firstSetByte(uint8x16_t mask)
+{
+   uint64x2_t mask64 = vreinterpretq_u64_u8(mask);
+   unsigned long long low = vgetq_lane_u64(mask64, 0);
+   unsigned long long high = vgetq_lane_u64(mask64, 1);
+   if (low)
+   {
+      return __builtin_ctzll(low) >> 3;
+   }
+   if (high)
+   {
+      return 8 + (__builtin_ctzll(high) >> 3);
+   }
+   return 16;
+}
+#endif
+
+//----------------------------------------------------------------------------
+// Find next '"' or '\' inside string
+//----------------------------------------------------------------------------
+static inline const char* scanString(const char* p_cur, const char* p_end)
+{
+#if JSON_USE_SSE2
+   const __m128i quote = _mm_set1_epi8('"');
+   const __m128i backSlash = _mm_set1_epi8('\\');
+   while (p_end - p_cur >= 16)
+   {
+      __m128i block = _mm_loadu_si128((const __m128i*)p_cur);
+      int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                                                _mm_cmpeq_epi8(block, backSlash)));
+      if (mask)
+      {
+         return p_cur + __builtin_ctz(mask);
+      }
+      p_cur += 16;
+   }
+#elif JSON_USE_NEON
+   const uint8x16_t quote = vdupq_n_u8('"');
+   const uint8x16_t backSlash = vdupq_n_u8('\\');
+   while (p_end - p_cur >= 16)
+   {
+      uint8x16_t block = vld1q_u8((const unsigned char*)p_cur);
+      int idx = firstSetByte(vorrq_u8(vceqq_u8(block, quote), vceqq_u8(block, backSlash)));
+      if (idx < 16)
+      {
+         return p_cur + idx;
+      }
+      p_cur += 16;
+   }
+#endif
+   while ((p_cur < p_end) && (*p_cur != '"') && (*p_cur != '\\'))
+   {
+      p_cur++;
+   }
+   return p_cur;
+}
+
+//----------------------------------------------------------------------------
+// Find next '"', '{', '}', '[' or ']' inside a skipped container
+// ('{' | 0x20) == '{', ('[' | 0x20) == '{', same for '}' and ']'
+//----------------------------------------------------------------------------
+static inline const char* scanSkipped(const char* p_cur, const char* p_end)
+{
+#if JSON_USE_SSE2
+   const __m128i quote = _mm_set1_epi8('"');
+   const __m128i lowerBit = _mm_set1_epi8(0x20);
+   const __m128i openBrace = _mm_set1_epi8('{');
+   const __m128i closeBrace = _mm_set1_epi8('}');
+   while (p_end - p_cur >= 16)
+   {
+      __m128i block = _mm_loadu_si128((const __m128i*)p_cur);
+      __m128i lowered = _mm_or_si128(block, lowerBit);
+      __m128i match = _mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                                   _mm_or_si128(_mm_cmpeq_epi8(lowered, openBrace),
+                                                _mm_cmpeq_epi8(lowered, closeBrace)));
+      int mask = _mm_movemask_epi8(match);
+      if (mask)
+      {
+         return p_cur + __builtin_ctz(mask);
+      }
+      p_cur += 16;
+   }
+#elif JSON_USE_NEON
+   const uint8x16_t quote = vdupq_n_u8('"');
+   const uint8x16_t lowerBit = vdupq_n_u8(0x20);
+   const uint8x16_t openBrace = vdupq_n_u8('{');
+   const uint8x16_t closeBrace = vdupq_n_u8('}');
+   while (p_end - p_cur >= 16)
+   {
+      uint8x16_t block = vld1q_u8((const unsigned char*)p_cur);
+      uint8x16_t lowered = vorrq_u8(block, lowerBit);
+      uint8x16_t match = vorrq_u8(vceqq_u8(block, quote),
+                                  vorrq_u8(vceqq_u8(lowered, openBrace),
+                                           vceqq_u8(lowered, closeBrace)));
+      int idx = firstSetByte(match);
+      if (idx < 16)
+      {
+         return p_cur + idx;
+      }
+      p_cur += 16;
+   }
+#endif
+   while (p_cur < p_end)
+   {
+      char c = *p_cur | 0x20;
+      if ((*p_cur == '"') || (c == '{') || (c == '}'))
+      {
+         break;
+      }
+      p_cur++;
+   }
+   return p_cur;
+}
+
+//----------------------------------------------------------------------------
+// Init extractor before feeding a new response
+//----------------------------------------------------------------------------
+void jsonExtractorInit(JsonExtractorT* p_ext, JsonJobCallbackT callback, void* p_arg)
+{
+   memset(p_ext, 0, sizeof(JsonExtractorT));
+   p_ext->callback = callback;
+   p_ext->p_arg = p_arg;
+}
+
+//----------------------------------------------------------------------------
+// Get role of container which is on top of stack, -1 if there is no container
+//----------------------------------------------------------------------------
+static inline int topRole(JsonExtractorT* p_ext)
+{
+   return p_ext->depth ? p_ext->roles[p_ext->depth - 1] : -1;
+}
+
+//----------------------------------------------------------------------------
+// Get job entry which fields in current object belong to
+//----------------------------------------------------------------------------
+static inline JsonJobEntryT* currentEntry(JsonExtractorT* p_ext)
+{
+   return ((p_ext->depth >= 2) && (p_ext->roles[1] == JOBS_ROLE)) ?
+          &p_ext->jobEntry : &p_ext->rootEntry;
+}
+
+//----------------------------------------------------------------------------
+// Check that fields of job can be taken in current object
+//----------------------------------------------------------------------------
+static inline bool isJobFieldObject(JsonExtractorT* p_ext)
+{
+   int role = topRole(p_ext);
+   return (role == ROOT_ROLE) || (role == JOB_ROLE) || (role == LAST_BUILD_ROLE);
+}
+
+//----------------------------------------------------------------------------
+// Value of current key is finished, next is ',' or end of container
+//----------------------------------------------------------------------------
+static inline void endValue(JsonExtractorT* p_ext)
+{
+   p_ext->curKey = NONE_KEY;
+   p_ext->expectKey = false;
+}
+
+//----------------------------------------------------------------------------
+// Get key id from key string
+//----------------------------------------------------------------------------
+static JsonKeyE keyOf(const char* key, size_t keyLen)
+{
+   switch (keyLen)
+   {
+      case 3:
+         if (!memcmp(key, "url", 3)) return URL_KEY;
+         break;
+      case 4:
+         if (!memcmp(key, "name", 4)) return NAME_KEY;
+         if (!memcmp(key, "jobs", 4)) return JOBS_KEY;
+         break;
+      case 5:
+         if (!memcmp(key, "color", 5)) return COLOR_KEY;
+         if (!memcmp(key, "build", 5)) return LAST_BUILD_KEY;
+         if (!memcmp(key, "phase", 5)) return PHASE_KEY;
+         break;
+      case 6:
+         if (!memcmp(key, "result", 6)) return RESULT_KEY;
+         if (!memcmp(key, "status", 6)) return RESULT_KEY;
+         if (!memcmp(key, "number", 6)) return NUMBER_KEY;
+         break;
+      case 8:
+         if (!memcmp(key, "full_url", 8)) return FULL_URL_KEY;
+         break;
+      case 9:
+         if (!memcmp(key, "timestamp", 9)) return TIMESTAMP_KEY;
+         if (!memcmp(key, "lastBuild", 9)) return LAST_BUILD_KEY;
+         break;
+      default:
+         break;
+   }
+   return NONE_KEY;
+}
+
+//----------------------------------------------------------------------------
+// Start of a string, decide where it is captured to
+//----------------------------------------------------------------------------
+static void beginString(JsonExtractorT* p_ext)
+{
+   p_ext->isInString = true;
+   p_ext->strLen = 0;
+   p_ext->p_strDst = NULL;
+   p_ext->strSize = 0;
+   p_ext->isKeyString = p_ext->expectKey;
+
+   if (p_ext->isKeyString)
+   {
+      p_ext->keyLen = 0;
+      p_ext->p_strDst = p_ext->keyBuf;
+      p_ext->strSize = sizeof(p_ext->keyBuf);
+   }
+   else if (isJobFieldObject(p_ext))
+   {
+      JsonJobEntryT* p_entry = currentEntry(p_ext);
+      if ((p_ext->curKey == NAME_KEY) && (topRole(p_ext) != LAST_BUILD_ROLE))
+      {
+         p_ext->p_strDst = p_entry->name;
+         p_ext->strSize = sizeof(p_entry->name);
+      }
+      else if ((p_ext->curKey == COLOR_KEY) && (topRole(p_ext) != LAST_BUILD_ROLE))
+      {
+         p_ext->p_strDst = p_entry->color;
+         p_ext->strSize = sizeof(p_entry->color);
+      }
+      else if (p_ext->curKey == RESULT_KEY)
+      {
+         p_ext->p_strDst = p_entry->result;
+         p_ext->strSize = sizeof(p_entry->result);
+      }
+      else if (p_ext->curKey == PHASE_KEY)
+      {
+         p_ext->p_strDst = p_entry->phase;
+         p_ext->strSize = sizeof(p_entry->phase);
+      }
+      else if ((p_ext->curKey == URL_KEY) && (topRole(p_ext) != LAST_BUILD_ROLE))
+      {
+         p_ext->p_strDst = p_entry->url;
+         p_ext->strSize = sizeof(p_entry->url);
+      }
+      else if ((p_ext->curKey == FULL_URL_KEY) && (topRole(p_ext) == LAST_BUILD_ROLE))
+      {
+         p_ext->p_strDst = p_entry->fullUrl;
+         p_ext->strSize = sizeof(p_entry->fullUrl);
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Append characters to captured string, string is truncated if it is too long
+//----------------------------------------------------------------------------
+static inline void appendString(JsonExtractorT* p_ext, const char* data, size_t len)
+{
+   if (!p_ext->p_strDst)
+   {
+      return;
+   }
+   // Keep 1 byte for '\0'
+   if (p_ext->strLen + len >= p_ext->strSize)
+   {
+      len = p_ext->strSize - 1 - p_ext->strLen;
+   }
+   memcpy(p_ext->p_strDst + p_ext->strLen, data, len);
+   p_ext->strLen += len;
+}
+
+//----------------------------------------------------------------------------
+// End of a string
+//----------------------------------------------------------------------------
+static void endString(JsonExtractorT* p_ext)
+{
+   p_ext->isInString = false;
+   if (p_ext->p_strDst)
+   {
+      p_ext->p_strDst[p_ext->strLen] = 0;
+   }
+
+   if (p_ext->isKeyString)
+   {
+      // Truncated key (length == buffer size - 1) never matches known keys
+      p_ext->curKey = (p_ext->strLen < sizeof(p_ext->keyBuf) - 1) ?
+                      keyOf(p_ext->keyBuf, p_ext->strLen) : NONE_KEY;
+      p_ext->expectKey = false;
+   }
+   else if (p_ext->skipDepth == 0)
+   {
+      endValue(p_ext);
+   }
+}
+
+//----------------------------------------------------------------------------
+// End of number or literal token
+//----------------------------------------------------------------------------
+static void endToken(JsonExtractorT* p_ext)
+{
+   p_ext->isInToken = false;
+   p_ext->token[p_ext->tokenLen] = 0;
+   if ((p_ext->curKey == TIMESTAMP_KEY) && isJobFieldObject(p_ext))
+   {
+      currentEntry(p_ext)->timestamp = atoll(p_ext->token);
+   }
+   else if ((p_ext->curKey == NUMBER_KEY) && isJobFieldObject(p_ext))
+   {
+      currentEntry(p_ext)->number = atoll(p_ext->token);
+   }
+   else if ((p_ext->curKey == RESULT_KEY) && isJobFieldObject(p_ext))
+   {
+      // "result": null when job is building
+      currentEntry(p_ext)->result[0] = 0;
+   }
+   endValue(p_ext);
+}
+
+//----------------------------------------------------------------------------
+// Check that job entry has any field
+//----------------------------------------------------------------------------
+static inline bool hasJobField(const JsonJobEntryT* p_entry)
+{
+   return p_entry->name[0] || p_entry->color[0] || p_entry->result[0] ||
+          p_entry->timestamp || p_entry->number || p_entry->phase[0];
+}
+
+//----------------------------------------------------------------------------
+// Open object or array
+//----------------------------------------------------------------------------
+static void openContainer(JsonExtractorT* p_ext, char c)
+{
+   int parentRole = topRole(p_ext);
+   int role = -1;
+
+   if (parentRole < 0)
+   {
+      if (p_ext->isRootClosed)
+      {
+         p_ext->isError = true;
+         return;
+      }
+      role = (c == '{') ? ROOT_ROLE : ARRAY_ROLE;
+   }
+   else if ((parentRole == ROOT_ROLE) && (p_ext->curKey == JOBS_KEY) && (c == '['))
+   {
+      role = JOBS_ROLE;
+   }
+   else if ((parentRole == JOBS_ROLE) && (c == '{'))
+   {
+      role = JOB_ROLE;
+      memset(&p_ext->jobEntry, 0, offsetof(JsonJobEntryT, url));
+      p_ext->jobEntry.url[0] = 0;
+      p_ext->jobEntry.fullUrl[0] = 0;
+   }
+   else if (((parentRole == ROOT_ROLE) || (parentRole == JOB_ROLE)) &&
+            (p_ext->curKey == LAST_BUILD_KEY) && (c == '{'))
+   {
+      role = LAST_BUILD_ROLE;
+   }
+
+   if ((role < 0) || (p_ext->depth >= JSON_MAX_DEPTH))
+   {
+      // We do not care about this container -> skip it
+      p_ext->skipDepth = 1;
+      return;
+   }
+
+   p_ext->roles[p_ext->depth++] = role;
+   p_ext->curKey = NONE_KEY;
+   p_ext->expectKey = (c == '{');
+}
+
+//----------------------------------------------------------------------------
+// Close object or array
+//----------------------------------------------------------------------------
+static void closeContainer(JsonExtractorT* p_ext, char c)
+{
+   if (!p_ext->depth)
+   {
+      p_ext->isError = true;
+      return;
+   }
+   int role = p_ext->roles[--p_ext->depth];
+   bool isObject = (role != JOBS_ROLE) && (role != ARRAY_ROLE);
+   if (isObject != (c == '}'))
+   {
+      p_ext->isError = true;
+      return;
+   }
+
+   if ((role == JOB_ROLE) && hasJobField(&p_ext->jobEntry))
+   {
+      p_ext->callback(p_ext->p_arg, &p_ext->jobEntry);
+   }
+   else if (role == ROOT_ROLE)
+   {
+      p_ext->isRootClosed = true;
+      if (hasJobField(&p_ext->rootEntry))
+      {
+         p_ext->callback(p_ext->p_arg, &p_ext->rootEntry);
+      }
+   }
+   endValue(p_ext);
+}
+
+//----------------------------------------------------------------------------
+// Feed a chunk of response to extractor
+//----------------------------------------------------------------------------
+bool jsonExtractorFeed(JsonExtractorT* p_ext, const char* data, size_t len)
+{
+   const char* p_cur = data;
+   const char* p_end = data + len;
+
+   while ((p_cur < p_end) && !p_ext->isError)
+   {
+      if (p_ext->isInString)
+      {
+         if (p_ext->unicodeLeft)
+         {
+            // Skip hex digits of \uXXXX
+            p_ext->unicodeLeft--;
+            p_cur++;
+            continue;
+         }
+         if (p_ext->isEscape)
+         {
+            char c = *p_cur++;
+            p_ext->isEscape = false;
+            switch (c)
+            {
+               case 'n': c = '\n'; break;
+               case 't': c = '\t'; break;
+               case 'r': c = '\r'; break;
+               case 'b': c = '\b'; break;
+               case 'f': c = '\f'; break;
+               case 'u':
+               {
+                  // Job name and color are ascii, keep '?' for other characters
+                  p_ext->unicodeLeft = 4;
+                  c = '?';
+               }
+               break;
+               default:
+                  break;
+            }
+            appendString(p_ext, &c, 1);
+            continue;
+         }
+
+         const char* p_special = scanString(p_cur, p_end);
+         appendString(p_ext, p_cur, p_special - p_cur);
+         p_cur = p_special;
+         if (p_cur == p_end)
+         {
+            break;
+         }
+         if (*p_cur++ == '\\')
+         {
+            p_ext->isEscape = true;
+         }
+         else
+         {
+            endString(p_ext);
+         }
+         continue;
+      }
+
+      if (p_ext->skipDepth)
+      {
+         p_cur = scanSkipped(p_cur, p_end);
+         if (p_cur == p_end)
+         {
+            break;
+         }
+         char c = *p_cur++;
+         if (c == '"')
+         {
+            beginString(p_ext);
+            p_ext->p_strDst = NULL;
+            p_ext->isKeyString = false;
+         }
+         else if ((c == '{') || (c == '['))
+         {
+            p_ext->skipDepth++;
+         }
+         else if (--p_ext->skipDepth == 0)
+         {
+            endValue(p_ext);
+         }
+         continue;
+      }
+
+      char c = *p_cur;
+      if (p_ext->isInToken)
+      {
+         if (((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) ||
+             (c == '-') || (c == '+') || (c == '.') || (c == 'E'))
+         {
+            if (p_ext->tokenLen + 1 < sizeof(p_ext->token))
+            {
+               p_ext->token[p_ext->tokenLen++] = c;
+            }
+            p_cur++;
+            continue;
+         }
+         endToken(p_ext);
+      }
+
+      switch (c)
+      {
+         case ' ':
+         case '\t':
+         case '\n':
+         case '\r':
+         case ':':
+            break;
+         case '"':
+            beginString(p_ext);
+            break;
+         case ',':
+            p_ext->curKey = NONE_KEY;
+            p_ext->expectKey = (p_ext->depth && (topRole(p_ext) != JOBS_ROLE) &&
+                                (topRole(p_ext) != ARRAY_ROLE));
+            break;
+         case '{':
+         case '[':
+            openContainer(p_ext, c);
+            break;
+         case '}':
+         case ']':
+            closeContainer(p_ext, c);
+            break;
+         default:
+            p_ext->isInToken = true;
+            p_ext->tokenLen = 0;
+            p_ext->token[p_ext->tokenLen++] = c;
+            break;
+      }
+      p_cur++;
+   }
+   return !p_ext->isError;
+}
+
+//----------------------------------------------------------------------------
+// All chunks have been fed, check that json data is complete
+//----------------------------------------------------------------------------
+bool jsonExtractorFinish(JsonExtractorT* p_ext)
+{
+   if (p_ext->isInToken)
+   {
+      endToken(p_ext);
+   }
+   return !p_ext->isError && !p_ext->isInString && !p_ext->skipDepth &&
+          !p_ext->depth && p_ext->isRootClosed;
+}
+
+//----------------------------------------------------------------------------
+// Merge fields which exist in p_entry to job entry pointed by p_arg
+//----------------------------------------------------------------------------
+void jsonMergeJobEntry(void* p_arg, const JsonJobEntryT* p_entry)
+{
+   JsonJobEntryT* p_dst = (JsonJobEntryT*)p_arg;
+   if (p_entry->name[0])
+   {
+      strcpy(p_dst->name, p_entry->name);
+   }
+   if (p_entry->color[0])
+   {
+      strcpy(p_dst->color, p_entry->color);
+   }
+   if (p_entry->timestamp)
+   {
+      p_dst->timestamp = p_entry->timestamp;
+   }
+   if (p_entry->number)
+   {
+      p_dst->number = p_entry->number;
+   }
+   if (p_entry->result[0])
+   {
+      strcpy(p_dst->result, p_entry->result);
+   }
+   if (p_entry->phase[0])
+   {
+      strcpy(p_dst->phase, p_entry->phase);
+   }
+   if (p_entry->url[0])
+   {
+      strcpy(p_dst->url, p_entry->url);
+   }
+   if (p_entry->fullUrl[0])
+   {
+      strcpy(p_dst->fullUrl, p_entry->fullUrl);
+   }
+}
@@ -0,0 +1,83 @@
+#ifndef JENKIN_JSON_H
+#define JENKIN_JSON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Maximum nested level of json containers that extractor can track
+#define JSON_MAX_DEPTH 32
+
+//----------------------------------------------------------------
+// Information of one job in response of queries:
+//    <job>/api/json?tree=name,color
+//    <job>/lastBuild/api/json?tree=number,timestamp,result
+//    /api/json?tree=jobs[name,color,lastBuild[number,timestamp,result]]
+// and in build notification which is posted by jenkins:
+//    {"name":..., "url":..., "build":{"full_url":..., "number":..., "phase":...,
+//     "status":..., "timestamp":...}}
+//----------------------------------------------------------------
+typedef struct jsonJobEntry
+{
+   char name[256];
+   char color[32];
+   long long timestamp;    // in ms, 0 if job does not have any build
+   long long number;       // of last build, 0 if job does not have any build
+   char result[16];        // "" if job is building or does not have any build
+   char phase[16];         // phase of build notification, "" in other queries
+
+   // Urls are only in build notification, they are kept at end so that
+   // entries of tree response do not clear them as a whole
+   char url[256];          // of job, relative to jenkins root, e.g. "job/folder/job/name/"
+   char fullUrl[512];      // of build, e.g. "http://host:8080/job/folder/job/name/5/"
+}JsonJobEntryT;
+
+typedef void (*JsonJobCallbackT)(void* p_arg, const JsonJobEntryT* p_entry);
+
+//----------------------------------------------------------------
+// Streaming extractor: response is fed chunk by chunk as it arrives from
+// socket, it does not build any tree and does not allocate memory.
+// Callback is called when a job object is closed:
+//    + each object in "jobs" array of root object
+//    + root object itself if it has any field of job
+//----------------------------------------------------------------
+typedef struct jsonExtractor
+{
+   JsonJobCallbackT callback;
+   void* p_arg;
+
+   unsigned char roles[JSON_MAX_DEPTH];   // role of each opening container
+   int   depth;                           // number of opening containers
+   int   skipDepth;                       // > 0 if we are skipping a container
+   bool  isError;
+   bool  isRootClosed;
+
+   // Parse state between two chunks
+   bool  expectKey;
+   bool  isInString;
+   bool  isKeyString;
+   bool  isEscape;
+   int   unicodeLeft;
+   bool  isInToken;
+   int   curKey;
+
+   char* p_strDst;                        // NULL if string is not captured
+   size_t strSize;
+   size_t strLen;
+
+   char  keyBuf[16];
+   size_t keyLen;
+   char  token[32];
+   size_t tokenLen;
+
+   JsonJobEntryT rootEntry;
+   JsonJobEntryT jobEntry;
+}JsonExtractorT;
+
+void jsonExtractorInit(JsonExtractorT* p_ext, JsonJobCallbackT callback, void* p_arg);
+bool jsonExtractorFeed(JsonExtractorT* p_ext, const char* data, size_t len);
+bool jsonExtractorFinish(JsonExtractorT* p_ext);
+
+// Callback to merge fields of job entry to JsonJobEntryT which is pointed by p_arg
+void jsonMergeJobEntry(void* p_arg, const JsonJobEntryT* p_entry);
+
+#endif
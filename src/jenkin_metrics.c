@@ -0,0 +1,377 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
+#include "jenkin_metrics.h"
+
+#define METRICS_REQUEST_SIZE 4096
+
+//----------------------------------------------------------------------------
+// Add to counter, only one thread writes counter at a time
+//----------------------------------------------------------------------------
+void metricsAdd(unsigned long long* p_value, unsigned long long delta)
+{
+   __atomic_store_n(p_value, __atomic_load_n(p_value, __ATOMIC_RELAXED) + delta,
+                    __ATOMIC_RELAXED);
+}
+
+//----------------------------------------------------------------------------
+// Read counter which is written by other thread
+//----------------------------------------------------------------------------
+unsigned long long metricsLoad(const unsigned long long* p_value)
+{
+   return __atomic_load_n(p_value, __ATOMIC_RELAXED);
+}
+
+//----------------------------------------------------------------------------
+// Put one observation to histogram, only one thread writes histogram at a time
+//----------------------------------------------------------------------------
+void metricsObserve(MetricsHistT* p_hist, long long ns)
+{
+   if (ns < 0)
+   {
+      ns = 0;
+   }
+   unsigned int bucket = 0;
+   unsigned long long us = ns / 1000;
+   while (us && (bucket < METRICS_BUCKETS - 1))
+   {
+      us >>= 1;
+      bucket++;
+   }
+   metricsAdd(&p_hist->buckets[bucket], 1);
+   metricsAdd(&p_hist->sumNs, ns);
+}
+
+//----------------------------------------------------------------------------
+// Print HELP and TYPE lines of metric family
+//----------------------------------------------------------------------------
+void metricsPrintFamily(HttpBufferT* p_out, const char* name, const char* type,
+                        const char* help)
+{
+   char line[512];
+   int len = snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n",
+                      name, help, name, type);
+   httpBufferAppend(p_out, line, len);
+}
+
+//----------------------------------------------------------------------------
+// Print label set {name="value"} or {name="value",extra}, backslash, quote and
+// new line of value are escaped
+//----------------------------------------------------------------------------
+static void printLabels(HttpBufferT* p_out, const char* labelName, const char* labelValue,
+                        const char* extra)
+{
+   if (!labelName && !extra)
+   {
+      return;
+   }
+   httpBufferAppend(p_out, "{", 1);
+   if (labelName)
+   {
+      httpBufferAppend(p_out, labelName, strlen(labelName));
+      httpBufferAppend(p_out, "=\"", 2);
+      const char* p_char;
+      for (p_char = labelValue; *p_char; p_char++)
+      {
+         if (*p_char == '\n')
+         {
+            httpBufferAppend(p_out, "\\n", 2);
+            continue;
+         }
+         if ((*p_char == '\\') || (*p_char == '"'))
+         {
+            httpBufferAppend(p_out, "\\", 1);
+         }
+         httpBufferAppend(p_out, p_char, 1);
+      }
+      httpBufferAppend(p_out, "\"", 1);
+   }
+   if (extra)
+   {
+      if (labelName)
+      {
+         httpBufferAppend(p_out, ",", 1);
+      }
+      httpBufferAppend(p_out, extra, strlen(extra));
+   }
+   httpBufferAppend(p_out, "}", 1);
+}
+
+//----------------------------------------------------------------------------
+// Print sample of counter or gauge, label is not printed if labelName is NULL
+//----------------------------------------------------------------------------
+void metricsPrintValue(HttpBufferT* p_out, const char* name, const char* labelName,
+                       const char* labelValue, double value)
+{
+   char str[64];
+   httpBufferAppend(p_out, name, strlen(name));
+   printLabels(p_out, labelName, labelValue, NULL);
+   int len = snprintf(str, sizeof(str), " %.17g\n", value);
+   httpBufferAppend(p_out, str, len);
+}
+
+//----------------------------------------------------------------------------
+// Print histogram in seconds: cumulative buckets, sum and count
+//----------------------------------------------------------------------------
+void metricsPrintHist(HttpBufferT* p_out, const char* name, const char* labelName,
+                      const char* labelValue, const MetricsHistT* p_hist)
+{
+   char str[160];
+   unsigned long long cumulative = 0;
+   unsigned int bucket;
+   for (bucket = 0; bucket < METRICS_BUCKETS; bucket++)
+   {
+      char le[40];
+      cumulative += metricsLoad(&p_hist->buckets[bucket]);
+      if (bucket == METRICS_BUCKETS - 1)
+      {
+         strcpy(le, "le=\"+Inf\"");
+      }
+      else
+      {
+         snprintf(le, sizeof(le), "le=\"%g\"", (double)(1ULL << bucket) / 1e6);
+      }
+      int len = snprintf(str, sizeof(str), "%s_bucket", name);
+      httpBufferAppend(p_out, str, len);
+      printLabels(p_out, labelName, labelValue, le);
+      len = snprintf(str, sizeof(str), " %llu\n", cumulative);
+      httpBufferAppend(p_out, str, len);
+   }
+
+   int len = snprintf(str, sizeof(str), "%s_sum", name);
+   httpBufferAppend(p_out, str, len);
+   printLabels(p_out, labelName, labelValue, NULL);
+   len = snprintf(str, sizeof(str), " %.9f\n",
+                  (double)metricsLoad(&p_hist->sumNs) / 1e9);
+   httpBufferAppend(p_out, str, len);
+
+   // Count is the same as +Inf bucket so that they match in one scrape
+   len = snprintf(str, sizeof(str), "%s_count", name);
+   httpBufferAppend(p_out, str, len);
+   printLabels(p_out, labelName, labelValue, NULL);
+   len = snprintf(str, sizeof(str), " %llu\n", cumulative);
+   httpBufferAppend(p_out, str, len);
+}
+
+//----------------------------------------------------------------------------
+// Print gauges of process: threads, resident memory and cpu time
+//----------------------------------------------------------------------------
+void metricsPrintProcess(HttpBufferT* p_out)
+{
+   long long threadCount = 0;
+   long long rssKb = 0;
+   FILE* p_file = fopen("/proc/self/status", "r");
+   if (p_file)
+   {
+      char line[256];
+      while (fgets(line, sizeof(line), p_file))
+      {
+         sscanf(line, "Threads: %lld", &threadCount);
+         sscanf(line, "VmRSS: %lld", &rssKb);
+      }
+      fclose(p_file);
+   }
+
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+   double cpuSec = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                   (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+   metricsPrintFamily(p_out, "jenkin_threads", "gauge", "Number of threads of process");
+   metricsPrintValue(p_out, "jenkin_threads", NULL, NULL, threadCount);
+   metricsPrintFamily(p_out, "jenkin_resident_memory_bytes", "gauge", "Resident memory size");
+   metricsPrintValue(p_out, "jenkin_resident_memory_bytes", NULL, NULL, rssKb * 1024.0);
+   metricsPrintFamily(p_out, "jenkin_cpu_seconds_total", "counter",
+                      "User and system cpu time of process");
+   metricsPrintValue(p_out, "jenkin_cpu_seconds_total", NULL, NULL, cpuSec);
+}
+
+//----------------------------------------------------------------------------
+// Read request header, wait at most METRICS_RECV_TIMEOUT, waiting is cancelled
+// by metricsStop()
+// return false if header is not received
+//----------------------------------------------------------------------------
+static bool recvHeader(MetricsServerT* p_server, int fd, char* header, size_t size)
+{
+   struct pollfd fds[2];
+   fds[0].fd = fd;
+   fds[0].events = POLLIN;
+   fds[1].fd = p_server->wakeFd;
+   fds[1].events = POLLIN;
+   size_t len = 0;
+   header[0] = 0;
+   while (!strstr(header, "\r\n\r\n"))
+   {
+      if (len == size - 1)
+      {
+         return false;
+      }
+      int ret = poll(fds, 2, METRICS_RECV_TIMEOUT * 1000);
+      if ((ret < 0) && (errno == EINTR))
+      {
+         continue;
+      }
+      if ((ret <= 0) || (fds[1].revents & POLLIN))
+      {
+         return false;
+      }
+      ssize_t n = recv(fd, header + len, size - 1 - len, 0);
+      if ((n < 0) && (errno == EINTR))
+      {
+         continue;
+      }
+      if (n <= 0)
+      {
+         return false;
+      }
+      len += n;
+      header[len] = 0;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Handle one request of client, only GET /metrics is served
+//----------------------------------------------------------------------------
+static void handleRequest(MetricsServerT* p_server, int fd)
+{
+   char header[METRICS_REQUEST_SIZE];
+   if (!recvHeader(p_server, fd, header, sizeof(header)))
+   {
+      return;
+   }
+
+   char response[200];
+   int len;
+   if (strncmp(header, "GET /metrics ", 13) && strncmp(header, "GET /metrics?", 13))
+   {
+      len = snprintf(response, sizeof(response),
+                     "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n"
+                     "Connection: close\r\n\r\n");
+      httpSendAll(fd, response, len);
+      return;
+   }
+
+   httpBufferReset(&p_server->out);
+   p_server->writer(p_server->p_arg, &p_server->out);
+   metricsPrintProcess(&p_server->out);
+   len = snprintf(response, sizeof(response),
+                  "HTTP/1.1 200 OK\r\n"
+                  "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                  "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                  p_server->out.len);
+   if (httpSendAll(fd, response, len))
+   {
+      httpSendAll(fd, p_server->out.p_data, p_server->out.len);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Loop of metrics server thread, it is stopped by metricsStop()
+//----------------------------------------------------------------------------
+static void* metricsLoop(void* arg)
+{
+   MetricsServerT* p_server = (MetricsServerT*)arg;
+   struct pollfd fds[2];
+   fds[0].fd = p_server->listenFd;
+   fds[0].events = POLLIN;
+   fds[1].fd = p_server->wakeFd;
+   fds[1].events = POLLIN;
+
+   while (1)
+   {
+      if ((poll(fds, 2, -1) == -1) && (errno != EINTR))
+      {
+         printf("Can not poll metrics listener: %s\n", strerror(errno));
+         break;
+      }
+      if (fds[1].revents & POLLIN)
+      {
+         break;
+      }
+      if (!(fds[0].revents & POLLIN))
+      {
+         continue;
+      }
+
+      int fd = accept4(p_server->listenFd, NULL, NULL, SOCK_CLOEXEC);
+      if (fd < 0)
+      {
+         continue;
+      }
+      struct timeval tv;
+      tv.tv_sec = METRICS_RECV_TIMEOUT;
+      tv.tv_usec = 0;
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+      handleRequest(p_server, fd);
+      close(fd);
+   }
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Start metrics server thread
+//----------------------------------------------------------------------------
+bool metricsStart(MetricsServerT* p_server, const char* listenAddr,
+                  MetricsWriterT writer, void* p_arg)
+{
+   memset(p_server, 0, sizeof(MetricsServerT));
+   p_server->writer = writer;
+   p_server->p_arg = p_arg;
+   p_server->wakeFd = -1;
+   p_server->listenFd = httpListen(listenAddr);
+   if (p_server->listenFd < 0)
+   {
+      return false;
+   }
+   p_server->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if (p_server->wakeFd < 0)
+   {
+      printf("Can not create eventfd: %s\n", strerror(errno));
+      metricsStop(p_server);
+      return false;
+   }
+   if (pthread_create(&p_server->thread, NULL, metricsLoop, p_server))
+   {
+      printf("Can not create metrics thread\n");
+      metricsStop(p_server);
+      return false;
+   }
+   p_server->isStarted = true;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Stop metrics server thread and close its sockets
+//----------------------------------------------------------------------------
+void metricsStop(MetricsServerT* p_server)
+{
+   if (p_server->isStarted)
+   {
+      uint64_t one = 1;
+      ssize_t ret = write(p_server->wakeFd, &one, sizeof(one));
+      (void)ret;
+      pthread_join(p_server->thread, NULL);
+      p_server->isStarted = false;
+   }
+   if (p_server->wakeFd >= 0)
+   {
+      close(p_server->wakeFd);
+      p_server->wakeFd = -1;
+   }
+   if (p_server->listenFd >= 0)
+   {
+      close(p_server->listenFd);
+      p_server->listenFd = -1;
+   }
+   httpBufferFree(&p_server->out);
+}
@@ -0,0 +1,78 @@
+#ifndef JENKIN_METRICS_H
+#define JENKIN_METRICS_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "jenkin_http.h"
+
+// Histogram bucket N counts observations < 2^N us, last bucket is +Inf
+// (2^(METRICS_BUCKETS - 2) us is about 67 s)
+#define METRICS_BUCKETS 28
+
+// Client which does not send whole request in this time is dropped
+#define METRICS_RECV_TIMEOUT 2  // in second
+
+//----------------------------------------------------------------
+// Latency histogram
+// Each histogram and counter has one writer at a time (the thread which
+// owns the group, server or gpio), so recording is only plain loads and
+// stores without lock or locked instruction. Scraper reads values with
+// atomic loads, so it never sees torn values, but buckets of a histogram
+// may be read in middle of an observation.
+//----------------------------------------------------------------
+typedef struct metricsHist
+{
+   unsigned long long buckets[METRICS_BUCKETS];
+   unsigned long long sumNs;
+}MetricsHistT;
+
+//----------------------------------------------------------------
+// Metrics of polling a group, or a jenkin server in aggregate mode
+//----------------------------------------------------------------
+typedef struct pollMetrics
+{
+   MetricsHistT fetch;              // whole poll: all requests and parsing
+   MetricsHistT parse;              // time in json extractor of a poll
+   unsigned long long requestCount;
+   unsigned long long errorCount;
+   unsigned long long timeoutCount;
+}PollMetricsT;
+
+//----------------------------------------------------------------
+// Writer of all metrics in Prometheus text format, it is called by
+// thread of metrics server for each scrape
+//----------------------------------------------------------------
+typedef void (*MetricsWriterT)(void* p_arg, HttpBufferT* p_out);
+
+//----------------------------------------------------------------
+// Server of metrics endpoint: GET /metrics on [host:]port or unix socket
+// One thread accepts connections and handles one request per connection.
+//----------------------------------------------------------------
+typedef struct metricsServer
+{
+   int listenFd;
+   int wakeFd;                      // eventfd to stop thread
+   pthread_t thread;
+   bool isStarted;
+   MetricsWriterT writer;
+   void* p_arg;
+   HttpBufferT out;
+}MetricsServerT;
+
+void metricsAdd(unsigned long long* p_value, unsigned long long delta);
+void metricsObserve(MetricsHistT* p_hist, long long ns);
+unsigned long long metricsLoad(const unsigned long long* p_value);
+
+void metricsPrintFamily(HttpBufferT* p_out, const char* name, const char* type,
+                        const char* help);
+void metricsPrintValue(HttpBufferT* p_out, const char* name, const char* labelName,
+                       const char* labelValue, double value);
+void metricsPrintHist(HttpBufferT* p_out, const char* name, const char* labelName,
+                      const char* labelValue, const MetricsHistT* p_hist);
+void metricsPrintProcess(HttpBufferT* p_out);
+
+bool metricsStart(MetricsServerT* p_server, const char* listenAddr,
+                  MetricsWriterT writer, void* p_arg);
+void metricsStop(MetricsServerT* p_server);
+
+#endif
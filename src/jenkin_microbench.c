@@ -0,0 +1,721 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include "jenkin_mon.h"
+
+//--------------------------------------------------------------------------------------------------
+// Microbenchmark for helpers of jenkin_mon: color conversion, status decoding
+// of jenkins responses, parsing of xml config and history log
+// jenkin_mon.c is linked without its main() (JENKIN_MON_NO_MAIN)
+//    $make microbench
+//    $./jenkin_microbench [name]          (only benchmarks whose name contains name)
+//
+// Output is one line per benchmark in key=value form, so that results of two
+// builds or two machines can be compared by script:
+//    bench=<name> size=<jobs> ops=<count> ns_op=... allocs_op=... alloc_bytes_op=...
+//    ops_s=... mb_s=...
+// and one line per size of config with heap which is kept by parsed config:
+//    footprint=parseXMLFile size=<jobs> bytes=... bytes_job=...
+// size is number of jobs in input (1 for helpers of one color or one job),
+// mb_s is throughput of input bytes (0 if input is not a text).
+//--------------------------------------------------------------------------------------------------
+
+// Each benchmark runs at least this time, number of ops is doubled until it does
+#define MICRO_MIN_RUN_NS   200000000LL    // 200 ms
+
+// Size of chunk that is fed to json extractor, the same as receive buffer of HttpConnT
+#define MICRO_CHUNK_SIZE   4096
+
+// Jobs per group in generated xml config
+#define MICRO_GROUP_JOBS   100
+#define MICRO_XML_FILE     "/tmp/jenkin_microbench.xml"
+
+// Directory of history log, jobs and groups which records are written for
+#define MICRO_HISTORY_DIR  "/tmp/jenkin_microbench_history"
+#define MICRO_HISTORY_IDS  1000
+
+//----------------------------------------------------------------
+// Count of allocations, malloc family of glibc is wrapped so that
+// allocations of libxml2 are counted too
+//----------------------------------------------------------------
+static unsigned long long s_allocCount = 0;      // atomic
+static unsigned long long s_allocBytes = 0;      // atomic
+
+#if defined(__GLIBC__)
+#define MICRO_HAS_ALLOC_COUNT 1
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+   __atomic_add_fetch(&s_allocCount, 1, __ATOMIC_RELAXED);
+   __atomic_add_fetch(&s_allocBytes, size, __ATOMIC_RELAXED);
+   return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+   __atomic_add_fetch(&s_allocCount, 1, __ATOMIC_RELAXED);
+   __atomic_add_fetch(&s_allocBytes, count * size, __ATOMIC_RELAXED);
+   return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+   __atomic_add_fetch(&s_allocCount, 1, __ATOMIC_RELAXED);
+   __atomic_add_fetch(&s_allocBytes, size, __ATOMIC_RELAXED);
+   return __libc_realloc(ptr, size);
+}
+#else
+#define MICRO_HAS_ALLOC_COUNT 0
+#endif
+
+// Result of benchmarked code is added here so that compiler can not drop it
+static volatile unsigned long long s_sink = 0;
+
+// Only benchmarks whose name contains this string are run
+static const char* s_filter = NULL;
+
+//----------------------------------------------------------------
+// Body of a benchmark: runs opCount operations
+//----------------------------------------------------------------
+typedef void (*MicroBodyT)(void* p_arg, unsigned long long opCount);
+
+//----------------------------------------------------------------------------
+// Get monotonic time in nano second
+//----------------------------------------------------------------------------
+static long long nowNs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------------
+// Run body with doubled number of ops until it takes MICRO_MIN_RUN_NS, then
+// print result of the last run
+// bytesPerOp is size of input of one op, 0 if input is not a text
+//----------------------------------------------------------------------------
+static void runBench(const char* name, unsigned int size, double bytesPerOp,
+                     MicroBodyT body, void* p_arg)
+{
+   if (s_filter && !strstr(name, s_filter))
+   {
+      return;
+   }
+
+   // Warm up caches and branch predictors
+   body(p_arg, 1);
+
+   unsigned long long opCount = 1;
+   long long elapsedNs;
+   unsigned long long allocCount;
+   unsigned long long allocBytes;
+   while (1)
+   {
+      unsigned long long startCount = __atomic_load_n(&s_allocCount, __ATOMIC_RELAXED);
+      unsigned long long startBytes = __atomic_load_n(&s_allocBytes, __ATOMIC_RELAXED);
+      long long startNs = nowNs();
+      body(p_arg, opCount);
+      elapsedNs = nowNs() - startNs;
+      allocCount = __atomic_load_n(&s_allocCount, __ATOMIC_RELAXED) - startCount;
+      allocBytes = __atomic_load_n(&s_allocBytes, __ATOMIC_RELAXED) - startBytes;
+      if (elapsedNs >= MICRO_MIN_RUN_NS)
+      {
+         break;
+      }
+      opCount *= 2;
+   }
+
+   double seconds = elapsedNs / 1e9;
+   printf("bench=%s size=%u ops=%llu ns_op=%.2f allocs_op=%.2f alloc_bytes_op=%.0f "\
+          "ops_s=%.0f mb_s=%.2f\n",
+          name, size, opCount, (double)elapsedNs / opCount, (double)allocCount / opCount,
+          (double)allocBytes / opCount, opCount / seconds, bytesPerOp * opCount / seconds / 1e6);
+}
+
+//================================================================================================//
+//                                       COLOR CONVERSION                                         //
+//================================================================================================//
+
+// Colors in responses of jenkins, unknown color "grey" is converted to noColor
+static const char* s_jobColors[] =
+{
+   "blue", "red", "yellow", "blue_anime", "red_anime", "yellow_anime",
+   "notbuilt", "disabled", "aborted", "aborted_anime", "grey"
+};
+#define MICRO_JOB_COLORS (sizeof(s_jobColors) / sizeof(s_jobColors[0]))
+
+//----------------------------------------------------------------------------
+// Average length of job colors
+//----------------------------------------------------------------------------
+static double jobColorBytes(void)
+{
+   size_t len = 0;
+   unsigned int idx;
+   for (idx = 0; idx < MICRO_JOB_COLORS; idx++)
+   {
+      len += strlen(s_jobColors[idx]);
+   }
+   return (double)len / MICRO_JOB_COLORS;
+}
+
+//----------------------------------------------------------------------------
+// convert2LedInfo() strips "_anime" from its input, so each op copies color
+// to a buffer first as assignJobState() does
+//----------------------------------------------------------------------------
+static void benchConvert2LedInfo(void* p_arg, unsigned long long opCount)
+{
+   char colorStr[32];
+   unsigned long long sum = 0;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      strcpy(colorStr, s_jobColors[op % MICRO_JOB_COLORS]);
+      LedInfoT led = convert2LedInfo(colorStr);
+      sum += led.color + led.isAnime;
+   }
+   s_sink += sum;
+}
+
+//----------------------------------------------------------------------------
+// Color of led rules in config
+//----------------------------------------------------------------------------
+static void benchParseLedInfo(void* p_arg, unsigned long long opCount)
+{
+   unsigned long long sum = 0;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      LedInfoT led;
+      sum += parseLedInfo(s_jobColors[op % MICRO_JOB_COLORS], &led) + led.color;
+   }
+   s_sink += sum;
+}
+
+//----------------------------------------------------------------------------
+// Led status of every color, with and without anime
+//----------------------------------------------------------------------------
+static void benchConvert2ColorStr(void* p_arg, unsigned long long opCount)
+{
+   char colorStr[20];
+   unsigned long long sum = 0;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      LedInfoT led;
+      led.color = (ColorE)((op >> 1) % (NON_COLOR + 1));
+      led.isAnime = op & 1;
+      convert2ColorStr(led, colorStr, sizeof(colorStr));
+      sum += colorStr[0];
+   }
+   s_sink += sum;
+}
+
+//----------------------------------------------------------------------------
+// Every on/off combination of rgb pins
+//----------------------------------------------------------------------------
+static void benchConvertRgb2ColorStr(void* p_arg, unsigned long long opCount)
+{
+   unsigned long long sum = 0;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      unsigned int rgb = op & 7;
+      sum += convertRgb2ColorStr((rgb & 4) ? ON : OF, (rgb & 2) ? ON : OF,
+                                 (rgb & 1) ? ON : OF)[0];
+   }
+   s_sink += sum;
+}
+
+// Results of last build in responses of jenkins, "" is building
+static const char* s_buildResults[] =
+{
+   "SUCCESS", "FAILURE", "UNSTABLE", "NOT_BUILT", "ABORTED", ""
+};
+#define MICRO_BUILD_RESULTS (sizeof(s_buildResults) / sizeof(s_buildResults[0]))
+
+//----------------------------------------------------------------------------
+// Result string of last build
+//----------------------------------------------------------------------------
+static void benchConvert2BuildResult(void* p_arg, unsigned long long opCount)
+{
+   unsigned long long sum = 0;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      sum += convert2BuildResult(s_buildResults[op % MICRO_BUILD_RESULTS]);
+   }
+   s_sink += sum;
+}
+
+//================================================================================================//
+//                                       STATUS DECODING                                          //
+//================================================================================================//
+
+//----------------------------------------------------------------
+// Responses of jenkins and jobs whose state is assigned from them
+//----------------------------------------------------------------
+typedef struct microDecode
+{
+   char* p_status[MICRO_JOB_COLORS];      // <job>/api/json?tree=name,color
+   size_t statusLen[MICRO_JOB_COLORS];
+   char* p_lastBuild[MICRO_BUILD_RESULTS]; // <job>/lastBuild/api/json?tree=timestamp,result
+   size_t lastBuildLen[MICRO_BUILD_RESULTS];
+   char* p_tree;                          // /api/json?tree=jobs[...]
+   size_t treeLen;
+   JobInfoT* p_jobs;
+   unsigned int jobCount;
+}MicroDecodeT;
+
+//----------------------------------------------------------------------------
+// Build responses of one job: status with each color, last build with each
+// result, in the same format as jenkins server
+//----------------------------------------------------------------------------
+static void buildJobPayloads(MicroDecodeT* p_decode)
+{
+   char str[512];
+   unsigned int idx;
+   for (idx = 0; idx < MICRO_JOB_COLORS; idx++)
+   {
+      p_decode->statusLen[idx] =
+         snprintf(str, sizeof(str), "{\"_class\":\"hudson.model.FreeStyleProject\","\
+                  "\"name\":\"project_00042_build_and_test\",\"color\":\"%s\"}",
+                  s_jobColors[idx]);
+      p_decode->p_status[idx] = strdup(str);
+   }
+   for (idx = 0; idx < MICRO_BUILD_RESULTS; idx++)
+   {
+      if (s_buildResults[idx][0])
+      {
+         p_decode->lastBuildLen[idx] =
+            snprintf(str, sizeof(str), "{\"_class\":\"hudson.model.FreeStyleBuild\","\
+                     "\"result\":\"%s\",\"timestamp\":1418372173536}", s_buildResults[idx]);
+      }
+      else
+      {
+         p_decode->lastBuildLen[idx] =
+            snprintf(str, sizeof(str), "{\"_class\":\"hudson.model.FreeStyleBuild\","\
+                     "\"result\":null,\"timestamp\":1418372173536}");
+      }
+      p_decode->p_lastBuild[idx] = strdup(str);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Build response of /api/json?tree=jobs[name,color,lastBuild[timestamp,result]]
+// in the same format as jenkins server
+//----------------------------------------------------------------------------
+static void buildTreePayload(MicroDecodeT* p_decode, unsigned int jobCount)
+{
+   size_t size = 200 + (size_t)jobCount * 300;
+   char* p_payload = malloc(size);
+   size_t len = snprintf(p_payload, size, "{\"_class\":\"hudson.model.Hudson\",\"jobs\":[");
+   unsigned int idx;
+   for (idx = 0; idx < jobCount; idx++)
+   {
+      const char* result = s_buildResults[idx % MICRO_BUILD_RESULTS];
+      len += snprintf(p_payload + len, size - len,
+                      "%s{\"_class\":\"hudson.model.FreeStyleProject\","\
+                      "\"name\":\"project_%05u_build_and_test\",\"color\":\"%s\","\
+                      "\"lastBuild\":{\"_class\":\"hudson.model.FreeStyleBuild\","\
+                      "\"result\":%s%s%s,\"timestamp\":%llu}}",
+                      idx ? "," : "", idx, s_jobColors[idx % MICRO_JOB_COLORS],
+                      result[0] ? "\"" : "", result[0] ? result : "null", result[0] ? "\"" : "",
+                      1418372173536ULL + idx * 1000ULL);
+   }
+   len += snprintf(p_payload + len, size - len, "]}");
+   p_decode->p_tree = p_payload;
+   p_decode->treeLen = len;
+   p_decode->p_jobs = calloc(jobCount, sizeof(JobInfoT));
+   p_decode->jobCount = jobCount;
+}
+
+//----------------------------------------------------------------------------
+// Feed payload to json extractor chunk by chunk as it is received from socket
+//----------------------------------------------------------------------------
+static bool feedPayload(JsonExtractorT* p_extractor, const char* p_payload, size_t len)
+{
+   size_t pos;
+   for (pos = 0; pos < len; pos += MICRO_CHUNK_SIZE)
+   {
+      size_t chunk = (len - pos < MICRO_CHUNK_SIZE) ? len - pos : MICRO_CHUNK_SIZE;
+      if (!jsonExtractorFeed(p_extractor, p_payload + pos, chunk))
+      {
+         return false;
+      }
+   }
+   return jsonExtractorFinish(p_extractor);
+}
+
+//----------------------------------------------------------------------------
+// Decoding of one job as fetchGroupInfo() does: status and last build are
+// merged to one entry, then it is assigned to job
+//----------------------------------------------------------------------------
+static void benchDecodeJob(void* p_arg, unsigned long long opCount)
+{
+   MicroDecodeT* p_decode = p_arg;
+   JobInfoT job;
+   memset(&job, 0, sizeof(job));
+   unsigned long long sum = 0;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      unsigned int statusIdx = op % MICRO_JOB_COLORS;
+      unsigned int lastBuildIdx = op % MICRO_BUILD_RESULTS;
+      JsonJobEntryT entry;
+      JsonExtractorT extractor;
+      memset(&entry, 0, sizeof(entry));
+      jsonExtractorInit(&extractor, jsonMergeJobEntry, &entry);
+      feedPayload(&extractor, p_decode->p_status[statusIdx], p_decode->statusLen[statusIdx]);
+      jsonExtractorInit(&extractor, jsonMergeJobEntry, &entry);
+      feedPayload(&extractor, p_decode->p_lastBuild[lastBuildIdx],
+                  p_decode->lastBuildLen[lastBuildIdx]);
+      sum += assignJobState(&job, &entry);
+   }
+   s_sink += sum;
+}
+
+//----------------------------------------------------------------------------
+// Callback of json extractor: job state is assigned to jobs in order
+//----------------------------------------------------------------------------
+static void assignTreeEntry(void* p_arg, const JsonJobEntryT* p_entry)
+{
+   MicroDecodeT* p_decode = p_arg;
+   JobInfoT* p_job = &p_decode->p_jobs[p_decode->jobCount++];
+   s_sink += assignJobState(p_job, p_entry);
+}
+
+//----------------------------------------------------------------------------
+// Decoding of all jobs of a server in aggregate mode
+//----------------------------------------------------------------------------
+static void benchDecodeTree(void* p_arg, unsigned long long opCount)
+{
+   MicroDecodeT* p_decode = p_arg;
+   unsigned int jobCount = p_decode->jobCount;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      JsonExtractorT extractor;
+      p_decode->jobCount = 0;
+      jsonExtractorInit(&extractor, assignTreeEntry, p_decode);
+      if (!feedPayload(&extractor, p_decode->p_tree, p_decode->treeLen) ||
+          (p_decode->jobCount != jobCount))
+      {
+         printf("Decoded %u/%u jobs\n", p_decode->jobCount, jobCount);
+         exit(1);
+      }
+   }
+}
+
+//================================================================================================//
+//                                        CONFIG PARSING                                          //
+//================================================================================================//
+
+//----------------------------------------------------------------------------
+// Write xml config with jobCount jobs, MICRO_GROUP_JOBS jobs per group
+// return size of file
+//----------------------------------------------------------------------------
+static size_t writeXmlConfig(const char* fileName, unsigned int jobCount)
+{
+   FILE* p_file = fopen(fileName, "w");
+   if (!p_file)
+   {
+      printf("Can not write %s\n", fileName);
+      exit(1);
+   }
+   fprintf(p_file, "<config>\n");
+   unsigned int job = 0;
+   unsigned int group;
+   for (group = 0; job < jobCount; group++)
+   {
+      fprintf(p_file,
+              "   <group>\n"
+              "      <groupname>group_%04u</groupname>\n"
+              "      <server>jenkins%u.example.com:8080</server>\n"
+              "      <username>xxxxxx</username>\n"
+              "      <password>xxxxxx</password>\n"
+              "      <red_led>%u</red_led>\n"
+              "      <green_led>%u</green_led>\n"
+              "      <blue_led>%u</blue_led>\n"
+              "      <display_timeout>30</display_timeout>\n"
+              "      <last_build_threshold>237000</last_build_threshold>\n"
+              "      <rules>\n"
+              "         <success_quorum>90</success_quorum>\n"
+              "         <led_fail>red_anime</led_fail>\n"
+              "      </rules>\n"
+              "      <jobs>\n",
+              group, group % 4, group * 3, group * 3 + 1, group * 3 + 2);
+      unsigned int lastJob = job + MICRO_GROUP_JOBS;
+      for (; (job < jobCount) && (job < lastJob); job++)
+      {
+         fprintf(p_file,
+                 "         <job>\n"
+                 "            <jobpath>/job/</jobpath>\n"
+                 "            <jobname>project_%05u_build_and_test</jobname>\n"
+                 "         </job>\n", job);
+      }
+      fprintf(p_file, "      </jobs>\n   </group>\n");
+   }
+   fprintf(p_file, "</config>\n");
+   fclose(p_file);
+
+   struct stat fileStat;
+   stat(fileName, &fileStat);
+   return fileStat.st_size;
+}
+
+//----------------------------------------------------------------------------
+// Parse config file and free its groups
+//----------------------------------------------------------------------------
+static void benchParseXMLFile(void* p_arg, unsigned long long opCount)
+{
+   const char* fileName = p_arg;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      GroupInfoT* p_headGroup = NULL;
+      if (!parseXMLFile(fileName, &p_headGroup))
+      {
+         printf("Can not parse %s\n", fileName);
+         exit(1);
+      }
+      while (p_headGroup)
+      {
+         GroupInfoT* p_group = p_headGroup;
+         p_headGroup = p_headGroup->p_nextGroup;
+         freeGroupConfig(p_group);
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Print heap which is kept by parsed config of jobCount jobs, including
+// overhead of malloc
+//----------------------------------------------------------------------------
+static void printConfigFootprint(const char* fileName, unsigned int jobCount)
+{
+#if defined(__GLIBC__)
+   size_t startBytes = mallinfo2().uordblks;
+   GroupInfoT* p_headGroup = NULL;
+   if (!parseXMLFile(fileName, &p_headGroup))
+   {
+      printf("Can not parse %s\n", fileName);
+      exit(1);
+   }
+   size_t bytes = mallinfo2().uordblks - startBytes;
+   printf("footprint=parseXMLFile size=%u bytes=%zu bytes_job=%.1f\n",
+          jobCount, bytes, (double)bytes / jobCount);
+   while (p_headGroup)
+   {
+      GroupInfoT* p_group = p_headGroup;
+      p_headGroup = p_headGroup->p_nextGroup;
+      freeGroupConfig(p_group);
+   }
+#endif
+}
+
+//================================================================================================//
+//                                         HISTORY LOG                                            //
+//================================================================================================//
+
+//----------------------------------------------------------------------------
+// Remove files of history log and its directory
+//----------------------------------------------------------------------------
+static void removeHistoryDir(const char* dir)
+{
+   DIR* p_dir = opendir(dir);
+   if (!p_dir)
+   {
+      return;
+   }
+   struct dirent* p_ent;
+   while ((p_ent = readdir(p_dir)) != NULL)
+   {
+      if (p_ent->d_name[0] != '.')
+      {
+         char path[512];
+         snprintf(path, sizeof(path), "%s/%s", dir, p_ent->d_name);
+         unlink(path);
+      }
+   }
+   closedir(p_dir);
+   rmdir(dir);
+}
+
+//----------------------------------------------------------------------------
+// Append opCount job transitions to history log, one write() each
+//----------------------------------------------------------------------------
+static void benchHistoryAppend(void* p_arg, unsigned long long opCount)
+{
+   HistoryLogT* p_log = p_arg;
+   HistoryRecordT record;
+   memset(&record, 0, sizeof(record));
+   record.kind = HISTORY_JOB;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      record.id = 1 + op % MICRO_HISTORY_IDS;
+      record.buildNumber = op;
+      record.color = op % NON_COLOR;
+      if (!historyAppend(p_log, &record))
+      {
+         printf("Can not append to %s\n", MICRO_HISTORY_DIR);
+         exit(1);
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Count records of one job
+//----------------------------------------------------------------------------
+static bool countHistoryRecord(void* p_arg, const HistoryRecordT* p_record)
+{
+   unsigned long long* p_count = p_arg;
+   *p_count += (p_record->id == 1);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Scan all mapped records of history log, as summary of jenkin_hist does
+//----------------------------------------------------------------------------
+static void benchHistoryScan(void* p_arg, unsigned long long opCount)
+{
+   const HistoryReaderT* p_reader = p_arg;
+   unsigned long long op;
+   for (op = 0; op < opCount; op++)
+   {
+      unsigned long long count = 0;
+      historyScan(p_reader, INT64_MIN, INT64_MAX, countHistoryRecord, &count);
+      s_sink += count;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Write history log of recordCount records and benchmark scan of it
+//----------------------------------------------------------------------------
+static void runHistoryScan(unsigned int recordCount)
+{
+   if (s_filter && !strstr("historyScan", s_filter))
+   {
+      return;
+   }
+   removeHistoryDir(MICRO_HISTORY_DIR);
+   HistoryLogT log;
+   if (!historyOpen(&log, MICRO_HISTORY_DIR))
+   {
+      exit(1);
+   }
+   benchHistoryAppend(&log, recordCount);
+   historyClose(&log);
+
+   HistoryReaderT reader;
+   if (!historyReaderOpen(&reader, MICRO_HISTORY_DIR))
+   {
+      exit(1);
+   }
+   runBench("historyScan", recordCount, (double)reader.recordCount * sizeof(HistoryRecordT),
+            benchHistoryScan, &reader);
+   historyReaderClose(&reader);
+   removeHistoryDir(MICRO_HISTORY_DIR);
+}
+
+//----------------------------------------------------------------------------
+// Main function
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+   s_filter = (argc > 1) ? argv[1] : NULL;
+   setvbuf(stdout, NULL, _IOLBF, 0);
+
+   struct utsname name;
+   uname(&name);
+   printf("machine=%s kernel=%s compiler=gcc-%d.%d.%d json=%s alloc_count=%s\n",
+          name.machine, name.release, __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__,
+#if defined(JSON_NO_SIMD)
+          "scalar",
+#else
+          "simd",
+#endif
+          MICRO_HAS_ALLOC_COUNT ? "yes" : "no");
+
+   runBench("convert2LedInfo", 1, jobColorBytes(), benchConvert2LedInfo, NULL);
+   runBench("parseLedInfo", 1, jobColorBytes(), benchParseLedInfo, NULL);
+   runBench("convert2ColorStr", 1, 0, benchConvert2ColorStr, NULL);
+   runBench("convertRgb2ColorStr", 1, 0, benchConvertRgb2ColorStr, NULL);
+   runBench("convert2BuildResult", 1, 0, benchConvert2BuildResult, NULL);
+
+   // Replacement of colorFromFile() and timeStampFromFile(): responses are
+   // decoded from memory instead of being read back from files
+   MicroDecodeT decode;
+   memset(&decode, 0, sizeof(decode));
+   buildJobPayloads(&decode);
+   double jobBytes = 0;
+   unsigned int idx;
+   for (idx = 0; idx < MICRO_JOB_COLORS; idx++)
+   {
+      jobBytes += (double)decode.statusLen[idx] / MICRO_JOB_COLORS;
+   }
+   for (idx = 0; idx < MICRO_BUILD_RESULTS; idx++)
+   {
+      jobBytes += (double)decode.lastBuildLen[idx] / MICRO_BUILD_RESULTS;
+   }
+   runBench("decodeJob", 1, jobBytes, benchDecodeJob, &decode);
+
+   unsigned int jobCounts[] = {10, 100, 1000, 10000, 100000};
+   for (idx = 0; idx < sizeof(jobCounts) / sizeof(jobCounts[0]); idx++)
+   {
+      buildTreePayload(&decode, jobCounts[idx]);
+      runBench("decodeTree", jobCounts[idx], decode.treeLen, benchDecodeTree, &decode);
+      free(decode.p_tree);
+      free(decode.p_jobs);
+   }
+
+   for (idx = 0; idx < sizeof(jobCounts) / sizeof(jobCounts[0]); idx++)
+   {
+      if (s_filter && !strstr("parseXMLFile", s_filter))
+      {
+         break;
+      }
+      size_t fileSize = writeXmlConfig(MICRO_XML_FILE, jobCounts[idx]);
+      runBench("parseXMLFile", jobCounts[idx], fileSize, benchParseXMLFile, MICRO_XML_FILE);
+      printConfigFootprint(MICRO_XML_FILE, jobCounts[idx]);
+   }
+   remove(MICRO_XML_FILE);
+
+   removeHistoryDir(MICRO_HISTORY_DIR);
+   HistoryLogT log;
+   if (!historyOpen(&log, MICRO_HISTORY_DIR))
+   {
+      exit(1);
+   }
+   runBench("historyAppend", 1, sizeof(HistoryRecordT), benchHistoryAppend, &log);
+   historyClose(&log);
+   unsigned int recordCounts[] = {10000, 1000000};
+   for (idx = 0; idx < sizeof(recordCounts) / sizeof(recordCounts[0]); idx++)
+   {
+      runHistoryScan(recordCounts[idx]);
+   }
+   removeHistoryDir(MICRO_HISTORY_DIR);
+
+   for (idx = 0; idx < MICRO_JOB_COLORS; idx++)
+   {
+      free(decode.p_status[idx]);
+   }
+   for (idx = 0; idx < MICRO_BUILD_RESULTS; idx++)
+   {
+      free(decode.p_lastBuild[idx]);
+   }
+   return 0;
+}
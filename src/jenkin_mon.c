@@ -9,9 +9,10 @@
 #include <string.h>
 #include <time.h>
 #include <stdbool.h>
+#include <limits.h>
+#include <ctype.h>
+#include <strings.h>
 #include "jenkin_mon.h"
-#include <dirent.h>   // For opendir() and closedir()
-#include <sys/stat.h> // For stat() and mkdir()
 #include <getopt.h>   // For getopt_long
 
 //--------------------------------------------------------------------------------------------------
@@ -65,7 +66,35 @@
 //    + Feature: design USB to GIPI module to control multiple jenkins led status
 
 // Option to use authorized account to get info from jenkin server or not
-#define USE_ANY_AUTHORIZED_IN_CURL 1
+#define USE_ANY_AUTHORIZED_IN_HTTP 1
+
+// Default poll policy of group, can be changed in xml file by
+// <poll_building>, <poll_idle>, <poll_max_idle> (in second)
+#define DEFAULT_POLL_BUILDING_TIME 2
+#define DEFAULT_POLL_IDLE_TIME     3
+#define DEFAULT_POLL_MAX_IDLE_TIME 60
+
+// When build notifications are received or JENKINS_HOME is watched, jobs are
+// still polled at this interval (in second) in case an event is lost (e.g.
+// inotify does not see files which are written by other host of NFS)
+#define HOOK_SAFETY_POLL_TIME      300
+
+//----------------------------------------------------------------
+// Color string and rgb gpio status of each color
+//----------------------------------------------------------------
+Color2LedInfoT C2LInfo[] =
+{
+   {NO_BUILT , "notbuilt", OF, OF, OF},
+   {DISABLED , "disabled", OF, OF, OF},
+   {RED_COLOR, "red"     , ON, OF, OF},
+   {GRE_COLOR, "green"   , OF, ON, OF},
+   {BLU_COLOR, "blue"    , OF, OF, ON},
+   {YEL_COLOR, "yellow"  , ON, ON, OF},
+   {CYA_COLOR, "cyan"    , OF, ON, ON},
+   {MAG_COLOR, "magenta" , ON, OF, ON},
+   {WHI_COLOR, "white"   , ON, ON, ON},
+   {NON_COLOR, "noColor" , OF, OF, OF}
+};
 
 //----------------------------------------------------------------
 // Global variable
@@ -78,22 +107,106 @@ bool g_isVerbose = false;
 // Option to control led
 const u_int8 g_ledAnimeTime = 1; // in second
 bool g_isCtrlRealLed = false;    // Defaut -> do not control real GPIO led
+char* g_gpioBackend = "sysfs";  // sysfs, chardev or mock
+char* g_gpioDev = NULL;          // NULL -> default device of gpio backend
+unsigned int g_pwmHz = 0;        // 0 -> leds are only on or off, no software pwm
+unsigned int g_ledLevel = PWM_MAX_LEVEL; // brightness of led which is on (pwm)
+unsigned int g_fadeMs = 300;     // led fades to new color in this time (pwm)
 
 // Option to deamonize
 bool g_isDaemon = false;
 
-/* Termination flag */
+// Option to get information of all jobs from each jenkin server by one query
+bool g_isAggregate = false;
+
+// Option to set number of workers that fetch and evaluate groups
+unsigned int g_workerCount = 0;  // 0 -> one worker per core
+
+// Option to listen for build notifications of jenkins, [host:]port
+char* g_hookAddr = NULL;         // NULL -> only poll jenkins
+char* g_hookToken = NULL;        // NULL -> notifications are not checked
+
+// Option to read jobs from JENKINS_HOME on disk instead of jenkins api
+char* g_homeDir = NULL;          // NULL -> get jobs through http
+
+// Option to append transitions of jobs and groups to history log
+char* g_historyDir = NULL;       // NULL -> no history
+
+// Option to serve metrics in Prometheus text format, [host:]port or unix socket
+char* g_metricsAddr = NULL;      // NULL -> no metrics endpoint
+
+/* Termination flag, it is only accessed atomically so that signal handler
+ * can set it without any lock */
 static bool g_terminateAll = false;
-static pthread_mutex_t g_terminateLock;
+
+// Thread to control led of all groups, it sleeps on scheduler until next
+// tick of an animated led or until led status of a group is changed
+static pthread_t g_ctrlLedThread;
+static SchedulerT g_ledSched = SCHED_INITIALIZER;
+
+// Workers that fetch and evaluate groups, fetch tasks are submitted by main
+// thread when poll timer of group (or server in aggregate mode) is expired.
+// Fetch task does not wait for network: when socket of its request is not
+// ready, main thread watches the socket and submits the task again.
+static PoolT g_pool;
+static SchedulerT g_pollSched = SCHED_INITIALIZER;
+
+// Groups whose led status is changed, taken by led thread
+static GroupInfoT* g_changedLedGroups = NULL;   // atomic
+
+// Listener of build notifications and index to find their jobs
+static HookServerT g_hook;
+static JobIndexT g_jobIndex;
+static pthread_mutex_t g_jobIndexLock = PTHREAD_MUTEX_INITIALIZER;   // index and hooked jobs
+
+// Watcher of job files in JENKINS_HOME, it finds jobs by the same index
+static HomeWatcherT g_home;
+
+// History log of job and group transitions, written by any thread which
+// changes them while lockJobSta of their group is held
+static HistoryLogT g_history;
+
+// Health of jenkins servers by server name, breakers are kept until exit
+static BreakerT* g_breakers = NULL;
+
+// Metrics endpoint, it reads groups and servers while g_jobIndexLock is held
+static MetricsServerT g_metrics;
+static MetricsSourceT g_metricsSource;
+
+// Config is reloaded by main thread on SIGHUP, led thread is parked meanwhile
+static bool g_isReloadRequested = false;           // atomic
+static pthread_mutex_t g_ledPauseLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_ledPauseCond = PTHREAD_COND_INITIALIZER;
+static bool g_isLedPauseRequested = false;
+static bool g_isLedPaused = false;
+static bool g_isLedThreadStarted = false;
+
+//----------------------------------------------------------------------------
+// Check that all threads are requested to terminate
+//----------------------------------------------------------------------------
+static inline bool isTerminated(void)
+{
+   return __atomic_load_n(&g_terminateAll, __ATOMIC_SEQ_CST);
+}
 
 //----------------------------------------------------------------------------
 // Handle for SIGINT and SIGTERM
+// Note: only async-signal-safe operations here (atomic store, write eventfd)
 //----------------------------------------------------------------------------
 static void sig_term(int isig)
 {
-   pthread_mutex_lock(&g_terminateLock);
-   g_terminateAll = true;
-   pthread_mutex_unlock(&g_terminateLock);
+   __atomic_store_n(&g_terminateAll, true, __ATOMIC_SEQ_CST);
+   schedWake(&g_ledSched);
+   schedWake(&g_pollSched);
+}
+
+//----------------------------------------------------------------------------
+// Handle for SIGHUP: config is reloaded by main thread
+//----------------------------------------------------------------------------
+static void sig_hup(int isig)
+{
+   __atomic_store_n(&g_isReloadRequested, true, __ATOMIC_SEQ_CST);
+   schedWake(&g_pollSched);
 }
 
 //----------------------------------------------------------------------------
@@ -113,9 +226,9 @@ static void sig_chld(int sig)
 //----------------------------------------------------------------------------
 static void exitNow()
 {
-   pthread_mutex_lock(&g_terminateLock);
-   g_terminateAll = true;
-   pthread_mutex_unlock(&g_terminateLock);
+   __atomic_store_n(&g_terminateAll, true, __ATOMIC_SEQ_CST);
+   schedWake(&g_ledSched);
+   schedWake(&g_pollSched);
 }
 
 //----------------------------------------------------------------------------
@@ -158,20 +271,16 @@ void printJobInfo(JobInfoT* p_job)
    if (p_job)
    {
       printf("job name: %s\n"\
-             "job path: %s\n"\
-             "status file: %s\n"\
-             "last status file: %s\n",\
+             "job path: %s\n",\
              p_job->jobName,
-             p_job->jobPath,
-             p_job->statusInfoFile,
-             p_job->lastBuildInfoFile);
+             p_job->jobPath);
    }
 }
 
 //----------------------------------------------------------------------------
 // Parsing Information of job (job attribute) in xml file to a JobInfoT data structure
 //----------------------------------------------------------------------------
-bool parseJobAttr(xmlDoc *doc, xmlNode *jobNode, JobInfoT* p_job)
+bool parseJobAttr(xmlDoc *doc, xmlNode *jobNode, ArenaT* p_arena, JobInfoT* p_job)
 {
    if (jobNode->children == NULL)
    {
@@ -190,13 +299,11 @@ bool parseJobAttr(xmlDoc *doc, xmlNode *jobNode, JobInfoT* p_job)
             xmlChar* key = xmlNodeListGetString(doc, jobAttrNode->xmlChildrenNode, 1);
             if (!strcmp(jobAttrNode->name, "jobpath"))
             {
-               p_job->jobPath = malloc((strlen(key) + 1) * sizeof(char));
-               strcpy(p_job->jobPath, key);
+               p_job->jobPath = arenaIntern(p_arena, key);
             }
             else if (!strcmp(jobAttrNode->name, "jobname"))
             {
-               p_job->jobName = malloc((strlen(key) + 1) * sizeof(char));
-               strcpy(p_job->jobName, key);
+               p_job->jobName = arenaIntern(p_arena, key);
             }
             xmlFree(key);
          }
@@ -216,8 +323,10 @@ bool parseJobAttr(xmlDoc *doc, xmlNode *jobNode, JobInfoT* p_job)
 
 //----------------------------------------------------------------------------
 // Parsing Information of jobs in xml file to group data structure
+// Jobs are allocated from arena one after another, they live as long as
+// their group holds reference of arena
 //----------------------------------------------------------------------------
-bool parseJobsInfo(xmlDoc *doc, xmlNode *jobsNode, JobInfoT** p_headJob)
+bool parseJobsInfo(xmlDoc *doc, xmlNode *jobsNode, ArenaT* p_arena, JobInfoT** p_headJob)
 {
    xmlNode* jobNode = NULL;
    if (!jobsNode->children)
@@ -225,35 +334,22 @@ bool parseJobsInfo(xmlDoc *doc, xmlNode *jobsNode, JobInfoT** p_headJob)
       printf("Don't have any job in group\n");
       return false;
    }
-   JobInfoT* p_curJob = NULL;
+   JobInfoT** pp_tailJob = p_headJob;
    for (jobNode = jobsNode->children; jobNode; jobNode = jobNode->next)
    {
       if (jobNode->type == XML_ELEMENT_NODE)
       {
          if (!strcmp(jobNode->name, "job"))
          {
-            JobInfoT jobInfoTemp;
-            memset(&jobInfoTemp, 0, sizeof(JobInfoT));
-            if (parseJobAttr(doc, jobNode, &jobInfoTemp))
+            JobInfoT* p_job = arenaAlloc(p_arena, sizeof(JobInfoT));
+            if (!p_job)
             {
-               if (!p_curJob)
-               {
-                  // First time -> head job = NULL
-                  // Allocate memory for head job
-                  p_curJob = malloc(sizeof(JobInfoT));
-                  memset(p_curJob, 0, sizeof(JobInfoT));
-                  *p_headJob = p_curJob;
-               }
-               else
-               {
-                  // Allocate memory for next job
-                  p_curJob->p_nextJob = malloc(sizeof(JobInfoT));
-                  p_curJob = p_curJob->p_nextJob;
-               }
-
-               // Get all job data to current job
-               *p_curJob = jobInfoTemp;
-               p_curJob->p_nextJob = NULL;
+               return false;
+            }
+            if (parseJobAttr(doc, jobNode, p_arena, p_job))
+            {
+               *pp_tailJob = p_job;
+               pp_tailJob = &p_job->p_nextJob;
             }
             else
             {
@@ -282,6 +378,7 @@ bool parseGroupAttr(xmlDoc *doc, xmlNode *groupNode, GroupInfoT* p_group)
       printf("Don't have any group attribute in this group in XML file\n");
       return false;
    }
+   setDefaultGroupRule(p_group);
    xmlNode* groupAttrNode = NULL;
    for (groupAttrNode = groupNode->children; groupAttrNode;
         groupAttrNode = groupAttrNode->next)
@@ -295,29 +392,31 @@ bool parseGroupAttr(xmlDoc *doc, xmlNode *groupNode, GroupInfoT* p_group)
              (!strcmp(groupAttrNode->name, "red_led")) ||
              (!strcmp(groupAttrNode->name, "green_led")) ||
              (!strcmp(groupAttrNode->name, "blue_led")) ||
+             (!strcmp(groupAttrNode->name, "red_led_name")) ||
+             (!strcmp(groupAttrNode->name, "green_led_name")) ||
+             (!strcmp(groupAttrNode->name, "blue_led_name")) ||
+             (!strcmp(groupAttrNode->name, "poll_building")) ||
+             (!strcmp(groupAttrNode->name, "poll_idle")) ||
+             (!strcmp(groupAttrNode->name, "poll_max_idle")) ||
              (!strcmp(groupAttrNode->name, "display_timeout")) ||
              (!strcmp(groupAttrNode->name, "last_build_threshold")))
          {
             xmlChar* key = xmlNodeListGetString(doc, groupAttrNode->xmlChildrenNode, 1);
             if (!strcmp(groupAttrNode->name, "groupname"))
             {
-               p_group->groupName = malloc((strlen(key) + 1) * sizeof(char));
-               strcpy(p_group->groupName, key);
+               p_group->groupName = arenaIntern(p_group->p_arena, key);
             }
             else if (!strcmp(groupAttrNode->name, "server"))
             {
-               p_group->server.serverName = malloc((strlen(key) + 1) * sizeof(char));
-               strcpy(p_group->server.serverName, key);
+               p_group->server.serverName = arenaIntern(p_group->p_arena, key);
             }
             else if (!strcmp(groupAttrNode->name, "username"))
             {
-               p_group->server.userName = malloc((strlen(key) + 1) * sizeof(char));
-               strcpy(p_group->server.userName, key);
+               p_group->server.userName = arenaIntern(p_group->p_arena, key);
             }
             else if (!strcmp(groupAttrNode->name, "password"))
             {
-               p_group->server.passWord = malloc((strlen(key) + 1) * sizeof(char));
-               strcpy(p_group->server.passWord, key);
+               p_group->server.passWord = arenaIntern(p_group->p_arena, key);
             }
             else if (!strcmp(groupAttrNode->name, "red_led"))
             {
@@ -332,6 +431,30 @@ bool parseGroupAttr(xmlDoc *doc, xmlNode *groupNode, GroupInfoT* p_group)
             {
                p_group->gpio.bluLed = atoi(key);
             }
+            else if (!strcmp(groupAttrNode->name, "red_led_name"))
+            {
+               p_group->gpio.redLedName = arenaIntern(p_group->p_arena, key);
+            }
+            else if (!strcmp(groupAttrNode->name, "green_led_name"))
+            {
+               p_group->gpio.greLedName = arenaIntern(p_group->p_arena, key);
+            }
+            else if (!strcmp(groupAttrNode->name, "blue_led_name"))
+            {
+               p_group->gpio.bluLedName = arenaIntern(p_group->p_arena, key);
+            }
+            else if (!strcmp(groupAttrNode->name, "poll_building"))
+            {
+               p_group->pollPolicy.buildingTime = atoi(key);
+            }
+            else if (!strcmp(groupAttrNode->name, "poll_idle"))
+            {
+               p_group->pollPolicy.idleTime = atoi(key);
+            }
+            else if (!strcmp(groupAttrNode->name, "poll_max_idle"))
+            {
+               p_group->pollPolicy.maxIdleTime = atoi(key);
+            }
             else if (!strcmp(groupAttrNode->name, "display_timeout"))
             {
                p_group->displaySuccessTimeout = atoi(key);
@@ -344,12 +467,20 @@ bool parseGroupAttr(xmlDoc *doc, xmlNode *groupNode, GroupInfoT* p_group)
          }
          else if (!strcmp(groupAttrNode->name, "jobs"))
          {
-            if(!parseJobsInfo(doc, groupAttrNode, &p_group->p_allJobs))
+            if(!parseJobsInfo(doc, groupAttrNode, p_group->p_arena, &p_group->p_allJobs))
             {
                printf("Can not parse JobsInfo\n");
                return false;
             }
          }
+         else if (!strcmp(groupAttrNode->name, "rules"))
+         {
+            if (!parseGroupRule(doc, groupAttrNode, p_group))
+            {
+               printf("Can not parse rules\n");
+               return false;
+            }
+         }
          else
          {
             printf("Wrong group attribute: %s\n",groupAttrNode->name);
@@ -364,16 +495,253 @@ bool parseGroupAttr(xmlDoc *doc, xmlNode *groupNode, GroupInfoT* p_group)
    return true;
 }
 
+//----------------------------------------------------------------------------
+// Default rules: group is success if all its jobs are blue, building or
+// threshold if one job is
+//----------------------------------------------------------------------------
+void setDefaultGroupRule(GroupInfoT* p_group)
+{
+   p_group->rule.successColors = COLOR_BIT(BLU_COLOR);
+   p_group->rule.disableColors = COLOR_BIT(NO_BUILT) | COLOR_BIT(DISABLED);
+   p_group->rule.successQuorum = 100;
+   p_group->rule.buildingQuorum = 0;
+   p_group->rule.thresholdQuorum = 0;
+
+   // Channel which is on in color table is fully on
+   u_int32 color;
+   for (color = 0; color <= NON_COLOR; color++)
+   {
+      p_group->rule.colorLevels[color].r = (C2LInfo[color].r == ON) ? 100 : 0;
+      p_group->rule.colorLevels[color].g = (C2LInfo[color].g == ON) ? 100 : 0;
+      p_group->rule.colorLevels[color].b = (C2LInfo[color].b == ON) ? 100 : 0;
+   }
+
+   p_group->stdLed.disable.color = NON_COLOR ;
+   p_group->stdLed.disable.isAnime = false ;
+
+   p_group->stdLed.building.color = YEL_COLOR;
+   p_group->stdLed.building.isAnime = true;
+
+   p_group->stdLed.threshold.color = YEL_COLOR;
+   p_group->stdLed.threshold.isAnime = false ;
+
+   p_group->stdLed.success.color = BLU_COLOR;
+   p_group->stdLed.success.isAnime = false ;
+
+   p_group->stdLed.successNotShow.color = NON_COLOR;
+   p_group->stdLed.successNotShow.isAnime = false ;
+
+   p_group->stdLed.fail.color = RED_COLOR;
+   p_group->stdLed.fail.isAnime = true;
+
+   p_group->stdLed.unreachable.color = CYA_COLOR;
+   p_group->stdLed.unreachable.isAnime = false;
+}
+
+//----------------------------------------------------------------------------
+// Parsing rules of group in xml file, rule which is not given keeps its
+// default value
+//    <rules>
+//       <success_color>blue</success_color>     (can be repeated)
+//       <disable_color>disabled</disable_color> (can be repeated)
+//       <success_quorum>90</success_quorum>     (percent of counted jobs)
+//       <building_quorum>0</building_quorum>    (0 -> at least one job)
+//       <threshold_quorum>0</threshold_quorum>
+//       <led_disable>noColor</led_disable>
+//       <led_building>yellow_anime</led_building>
+//       <led_threshold>yellow</led_threshold>
+//       <led_success>blue</led_success>
+//       <led_success_timeout>noColor</led_success_timeout>
+//       <led_fail>red_anime</led_fail>
+//       <led_unreachable>cyan</led_unreachable>   (server does not answer)
+//       <color_level>yellow 100 60 0</color_level> (can be repeated, red green
+//                                                   blue in percent, pwm only)
+//    </rules>
+//----------------------------------------------------------------------------
+bool parseGroupRule(xmlDoc *doc, xmlNode *rulesNode, GroupInfoT* p_group)
+{
+   struct
+   {
+      const char* name;
+      LedInfoT* p_led;
+   } ledRules[] =
+   {
+      {"led_disable",         &p_group->stdLed.disable},
+      {"led_building",        &p_group->stdLed.building},
+      {"led_threshold",       &p_group->stdLed.threshold},
+      {"led_success",         &p_group->stdLed.success},
+      {"led_success_timeout", &p_group->stdLed.successNotShow},
+      {"led_fail",            &p_group->stdLed.fail},
+      {"led_unreachable",     &p_group->stdLed.unreachable},
+      {NULL,                  NULL}
+   };
+   bool isSuccessColorSet = false;
+   bool isDisableColorSet = false;
+
+   xmlNode* ruleNode = NULL;
+   for (ruleNode = rulesNode->children; ruleNode; ruleNode = ruleNode->next)
+   {
+      if (ruleNode->type != XML_ELEMENT_NODE)
+      {
+         continue;
+      }
+      xmlChar* key = xmlNodeListGetString(doc, ruleNode->xmlChildrenNode, 1);
+      const char* value = key ? (const char*)key : "";
+      bool isOk = true;
+      u_int32 idx;
+      for (idx = 0; ledRules[idx].name && strcmp(ruleNode->name, ledRules[idx].name); idx++);
+
+      if (ledRules[idx].name)
+      {
+         isOk = parseLedInfo(value, ledRules[idx].p_led);
+      }
+      else if (!strcmp(ruleNode->name, "success_color") ||
+               !strcmp(ruleNode->name, "disable_color"))
+      {
+         // First color of list replaces default colors
+         bool isSuccess = !strcmp(ruleNode->name, "success_color");
+         u_int16* p_colors = isSuccess ? &p_group->rule.successColors :
+                                         &p_group->rule.disableColors;
+         bool* p_isSet = isSuccess ? &isSuccessColorSet : &isDisableColorSet;
+         if (!*p_isSet)
+         {
+            *p_colors = 0;
+            *p_isSet = true;
+         }
+         LedInfoT led;
+         isOk = parseLedInfo(value, &led) && !led.isAnime;
+         if (isOk)
+         {
+            *p_colors |= COLOR_BIT(led.color);
+         }
+      }
+      else if (!strcmp(ruleNode->name, "color_level"))
+      {
+         char colorStr[20];
+         u_int32 r, g, b;
+         LedInfoT led;
+         isOk = (sscanf(value, "%19s %u %u %u", colorStr, &r, &g, &b) == 4) &&
+                parseLedInfo(colorStr, &led) && !led.isAnime &&
+                (r <= 100) && (g <= 100) && (b <= 100);
+         if (isOk)
+         {
+            p_group->rule.colorLevels[led.color].r = r;
+            p_group->rule.colorLevels[led.color].g = g;
+            p_group->rule.colorLevels[led.color].b = b;
+         }
+      }
+      else if (!strcmp(ruleNode->name, "success_quorum") ||
+               !strcmp(ruleNode->name, "building_quorum") ||
+               !strcmp(ruleNode->name, "threshold_quorum"))
+      {
+         int quorum = atoi(value);
+         isOk = (quorum >= 0) && (quorum <= 100);
+         if (!strcmp(ruleNode->name, "success_quorum"))
+         {
+            p_group->rule.successQuorum = quorum;
+         }
+         else if (!strcmp(ruleNode->name, "building_quorum"))
+         {
+            p_group->rule.buildingQuorum = quorum;
+         }
+         else
+         {
+            p_group->rule.thresholdQuorum = quorum;
+         }
+      }
+      else
+      {
+         printf("Wrong rule: %s\n", ruleNode->name);
+         isOk = false;
+      }
+
+      if (!isOk)
+      {
+         printf("Wrong value of rule %s: %s\n", ruleNode->name, value);
+      }
+      xmlFree(key);
+      if (!isOk)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Compile led of each group status into table which is indexed by packed
+// group status, so that evaluation is one table read
+// Priority: unreachable, disable, building, threshold, success timeout,
+// success, fail
+//----------------------------------------------------------------------------
+void compileGroupRule(GroupInfoT* p_group)
+{
+   u_int32 status;
+   for (status = 0; status < GROUP_STA_COUNT; status++)
+   {
+      LedInfoT* p_led = &p_group->ledTable[status];
+      if (status & GROUP_STA_UNREACHABLE)
+      {
+         *p_led = p_group->stdLed.unreachable;
+      }
+      else if (status & GROUP_STA_ALL_DISABLE)
+      {
+         *p_led = p_group->stdLed.disable;
+      }
+      else if (status & GROUP_STA_BUILDING)
+      {
+         *p_led = p_group->stdLed.building;
+      }
+      else if (!(status & GROUP_STA_SUCCESS))
+      {
+         *p_led = p_group->stdLed.fail;
+      }
+      else if (status & GROUP_STA_THRESHOLD)
+      {
+         *p_led = p_group->stdLed.threshold;
+      }
+      else if (status & GROUP_STA_SUCCESS_TIMEOUT)
+      {
+         *p_led = p_group->stdLed.successNotShow;
+      }
+      else
+      {
+         *p_led = p_group->stdLed.success;
+      }
+   }
+}
+
 //----------------------------------------------------------------------------
 // Init led
 //----------------------------------------------------------------------------
-void initAllGroupLed(GroupInfoT* p_headGroup)
+bool initAllGroupLed(GroupInfoT* p_headGroup)
 {
+   if (!g_isCtrlRealLed)
+   {
+      return true;
+   }
+   if (!gpioInit(g_gpioBackend, g_gpioDev, g_ledAnimeTime * 1000))
+   {
+      return false;
+   }
+
+   // Request all led pins and set them as output, led is turned off
    GroupInfoT* p_group = NULL;
    for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
    {
-      // TODO: need to init gpio in this function instead of using bashscript
+      if (!gpioRequestPin(p_group->gpio.redLed, p_group->gpio.redLedName) ||
+          !gpioRequestPin(p_group->gpio.greLed, p_group->gpio.greLedName) ||
+          !gpioRequestPin(p_group->gpio.bluLed, p_group->gpio.bluLedName))
+      {
+         printf("Can not init gpio of group %s\n", p_group->groupName);
+         return false;
+      }
+   }
+   if (!gpioStart())
+   {
+      return false;
    }
+   return (!g_pwmHz || pwmStart(g_pwmHz));
 }
 
 //----------------------------------------------------------------------------
@@ -399,14 +767,20 @@ void printGroupInfo(GroupInfoT* p_group)
             " server: %s\n"\
             " username: %s, password:%s\n"\
             " red: gpio%u, gre: gpio%u, blu: gpio%u\n"\
+            " poll_building: %u, poll_idle: %u, poll_max_idle: %u\n"\
             " display_timeout: %u\n"\
-            " last_build_threshold: %u\n",\
+            " last_build_threshold: %u\n"\
+            " quorum success: %u%%, building: %u%%, threshold: %u%%\n",\
             p_group->groupName,
             p_group->server.serverName,
             p_group->server.userName, p_group->server.passWord,
             p_group->gpio.redLed, p_group->gpio.greLed, p_group->gpio.bluLed,
+            p_group->pollPolicy.buildingTime, p_group->pollPolicy.idleTime,
+            p_group->pollPolicy.maxIdleTime,
             p_group->displaySuccessTimeout,
-            p_group->lastBuildThreshold);
+            p_group->lastBuildThreshold,
+            p_group->rule.successQuorum, p_group->rule.buildingQuorum,
+            p_group->rule.thresholdQuorum);
       printAllJobInfo(p_group->p_allJobs);
    }
 }
@@ -419,51 +793,167 @@ void initStuffOfAllGroup(GroupInfoT* p_headGroup)
    GroupInfoT* p_group = NULL;
    for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
    {
-      if (pthread_mutex_init(&p_group->lockLedSta, NULL))
+      if (!initGroupStuff(p_group))
       {
-         printf("Init mutex fail\n");
          exit(1);
       }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Fill poll policy which is not configured in xml file by default values
+//----------------------------------------------------------------------------
+void setDefaultPollPolicy(PollPolicyT* p_policy)
+{
+   if (p_policy->idleTime == 0)
+   {
+      p_policy->idleTime = DEFAULT_POLL_IDLE_TIME;
+   }
+   if (p_policy->buildingTime == 0)
+   {
+      p_policy->buildingTime = DEFAULT_POLL_BUILDING_TIME;
+   }
+   if (p_policy->maxIdleTime < p_policy->idleTime)
+   {
+      p_policy->maxIdleTime = (p_policy->maxIdleTime == 0) ?
+                              DEFAULT_POLL_MAX_IDLE_TIME : p_policy->idleTime;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Init stuff of one group which is parsed from xml file
+//----------------------------------------------------------------------------
+bool initGroupStuff(GroupInfoT* p_group)
+{
+   if (pthread_mutex_init(&p_group->lockJobSta, NULL))
+   {
+      printf("Init mutex fail\n");
+      return false;
+   }
+   p_group->p_metrics = calloc(1, sizeof(GroupMetricsT));
+   p_group->p_fetch = calloc(1, sizeof(GroupFetchT));
+   if (!p_group->p_metrics || !p_group->p_fetch)
+   {
+      printf("Can not allocate metrics of group %s\n", p_group->groupName);
+      free(p_group->p_metrics);
+      free(p_group->p_fetch);
+      p_group->p_metrics = NULL;
+      p_group->p_fetch = NULL;
+      pthread_mutex_destroy(&p_group->lockJobSta);
+      return false;
+   }
+
+   // Led of each group status is configured by <rules> in xml file
+   compileGroupRule(p_group);
 
-      // TODO may be we should allow user config this color through xml file
-      p_group->stdLed.disable.color = NON_COLOR ;
-      p_group->stdLed.disable.isAnime = false ;
+   LedInfoT initLed = {WHI_COLOR, false};
+   p_group->ledWord = packLedInfo(initLed);
 
-      p_group->stdLed.building.color = YEL_COLOR;
-      p_group->stdLed.building.isAnime = true;
+   // Timeout of requests is measured from round trip time of server by its
+   // breaker, this is only the limit for a slow server
+   p_group->curlTime.maxTime = 60;
 
-      p_group->stdLed.threshold.color = YEL_COLOR;
-      p_group->stdLed.threshold.isAnime = false ;
+   setDefaultPollPolicy(&p_group->pollPolicy);
 
-      p_group->stdLed.success.color = BLU_COLOR;
-      p_group->stdLed.success.isAnime = false ;
+   if (!initGroupConn(p_group))
+   {
+      free(p_group->p_metrics);
+      free(p_group->p_fetch);
+      p_group->p_metrics = NULL;
+      p_group->p_fetch = NULL;
+      pthread_mutex_destroy(&p_group->lockJobSta);
+      return false;
+   }
 
-      p_group->stdLed.successNotShow.color = NON_COLOR;
-      p_group->stdLed.successNotShow.isAnime = false ;
+   p_group->curSta.isBuilding = false;
+   p_group->curSta.isSuccess = false;
+   p_group->curSta.isThreshold = false;
+   p_group->curSta.isAllDisable = true;
+   p_group->curSta.isSuccessTimeout = false;
+   p_group->curSta.isUnreachable = false;
 
-      p_group->stdLed.fail.color = RED_COLOR;
-      p_group->stdLed.fail.isAnime = true;
+   // Group is evaluated after first fetch
+   p_group->isJobChanged = true;
+   return true;
+}
 
-      p_group->ledStatus.color = WHI_COLOR;
-      p_group->ledStatus.isAnime = false;
+//----------------------------------------------------------------------------
+// Init connection to jenkins server of group, it is kept during life time of
+// group (or until server of group is changed by reloading). Breaker of server
+// is shared with other groups which have the same server.
+//----------------------------------------------------------------------------
+bool initGroupConn(GroupInfoT* p_group)
+{
+   p_group->p_breaker = breakerFind(&g_breakers, p_group->server.serverName,
+                                    p_group->curlTime.maxTime * 1000);
+   if (!p_group->p_breaker)
+   {
+      printf("Can not allocate breaker of server %s\n", p_group->server.serverName);
+      return false;
+   }
+#if USE_ANY_AUTHORIZED_IN_HTTP
+   if (!httpConnInit(&p_group->httpConn, p_group->server.serverName,
+                     NULL, NULL, p_group->curlTime.maxTime * 1000))
+#else
+   if (!httpConnInit(&p_group->httpConn, p_group->server.serverName,
+                     p_group->server.userName, p_group->server.passWord,
+                     p_group->curlTime.maxTime * 1000))
+#endif
+   {
+      printf("Init connection to server %s fail\n", p_group->server.serverName);
+      return false;
+   }
+   return true;
+}
 
-      // Init CurlTime value
-      // TODO: should use Ping or sth like that to get network speed between
-      //       current computer and jenkins server, then change this value frequently
-      //       I think interval between ajudgement should be 4-5 hour
-      //       We can you sigalrm to create timer
-      p_group->curlTime.maxTime = 60;
-      p_group->curlTime.pollTime = 3;
+//----------------------------------------------------------------
+// Size of arena which holds whole config
+//----------------------------------------------------------------
+typedef struct configSize
+{
+   u_int32 groupCount;
+   u_int32 jobCount;
+   u_int32 stringCount;          // elements which only have text
+   size_t stringBytes;
+}ConfigSizeT;
 
-      p_group->curSta.isBuilding = false;
-      p_group->curSta.isSuccess = false;
-      p_group->curSta.isThreshold = false;
-      p_group->curSta.isAllDisable = true;
+//----------------------------------------------------------------------------
+// Count groups, jobs and text of elements in xml tree, text of every
+// element is counted as a string although not all of them are stored
+//----------------------------------------------------------------------------
+static void countConfigNodes(xmlNode* p_node, ConfigSizeT* p_size)
+{
+   for (; p_node; p_node = p_node->next)
+   {
+      if (p_node->type != XML_ELEMENT_NODE)
+      {
+         continue;
+      }
+      if (!strcmp(p_node->name, "group"))
+      {
+         p_size->groupCount++;
+      }
+      else if (!strcmp(p_node->name, "job"))
+      {
+         p_size->jobCount++;
+      }
+      xmlNode* p_child = p_node->children;
+      if (p_child && (p_child->type == XML_TEXT_NODE) && !p_child->next)
+      {
+         p_size->stringCount++;
+         p_size->stringBytes += strlen(p_child->content) + 1;
+      }
+      else
+      {
+         countConfigNodes(p_child, p_size);
+      }
    }
 }
 
 //----------------------------------------------------------------------------
 // Parsing XML file and append data to All group database
+// All groups and jobs of file are allocated from one arena which is sized
+// for the file, each group and job in list holds a reference of it
 //----------------------------------------------------------------------------
 bool parseXMLFile(const char* fileName, GroupInfoT** pp_headGroup)
 {
@@ -489,64 +979,71 @@ bool parseXMLFile(const char* fileName, GroupInfoT** pp_headGroup)
    if (rootNode->children == NULL)
    {
       printf("Don't have any group in XML file\n");
+      xmlFreeDoc(doc);
       return false;
    }
-   else
+
+   ConfigSizeT size;
+   memset(&size, 0, sizeof(size));
+   countConfigNodes(rootNode->children, &size);
+   ArenaT* p_arena = arenaCreate(size.groupCount * sizeof(GroupInfoT) +
+                                 size.jobCount * sizeof(JobInfoT),
+                                 size.stringBytes, size.stringCount);
+   if (!p_arena)
    {
-      // Get start Posision of group database to loop
-      p_curGroup = getTailGroup(*pp_headGroup);
+      xmlFreeDoc(doc);
+      return false;
+   }
+
+   // Get start Posision of group database to loop
+   p_curGroup = getTailGroup(*pp_headGroup);
+   GroupInfoT** pp_tailGroup = p_curGroup ? &p_curGroup->p_nextGroup : pp_headGroup;
 
-      // Iterator to get information of all Groups node in XML file
-      for (groupNode = rootNode->children; groupNode; groupNode = groupNode->next)
+   // Iterator to get information of all Groups node in XML file
+   bool isOk = true;
+   for (groupNode = rootNode->children; groupNode && isOk; groupNode = groupNode->next)
+   {
+      if (groupNode->type == XML_ELEMENT_NODE)
       {
-         if (groupNode->type == XML_ELEMENT_NODE)
+         if(!strcmp(groupNode->name, "group"))
          {
-            if(!strcmp(groupNode->name, "group"))
+            GroupInfoT* p_group = arenaAlloc(p_arena, sizeof(GroupInfoT));
+            isOk = (p_group != NULL);
+            if (isOk)
             {
-               GroupInfoT groupInfoTemp;
-               memset(&groupInfoTemp, 0, sizeof(groupInfoTemp));
-               if (parseGroupAttr(doc, groupNode, &groupInfoTemp))
+               p_group->p_arena = p_arena;
+               isOk = parseGroupAttr(doc, groupNode, p_group);
+               if (isOk)
                {
-                  if (!p_curGroup)
-                  {
-                     // Allocate memory for head group
-                     p_curGroup = malloc(sizeof(GroupInfoT));
-                     memset(p_curGroup, 0, sizeof(GroupInfoT));
-                     *pp_headGroup = p_curGroup;
-                  }
-                  else
-                  {
-                     // Allocate memory for next group
-                     p_curGroup->p_nextGroup = malloc(sizeof(GroupInfoT));
-                     p_curGroup = p_curGroup->p_nextGroup;
-                  }
-
-                  // Get all group data temp to current Group
-                  *p_curGroup = groupInfoTemp;
-                  p_curGroup->p_nextGroup = NULL;
+                  arenaRef(p_arena);
+                  *pp_tailGroup = p_group;
+                  pp_tailGroup = &p_group->p_nextGroup;
                }
                else
                {
                   printf("Cannot parse group in XML file\n");
-                  return false;
                }
             }
-            else
-            {
-               printf("wrong group XML element: %s\n",groupNode->name);
-               return false;
-            }
+         }
+         else
+         {
+            printf("wrong group XML element: %s\n",groupNode->name);
+            isOk = false;
          }
       }
    }
 
+   // Arena is freed here if no group is parsed
+   arenaSeal(p_arena);
+   arenaUnref(p_arena);
+
 	// Free the document
 	xmlFreeDoc(doc);
 
 	// Free the global variables that may have been allocated by the parser.
 	xmlCleanupParser();
 
-   return true;
+   return isOk;
 }
 
 //----------------------------------------------------------------------------
@@ -566,14 +1063,27 @@ bool parseArgument(int argc, char* argv[])
       {"daemon"  ,no_argument       ,0 ,'d'},
       {"help"    ,no_argument       ,0 ,'h'},
       {"realled" ,no_argument       ,0 ,'r'},
+      {"aggregate",no_argument      ,0 ,'a'},
+      {"gpio"    ,required_argument ,0 ,'b'},
+      {"gpiodev" ,required_argument ,0 ,'g'},
+      {"workers" ,required_argument ,0 ,'w'},
+      {"hook"    ,required_argument ,0 ,'k'},
+      {"hooktoken",required_argument ,0 ,'t'},
+      {"pwm"     ,required_argument ,0 ,'p'},
+      {"brightness",required_argument,0 ,'i'},
+      {"fade"    ,required_argument ,0 ,'s'},
+      {"metrics" ,required_argument ,0 ,'m'},
+      {"home"    ,required_argument ,0 ,'j'},
+      {"history" ,required_argument ,0 ,'l'},
       {0         ,0                 ,0 ,0  }
    };
 
    while (parseOK)
    {
       // getopt_long() function will check option in "argv" match with member in both list
-      // "f:vdh" list and longOptions[] array list
-      returnCharacter = getopt_long(argc, argv, "f:vdh", longOptions, &optionIdx);
+      // "f:vdhrab:g:w:k:t:p:i:s:m:j:l:" list and longOptions[] array list
+      returnCharacter = getopt_long(argc, argv, "f:vdhrab:g:w:k:t:p:i:s:m:j:l:", longOptions,
+                                    &optionIdx);
       if (returnCharacter == -1)
       {
          break;
@@ -606,168 +1116,101 @@ bool parseArgument(int argc, char* argv[])
             g_isCtrlRealLed = true;
          }
          break;
-         case '?':
+         case 'a':
          {
-            parseOK = false;
+            g_isAggregate = true;
          }
          break;
-         default:
+         case 'b':
          {
-            printf("?? getop_returnd character code 0%o ??\n", returnCharacter);
+            g_gpioBackend = optarg;
          }
          break;
-      }
-   }
-
-   if (optind < argc)
-   {
-      hasWrongNonOpt = true;
-      while (optind < argc)
-      {
-         printf("This non-option argument is wrong: %s\n", argv[optind++]);
-      }
-   }
-
-   return (parseOK && !hasWrongNonOpt && !needHelp);
-}
-
-//----------------------------------------------------------------------------
-// Build full path to files which contains the information of Job
-//----------------------------------------------------------------------------
-bool buildJobFiles(GroupInfoT* p_headGroup)
-{
-   char* infoFilesDir = "infoFiles";
-#if 0
-   // Way 1: to check directory is OK or not
-   // Check infoFilesDir exist or not
-   DIR* infoFileDir = opendir(infoFilesDir);
-   if (infoFileDir)
-   {
-      if (closedir(infoFileDir))
-      {
-         printf("There is a problem with infoFiles directory: %s\n", strerror(errno));
-         exit(1);
-      }
-   }
-   else
-   {
-      printf("There is a problem with infoFiles directory: %s\n", strerror(errno));
-      exit(1);
-   }
-#else
-   // Way 2: to check directory is OK or not
-   struct stat st = {0};
-   if (stat(infoFilesDir, &st) == -1)
-   {
-      if(mkdir(infoFilesDir, (S_IXUSR| S_IRUSR | S_IWUSR) | S_IROTH))
-      {
-         printf("Can not create directory: %s, error: %s\n", infoFilesDir, strerror(errno));
-      }
-   }
-#endif
-
-   GroupInfoT* p_group = p_headGroup;
-   if (p_group)
-   {
-      u_int32 groupIndex = 0;
-      for (; p_group; p_group = p_group->p_nextGroup)
-      {
-         JobInfoT* p_job = p_group->p_allJobs;
-         if (p_job)
+         case 'g':
+         {
+            g_gpioDev = optarg;
+         }
+         break;
+         case 'w':
+         {
+            g_workerCount = atoi(optarg);
+         }
+         break;
+         case 'k':
+         {
+            g_hookAddr = optarg;
+         }
+         break;
+         case 't':
+         {
+            g_hookToken = optarg;
+         }
+         break;
+         case 'p':
+         {
+            g_pwmHz = atoi(optarg);
+         }
+         break;
+         case 'i':
          {
-            u_int32 jobIndex = 0;
-            for (; p_job; p_job = p_job->p_nextJob)
+            int percent = atoi(optarg);
+            if ((percent < 1) || (percent > 100))
             {
-               sprintf(p_job->statusInfoFile, "%s/s%u_%u",
-                       infoFilesDir, groupIndex, jobIndex);
-               sprintf(p_job->lastBuildInfoFile, "%s/l%u_%u",
-                       infoFilesDir, groupIndex, jobIndex);
-               jobIndex++;
+               printf("Brightness must be 1..100 percent\n");
+               parseOK = false;
             }
-            groupIndex++;
+            g_ledLevel = percent * PWM_MAX_LEVEL / 100;
          }
-         else
+         break;
+         case 's':
          {
-            printf("Do not have any job in data base\n");
-            return false;
+            g_fadeMs = atoi(optarg);
          }
+         break;
+         case 'm':
+         {
+            g_metricsAddr = optarg;
+         }
+         break;
+         case 'j':
+         {
+            g_homeDir = optarg;
+         }
+         break;
+         case 'l':
+         {
+            g_historyDir = optarg;
+         }
+         break;
+         case '?':
+         {
+            parseOK = false;
+         }
+         break;
+         default:
+         {
+            printf("?? getop_returnd character code 0%o ??\n", returnCharacter);
+         }
+         break;
       }
    }
-   else
-   {
-      printf("Do not have group in data base\n");
-      return false;
-   }
-   return true;
-}
 
-//----------------------------------------------------------------------------
-// Get color from status info file
-//----------------------------------------------------------------------------
-void colorFromFile(char* fileName, char* colorStr, size_t strSize)
-{
-   char grepCommand[100];
-   char colorLine[30];
-   sprintf(grepCommand, "grep \"^  \\\"color\" %s", fileName);
-   FILE* file = popen(grepCommand, "r");
-   if (!file)
-   {
-      printf("can not openfile: %s, error: %s\n", fileName, strerror(errno));
-      return;
-   }
-   if (fgets(colorLine, sizeof(colorLine), file))
+   if (g_isAggregate && g_homeDir)
    {
-      if (sscanf(colorLine, "  \"color\" : \"%[^\"]", colorStr) != 1)
-      {
-         printf("get color failed.\n");
-      }
+      printf("--aggregate and --home can not be used together\n");
+      parseOK = false;
    }
-   fclose(file);
-}
-
-//----------------------------------------------------------------------------
-// Get timestamp in second resolution from last build info file
-//----------------------------------------------------------------------------
-int64 timeStampFromFile(char* fileName)
-{
-   int64 timeStamp = 0;
-   char grepCommand[100];
-   char timeStampLine[50];
-#if 0
-   // Bug in valgrind: "Use of uninitialised value of size 8"
-   // because we use timeStampStr variable in later atoll(timeStampStr)
-   // We should init for this string
-   char timeStampStr[30];
-#else
-   char timeStampStr[30];
-   timeStampStr[0] = 0;
-#endif
 
-   sprintf(grepCommand, "grep \"timestamp\" %s", fileName);
-   FILE* file = popen(grepCommand, "r");
-   if (!file)
-   {
-      printf("can not openfile: %s, error: %s\n", fileName, strerror(errno));
-      return 0;
-   }
-   if (fgets(timeStampLine, sizeof(timeStampLine), file))
+   if (optind < argc)
    {
-      //printf("timeStampLine: %s\n", timeStampLine);
-                               //  \"timestamp\" : 1418372173536
-      if (sscanf(timeStampLine, "  \"timestamp\" : %s", timeStampStr) != 1)
+      hasWrongNonOpt = true;
+      while (optind < argc)
       {
-         printf("get time stamp failed.\n");
+         printf("This non-option argument is wrong: %s\n", argv[optind++]);
       }
    }
-   fclose(file);
-   timeStamp = atoll(timeStampStr) / 1000;
-   if (g_isVerbose)
-   {
-      printf("Get timeStamp in ms from file %s: %s (in s :%llu)\n",
-              fileName, timeStampStr, timeStamp);
-   }
 
-   return timeStamp;
+   return (parseOK && !hasWrongNonOpt && !needHelp);
 }
 
 //----------------------------------------------------------------------------
@@ -814,6 +1257,24 @@ LedInfoT convert2LedInfo(char* colorStr)
    return led;
 }
 
+//----------------------------------------------------------------------------
+// Convert color string of config ("blue", "red_anime", ...) to led status
+// return false if color is unknown
+//----------------------------------------------------------------------------
+bool parseLedInfo(const char* colorStr, LedInfoT* p_led)
+{
+   char str[20];
+   if (strlen(colorStr) >= sizeof(str))
+   {
+      return false;
+   }
+   strcpy(str, colorStr);
+   *p_led = convert2LedInfo(str);
+
+   // Unknown color is converted to noColor
+   return (p_led->color != NON_COLOR) || !strcmp(str, "noColor");
+}
+
 //----------------------------------------------------------------------------
 // Convert led Status to color string
 // Note: need to free pointer to string that are return from this function
@@ -892,99 +1353,11 @@ char* convertRgb2ColorStr(GpioStatusE r, GpioStatusE g, GpioStatusE b)
    return pColor2Led->colorStr;
 }
 
-//----------------------------------------------------------------------------
-// Get led Status Info from file
-//----------------------------------------------------------------------------
-LedInfoT ledInfoFromfile(char* fileName)
-{
-   char colorStr[20];
-   colorFromFile(fileName, colorStr, sizeof(colorStr));
-   LedInfoT ledInfo = convert2LedInfo(colorStr);
-   if (g_isVerbose)
-   {
-      convert2ColorStr(ledInfo, colorStr, 20);
-      printf("Get color from file %s: %s\n", fileName, colorStr);
-   }
-   return ledInfo;
-}
-
-//----------------------------------------------------------------------------
-// Read current value of GPIO
-//----------------------------------------------------------------------------
-GpioStatusE readGPIOValue(u_int8 pin)
-{
-   if (g_isCtrlRealLed)
-   {
-      GpioStatusE value;
-      char catCommand[200];
-      char valueStr[10];
-      sprintf(catCommand, "cat /sys/class/gpio/gpio%u/value", pin);
-      FILE* file;
-      if (!(file = popen(catCommand, "r")))
-      {
-         printf("Can not read value of gpio: %s\n", catCommand);
-         return;
-      }
-      if (fgets(valueStr, sizeof(valueStr), file))
-      {
-         value = atoi(valueStr);
-      }
-      fclose(file);
-      return value;
-   }
-   else
-   {
-      return 0;
-   }
-}
-
-//----------------------------------------------------------------------------
-// Set state to GPIO after checking current state
-//----------------------------------------------------------------------------
-void setGPIOValue(u_int8 pin, GpioStatusE state)
-{
-   if (g_isCtrlRealLed)
-   {
-      if (state != readGPIOValue(pin))
-      {
-         char echoCommand[200];
-         sprintf(echoCommand,
-               "echo %d > /sys/class/gpio/gpio%u/value", state, pin);
-         FILE* file;
-         if (!(file = popen(echoCommand, "r")))
-         {
-            printf("Can not set value to gpio: %s\n", echoCommand);
-            return;
-         }
-         fclose(file);
-      }
-   }
-}
-
-//----------------------------------------------------------------------------
-// Set state to GPIO without checking current state
-//----------------------------------------------------------------------------
-void setGPIOValueNoCheck(u_int8 pin, GpioStatusE state)
-{
-   if (g_isCtrlRealLed)
-   {
-      char echoCommand[200];
-      sprintf(echoCommand,
-            "echo %d > /sys/class/gpio/gpio%u/value", state, pin);
-      FILE* file;
-      if (!(file = popen(echoCommand, "r")))
-      {
-         printf("Can not set value to gpio: %s\n", echoCommand);
-         return;
-      }
-      fclose(file);
-   }
-}
-
 //----------------------------------------------------------------------------
 // Control led only by setting value to GPIO
 //----------------------------------------------------------------------------
-void ledCtrl(ColorE color, GpioStatusE gpioState, LedGpioT gpioLed, char* stuffInfoStr)
+void ledCtrl(ColorE color, GpioStatusE gpioState, LedGpioT gpioLed,
+             const ColorLevelT* p_levels, char* stuffInfoStr)
 {
    Color2LedInfoT* pColor2Led = C2LInfo;
    while ((pColor2Led->color != NON_COLOR) &&
@@ -997,7 +1370,7 @@ void ledCtrl(ColorE color, GpioStatusE gpioState, LedGpioT gpioLed, char* stuffI
    GpioStatusE g = OF;
    GpioStatusE b = OF;
 
-   if (gpioState == ON)
+   if ((gpioState == ON) || (gpioState == BL))
    {
       r = pColor2Led->r;
       g = pColor2Led->g;
@@ -1005,449 +1378,3134 @@ void ledCtrl(ColorE color, GpioStatusE gpioState, LedGpioT gpioLed, char* stuffI
    }
 
    // Set value for GPIO -> control Led
-   if (g_isCtrlRealLed)
+   // value is written when frame of all groups is committed
+   // if gpio driver blinks led, pins that are on will blink
+   // pwm mixes channels by levels of color instead of on and off
+   if (g_isCtrlRealLed && g_pwmHz)
    {
-      setGPIOValueNoCheck(gpioLed.redLed, r);
-      setGPIOValueNoCheck(gpioLed.greLed, g);
-      setGPIOValueNoCheck(gpioLed.bluLed, b);
+      const ColorLevelT* p_level = &p_levels[pColor2Led->color];
+      bool isOn = (gpioState == ON) || (gpioState == BL);
+      pwmLedPin(gpioLed.redLed, gpioState == BL, isOn ? p_level->r : 0);
+      pwmLedPin(gpioLed.greLed, gpioState == BL, isOn ? p_level->g : 0);
+      pwmLedPin(gpioLed.bluLed, gpioState == BL, isOn ? p_level->b : 0);
+   }
+   else if (g_isCtrlRealLed)
+   {
+      gpioSetValue(gpioLed.redLed, ((gpioState == BL) && (r == ON)) ? GPIO_BLINK : r);
+      gpioSetValue(gpioLed.greLed, ((gpioState == BL) && (g == ON)) ? GPIO_BLINK : g);
+      gpioSetValue(gpioLed.bluLed, ((gpioState == BL) && (b == ON)) ? GPIO_BLINK : b);
    }
 
    if (g_isVerbose)
    {
-      printf("\nGroup %s's LED color: %s <=> red-green-blue: %d-%d-%d r-g-b:%d-%d-%d\n",
+      printf("\nGroup %s's LED color: %s%s <=> red-green-blue: %d-%d-%d r-g-b:%d-%d-%d\n",
              stuffInfoStr, convertRgb2ColorStr(r,g,b),
+             (gpioState == BL) ? " (blink by gpio driver)" : "",
              gpioLed.redLed, gpioLed.greLed, gpioLed.bluLed,
              r, g, b);
    }
 }
 
 //----------------------------------------------------------------------------
-// Build multiple threads to Evaluate Color for each Group
-// Each Group has 1 threads to evaluate group's color
+// Hand led pin to software pwm: pin fades to percent of led brightness or
+// to off, blinking led breathes in one period of on and off
 //----------------------------------------------------------------------------
-bool buildEvalGrpColorTheads(GroupInfoT* p_headGroup)
+void pwmLedPin(unsigned int pin, bool isAnime, u_int32 percent)
 {
-   bool areAllOk = true;
-   GroupInfoT* p_group = NULL;
-   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   unsigned int level = g_ledLevel * percent / 100;
+   if (isAnime && level)
    {
-      if (pthread_create(&p_group->evalColorThread, NULL, evalGrpColorPoll, p_group))
-      {
-         areAllOk = false;
-         break;
-      }
+      pwmSetBreath(pin, level, g_ledAnimeTime * 2000);
+   }
+   else
+   {
+      pwmSetLevel(pin, level, g_fadeMs);
    }
-   return areAllOk;
 }
 
 //----------------------------------------------------------------------------
-// Evaluate Color for Group
+// Check if leds can blink without led thread (software pwm or gpio driver)
+//----------------------------------------------------------------------------
+bool ledCanBlink(void)
+{
+   return (g_isCtrlRealLed && g_pwmHz) || gpioCanBlink();
+}
+
+//----------------------------------------------------------------------------
+// Build worker pool to fetch and evaluate groups
+// Each group (or each jenkin server in aggregate mode) has one poll timer,
+// its fetch task is submitted to pool when timer is expired. Fetch task
+// returns when socket of its request is not ready, it is submitted again by
+// its io timer. Then fetch task spawns evaluate tasks, which are run next by
+// the same worker or stolen by an idle worker, then poll timer is posted
+// again. So pool is sized by cores, not by groups.
 //----------------------------------------------------------------------------
-void* evalGrpColorPoll(void* arg)
+bool buildWorkerPool(GroupInfoT* p_headGroup, JenkinServerT* p_headServer)
 {
-   GroupInfoT* p_group = (GroupInfoT*)arg;
-   u_int32 curlCmdSize = 10000;
-   char* pCurlCmd = malloc(curlCmdSize * sizeof(*pCurlCmd));
-   if (!buildCurlCmd(p_group, pCurlCmd, curlCmdSize))
+   if (!schedInit(&g_pollSched))
+   {
+      return false;
+   }
+   if (!poolInit(&g_pool, g_workerCount ? g_workerCount : poolDefaultWorkers()))
    {
-      printf("Can not build curl Command\n");
-      exitNow();
+      return false;
    }
-   else
+   if (g_isVerbose)
    {
-      if (g_isVerbose)
-      {
-         printf("Group %s's Curl command:\n%s\n", p_group->groupName, pCurlCmd);
-      }
+      printf("Worker pool has %u workers\n", g_pool.workerCount);
    }
 
-   while (1)
+   // First fetch of all groups is done now
+   long long nowNs = schedNowNs();
+   GroupInfoT* p_group = NULL;
+   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
    {
-      pthread_mutex_lock(&g_terminateLock);
-      bool tempTerminate = g_terminateAll;
-      pthread_mutex_unlock(&g_terminateLock);
-      if (tempTerminate)
+      initGroupTasks(p_group);
+      if (!g_isAggregate)
       {
-         break;
+         schedAdd(&g_pollSched, &p_group->pollTimer, nowNs);
       }
+   }
 
-      if (executeCurlCmd(pCurlCmd))
-      {
-         evaluateColor(p_group);
-         sleep(p_group->curlTime.pollTime);
-      }
+   JenkinServerT* p_server = NULL;
+   for (p_server = p_headServer; p_server; p_server = p_server->p_nextServer)
+   {
+      initServerTasks(p_server);
+      schedAdd(&g_pollSched, &p_server->pollTimer, nowNs);
    }
+   return true;
+}
 
-   free(pCurlCmd);
-   return 0;
+//----------------------------------------------------------------------------
+// Init tasks and poll timer of group, timer is not queued
+//----------------------------------------------------------------------------
+void initGroupTasks(GroupInfoT* p_group)
+{
+   p_group->fetchTask.run = fetchGroupTask;
+   p_group->fetchTask.p_arg = p_group;
+   p_group->evalTask.run = g_isAggregate ? evalServerGroupTask : evalGroupTask;
+   p_group->evalTask.p_arg = p_group;
+   schedTimerInit(&p_group->pollTimer, &p_group->fetchTask);
+   schedTimerInit(&p_group->ioTimer, &p_group->fetchTask);
 }
 
 //----------------------------------------------------------------------------
-// Build Curl command string
+// Init task and poll timer of jenkin server, timer is not queued
 //----------------------------------------------------------------------------
-bool buildCurlCmd(GroupInfoT* p_group, char* curlCommand, u_int32 curlCommandSize)
+void initServerTasks(JenkinServerT* p_server)
 {
-   u_int32 remainLen = curlCommandSize;
-   u_int32 len;
+   p_server->fetchTask.run = fetchServerTask;
+   p_server->fetchTask.p_arg = p_server;
+   schedTimerInit(&p_server->pollTimer, &p_server->fetchTask);
+   schedTimerInit(&p_server->ioTimer, &p_server->fetchTask);
+}
 
-#if USE_ANY_AUTHORIZED_IN_CURL
-   len = snprintf(curlCommand, remainLen, "curl --silent --max-time %d --anyauth ",
-                  p_group->curlTime.maxTime);
-#else
-   len = snprintf(curlCommand, remainLen, "curl --silent --max-time %d -u %s:%s ",
-                  p_group->curlTime.maxTime, p_group->server.userName, p_group->server.passWord);
-#endif
-   if (len >= remainLen)
-   {
-      return false;
-   }
-   else
+//----------------------------------------------------------------------------
+// Submit fetch tasks to worker pool when their poll time comes or when socket
+// of their request is ready, reload config when it is requested, return when
+// all threads are terminated
+//----------------------------------------------------------------------------
+void dispatchPollTasks(GroupInfoT** pp_allGroups, JenkinServerT** pp_allServers)
+{
+   while (1)
    {
-      remainLen -= len;
-   }
+      if (isTerminated())
+      {
+         break;
+      }
 
-   JobInfoT* p_job = p_group->p_allJobs;
-   if (p_job)
-   {
-      for (; p_job; p_job = p_job->p_nextJob)
+      if (__atomic_exchange_n(&g_isReloadRequested, false, __ATOMIC_SEQ_CST))
       {
-         // Build command to get status of Job
-         char* pStatusCmd = malloc(remainLen * sizeof(*pStatusCmd));
-         len = snprintf(pStatusCmd, remainLen,
-                        " %s%s%s/api/json?pretty=true\\&"\
-                        "tree=name,color -o %s",
-                        p_group->server.serverName, p_job->jobPath, p_job->jobName,
-                        p_job->statusInfoFile);
-         if (len >= remainLen)
-         {
-            free(pStatusCmd);
-            return false;
-         }
-         else
-         {
-            remainLen -= len;
-            strcat(curlCommand, pStatusCmd);
-            free(pStatusCmd);
-         }
+         reloadConfig(pp_allGroups, pp_allServers);
+      }
 
-         // Build command to get last build information of Job
-         char* pLastBuildCmd = malloc(remainLen * sizeof(*pLastBuildCmd));
-         len = snprintf(pLastBuildCmd, remainLen,
-                       " %s%s%s/lastBuild/api/json?pretty=true\\&"\
-                       "tree=fullDisplayName,id,timestamp,result -o %s",
-                       p_group->server.serverName, p_job->jobPath, p_job->jobName,
-                       p_job->lastBuildInfoFile);
-         if (len >= remainLen)
-         {
-            free(pLastBuildCmd);
-            return false;
-         }
-         else
+      SchedTimerT* p_timer = NULL;
+      while ((p_timer = schedPopExpired(&g_pollSched, schedNowNs())))
+      {
+         if (!poolSubmit(&g_pool, (PoolTaskT*)p_timer->p_arg))
          {
-            remainLen -= len;
-            strcat(curlCommand, pLastBuildCmd);
-            free(pLastBuildCmd);
+            printf("Can not submit task to worker pool\n");
+            exitNow();
          }
       }
 
-      // Add done string
-      char* doneStr = malloc(remainLen * sizeof(*doneStr));
-      len = snprintf(doneStr, remainLen,
-                     ";echo Finish curl from jenkin server: %s", p_group->server.serverName);
-      if (len >= remainLen)
-      {
-         free(doneStr);
-         return false;
-      }
-      else
+      if (!schedWait(&g_pollSched))
       {
-         strcat(curlCommand, doneStr);
-         free(doneStr);
+         exitNow();
       }
    }
+}
+
+//----------------------------------------------------------------------------
+// Task to get information of all jobs of group, it is run again by io timer
+// of group while request of group is in flight
+//----------------------------------------------------------------------------
+void fetchGroupTask(PoolTaskT* p_task, PoolWorkerT* p_worker)
+{
+   GroupInfoT* p_group = (GroupInfoT*)p_task->p_arg;
+   FetchResultE result = fetchGroupInfo(p_group);
+   if (result == FETCH_WAIT)
+   {
+      // Task may run again at once, group must not be touched after it
+      waitFetch(&p_group->ioTimer, &p_group->httpConn);
+   }
+   else if (result == FETCH_OK)
+   {
+      poolSpawn(p_worker, &p_group->evalTask);
+   }
    else
    {
-      printf("Do not have any job in data base\n");
-      return false;
+      schedPost(&g_pollSched, &p_group->pollTimer, nextGroupPollNs(p_group));
    }
+}
 
-   return true;
+//----------------------------------------------------------------------------
+// Task to evaluate color of group, then group is polled again at poll time
+// of its jobs
+//----------------------------------------------------------------------------
+void evalGroupTask(PoolTaskT* p_task, PoolWorkerT* p_worker)
+{
+   GroupInfoT* p_group = (GroupInfoT*)p_task->p_arg;
+   evaluateColor(p_group);
+   schedPost(&g_pollSched, &p_group->pollTimer, nextGroupPollNs(p_group));
+}
+
+//----------------------------------------------------------------------------
+// Sink to feed body of http response to json extractor of request
+//----------------------------------------------------------------------------
+static bool extractorSink(void* p_arg, const char* data, size_t len)
+{
+   FetchRequestT* p_request = (FetchRequestT*)p_arg;
+   long long startNs = schedNowNs();
+   bool isOk = jsonExtractorFeed(&p_request->extractor, data, len);
+   p_request->parseNs += schedNowNs() - startNs;
+   return isOk;
 }
 
 //----------------------------------------------------------------------------
-// Execute curl command to get information about a groups from jenkin server
+// Send request through connection and feed response to json extractor of
+// request, which is initialized by caller. Request which is in flight is
+// resumed instead, path is not used then.
+// Timeout of request is given by breaker of server, which then accounts
+// round trip time or failure of request. Caller asks breakerAllow() first.
+// Request and timeout are counted to metrics, time of parsing is added to
+// *p_parseNs. Error is counted by caller, a failed request may be normal
+// (job which has never been built does not have last build).
+// return HTTP_WAIT if socket is not ready, caller waits for it by
+//        waitFetch() and calls this function again when it is resumed
+//        HTTP_DONE if request is finished, *p_isOk is its result
 //----------------------------------------------------------------------------
-bool executeCurlCmd(char* curlCommand)
+HttpProgressE fetchJson(HttpConnT* p_conn, BreakerT* p_breaker, const char* path,
+                        FetchRequestT* p_request, PollMetricsT* p_metrics,
+                        long long* p_parseNs, bool* p_isOk)
 {
-   // TODO: should use CURL api function instead of execute curl command in shell
-   char curlDoneStr[100];
-   curlDoneStr[0] = 0; //To void valgrind error
-                       //"Conditional jump or move depends on uninitialised value(s)"
-                       //If curlDoneStr is not initialized and not modified before printf
-                       //, we will prints many things we do not expect!
-   FILE* file;
-   // XXX : by using system() function, we can not receive SIGTERM or
-   //       SIGINT signal by press "Ctrl + C"
-   //       -> solution: use popen() function
-   if ((file = popen(curlCommand, "r")) == NULL)
+   HttpProgressE progress;
+   if (p_request->isInFlight)
    {
-      printf("Can not execute command: %s\n", curlCommand);
-      return false;
+      progress = httpResume(p_conn);
    }
-
-   while (fgets(curlDoneStr, sizeof(curlDoneStr), file) != NULL)
+   else
    {
-      pthread_mutex_lock(&g_terminateLock);
-      bool tempTerminate = g_terminateAll;
-      pthread_mutex_unlock(&g_terminateLock);
-      if (tempTerminate)
-      {
-         break;
-      }
+      p_request->parseNs = 0;
+      p_request->startNs = schedNowNs();
+      httpConnSetTimeout(p_conn, breakerTimeoutMs(p_breaker));
+      progress = httpStart(p_conn, path, extractorSink, p_request);
+   }
+   p_request->isInFlight = (progress == HTTP_WAIT);
+   if (progress == HTTP_WAIT)
+   {
+      return HTTP_WAIT;
    }
+   long long endNs = schedNowNs();
+   *p_isOk = false;
 
-   fclose(file);
-   if (g_isVerbose)
+   // Server which answers 404 is alive, 5xx of jenkins or its proxy is not.
+   // Canceled request tells nothing about server, but it may be the probe.
+   if (p_conn->isCanceled)
    {
-      printf("%s\n", curlDoneStr);
+      breakerCancel(p_breaker, endNs);
+      return HTTP_DONE;
    }
-   return true;
+   breakerRecord(p_breaker, (p_conn->statusCode >= 0) && (p_conn->statusCode < 500),
+                 p_conn->isTimedOut, endNs - p_request->startNs, endNs);
+   metricsAdd(&p_metrics->requestCount, 1);
+   if (p_conn->isTimedOut)
+   {
+      metricsAdd(&p_metrics->timeoutCount, 1);
+   }
+   *p_parseNs += p_request->parseNs;
+   *p_isOk = (p_conn->statusCode == 200);
+   return HTTP_DONE;
 }
 
 //----------------------------------------------------------------------------
-// Evaluate Color for group
+// Let main thread run fetch task again when socket of its request is ready
+// or deadline of request is passed
+// Note: it is the last thing a fetch task does, task may be run again before
+// this function returns
 //----------------------------------------------------------------------------
-void evaluateColor(GroupInfoT* p_group)
+void waitFetch(SchedTimerT* p_ioTimer, HttpConnT* p_conn)
 {
-   // evaluate Group Status base on information store in status files and last
-   // last build status file
-   evalGroupStatus(p_group);
-
-   // evaluate Led status base on Current Group Status information and
-   // last group Status information
-   evalLedStatus(p_group);
+   // Request times out at its deadline if socket can not be watched
+   schedPostWait(&g_pollSched, p_ioTimer, p_conn->deadlineNs, p_conn->sockFd,
+                 p_conn->waitEvents);
+}
 
-   if (g_isVerbose)
+//----------------------------------------------------------------------------
+// Assign information of job which is parsed from json data to job state
+// return true if state of job is changed
+//----------------------------------------------------------------------------
+bool assignJobState(JobInfoT* p_job, const JsonJobEntryT* p_entry)
+{
+   char colorStr[sizeof(p_entry->color)];
+   strcpy(colorStr, p_entry->color);
+   JobStateT preState = p_job->state;
+   p_job->state.led = convert2LedInfo(colorStr);
+   p_job->state.lastBuildTimeStamp = p_entry->timestamp / 1000;
+   p_job->state.lastBuildResult = convert2BuildResult(p_entry->result);
+   p_job->state.lastBuildNumber = p_entry->number;
+   p_job->state.isUpdated = true;
+   bool isChanged = isJobStateChanged(&preState, &p_job->state);
+   if (isChanged)
+   {
+      logJobHistory(p_job);
+   }
+   return isChanged;
+}
+
+//----------------------------------------------------------------------------
+// Compare fields of job state which are shown by led
+//----------------------------------------------------------------------------
+bool isJobStateChanged(const JobStateT* p_preState, const JobStateT* p_curState)
+{
+   return (p_preState->led.color != p_curState->led.color) ||
+          (p_preState->led.isAnime != p_curState->led.isAnime) ||
+          (p_preState->lastBuildTimeStamp != p_curState->lastBuildTimeStamp) ||
+          (p_preState->lastBuildResult != p_curState->lastBuildResult);
+}
+
+//----------------------------------------------------------------------------
+// Append state of job to history log, it is called when state is changed
+//----------------------------------------------------------------------------
+void logJobHistory(JobInfoT* p_job)
+{
+   if (!g_history.isOpen)
+   {
+      return;
+   }
+   if (!p_job->historyId)
+   {
+      char name[1000];
+      snprintf(name, sizeof(name), "%s%s", p_job->jobPath, p_job->jobName);
+      p_job->historyId = historyIdOf(&g_history, HISTORY_JOB, name);
+   }
+   HistoryRecordT record;
+   memset(&record, 0, sizeof(record));
+   record.kind = HISTORY_JOB;
+   record.id = p_job->historyId;
+   record.color = p_job->state.led.color;
+   record.flags = p_job->state.led.isAnime ? HISTORY_ANIME : 0;
+   record.state = p_job->state.lastBuildResult;
+   record.buildNumber = p_job->state.lastBuildNumber;
+   record.buildTime = (p_job->state.lastBuildTimeStamp > 0) ?
+                      (u_int32)p_job->state.lastBuildTimeStamp : 0;
+   historyAppend(&g_history, &record);
+}
+
+//----------------------------------------------------------------------------
+// Set state of jobs to their last build in index of builds which
+// jenkin_backfill writes to history directory, so that the first poll after
+// start is compared with the last known build and only jobs which are
+// changed since are logged. It is called before jobs are polled.
+//----------------------------------------------------------------------------
+void loadBuildIndex(GroupInfoT* p_headGroup)
+{
+   // Color of job which jenkins shows for result of its last finished build
+   static const char* resultColors[] = {"notbuilt", "blue", "yellow", "red", "notbuilt", "aborted"};
+   HistoryBuildsT index;
+   if (!g_history.isOpen || !historyBuildsOpen(&index, g_historyDir))
+   {
+      return;
+   }
+   u_int32 jobCount = 0;
+   u_int32 loadCount = 0;
+   GroupInfoT* p_group;
+   JobInfoT* p_job;
+   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   {
+      for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+      {
+         jobCount++;
+         if (!p_job->historyId)
+         {
+            char name[1000];
+            snprintf(name, sizeof(name), "%s%s", p_job->jobPath, p_job->jobName);
+            p_job->historyId = historyIdOf(&g_history, HISTORY_JOB, name);
+         }
+         const HistoryBuildT* p_builds = NULL;
+         size_t count = historyBuildsOf(&index, p_job->historyId, &p_builds);
+         if (!count)
+         {
+            continue;
+         }
+         const HistoryBuildT* p_last = &p_builds[count - 1];
+         const HistoryBuildT* p_finished = p_last;
+         while ((p_finished > p_builds) && (p_finished->result == NO_RESULT))
+         {
+            p_finished--;
+         }
+         char colorStr[32];
+         snprintf(colorStr, sizeof(colorStr), "%s%s",
+                  resultColors[(p_finished->result <= ABORTED_RESULT) ? p_finished->result : 0],
+                  (p_last->result == NO_RESULT) ? "_anime" : "");
+         p_job->state.led = convert2LedInfo(colorStr);
+         p_job->state.lastBuildTimeStamp = p_last->timeMs / 1000;
+         p_job->state.lastBuildResult = p_last->result;
+         p_job->state.lastBuildNumber = p_last->number;
+         loadCount++;
+      }
+   }
+   printf("Jobs are set to their last build in history index: %u of %u jobs, %zu builds\n",
+          loadCount, jobCount, index.count);
+   historyBuildsClose(&index);
+}
+
+//----------------------------------------------------------------------------
+// Append status and led of group to history log if any of them is changed
+// since it is logged last time, it is called after each evaluation
+//----------------------------------------------------------------------------
+void logGroupHistory(GroupInfoT* p_group)
+{
+   if (!g_history.isOpen)
+   {
+      return;
+   }
+   // Top bit is set so that logged word is never 0
+   LedInfoT ledInfo = loadGrpLedStatus(p_group);
+   u_int32 status = packGroupStatus(&p_group->curSta);
+   u_int32 word = 0x80000000u | (packLedInfo(ledInfo) << 8) | status;
+   if (word == p_group->historyWord)
+   {
+      return;
+   }
+   p_group->historyWord = word;
+   if (!p_group->historyId)
+   {
+      p_group->historyId = historyIdOf(&g_history, HISTORY_GROUP, p_group->groupName);
+   }
+   HistoryRecordT record;
+   memset(&record, 0, sizeof(record));
+   record.kind = HISTORY_GROUP;
+   record.id = p_group->historyId;
+   record.color = ledInfo.color;
+   record.flags = ledInfo.isAnime ? HISTORY_ANIME : 0;
+   record.state = status;
+   historyAppend(&g_history, &record);
+}
+
+//----------------------------------------------------------------------------
+// Set next poll time after a poll by poll policy
+//----------------------------------------------------------------------------
+void updatePollState(const PollPolicyT* p_policy, PollStateT* p_poll,
+                     bool isBuilding, bool isChanged, long long nowNs)
+{
+   if (isChanged)
+   {
+      // Something happens, next change may come soon (e.g. build is queued
+      // right after previous build)
+      p_poll->delay = 0;
+   }
+   else if (isBuilding)
+   {
+      p_poll->delay = p_policy->buildingTime;
+   }
+   else if (p_poll->delay < p_policy->idleTime)
+   {
+      p_poll->delay = p_policy->idleTime;
+   }
+   else
+   {
+      p_poll->delay *= 2;
+      if (p_poll->delay > p_policy->maxIdleTime)
+      {
+         p_poll->delay = p_policy->maxIdleTime;
+      }
+   }
+   if ((g_hookAddr || g_homeDir) && (p_poll->delay < HOOK_SAFETY_POLL_TIME))
+   {
+      // Changes come from build notifications or watcher of JENKINS_HOME
+      p_poll->delay = HOOK_SAFETY_POLL_TIME;
+   }
+   p_poll->nextPollNs = nowNs + p_poll->delay * 1000000000LL;
+}
+
+//----------------------------------------------------------------------------
+// Get status and last build of job which is fetched by group from jenkin
+// server through connection of group, or go on with its request which is in
+// flight. Entry of job is in fetch state of group, time of parsing is added
+// to fetch state too.
+// return HTTP_WAIT if request of job is in flight
+//        HTTP_DONE then, *p_isFetched is false if status of job can not be got
+//----------------------------------------------------------------------------
+static HttpProgressE fetchJobEntry(GroupInfoT* p_group, bool* p_isFetched)
+{
+   char path[1000];
+   GroupFetchT* p_fetch = p_group->p_fetch;
+   JobInfoT* p_job = p_fetch->p_job;
+   bool isOk = false;
+
+   // Get status of Job
+   if (p_fetch->jobStep == JOB_STEP_NONE)
+   {
+      memset(&p_fetch->entry, 0, sizeof(JsonJobEntryT));
+      snprintf(path, sizeof(path), "%s%s/api/json?tree=name,color",
+               p_job->jobPath, p_job->jobName);
+      jsonExtractorInit(&p_fetch->request.extractor, jsonMergeJobEntry, &p_fetch->entry);
+      p_fetch->jobStep = JOB_STEP_STATUS;
+   }
+   if (p_fetch->jobStep == JOB_STEP_STATUS)
+   {
+      if (fetchJson(&p_group->httpConn, p_group->p_breaker, path, &p_fetch->request,
+                    &p_group->p_metrics->poll, &p_fetch->parseNs, &isOk) == HTTP_WAIT)
+      {
+         return HTTP_WAIT;
+      }
+      if (!isOk || !jsonExtractorFinish(&p_fetch->request.extractor))
+      {
+         p_fetch->jobStep = JOB_STEP_NONE;
+         *p_isFetched = false;
+         return HTTP_DONE;
+      }
+
+      // Get last build information of Job
+      snprintf(path, sizeof(path), "%s%s/lastBuild/api/json?tree=number,timestamp,result",
+               p_job->jobPath, p_job->jobName);
+      jsonExtractorInit(&p_fetch->request.extractor, jsonMergeJobEntry, &p_fetch->entry);
+      p_fetch->jobStep = JOB_STEP_LAST_BUILD;
+   }
+   if (fetchJson(&p_group->httpConn, p_group->p_breaker, path, &p_fetch->request,
+                 &p_group->p_metrics->poll, &p_fetch->parseNs, &isOk) == HTTP_WAIT)
+   {
+      return HTTP_WAIT;
+   }
+
+   // Job which has never been built does not have last build (404). Other
+   // failure keeps previous state of job, it must not look like a job which
+   // is never built.
+   p_fetch->jobStep = JOB_STEP_NONE;
+   *p_isFetched = isOk ? jsonExtractorFinish(&p_fetch->request.extractor) :
+                         (p_group->httpConn.statusCode == 404);
+   return HTTP_DONE;
+}
+
+//----------------------------------------------------------------------------
+// Read status and last build of job from its files in JENKINS_HOME, time of
+// reading is added to *p_parseNs
+// return false if job does not exist
+//----------------------------------------------------------------------------
+static bool readHomeJobEntry(JobInfoT* p_job, JsonJobEntryT* p_entry, long long* p_parseNs)
+{
+   char jobDir[PATH_MAX];
+   long long startNs = schedNowNs();
+   bool isOk = homeJobDir(g_homeDir, p_job->jobPath, p_job->jobName, jobDir, sizeof(jobDir)) &&
+               homeReadJob(jobDir, p_entry);
+   *p_parseNs += schedNowNs() - startNs;
+   if (!isOk)
+   {
+      printf("Can not read job %s%s in %s\n", p_job->jobPath, p_job->jobName, g_homeDir);
+   }
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Get information about all jobs of a group from jenkin server, or from
+// JENKINS_HOME if it is given by --home
+// Requests are sent through persistent connection of group, so that we do not
+// need to fork curl process and do tcp handshake in every poll cycle.
+// Responses are parsed directly to state of job while they are received,
+// nothing is written to disk.
+// Only jobs whose poll time comes are fetched. Jobs are not fetched while
+// breaker of server is open, they are polled again at probe time.
+// Fetch goes on from its state in p_fetch of group when request of a job is
+// in flight, so worker does not wait for network.
+// return FETCH_WAIT if request of a job is in flight
+//        FETCH_FAILED if we can not get information of any job which is
+//        polled and server is not known to be unreachable
+//----------------------------------------------------------------------------
+FetchResultE fetchGroupInfo(GroupInfoT* p_group)
+{
+   GroupFetchT* p_fetch = p_group->p_fetch;
+   if (!p_fetch->isActive)
+   {
+      p_fetch->isActive = true;
+      p_fetch->isAnyPolled = false;
+      p_fetch->isAnyOk = false;
+      p_fetch->startNs = schedNowNs();
+      p_fetch->parseNs = 0;
+      p_fetch->p_job = p_group->p_allJobs;
+      p_fetch->jobStep = JOB_STEP_NONE;
+   }
+
+   // Jobs whose poll time comes when fetch is started are fetched
+   long long nowNs = p_fetch->startNs;
+   for (; p_fetch->p_job; p_fetch->p_job = p_fetch->p_job->p_nextJob)
+   {
+      JobInfoT* p_job = p_fetch->p_job;
+      if (p_fetch->jobStep == JOB_STEP_NONE)
+      {
+         if (p_job->poll.nextPollNs > nowNs)
+         {
+            continue;
+         }
+         p_fetch->isAnyPolled = true;
+
+         if (isTerminated())
+         {
+            p_fetch->isActive = false;
+            return FETCH_FAILED;
+         }
+
+         if (!g_homeDir && !breakerAllow(p_group->p_breaker, schedNowNs()))
+         {
+            p_job->poll.nextPollNs = breakerRetryNs(p_group->p_breaker, schedNowNs());
+            continue;
+         }
+      }
+
+      bool isFetched = false;
+      if (g_homeDir)
+      {
+         isFetched = readHomeJobEntry(p_job, &p_fetch->entry, &p_fetch->parseNs);
+      }
+      else if (fetchJobEntry(p_group, &isFetched) == HTTP_WAIT)
+      {
+         return FETCH_WAIT;
+      }
+      if (!isFetched && p_group->httpConn.isCanceled)
+      {
+         // Group is changed by reload, job keeps its poll time
+         break;
+      }
+      if (!isFetched)
+      {
+         // Try again after normal poll time, or at probe time of server
+         // which is found unreachable
+         metricsAdd(&p_group->p_metrics->poll.errorCount, 1);
+         p_job->poll.nextPollNs = isServerUnreachable(p_group) ?
+                                  breakerRetryNs(p_group->p_breaker, schedNowNs()) :
+                                  nowNs + p_group->pollPolicy.idleTime * 1000000000LL;
+         continue;
+      }
+
+      pthread_mutex_lock(&p_group->lockJobSta);
+      bool isStateChanged = assignJobState(p_job, &p_fetch->entry);
+      p_group->isJobChanged = p_group->isJobChanged || isStateChanged;
+      pthread_mutex_unlock(&p_group->lockJobSta);
+
+      // First poll is not a change
+      bool isChanged = isStateChanged && (p_job->poll.nextPollNs != 0);
+      updatePollState(&p_group->pollPolicy, &p_job->poll,
+                      p_job->state.led.isAnime, isChanged, schedNowNs());
+      p_fetch->isAnyOk = true;
+      if (g_isVerbose)
+      {
+         printf("Job %s%s is %s, poll it again after %u s\n", p_job->jobPath, p_job->jobName,
+                isChanged ? "changed" : "not changed", p_job->poll.delay);
+      }
+   }
+   p_fetch->isActive = false;
+
+   if (p_fetch->isAnyPolled)
+   {
+      metricsObserve(&p_group->p_metrics->poll.fetch, schedNowNs() - p_fetch->startNs);
+      metricsObserve(&p_group->p_metrics->poll.parse, p_fetch->parseNs);
+   }
+   if (g_isVerbose && p_fetch->isAnyPolled)
+   {
+      printf("Finish get information from jenkin server: %s\n", p_group->server.serverName);
+   }
+
+   // Group which loses its server is evaluated to show it
+   return (p_fetch->isAnyOk || !p_fetch->isAnyPolled || isServerUnreachable(p_group)) ?
+          FETCH_OK : FETCH_FAILED;
+}
+
+//----------------------------------------------------------------------------
+// Get time to poll group: the earliest poll time of its jobs, but group is
+// evaluated at least every idle time because led of group also depends on
+// current time (display_timeout, last_build_threshold)
+//----------------------------------------------------------------------------
+long long nextGroupPollNs(GroupInfoT* p_group)
+{
+   long long nextPollNs = schedNowNs() + p_group->pollPolicy.idleTime * 1000000000LL;
+   JobInfoT* p_job = NULL;
+   for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+   {
+      if (p_job->poll.nextPollNs < nextPollNs)
+      {
+         nextPollNs = p_job->poll.nextPollNs;
+      }
+   }
+   return nextPollNs;
+}
+
+//----------------------------------------------------------------------------
+// Get container path of job: path of jenkin root or folder which contains job
+//    "/job/"              -> ""
+//    "/job/folder/job/"   -> "/job/folder"
+//----------------------------------------------------------------------------
+static void containerPathOf(const char* jobPath, char* containerPath, size_t pathSize)
+{
+   size_t len = strlen(jobPath);
+   while (len && jobPath[len - 1] == '/')
+   {
+      len--;
+   }
+   if ((len >= strlen("/job")) && !strncmp(jobPath + len - strlen("/job"), "/job", strlen("/job")))
+   {
+      len -= strlen("/job");
+   }
+   else
+   {
+      printf("Job path %s does not end with /job/, use it as container path\n", jobPath);
+   }
+   if (len >= pathSize)
+   {
+      len = pathSize - 1;
+   }
+   memcpy(containerPath, jobPath, len);
+   containerPath[len] = 0;
+}
+
+//----------------------------------------------------------------------------
+// Build list of jenkin servers, groups which have the same server name will
+// share one server. Each server stores list of container paths of all its jobs
+//----------------------------------------------------------------------------
+bool buildServerList(GroupInfoT* p_headGroup, JenkinServerT** pp_headServer)
+{
+   GroupInfoT* p_group = NULL;
+   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   {
+      if (!assignGroupServer(p_group, pp_headServer))
+      {
+         return false;
+      }
+   }
+
+   JenkinServerT* p_server = NULL;
+   for (p_server = *pp_headServer; p_server; p_server = p_server->p_nextServer)
+   {
+      p_server->p_allGroups = p_headGroup;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Find jenkin server of group in list, or append new server to list, then
+// add container paths of all jobs of group to server
+// return NULL if connection to new server can not be initialized
+//----------------------------------------------------------------------------
+JenkinServerT* assignGroupServer(GroupInfoT* p_group, JenkinServerT** pp_headServer)
+{
+   JenkinServerT** pp_server = pp_headServer;
+   while (*pp_server && strcmp((*pp_server)->serverName, p_group->server.serverName))
+   {
+      pp_server = &(*pp_server)->p_nextServer;
+   }
+
+   JenkinServerT* p_server = *pp_server;
+   if (!p_server)
+   {
+      p_server = malloc(sizeof(JenkinServerT));
+      memset(p_server, 0, sizeof(JenkinServerT));
+      p_server->serverName = strdup(p_group->server.serverName);
+#if USE_ANY_AUTHORIZED_IN_HTTP
+      if (!httpConnInit(&p_server->httpConn, p_server->serverName,
+                        NULL, NULL, p_group->curlTime.maxTime * 1000))
+#else
+      if (!httpConnInit(&p_server->httpConn, p_server->serverName,
+                        p_group->server.userName, p_group->server.passWord,
+                        p_group->curlTime.maxTime * 1000))
+#endif
+      {
+         printf("Init connection to server %s fail\n", p_server->serverName);
+         free(p_server->serverName);
+         free(p_server);
+         return NULL;
+      }
+      p_server->p_breaker = p_group->p_breaker;
+      *pp_server = p_server;
+   }
+
+   if (p_server->groupCount == 0)
+   {
+      p_server->pollPolicy = p_group->pollPolicy;
+   }
+   else
+   {
+      // One query gets all jobs, so server uses the fastest policy of its groups
+      PollPolicyT* p_policy = &p_server->pollPolicy;
+      if (p_group->pollPolicy.buildingTime < p_policy->buildingTime)
+      {
+         p_policy->buildingTime = p_group->pollPolicy.buildingTime;
+      }
+      if (p_group->pollPolicy.idleTime < p_policy->idleTime)
+      {
+         p_policy->idleTime = p_group->pollPolicy.idleTime;
+      }
+      if (p_group->pollPolicy.maxIdleTime < p_policy->maxIdleTime)
+      {
+         p_policy->maxIdleTime = p_group->pollPolicy.maxIdleTime;
+      }
+   }
+   p_server->groupCount++;
+   p_group->p_jenkinServer = p_server;
+
+   JobInfoT* p_job = NULL;
+   for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+   {
+      char containerPath[1000];
+      containerPathOf(p_job->jobPath, containerPath, sizeof(containerPath));
+
+      u_int32 idx;
+      for (idx = 0; idx < p_server->containerCount; idx++)
+      {
+         if (!strcmp(p_server->containerPaths[idx], containerPath))
+         {
+            break;
+         }
+      }
+      if (idx == p_server->containerCount)
+      {
+         p_server->containerPaths = realloc(p_server->containerPaths,
+                                            (idx + 1) * sizeof(char*));
+         p_server->containerPaths[idx] = strdup(containerPath);
+         p_server->containerCount++;
+      }
+      p_job->containerIdx = idx;
+   }
+   return p_server;
+}
+
+//----------------------------------------------------------------------------
+// Forget groups and container paths of all servers, groups are assigned to
+// servers again by assignGroupServer()
+//----------------------------------------------------------------------------
+void resetServerGroups(JenkinServerT* p_headServer)
+{
+   JenkinServerT* p_server = NULL;
+   for (p_server = p_headServer; p_server; p_server = p_server->p_nextServer)
+   {
+      u_int32 idx;
+      for (idx = 0; idx < p_server->containerCount; idx++)
+      {
+         free(p_server->containerPaths[idx]);
+      }
+      free(p_server->containerPaths);
+      p_server->containerPaths = NULL;
+      p_server->containerCount = 0;
+      p_server->groupCount = 0;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Task to get information of all jobs of jenkin server, then evaluate color
+// of its groups by tasks which can run in parallel. It is run again by io
+// timer of server while request of server is in flight.
+//----------------------------------------------------------------------------
+void fetchServerTask(PoolTaskT* p_task, PoolWorkerT* p_worker)
+{
+   JenkinServerT* p_server = (JenkinServerT*)p_task->p_arg;
+   int groupCount = 0;
+
+   // Groups are evaluated without fetching if poll time of server does not come,
+   // or to show that server is unreachable
+   bool isEval = true;
+   if (p_server->fetch.isActive || (p_server->poll.nextPollNs <= schedNowNs()))
+   {
+      FetchResultE result = fetchServerInfo(p_server);
+      if (result == FETCH_WAIT)
+      {
+         // Task may run again at once, server must not be touched after it
+         waitFetch(&p_server->ioTimer, &p_server->httpConn);
+         return;
+      }
+      isEval = (result == FETCH_OK) || breakerIsOpen(p_server->p_breaker);
+   }
+   if (isEval)
+   {
+      GroupInfoT* p_group = NULL;
+      for (p_group = p_server->p_allGroups; p_group; p_group = p_group->p_nextGroup)
+      {
+         if (p_group->p_jenkinServer == p_server)
+         {
+            groupCount++;
+         }
+      }
+   }
+
+   if (groupCount == 0)
+   {
+      schedPost(&g_pollSched, &p_server->pollTimer, nextServerPollNs(p_server));
+      return;
+   }
+
+   // Count must be set before any evaluate task can finish
+   p_server->pendingEvalCount = groupCount;
+   GroupInfoT* p_group = NULL;
+   for (p_group = p_server->p_allGroups; p_group; p_group = p_group->p_nextGroup)
+   {
+      if (p_group->p_jenkinServer == p_server)
+      {
+         poolSpawn(p_worker, &p_group->evalTask);
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Task to evaluate color of group in aggregate mode, the last one of server
+// polls server again at its poll time
+//----------------------------------------------------------------------------
+void evalServerGroupTask(PoolTaskT* p_task, PoolWorkerT* p_worker)
+{
+   GroupInfoT* p_group = (GroupInfoT*)p_task->p_arg;
+   JenkinServerT* p_server = p_group->p_jenkinServer;
+   evaluateColor(p_group);
+   if (__sync_sub_and_fetch(&p_server->pendingEvalCount, 1) == 0)
+   {
+      schedPost(&g_pollSched, &p_server->pollTimer, nextServerPollNs(p_server));
+   }
+}
+
+//----------------------------------------------------------------------------
+// Get time to poll server, its groups are evaluated at least every idle time
+//----------------------------------------------------------------------------
+long long nextServerPollNs(JenkinServerT* p_server)
+{
+   long long nextPollNs = schedNowNs() + p_server->pollPolicy.idleTime * 1000000000LL;
+   return (p_server->poll.nextPollNs < nextPollNs) ? p_server->poll.nextPollNs : nextPollNs;
+}
+
+//----------------------------------------------------------------------------
+// Get build result from result string of jenkin
+//----------------------------------------------------------------------------
+BuildResultE convert2BuildResult(const char* resultStr)
+{
+   if (!strcmp(resultStr, "SUCCESS"))
+   {
+      return SUCCESS_RESULT;
+   }
+   else if (!strcmp(resultStr, "UNSTABLE"))
+   {
+      return UNSTABLE_RESULT;
+   }
+   else if (!strcmp(resultStr, "FAILURE"))
+   {
+      return FAILURE_RESULT;
+   }
+   else if (!strcmp(resultStr, "NOT_BUILT"))
+   {
+      return NOT_BUILT_RESULT;
+   }
+   else if (!strcmp(resultStr, "ABORTED"))
+   {
+      return ABORTED_RESULT;
+   }
+   return NO_RESULT;
+}
+
+//----------------------------------------------------------------------------
+// Spread information of one job in aggregated response to all JobInfoT which
+// monitor this job in all groups of server. Jobs are found by hash index of
+// job names, so cost of a response does not grow with monitored jobs.
+//----------------------------------------------------------------------------
+static void spreadJobEntry(void* p_arg, const JsonJobEntryT* p_entry)
+{
+   SpreadJobArgT* p_spreadArg = (SpreadJobArgT*)p_arg;
+   JobIndexT* p_index = &g_jobIndex;
+
+   pthread_mutex_lock(&g_jobIndexLock);
+   u_int32 hash = hashJobName(p_entry->name);
+   u_int32 idx;
+   for (idx = hash & (p_index->size - 1); p_index->p_entries[idx].p_job;
+        idx = (idx + 1) & (p_index->size - 1))
+   {
+      JobIndexEntryT* p_indexEntry = &p_index->p_entries[idx];
+      JobInfoT* p_job = p_indexEntry->p_job;
+      GroupInfoT* p_group = p_indexEntry->p_group;
+      if ((p_indexEntry->hash != hash) || (p_group->p_jenkinServer != p_spreadArg->p_server) ||
+          (p_job->containerIdx != p_spreadArg->containerIdx) ||
+          strcmp(p_job->jobName, p_entry->name))
+      {
+         continue;
+      }
+      pthread_mutex_lock(&p_group->lockJobSta);
+      if (assignJobState(p_job, p_entry))
+      {
+         p_group->isJobChanged = true;
+         p_spreadArg->isAnyChanged = true;
+      }
+      pthread_mutex_unlock(&p_group->lockJobSta);
+      if (p_job->state.led.isAnime)
+      {
+         p_spreadArg->isAnyBuilding = true;
+      }
+   }
+   pthread_mutex_unlock(&g_jobIndexLock);
+}
+
+//----------------------------------------------------------------------------
+// Get information of all jobs in jenkin server by one query for each container
+// then spread it to all jobs of all groups of this server while response is
+// received
+// Fetch goes on from its state in fetch of server when request of a container
+// is in flight, so worker does not wait for network.
+// return FETCH_WAIT if request of a container is in flight
+//        FETCH_OK if we get information from at least one container
+//----------------------------------------------------------------------------
+FetchResultE fetchServerInfo(JenkinServerT* p_server)
+{
+   char path[1100];
+   GroupInfoT* p_group = NULL;
+   JobInfoT* p_job = NULL;
+   ServerFetchT* p_fetch = &p_server->fetch;
+
+   if (!p_fetch->isActive)
+   {
+      for (p_group = p_server->p_allGroups; p_group; p_group = p_group->p_nextGroup)
+      {
+         if (p_group->p_jenkinServer == p_server)
+         {
+            pthread_mutex_lock(&p_group->lockJobSta);
+            for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+            {
+               p_job->state.isUpdated = false;
+            }
+            pthread_mutex_unlock(&p_group->lockJobSta);
+         }
+      }
+
+      // Only jobs of containers which are fetched can be found missing
+      p_fetch->isFetched = calloc(p_server->containerCount ? p_server->containerCount : 1,
+                                  sizeof(bool));
+      p_fetch->spreadArg.p_server = p_server;
+      p_fetch->spreadArg.isAnyChanged = false;
+      p_fetch->spreadArg.isAnyBuilding = false;
+      p_fetch->containerIdx = 0;
+      p_fetch->isAnyOk = false;
+      p_fetch->startNs = schedNowNs();
+      p_fetch->parseNs = 0;
+      p_fetch->isActive = true;
+   }
+
+   for (; p_fetch->containerIdx < p_server->containerCount; p_fetch->containerIdx++)
+   {
+      u_int32 idx = p_fetch->containerIdx;
+      if (!p_fetch->request.isInFlight)
+      {
+         snprintf(path, sizeof(path),
+                  "%s/api/json?tree=jobs[name,color,lastBuild[number,timestamp,result]]",
+                  p_server->containerPaths[idx]);
+
+         if (!breakerAllow(p_server->p_breaker, schedNowNs()))
+         {
+            break;
+         }
+         p_fetch->spreadArg.containerIdx = idx;
+         jsonExtractorInit(&p_fetch->request.extractor, spreadJobEntry, &p_fetch->spreadArg);
+      }
+      bool isOk = false;
+      if (fetchJson(&p_server->httpConn, p_server->p_breaker, path, &p_fetch->request,
+                    &p_server->metrics, &p_fetch->parseNs, &isOk) == HTTP_WAIT)
+      {
+         return FETCH_WAIT;
+      }
+      if (isOk && jsonExtractorFinish(&p_fetch->request.extractor))
+      {
+         p_fetch->isAnyOk = true;
+         if (p_fetch->isFetched)
+         {
+            p_fetch->isFetched[idx] = true;
+         }
+      }
+      else if (p_server->httpConn.isCanceled)
+      {
+         break;
+      }
+      else
+      {
+         metricsAdd(&p_server->metrics.errorCount, 1);
+      }
+   }
+   p_fetch->isActive = false;
+   bool* isFetched = p_fetch->isFetched;
+   p_fetch->isFetched = NULL;
+
+   // Server is changed by reload, it keeps its poll time
+   if (p_server->httpConn.isCanceled)
+   {
+      free(isFetched);
+      return FETCH_FAILED;
+   }
+
+   // Job which is not in response of its container may be deleted or renamed
+   // in jenkin server, job of container which is not fetched keeps its state
+   for (p_group = p_server->p_allGroups; isFetched && p_group; p_group = p_group->p_nextGroup)
+   {
+      if (p_group->p_jenkinServer != p_server)
+      {
+         continue;
+      }
+      pthread_mutex_lock(&p_group->lockJobSta);
+      for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+      {
+         if (!isFetched[p_job->containerIdx] || p_job->state.isUpdated ||
+             ((p_job->state.led.color == NON_COLOR) && !p_job->state.led.isAnime))
+         {
+            continue;
+         }
+         printf("Job %s%s is not found in server %s\n",
+                p_job->jobPath, p_job->jobName, p_server->serverName);
+         p_job->state.led.color = NON_COLOR;
+         p_job->state.led.isAnime = false;
+         logJobHistory(p_job);
+
+         // Led must not keep old color of job until next timed evaluation
+         p_group->isJobChanged = true;
+         p_fetch->spreadArg.isAnyChanged = true;
+      }
+      pthread_mutex_unlock(&p_group->lockJobSta);
+   }
+   free(isFetched);
+
+   // Server is polled by policy as one big job
+   long long nowNs = schedNowNs();
+   metricsObserve(&p_server->metrics.fetch, nowNs - p_fetch->startNs);
+   metricsObserve(&p_server->metrics.parse, p_fetch->parseNs);
+   if (p_fetch->isAnyOk)
+   {
+      // First poll is not a change
+      updatePollState(&p_server->pollPolicy, &p_server->poll, p_fetch->spreadArg.isAnyBuilding,
+                      p_fetch->spreadArg.isAnyChanged && (p_server->poll.nextPollNs != 0), nowNs);
+   }
+   else if (breakerIsOpen(p_server->p_breaker))
+   {
+      p_server->poll.nextPollNs = breakerRetryNs(p_server->p_breaker, nowNs);
+   }
+   else
+   {
+      p_server->poll.nextPollNs = nowNs + p_server->pollPolicy.idleTime * 1000000000LL;
+   }
+
+   if (g_isVerbose)
+   {
+      printf("Finish get information from jenkin server: %s, poll it again after %lld ms\n",
+             p_server->serverName, (p_server->poll.nextPollNs - nowNs) / 1000000);
+   }
+   return p_fetch->isAnyOk ? FETCH_OK : FETCH_FAILED;
+}
+
+//----------------------------------------------------------------------------
+// Evaluate Color for group
+//----------------------------------------------------------------------------
+void evaluateColor(GroupInfoT* p_group)
+{
+   // Nothing to do if no job is changed and no time deadline is passed,
+   // led status would be evaluated to the same value
+   // Group is evaluated by workers and hook listener
+   pthread_mutex_lock(&p_group->lockJobSta);
+   long long startNs = schedNowNs();
+   int64 curTime = currentTimeStamp();
+   if (!p_group->isJobChanged && (curTime < p_group->nextEvalTimeStamp) &&
+       (isServerUnreachable(p_group) == p_group->curSta.isUnreachable))
+   {
+      p_group->skipEvalCount++;
+      pthread_mutex_unlock(&p_group->lockJobSta);
+      if (g_isVerbose)
+      {
+         printf("Group %s is not changed, skip evaluation\n", p_group->groupName);
+      }
+      return;
+   }
+   p_group->isJobChanged = false;
+   p_group->evalCount++;
+
+   // evaluate Group Status base on state of all jobs which is got from
+   // jenkin server
+   evalGroupStatus(p_group);
+
+   // evaluate Led status base on Current Group Status information and
+   // last group Status information
+   evalLedStatus(p_group);
+   logGroupHistory(p_group);
+
+   p_group->nextEvalTimeStamp = nextEvalTimeStamp(p_group, curTime);
+   metricsObserve(&p_group->p_metrics->eval, schedNowNs() - startNs);
+
+   if (g_isVerbose)
+   {
+      char str[100];
+      char colorStr[20];
+
+      convert2ColorStr(loadGrpLedStatus(p_group), colorStr, 20);
+
+      snprintf(str, 100, "%s%s - %s - %s- %s",
+               (p_group->curSta.isUnreachable) ? "Unreachable - " : "",
+               (p_group->curSta.isAllDisable) ?  "Disable"   : " ",
+               (p_group->curSta.isThreshold)  ?  "Threshold" : " ",
+               (p_group->curSta.isBuilding)   ?  "Building"  : "Not building ",
+               (p_group->curSta.isSuccess)    ?  "Success"   : "False ");
+
+      printf("\nGroup %s\ngroup status:%s; led status: %s\n\n",
+             p_group->groupName, str, colorStr);
+
+   }
+   pthread_mutex_unlock(&p_group->lockJobSta);
+}
+
+//----------------------------------------------------------------------------
+// Get time when led of group may change although no job is changed: a job
+// passes last_build_threshold, or success led passes display_timeout
+//----------------------------------------------------------------------------
+int64 nextEvalTimeStamp(GroupInfoT* p_group, int64 curTime)
+{
+   int64 nextTime = LLONG_MAX;
+   JobInfoT* p_job = NULL;
+   for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+   {
+      if (!isJobDisabled(p_group, p_job))
+      {
+         // Job which passed threshold already stays there until it is changed
+         int64 thresholdTime = p_job->state.lastBuildTimeStamp +
+                               (int64)p_group->lastBuildThreshold + 1;
+         if ((thresholdTime > curTime) && (thresholdTime < nextTime))
+         {
+            nextTime = thresholdTime;
+         }
+      }
+   }
+
+   if (p_group->needToCheckTimeStamp)
+   {
+      int64 timeoutTime = p_group->lastSuccessTimeStamp +
+                          (int64)p_group->displaySuccessTimeout + 1;
+      if (timeoutTime < nextTime)
+      {
+         nextTime = timeoutTime;
+      }
+   }
+   return nextTime;
+}
+
+//----------------------------------------------------------------------------
+// Print how many times each group is evaluated or skipped because nothing
+// is changed
+//----------------------------------------------------------------------------
+void printEvalCount(GroupInfoT* p_headGroup)
+{
+   u_int64 evalCount = 0;
+   u_int64 skipEvalCount = 0;
+   GroupInfoT* p_group = NULL;
+   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   {
+      if (g_isVerbose)
+      {
+         printf("Group %s: evaluated %llu, skipped %llu\n", p_group->groupName,
+                p_group->evalCount, p_group->skipEvalCount);
+      }
+      evalCount += p_group->evalCount;
+      skipEvalCount += p_group->skipEvalCount;
+   }
+   printf("All groups: evaluated %llu, skipped %llu\n", evalCount, skipEvalCount);
+}
+
+//----------------------------------------------------------------------------
+// Check that job is not counted in group status by rules of group
+//----------------------------------------------------------------------------
+bool isJobDisabled(const GroupInfoT* p_group, const JobInfoT* p_job)
+{
+   return (p_group->rule.disableColors & COLOR_BIT(p_job->state.led.color)) != 0;
+}
+
+//----------------------------------------------------------------------------
+// Check that count of jobs reaches quorum (in percent) of counted jobs,
+// quorum 0 means at least one job
+//----------------------------------------------------------------------------
+static bool isQuorum(u_int32 count, u_int32 jobCount, u_int8 quorum)
+{
+   return (count > 0) && (count * 100 >= (u_int32)quorum * jobCount);
+}
+
+//----------------------------------------------------------------------------
+// evaluate Group Status
+//----------------------------------------------------------------------------
+void evalGroupStatus(GroupInfoT* p_group)
+{
+   p_group->preSta = p_group->curSta;
+   u_int32 jobCount = 0;
+   u_int32 successCount = 0;
+   u_int32 buildingCount = 0;
+   u_int32 thresholdCount = 0;
+   int64 curTime = currentTimeStamp();
+   JobInfoT* p_job = NULL;
+
+   for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+   {
+      LedInfoT jobLedInfo = p_job->state.led;
+      if (g_isVerbose)
+      {
+         char colorStr[20];
+         convert2ColorStr(jobLedInfo, colorStr, 20);
+         printf("Job %s: color %s, last build timestamp %lld\n",
+                p_job->jobName, colorStr, p_job->state.lastBuildTimeStamp);
+      }
+      if (isJobDisabled(p_group, p_job))
+      {
+         continue;
+      }
+      jobCount++;
+      if (p_group->rule.successColors & COLOR_BIT(jobLedInfo.color))
+      {
+         successCount++;
+      }
+      if (jobLedInfo.isAnime)
+      {
+         buildingCount++;
+      }
+      if ((curTime - p_job->state.lastBuildTimeStamp) > (int64)p_group->lastBuildThreshold)
+      {
+         thresholdCount++;
+      }
+   }
+
+   p_group->curSta.isAllDisable = (jobCount == 0);
+   p_group->curSta.isSuccess = isQuorum(successCount, jobCount, p_group->rule.successQuorum);
+   p_group->curSta.isBuilding = isQuorum(buildingCount, jobCount, p_group->rule.buildingQuorum);
+   p_group->curSta.isThreshold = isQuorum(thresholdCount, jobCount,
+                                          p_group->rule.thresholdQuorum);
+   p_group->curSta.isUnreachable = isServerUnreachable(p_group);
+}
+
+//----------------------------------------------------------------------------
+// Check that breaker of server of group is open, so that states of its jobs
+// are not known now. Jobs which are read from JENKINS_HOME are always known.
+//----------------------------------------------------------------------------
+bool isServerUnreachable(const GroupInfoT* p_group)
+{
+   return !g_homeDir && p_group->p_breaker && breakerIsOpen(p_group->p_breaker);
+}
+
+//----------------------------------------------------------------------------
+// Pack group status into index of led table
+//----------------------------------------------------------------------------
+u_int32 packGroupStatus(const GroupStatusT* p_status)
+{
+   return (p_status->isAllDisable     ? GROUP_STA_ALL_DISABLE     : 0) |
+          (p_status->isBuilding       ? GROUP_STA_BUILDING        : 0) |
+          (p_status->isSuccess        ? GROUP_STA_SUCCESS         : 0) |
+          (p_status->isThreshold      ? GROUP_STA_THRESHOLD       : 0) |
+          (p_status->isSuccessTimeout ? GROUP_STA_SUCCESS_TIMEOUT : 0) |
+          (p_status->isUnreachable    ? GROUP_STA_UNREACHABLE     : 0);
+}
+
+//----------------------------------------------------------------------------
+// assign Group's Led Status
+//----------------------------------------------------------------------------
+void assignGrpLedStatus(GroupInfoT* p_group, LedInfoT ledInfo)
+{
+   u_int32 ledWord = packLedInfo(ledInfo);
+   bool isChanged = (__atomic_exchange_n(&p_group->ledWord, ledWord, __ATOMIC_SEQ_CST) != ledWord);
+
+   // Only wake led thread up when there is something to show, time of the
+   // first change which is not shown yet is kept for metrics
+   if (isChanged)
+   {
+      long long noChangeNs = 0;
+      __atomic_compare_exchange_n(&p_group->ledChangedNs, &noChangeNs, schedNowNs(), false,
+                                  __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+      pushChangedLedGroup(p_group);
+      schedWake(&g_ledSched);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Pack led status to one word, so that it is published by one atomic store
+//----------------------------------------------------------------------------
+u_int32 packLedInfo(LedInfoT ledInfo)
+{
+   return (u_int32)ledInfo.color | (ledInfo.isAnime ? 0x100 : 0);
+}
+
+//----------------------------------------------------------------------------
+// Unpack led status from word which is packed by packLedInfo()
+//----------------------------------------------------------------------------
+LedInfoT unpackLedInfo(u_int32 ledWord)
+{
+   LedInfoT ledInfo;
+   ledInfo.color = (ColorE)(ledWord & 0xFF);
+   ledInfo.isAnime = (ledWord & 0x100) != 0;
+   return ledInfo;
+}
+
+//----------------------------------------------------------------------------
+// Get led status of group which is published by assignGrpLedStatus()
+//----------------------------------------------------------------------------
+LedInfoT loadGrpLedStatus(GroupInfoT* p_group)
+{
+   return unpackLedInfo(__atomic_load_n(&p_group->ledWord, __ATOMIC_SEQ_CST));
+}
+
+//----------------------------------------------------------------------------
+// Put group to list of groups whose led status is changed
+// List is a lock-free stack: a group is pushed only by the thread which
+// marks it, the led thread takes the whole stack at once
+//----------------------------------------------------------------------------
+void pushChangedLedGroup(GroupInfoT* p_group)
+{
+   if (__atomic_exchange_n(&p_group->isLedChanged, true, __ATOMIC_SEQ_CST))
+   {
+      // Group is in list already, led thread will read its new status
+      return;
+   }
+   GroupInfoT* p_headGroup = __atomic_load_n(&g_changedLedGroups, __ATOMIC_SEQ_CST);
+   do
+   {
+      p_group->p_nextChangedGroup = p_headGroup;
+   } while (!__atomic_compare_exchange_n(&g_changedLedGroups, &p_headGroup, p_group, true,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+}
+
+//----------------------------------------------------------------------------
+// Take all groups whose led status is changed
+// Note: groups are kept marked until they are walked by nextChangedLedGroup()
+//----------------------------------------------------------------------------
+GroupInfoT* takeChangedLedGroups(void)
+{
+   return __atomic_exchange_n(&g_changedLedGroups, NULL, __ATOMIC_SEQ_CST);
+}
+
+//----------------------------------------------------------------------------
+// Walk to next changed group, group can be pushed again after this call, so
+// its next pointer is read before it is unmarked
+//----------------------------------------------------------------------------
+GroupInfoT* nextChangedLedGroup(GroupInfoT* p_group)
+{
+   GroupInfoT* p_nextGroup = p_group->p_nextChangedGroup;
+   __atomic_store_n(&p_group->isLedChanged, false, __ATOMIC_SEQ_CST);
+   return p_nextGroup;
+}
+
+//----------------------------------------------------------------------------
+// Evaluate Group's Led Status: led of group status is read from led table,
+// only time of success is tracked here
+//----------------------------------------------------------------------------
+void evalLedStatus(GroupInfoT* p_group)
+{
+   GroupStatusT* p_curSta = &p_group->curSta;
+   GroupStatusT* p_preSta = &p_group->preSta;
+   p_curSta->isSuccessTimeout = false;
+   if (!p_curSta->isAllDisable && !p_curSta->isBuilding &&
+       p_curSta->isSuccess && !p_curSta->isThreshold)
+   {
+      if (p_preSta->isAllDisable || p_preSta->isBuilding ||
+          !p_preSta->isSuccess || p_preSta->isThreshold)
+      {
+         //First time full success occur -> Store timestamp
+         p_group->lastSuccessTimeStamp = currentTimeStamp();
+         p_group->needToCheckTimeStamp = true;
+      }
+      else if (p_group->needToCheckTimeStamp)
+      {
+         //Check timestamp to turn off Led
+         int64 curTime = currentTimeStamp();
+         if ((curTime - p_group->lastSuccessTimeStamp) >
+             (int64)p_group->displaySuccessTimeout)
+         {
+            // LED is turned off -> don't need to check timestamp anymore
+            p_group->needToCheckTimeStamp = false;
+         }
+      }
+      p_curSta->isSuccessTimeout = !p_group->needToCheckTimeStamp;
+   }
+   assignGrpLedStatus(p_group, p_group->ledTable[packGroupStatus(p_curSta)]);
+}
+
+//----------------------------------------------------------------------------
+// Build one thread to control led of all groups
+//----------------------------------------------------------------------------
+bool buildCtrlLedThread(GroupInfoT* p_headGroup)
+{
+   if (!schedInit(&g_ledSched))
+   {
+      return false;
+   }
+
+   // All groups are shown at the first loop of led thread
+   GroupInfoT* p_group = NULL;
+   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   {
+      schedTimerInit(&p_group->blinkTimer, p_group);
+      redrawGrpLed(p_group);
+   }
+   g_isLedThreadStarted = true;
+   if (pthread_create(&g_ctrlLedThread, NULL, ctrlAllLedPoll, p_headGroup))
+   {
+      g_isLedThreadStarted = false;
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Forget led status that is shown by group, so that led thread shows it again
+//----------------------------------------------------------------------------
+void redrawGrpLed(GroupInfoT* p_group)
+{
+   p_group->isLedRedraw = true;
+   p_group->gpioSta = ON;
+   pushChangedLedGroup(p_group);
+}
+
+//----------------------------------------------------------------------------
+// Park led thread at start of its next loop, return when it is parked (or
+// stopped), so that caller can change groups, gpio and led scheduler
+//----------------------------------------------------------------------------
+void pauseLedThread(void)
+{
+   pthread_mutex_lock(&g_ledPauseLock);
+   g_isLedPauseRequested = true;
+   schedWake(&g_ledSched);
+   while (!g_isLedPaused && g_isLedThreadStarted)
+   {
+      pthread_cond_wait(&g_ledPauseCond, &g_ledPauseLock);
+   }
+   pthread_mutex_unlock(&g_ledPauseLock);
+}
+
+//----------------------------------------------------------------------------
+// Let led thread which is parked by pauseLedThread() go on
+//----------------------------------------------------------------------------
+void resumeLedThread(void)
+{
+   pthread_mutex_lock(&g_ledPauseLock);
+   g_isLedPauseRequested = false;
+   pthread_cond_broadcast(&g_ledPauseCond);
+   pthread_mutex_unlock(&g_ledPauseLock);
+   schedWake(&g_ledSched);
+}
+
+//----------------------------------------------------------------------------
+// Park led thread while pause is requested, called by led thread only
+//----------------------------------------------------------------------------
+static void parkLedThread(void)
+{
+   pthread_mutex_lock(&g_ledPauseLock);
+   if (g_isLedPauseRequested)
+   {
+      g_isLedPaused = true;
+      pthread_cond_broadcast(&g_ledPauseCond);
+      while (g_isLedPauseRequested)
+      {
+         pthread_cond_wait(&g_ledPauseCond, &g_ledPauseLock);
+      }
+      g_isLedPaused = false;
+   }
+   pthread_mutex_unlock(&g_ledPauseLock);
+}
+
+//----------------------------------------------------------------------------
+// Poll to control led of all groups
+// Animated leds are toggled on a shared tick of g_ledAnimeTime: led is on at
+// even ticks and off at odd ticks, so that all animated leds blink at the
+// same time. Only animated groups are put into deadline queue, the thread
+// wakes up one time per tick whatever number of groups is, and does not wake
+// up at all if no led is animated by us and no led status is changed.
+// Each loop builds one frame, then frame is written to gpio at once.
+//----------------------------------------------------------------------------
+void* ctrlAllLedPoll(void *arg)
+{
+   long long tickNs = g_ledAnimeTime * 1000000000LL;
+   long long epochNs = schedNowNs();
+
+   while (1)
+   {
+      if (isTerminated())
+      {
+         break;
+      }
+      parkLedThread();
+
+      long long nowNs = schedNowNs();
+      long long tickIdx = (nowNs - epochNs) / tickNs;
+      GpioStatusE tickSta = (tickIdx % 2) ? OF : ON;
+      long long nextTickNs = epochNs + (tickIdx + 1) * tickNs;
+
+      // Toggle animated leds
+      SchedTimerT* p_timer = NULL;
+      while ((p_timer = schedPopExpired(&g_ledSched, nowNs)))
+      {
+         GroupInfoT* p_group = (GroupInfoT*)p_timer->p_arg;
+         p_group->gpioSta = tickSta;
+         ledCtrl(p_group->preLedSta.color, p_group->gpioSta, p_group->gpio,
+                 p_group->rule.colorLevels, p_group->groupName);
+         schedAdd(&g_ledSched, p_timer, nextTickNs);
+      }
+
+      // Show new led status
+      GroupInfoT* p_group = takeChangedLedGroups();
+      while (p_group)
+      {
+         GroupInfoT* p_changedGroup = p_group;
+         p_group = nextChangedLedGroup(p_changedGroup);
+         ctrlGrpLedFrame(p_changedGroup, tickSta, nextTickNs);
+      }
+
+      // Pwm thread owns gpio when it is used
+      if (g_isCtrlRealLed && !g_pwmHz)
+      {
+         gpioCommit();
+      }
+
+      if (!schedWait(&g_ledSched))
+      {
+         exitNow();
+      }
+   }
+
+   // Nobody waits for a thread which is stopped
+   pthread_mutex_lock(&g_ledPauseLock);
+   g_isLedThreadStarted = false;
+   pthread_cond_broadcast(&g_ledPauseCond);
+   pthread_mutex_unlock(&g_ledPauseLock);
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Put changed led of group to current frame
+//----------------------------------------------------------------------------
+void ctrlGrpLedFrame(GroupInfoT* p_group, GpioStatusE tickSta, long long nextTickNs)
+{
+   LedInfoT curLedSta = loadGrpLedStatus(p_group);
+   long long changedNs = __atomic_exchange_n(&p_group->ledChangedNs, 0, __ATOMIC_SEQ_CST);
+   if (changedNs)
+   {
+      metricsObserve(&p_group->p_metrics->led, schedNowNs() - changedNs);
+   }
+
+   // Status may be changed back before led thread takes it
+   if (!p_group->isLedRedraw &&
+       (p_group->preLedSta.color == curLedSta.color) &&
+       (p_group->preLedSta.isAnime == curLedSta.isAnime))
+   {
+      return;
+   }
+
+   if (curLedSta.isAnime && !ledCanBlink())
+   {
+      // Led is toggled by us on shared tick
+      p_group->gpioSta = tickSta;
+      schedAdd(&g_ledSched, &p_group->blinkTimer, nextTickNs);
+   }
+   else
+   {
+      // Hand blinking off to gpio driver (or pwm) if it can blink led by itself,
+      // then led is written only when its status is changed
+      p_group->gpioSta = curLedSta.isAnime ? BL : ON;
+      schedRemove(&g_ledSched, &p_group->blinkTimer);
+   }
+   ledCtrl(curLedSta.color, p_group->gpioSta, p_group->gpio,
+           p_group->rule.colorLevels, p_group->groupName);
+   p_group->preLedSta = curLedSta;
+   p_group->isLedRedraw = false;
+}
+
+//----------------------------------------------------------------------------
+// Hash of job name (FNV-1a)
+//----------------------------------------------------------------------------
+u_int32 hashJobName(const char* jobName)
+{
+   u_int32 hash = 2166136261u;
+   while (*jobName)
+   {
+      hash ^= (unsigned char)*jobName++;
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+//----------------------------------------------------------------------------
+// Check that jobs are found by index: build notifications, changes of
+// JENKINS_HOME and entries of aggregated response come with name of job
+//----------------------------------------------------------------------------
+static bool hasJobIndex(void)
+{
+   return g_hookAddr || g_homeDir || g_isAggregate;
+}
+
+//----------------------------------------------------------------------------
+// Build hash index of all jobs of all groups, index is kept at most half
+// full so that probe sequences are short
+//----------------------------------------------------------------------------
+bool buildJobIndex(GroupInfoT* p_headGroup, JobIndexT* p_index)
+{
+   u_int32 jobCount = 0;
+   GroupInfoT* p_group = NULL;
+   JobInfoT* p_job = NULL;
+   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   {
+      for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+      {
+         jobCount++;
+      }
+   }
+
+   u_int32 size = 16;
+   while (size < jobCount * 2)
+   {
+      size *= 2;
+   }
+   if (!resizeJobIndex(p_index, size))
+   {
+      return false;
+   }
+
+   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   {
+      for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+      {
+         if (!jobIndexAdd(p_index, p_job, p_group))
+         {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Move all entries of index to new table of given size
+//----------------------------------------------------------------------------
+bool resizeJobIndex(JobIndexT* p_index, u_int32 size)
+{
+   JobIndexEntryT* p_entries = calloc(size, sizeof(JobIndexEntryT));
+   if (!p_entries)
+   {
+      return false;
+   }
+   u_int32 idx;
+   for (idx = 0; idx < p_index->size; idx++)
+   {
+      JobIndexEntryT* p_entry = &p_index->p_entries[idx];
+      if (p_entry->p_job)
+      {
+         u_int32 newIdx = p_entry->hash & (size - 1);
+         while (p_entries[newIdx].p_job)
+         {
+            newIdx = (newIdx + 1) & (size - 1);
+         }
+         p_entries[newIdx] = *p_entry;
+      }
+   }
+   free(p_index->p_entries);
+   p_index->p_entries = p_entries;
+   p_index->size = size;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Add job of group to index, index is grown when it is half full
+//----------------------------------------------------------------------------
+bool jobIndexAdd(JobIndexT* p_index, JobInfoT* p_job, GroupInfoT* p_group)
+{
+   if (((p_index->count + 1) * 2 > p_index->size) &&
+       !resizeJobIndex(p_index, p_index->size ? p_index->size * 2 : 16))
+   {
+      return false;
+   }
+   u_int32 hash = hashJobName(p_job->jobName);
+   u_int32 idx = hash & (p_index->size - 1);
+   while (p_index->p_entries[idx].p_job)
+   {
+      idx = (idx + 1) & (p_index->size - 1);
+   }
+   p_index->p_entries[idx].hash = hash;
+   p_index->p_entries[idx].p_job = p_job;
+   p_index->p_entries[idx].p_group = p_group;
+   p_index->count++;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Put new job in place of job which monitors the same jenkins job, e.g. job
+// which is moved to arena of reloaded config
+//----------------------------------------------------------------------------
+void jobIndexReplace(JobIndexT* p_index, JobInfoT* p_job, JobInfoT* p_newJob)
+{
+   if (!p_index->size)
+   {
+      return;
+   }
+   u_int32 mask = p_index->size - 1;
+   u_int32 idx;
+   for (idx = hashJobName(p_job->jobName) & mask; p_index->p_entries[idx].p_job;
+        idx = (idx + 1) & mask)
+   {
+      if (p_index->p_entries[idx].p_job == p_job)
+      {
+         p_index->p_entries[idx].p_job = p_newJob;
+         return;
+      }
+   }
+}
+
+//----------------------------------------------------------------------------
+// Remove job from index
+// Entries after the hole are shifted back if the hole is on their probe
+// sequence, so that lookup can still stop at the first empty slot
+//----------------------------------------------------------------------------
+void jobIndexRemove(JobIndexT* p_index, JobInfoT* p_job)
+{
+   if (!p_index->size)
+   {
+      return;
+   }
+   u_int32 mask = p_index->size - 1;
+   u_int32 hole = hashJobName(p_job->jobName) & mask;
+   while (p_index->p_entries[hole].p_job != p_job)
+   {
+      if (!p_index->p_entries[hole].p_job)
+      {
+         return;
+      }
+      hole = (hole + 1) & mask;
+   }
+
+   u_int32 idx = hole;
+   while (1)
+   {
+      idx = (idx + 1) & mask;
+      JobIndexEntryT* p_entry = &p_index->p_entries[idx];
+      if (!p_entry->p_job)
+      {
+         break;
+      }
+      // Entry can fill the hole if its home slot is not between hole and it
+      u_int32 home = p_entry->hash & mask;
+      if (((idx - home) & mask) >= ((idx - hole) & mask))
+      {
+         p_index->p_entries[hole] = *p_entry;
+         hole = idx;
+      }
+   }
+   p_index->p_entries[hole].p_job = NULL;
+   p_index->count--;
+}
+
+//----------------------------------------------------------------------------
+// Free hash index of jobs, jobs are not touched
+//----------------------------------------------------------------------------
+void freeJobIndex(JobIndexT* p_index)
+{
+   free(p_index->p_entries);
+   p_index->p_entries = NULL;
+   p_index->size = 0;
+   p_index->count = 0;
+}
+
+//----------------------------------------------------------------------------
+// Assign build notification to job state
+// Phase STARTED: job is building, color of last build is kept as jenkins does
+// Phase COMPLETED, FINALIZED: job shows status of finished build
+// return true if state of job is changed
+//----------------------------------------------------------------------------
+bool assignJobEvent(JobInfoT* p_job, const JsonJobEntryT* p_entry)
+{
+   JobStateT preState = p_job->state;
+   if (p_entry->number)
+   {
+      p_job->state.lastBuildNumber = p_entry->number;
+   }
+   if (!strcmp(p_entry->phase, "STARTED"))
+   {
+      p_job->state.led.isAnime = true;
+      p_job->state.lastBuildResult = NO_RESULT;
+      p_job->state.lastBuildTimeStamp = p_entry->timestamp ?
+                                        p_entry->timestamp / 1000 : currentTimeStamp();
+   }
+   else if (p_entry->result[0])
+   {
+      p_job->state.lastBuildResult = convert2BuildResult(p_entry->result);
+      switch (p_job->state.lastBuildResult)
+      {
+         case SUCCESS_RESULT:    p_job->state.led.color = BLU_COLOR; break;
+         case UNSTABLE_RESULT:   p_job->state.led.color = YEL_COLOR; break;
+         case FAILURE_RESULT:    p_job->state.led.color = RED_COLOR; break;
+         case NOT_BUILT_RESULT:  p_job->state.led.color = NO_BUILT;  break;
+         default:                p_job->state.led.color = NON_COLOR; break;
+      }
+      p_job->state.led.isAnime = false;
+
+      // Timestamp of build is its start time
+      if (p_entry->timestamp)
+      {
+         p_job->state.lastBuildTimeStamp = p_entry->timestamp / 1000;
+      }
+      else if (!preState.led.isAnime)
+      {
+         p_job->state.lastBuildTimeStamp = currentTimeStamp();
+      }
+   }
+   bool isChanged = isJobStateChanged(&preState, &p_job->state);
+   if (isChanged)
+   {
+      logJobHistory(p_job);
+   }
+   return isChanged;
+}
+
+//----------------------------------------------------------------------------
+// Get container path of notified job from path of its url, the path is
+// decoded (%XX) and cut before last "/job/<name>":
+//    "/job/folder/job/name/"          -> "/job/folder"
+//    "/jenkins/job/name/5/"           -> "/jenkins"
+// return false if path does not have name of job
+//----------------------------------------------------------------------------
+static bool hookContainerOf(const char* urlPath, const char* name,
+                            char* containerPath, size_t pathSize)
+{
+   char path[1000];
+   size_t len = 0;
+   while (*urlPath && (len < sizeof(path) - 1))
+   {
+      unsigned int ch;
+      if ((urlPath[0] == '%') && isxdigit((unsigned char)urlPath[1]) &&
+          isxdigit((unsigned char)urlPath[2]) && (sscanf(urlPath + 1, "%2x", &ch) == 1))
+      {
+         path[len++] = (char)ch;
+         urlPath += 3;
+      }
+      else
+      {
+         path[len++] = *urlPath++;
+      }
+   }
+   path[len] = 0;
+
+   size_t nameLen = strlen(name);
+   char* p_found = NULL;
+   char* p_job = path;
+   while ((p_job = strstr(p_job, "/job/")))
+   {
+      char* p_name = p_job + strlen("/job/");
+      if (!strncmp(p_name, name, nameLen) && ((p_name[nameLen] == '/') || !p_name[nameLen]))
+      {
+         p_found = p_job;
+      }
+      p_job++;
+   }
+   if (!p_found || ((size_t)(p_found - path) >= pathSize))
+   {
+      return false;
+   }
+   memcpy(containerPath, path, p_found - path);
+   containerPath[p_found - path] = 0;
+   return true;
+}
+
+//----------------------------------------------------------------
+// Where notified job is: host, port and container path of full url of
+// build, or only container path of job url which is relative to jenkins
+// root. Notification which has no url is matched by job name only.
+//----------------------------------------------------------------
+typedef struct hookOrigin
+{
+   bool hasHost;
+   bool hasContainer;
+   char host[256];
+   char port[16];
+   char containerPath[1000];     // with base path of jenkins if url is full
+}HookOriginT;
+
+//----------------------------------------------------------------------------
+// Get origin of notified job from its urls
+// return false if urls are not urls of job
+//----------------------------------------------------------------------------
+static bool parseHookOrigin(const JsonJobEntryT* p_entry, HookOriginT* p_origin)
+{
+   memset(p_origin, 0, sizeof(HookOriginT));
+   if (p_entry->fullUrl[0])
+   {
+      const char* p_authority = strstr(p_entry->fullUrl, "://");
+      bool isHttps = !strncmp(p_entry->fullUrl, "https://", strlen("https://"));
+      p_authority = p_authority ? p_authority + strlen("://") : p_entry->fullUrl;
+      const char* p_path = strchr(p_authority, '/');
+      size_t authorityLen = p_path ? (size_t)(p_path - p_authority) : strlen(p_authority);
+      const char* p_colon = memchr(p_authority, ':', authorityLen);
+      size_t hostLen = p_colon ? (size_t)(p_colon - p_authority) : authorityLen;
+      size_t portLen = p_colon ? authorityLen - hostLen - 1 : 0;
+      if (!p_path || (hostLen >= sizeof(p_origin->host)) || (portLen >= sizeof(p_origin->port)))
+      {
+         return false;
+      }
+      memcpy(p_origin->host, p_authority, hostLen);
+      if (p_colon)
+      {
+         memcpy(p_origin->port, p_colon + 1, portLen);
+      }
+      else
+      {
+         strcpy(p_origin->port, isHttps ? "443" : "80");
+      }
+      p_origin->hasHost = true;
+      p_origin->hasContainer = true;
+      return hookContainerOf(p_path, p_entry->name, p_origin->containerPath,
+                             sizeof(p_origin->containerPath));
+   }
+   if (p_entry->url[0])
+   {
+      char path[sizeof(p_entry->url) + 1];
+      snprintf(path, sizeof(path), "%s%s", (p_entry->url[0] == '/') ? "" : "/", p_entry->url);
+      p_origin->hasContainer = true;
+      return hookContainerOf(path, p_entry->name, p_origin->containerPath,
+                             sizeof(p_origin->containerPath));
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Check that notified job is job of group: group polls the same server and
+// job is in the same folder
+//----------------------------------------------------------------------------
+static bool isHookJobOf(const HookOriginT* p_origin, const JobInfoT* p_job,
+                        const GroupInfoT* p_group)
+{
+   const HttpConnT* p_conn = &p_group->httpConn;
+   if (p_origin->hasHost &&
+       (strcasecmp(p_origin->host, p_conn->host) || strcmp(p_origin->port, p_conn->port)))
    {
-      char str[100];
-      char colorStr[20];
+      return false;
+   }
+   if (!p_origin->hasContainer)
+   {
+      return true;
+   }
+   char containerPath[1000];
+   size_t baseLen = p_origin->hasHost ? strlen(p_conn->basePath) : 0;
+   if (strncmp(p_origin->containerPath, p_conn->basePath, baseLen))
+   {
+      return false;
+   }
+   containerPathOf(p_job->jobPath, containerPath, sizeof(containerPath));
+   return !strcmp(p_origin->containerPath + baseLen, containerPath);
+}
 
-      pthread_mutex_lock(&p_group->lockLedSta);
-      convert2ColorStr(p_group->ledStatus, colorStr, 20);
-      pthread_mutex_unlock(&p_group->lockLedSta);
+//----------------------------------------------------------------------------
+// Callback of hook listener: update all jobs which have name, server and
+// container of notified job, then evaluate their groups right away
+//----------------------------------------------------------------------------
+void hookJobEntry(void* p_arg, const JsonJobEntryT* p_entry)
+{
+   JobIndexT* p_index = (JobIndexT*)p_arg;
+   if (g_isVerbose)
+   {
+      printf("Notification of job %s: phase %s, status %s, url %s\n",
+             p_entry->name, p_entry->phase, p_entry->result,
+             p_entry->fullUrl[0] ? p_entry->fullUrl : p_entry->url);
+   }
+   HookOriginT origin;
+   if (!parseHookOrigin(p_entry, &origin))
+   {
+      printf("Url of notified job %s is not understood: %s\n", p_entry->name,
+             p_entry->fullUrl[0] ? p_entry->fullUrl : p_entry->url);
+      return;
+   }
 
-      snprintf(str, 100, "%s - %s - %s- %s",
-               (p_group->curSta.isAllDisable) ?  "Disable"   : " ",
-               (p_group->curSta.isThreshold)  ?  "Threshold" : " ",
-               (p_group->curSta.isBuilding)   ?  "Building"  : "Not building ",
-               (p_group->curSta.isSuccess)    ?  "Success"   : "False ");
+   // Index and groups are not changed by reloading meanwhile
+   pthread_mutex_lock(&g_jobIndexLock);
+   u_int32 hash = hashJobName(p_entry->name);
+   u_int32 idx;
+   for (idx = hash & (p_index->size - 1); p_index->p_entries[idx].p_job;
+        idx = (idx + 1) & (p_index->size - 1))
+   {
+      JobIndexEntryT* p_indexEntry = &p_index->p_entries[idx];
+      if ((p_indexEntry->hash != hash) || strcmp(p_indexEntry->p_job->jobName, p_entry->name) ||
+          !isHookJobOf(&origin, p_indexEntry->p_job, p_indexEntry->p_group))
+      {
+         continue;
+      }
+      GroupInfoT* p_group = p_indexEntry->p_group;
+      pthread_mutex_lock(&p_group->lockJobSta);
+      if (assignJobEvent(p_indexEntry->p_job, p_entry))
+      {
+         p_group->isJobChanged = true;
+      }
+      pthread_mutex_unlock(&p_group->lockJobSta);
+      evaluateColor(p_group);
+   }
+   pthread_mutex_unlock(&g_jobIndexLock);
+}
+
+//----------------------------------------------------------------------------
+// Callback of JENKINS_HOME watcher: update job which has name and container
+// of changed job, then evaluate its groups right away
+//----------------------------------------------------------------------------
+void homeJobEntry(void* p_arg, const char* containerPath, const JsonJobEntryT* p_entry)
+{
+   JobIndexT* p_index = (JobIndexT*)p_arg;
+   if (g_isVerbose)
+   {
+      printf("Job %s/job/%s is changed on disk: %s\n", containerPath, p_entry->name, p_entry->color);
+   }
+
+   // Index and groups are not changed by reloading meanwhile
+   pthread_mutex_lock(&g_jobIndexLock);
+   u_int32 hash = hashJobName(p_entry->name);
+   u_int32 idx;
+   for (idx = hash & (p_index->size - 1); p_index->p_entries[idx].p_job;
+        idx = (idx + 1) & (p_index->size - 1))
+   {
+      JobIndexEntryT* p_indexEntry = &p_index->p_entries[idx];
+      char jobContainerPath[1000];
+      if ((p_indexEntry->hash != hash) || strcmp(p_indexEntry->p_job->jobName, p_entry->name))
+      {
+         continue;
+      }
+      containerPathOf(p_indexEntry->p_job->jobPath, jobContainerPath, sizeof(jobContainerPath));
+      if (strcmp(jobContainerPath, containerPath))
+      {
+         continue;
+      }
+      GroupInfoT* p_group = p_indexEntry->p_group;
+      pthread_mutex_lock(&p_group->lockJobSta);
+      if (assignJobState(p_indexEntry->p_job, p_entry))
+      {
+         p_group->isJobChanged = true;
+      }
+      pthread_mutex_unlock(&p_group->lockJobSta);
+      evaluateColor(p_group);
+   }
+   pthread_mutex_unlock(&g_jobIndexLock);
+}
+
+//----------------------------------------------------------------------------
+// Compare strings of config, NULL means not configured
+//----------------------------------------------------------------------------
+static bool isSameStr(const char* str1, const char* str2)
+{
+   if (!str1 || !str2)
+   {
+      return str1 == str2;
+   }
+   return !strcmp(str1, str2);
+}
+
+//----------------------------------------------------------------------------
+// Check that two jobs of config monitor the same jenkins job
+//----------------------------------------------------------------------------
+static bool isSameJob(const JobInfoT* p_job1, const JobInfoT* p_job2)
+{
+   return isSameStr(p_job1->jobPath, p_job2->jobPath) &&
+          isSameStr(p_job1->jobName, p_job2->jobName);
+}
+
+//----------------------------------------------------------------------------
+// Check that two groups have the same rules and led of each status
+//----------------------------------------------------------------------------
+static bool isSameRule(const GroupInfoT* p_group1, const GroupInfoT* p_group2)
+{
+   const GroupRuleT* p_rule1 = &p_group1->rule;
+   const GroupRuleT* p_rule2 = &p_group2->rule;
+   if ((p_rule1->successColors != p_rule2->successColors) ||
+       (p_rule1->disableColors != p_rule2->disableColors) ||
+       (p_rule1->successQuorum != p_rule2->successQuorum) ||
+       (p_rule1->buildingQuorum != p_rule2->buildingQuorum) ||
+       (p_rule1->thresholdQuorum != p_rule2->thresholdQuorum) ||
+       memcmp(p_rule1->colorLevels, p_rule2->colorLevels, sizeof(p_rule1->colorLevels)))
+   {
+      return false;
+   }
+   const LedInfoT* p_leds1 = &p_group1->stdLed.disable;
+   const LedInfoT* p_leds2 = &p_group2->stdLed.disable;
+   u_int32 idx;
+   for (idx = 0; idx < sizeof(StdLedStaT) / sizeof(LedInfoT); idx++)
+   {
+      if ((p_leds1[idx].color != p_leds2[idx].color) ||
+          (p_leds1[idx].isAnime != p_leds2[idx].isAnime))
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Get what is changed in config of group
+// return bit mask of GROUP_xxx_CHANGED, 0 if group is not changed
+//----------------------------------------------------------------------------
+u_int32 diffGroupConfig(const GroupInfoT* p_group, const GroupInfoT* p_newGroup)
+{
+   u_int32 diff = 0;
+   if ((p_group->pollPolicy.buildingTime != p_newGroup->pollPolicy.buildingTime) ||
+       (p_group->pollPolicy.idleTime != p_newGroup->pollPolicy.idleTime) ||
+       (p_group->pollPolicy.maxIdleTime != p_newGroup->pollPolicy.maxIdleTime) ||
+       (p_group->displaySuccessTimeout != p_newGroup->displaySuccessTimeout) ||
+       (p_group->lastBuildThreshold != p_newGroup->lastBuildThreshold) ||
+       !isSameRule(p_group, p_newGroup))
+   {
+      diff |= GROUP_ATTR_CHANGED;
+   }
+
+   if (!isSameStr(p_group->server.serverName, p_newGroup->server.serverName) ||
+       !isSameStr(p_group->server.userName, p_newGroup->server.userName) ||
+       !isSameStr(p_group->server.passWord, p_newGroup->server.passWord))
+   {
+      diff |= GROUP_SERVER_CHANGED;
+   }
+
+   if ((p_group->gpio.redLed != p_newGroup->gpio.redLed) ||
+       (p_group->gpio.greLed != p_newGroup->gpio.greLed) ||
+       (p_group->gpio.bluLed != p_newGroup->gpio.bluLed) ||
+       !isSameStr(p_group->gpio.redLedName, p_newGroup->gpio.redLedName) ||
+       !isSameStr(p_group->gpio.greLedName, p_newGroup->gpio.greLedName) ||
+       !isSameStr(p_group->gpio.bluLedName, p_newGroup->gpio.bluLedName))
+   {
+      diff |= GROUP_LED_CHANGED;
+   }
+
+   const JobInfoT* p_job = p_group->p_allJobs;
+   const JobInfoT* p_newJob = p_newGroup->p_allJobs;
+   while (p_job && p_newJob && isSameJob(p_job, p_newJob))
+   {
+      p_job = p_job->p_nextJob;
+      p_newJob = p_newJob->p_nextJob;
+   }
+   if (p_job || p_newJob)
+   {
+      diff |= GROUP_JOBS_CHANGED;
+   }
+   return diff;
+}
+
+//----------------------------------------------------------------------------
+// Take group which has given name out of list
+// Groups of new config are usually in the same order, so it is found at head
+//----------------------------------------------------------------------------
+static GroupInfoT* takeSameGroup(GroupInfoT** pp_headGroup, const char* groupName)
+{
+   GroupInfoT** pp_group = pp_headGroup;
+   for (; *pp_group; pp_group = &(*pp_group)->p_nextGroup)
+   {
+      if (isSameStr((*pp_group)->groupName, groupName))
+      {
+         GroupInfoT* p_group = *pp_group;
+         *pp_group = p_group->p_nextGroup;
+         p_group->p_nextGroup = NULL;
+         return p_group;
+      }
+   }
+   return NULL;
+}
+
+//----------------------------------------------------------------------------
+// Take job which monitors the same jenkins job out of list
+//----------------------------------------------------------------------------
+static JobInfoT* takeSameJob(JobInfoT** pp_headJob, const JobInfoT* p_job)
+{
+   JobInfoT** pp_job = pp_headJob;
+   for (; *pp_job; pp_job = &(*pp_job)->p_nextJob)
+   {
+      if (isSameJob(*pp_job, p_job))
+      {
+         JobInfoT* p_sameJob = *pp_job;
+         *pp_job = p_sameJob->p_nextJob;
+         return p_sameJob;
+      }
+   }
+   return NULL;
+}
+
+//----------------------------------------------------------------------------
+// Replace jobs of group by jobs of new config in new order, job which is
+// kept gives its state and poll history to job of new config
+// return number of added jobs
+//----------------------------------------------------------------------------
+u_int32 mergeGroupJobs(GroupInfoT* p_group, GroupInfoT* p_newGroup, u_int32* p_removedCount)
+{
+   u_int32 addedCount = 0;
+   JobInfoT* p_oldJobs = p_group->p_allJobs;
+   JobInfoT* p_job = NULL;
+   for (p_job = p_newGroup->p_allJobs; p_job; p_job = p_job->p_nextJob)
+   {
+      JobInfoT* p_oldJob = takeSameJob(&p_oldJobs, p_job);
+      if (p_oldJob)
+      {
+         p_job->state = p_oldJob->state;
+         p_job->poll = p_oldJob->poll;
+         p_job->containerIdx = p_oldJob->containerIdx;
+         p_job->historyId = p_oldJob->historyId;
+         if (hasJobIndex())
+         {
+            jobIndexReplace(&g_jobIndex, p_oldJob, p_job);
+         }
+      }
+      else
+      {
+         addedCount++;
+         if (hasJobIndex() && !jobIndexAdd(&g_jobIndex, p_job, p_group))
+         {
+            printf("Can not add job %s to index, it is only polled\n", p_job->jobName);
+         }
+      }
+   }
+   p_group->p_allJobs = p_newGroup->p_allJobs;
+   p_newGroup->p_allJobs = NULL;
+
+   // Jobs which are not in new config
+   for (p_job = p_oldJobs; p_job; p_job = p_job->p_nextJob)
+   {
+      if (hasJobIndex())
+      {
+         jobIndexRemove(&g_jobIndex, p_job);
+      }
+      (*p_removedCount)++;
+   }
+   return addedCount;
+}
+
+//----------------------------------------------------------------------------
+// Apply changed config to running group, stuff that is not changed (led
+// status, history of success, state of kept jobs) is not touched
+// Note: no task uses group, hook listener and led thread are stopped
+// return true if group needs to be fetched now
+//----------------------------------------------------------------------------
+bool applyGroupConfig(GroupInfoT* p_group, GroupInfoT* p_newGroup, u_int32 diff,
+                      u_int32* p_addedJobs, u_int32* p_removedJobs)
+{
+   bool needFetch = false;
+   if (diff & GROUP_ATTR_CHANGED)
+   {
+      // Led which is shown is mixed again if levels of colors are changed
+      if (memcmp(p_group->rule.colorLevels, p_newGroup->rule.colorLevels,
+                 sizeof(p_group->rule.colorLevels)))
+      {
+         redrawGrpLed(p_group);
+      }
+      p_group->pollPolicy = p_newGroup->pollPolicy;
+      p_group->displaySuccessTimeout = p_newGroup->displaySuccessTimeout;
+      p_group->lastBuildThreshold = p_newGroup->lastBuildThreshold;
+      p_group->rule = p_newGroup->rule;
+      p_group->stdLed = p_newGroup->stdLed;
+      compileGroupRule(p_group);
+   }
+
+   if (diff & (GROUP_SERVER_CHANGED | GROUP_LED_CHANGED | GROUP_JOBS_CHANGED))
+   {
+      // Group takes strings and jobs of new config, which are equal to its
+      // own if they are not changed, then arena which it used before is
+      // freed when no other group uses it. New jobs are polled now, their
+      // poll time is 0.
+      u_int32 addedJobs = mergeGroupJobs(p_group, p_newGroup, p_removedJobs);
+      *p_addedJobs += addedJobs;
+      needFetch = (addedJobs > 0);
+      p_group->server = p_newGroup->server;
+      p_group->gpio.redLedName = p_newGroup->gpio.redLedName;
+      p_group->gpio.greLedName = p_newGroup->gpio.greLedName;
+      p_group->gpio.bluLedName = p_newGroup->gpio.bluLedName;
+      arenaRef(p_newGroup->p_arena);
+      arenaUnref(p_group->p_configArena);
+      p_group->p_configArena = p_newGroup->p_arena;
+   }
+
+   if (diff & GROUP_SERVER_CHANGED)
+   {
+      // Connection of new server is initialized by reloadConfig()
+      httpConnFree(&p_group->httpConn);
+      p_group->httpConn = p_newGroup->httpConn;
+      p_group->p_breaker = p_newGroup->p_breaker;
+
+      // State of jobs comes from old server, all jobs are polled now
+      JobInfoT* p_job = NULL;
+      for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+      {
+         p_job->poll.nextPollNs = 0;
+      }
+      needFetch = true;
+   }
+
+   if (diff & GROUP_LED_CHANGED)
+   {
+      p_group->gpio = p_newGroup->gpio;
+      redrawGrpLed(p_group);
+   }
+
+   // Led is evaluated by new config at once, or after new jobs are fetched
+   p_group->isJobChanged = true;
+   if (!needFetch)
+   {
+      evaluateColor(p_group);
+   }
+   freeGroupConfig(p_newGroup);
+   return needFetch;
+}
+
+//----------------------------------------------------------------------------
+// Remove running group which is not in new config
+// Note: no task uses group, hook listener and led thread are stopped
+//----------------------------------------------------------------------------
+void removeGroup(GroupInfoT* p_group)
+{
+   schedRemove(&g_pollSched, &p_group->pollTimer);
+   schedRemove(&g_ledSched, &p_group->blinkTimer);
+
+   // Group may wait for led thread in list of changed groups
+   GroupInfoT* p_changedGroup = takeChangedLedGroups();
+   while (p_changedGroup)
+   {
+      GroupInfoT* p_nextGroup = nextChangedLedGroup(p_changedGroup);
+      if (p_changedGroup != p_group)
+      {
+         pushChangedLedGroup(p_changedGroup);
+      }
+      p_changedGroup = p_nextGroup;
+   }
+
+   if (hasJobIndex())
+   {
+      JobInfoT* p_job = NULL;
+      for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+      {
+         jobIndexRemove(&g_jobIndex, p_job);
+      }
+   }
+   if (g_history.isOpen && p_group->historyId)
+   {
+      // Status of group is not known any more
+      HistoryRecordT record;
+      memset(&record, 0, sizeof(record));
+      record.kind = HISTORY_GROUP;
+      record.id = p_group->historyId;
+      record.flags = HISTORY_REMOVED;
+      historyAppend(&g_history, &record);
+   }
+   freeGroupInfo(p_group);
+}
+
+//----------------------------------------------------------------------------
+// Assign all groups to jenkin servers again in aggregate mode, server which
+// does not have group any more is removed, poll time of new server is 0
+// Note: worker pool is idle, so servers are not fetching
+//----------------------------------------------------------------------------
+void rebuildServerList(GroupInfoT* p_headGroup, JenkinServerT** pp_headServer)
+{
+   resetServerGroups(*pp_headServer);
+   GroupInfoT* p_group = NULL;
+   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   {
+      if (!assignGroupServer(p_group, pp_headServer))
+      {
+         printf("Group %s is not polled until server is fixed\n", p_group->groupName);
+         p_group->p_jenkinServer = NULL;
+      }
+   }
+
+   JenkinServerT** pp_server = pp_headServer;
+   while (*pp_server)
+   {
+      JenkinServerT* p_server = *pp_server;
+      if (p_server->groupCount == 0)
+      {
+         *pp_server = p_server->p_nextServer;
+         schedRemove(&g_pollSched, &p_server->pollTimer);
+         freeServerInfo(p_server);
+         continue;
+      }
+      if (!p_server->fetchTask.run)
+      {
+         initServerTasks(p_server);
+      }
+      p_server->p_allGroups = p_headGroup;
+      pp_server = &p_server->p_nextServer;
+   }
+}
+
+//----------------------------------------------------------------------------
+// Free groups of new config which is not applied
+//----------------------------------------------------------------------------
+static void dropNewConfig(ReloadGroupT* p_reloads, u_int32 groupCount,
+                          GroupInfoT* p_newGroups, u_int32 addedCount)
+{
+   u_int32 idx;
+   for (idx = 0; idx < groupCount; idx++)
+   {
+      if (p_reloads[idx].isConnReady)
+      {
+         httpConnFree(&p_reloads[idx].p_newGroup->httpConn);
+      }
+      if (p_reloads[idx].p_newGroup)
+      {
+         freeGroupConfig(p_reloads[idx].p_newGroup);
+      }
+   }
+   while (p_newGroups)
+   {
+      GroupInfoT* p_group = p_newGroups;
+      p_newGroups = p_newGroups->p_nextGroup;
+      if (addedCount)
+      {
+         freeGroupInfo(p_group);
+         addedCount--;
+      }
+      else
+      {
+         freeGroupConfig(p_group);
+      }
+   }
+   free(p_reloads);
+}
+
+//----------------------------------------------------------------------------
+// Change led pins to pins of new config before running groups are changed:
+// new pins are requested first, then pins which are not used any more are
+// turned off and released. Pins which are kept are not touched.
+// Note: led thread is paused
+// return false if new pins can not be requested, running pins are kept
+//----------------------------------------------------------------------------
+static bool updateReloadLed(const ReloadGroupT* p_reloads, u_int32 groupCount,
+                            GroupInfoT* p_newGroups)
+{
+   u_int32 maxCount = groupCount;
+   GroupInfoT* p_group = NULL;
+   for (p_group = p_newGroups; p_group; p_group = p_group->p_nextGroup)
+   {
+      maxCount++;
+   }
+   unsigned int* p_pins = malloc(maxCount * 3 * sizeof(unsigned int));
+   const char** pp_ledNames = malloc(maxCount * 3 * sizeof(char*));
+   if (!p_pins || !pp_ledNames)
+   {
+      free(p_pins);
+      free(pp_ledNames);
+      return false;
+   }
+
+   bool isUsed[GPIO_MAX_PIN];
+   memset(isUsed, 0, sizeof(isUsed));
+   u_int32 pinCount = 0;
+   u_int32 idx;
+   for (idx = 0; idx < maxCount; idx++)
+   {
+      if (idx < groupCount)
+      {
+         p_group = p_reloads[idx].p_newGroup;
+      }
+      else
+      {
+         p_group = (idx == groupCount) ? p_newGroups : p_group->p_nextGroup;
+      }
+      if (!p_group)
+      {
+         continue;
+      }
+      const LedGpioT* p_gpio = &p_group->gpio;
+      p_pins[pinCount] = p_gpio->redLed;
+      pp_ledNames[pinCount++] = p_gpio->redLedName;
+      p_pins[pinCount] = p_gpio->greLed;
+      pp_ledNames[pinCount++] = p_gpio->greLedName;
+      p_pins[pinCount] = p_gpio->bluLed;
+      pp_ledNames[pinCount++] = p_gpio->bluLedName;
+   }
+   for (idx = 0; idx < pinCount; idx++)
+   {
+      isUsed[p_pins[idx] % GPIO_MAX_PIN] = true;
+   }
+
+   // Pwm thread gives gpio up for at most one period
+   pwmLockGpio();
+   bool isOk = gpioUpdatePins(p_pins, pp_ledNames, pinCount);
+   pwmUnlockGpio();
+   if (isOk && g_pwmHz)
+   {
+      for (idx = 0; idx < groupCount; idx++)
+      {
+         const LedGpioT* p_gpio = &p_reloads[idx].p_group->gpio;
+         unsigned int oldPins[3] = {p_gpio->redLed, p_gpio->greLed, p_gpio->bluLed};
+         u_int32 pinIdx;
+         for (pinIdx = 0; pinIdx < 3; pinIdx++)
+         {
+            if (!isUsed[oldPins[pinIdx] % GPIO_MAX_PIN])
+            {
+               pwmReleasePin(oldPins[pinIdx]);
+            }
+         }
+      }
+   }
+   free(p_pins);
+   free(pp_ledNames);
+   return isOk;
+}
+
+//----------------------------------------------------------------------------
+// Resume fetch which waits for its socket, it sees abort of its connection
+// and finishes at once instead of waiting for server until timeout
+// Note: it is called by main thread after posted timers are merged
+//----------------------------------------------------------------------------
+static void resumeWaitingFetch(SchedTimerT* p_ioTimer)
+{
+   if (schedIsQueued(p_ioTimer))
+   {
+      schedRemove(&g_pollSched, p_ioTimer);
+      poolSubmit(&g_pool, (PoolTaskT*)p_ioTimer->p_arg);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Wait for tasks which use groups that are changed or removed by reload,
+// their requests are canceled so that a dead server does not hold reload
+// until timeout. Canceled fetch keeps poll time of its jobs, it is fetched
+// again after reload.
+// In aggregate mode one fetch of server spreads jobs to many groups and
+// servers are assigned again, so fetches of all servers are canceled.
+// Note: it is called by main thread, the only thread which submits tasks
+//----------------------------------------------------------------------------
+static void quiesceReloadGroups(const ReloadGroupT* p_reloads, u_int32 groupCount,
+                                JenkinServerT* p_headServer)
+{
+   // Group or server whose poll timer is not queued is fetched or evaluated
+   // by a task, the task posts timer back when it does not use it any more.
+   // Fetch which waits for socket has its io timer queued instead.
+   JenkinServerT* p_server = NULL;
+   u_int32 idx;
+   u_int32 busyCount = 0;
+   schedMergePosted(&g_pollSched);
+   if (g_isAggregate)
+   {
+      for (p_server = p_headServer; p_server; p_server = p_server->p_nextServer)
+      {
+         httpConnAbort(&p_server->httpConn);
+      }
+      do
+      {
+         busyCount = 0;
+         for (p_server = p_headServer; p_server; p_server = p_server->p_nextServer)
+         {
+            if (!schedIsQueued(&p_server->pollTimer))
+            {
+               resumeWaitingFetch(&p_server->ioTimer);
+               busyCount++;
+            }
+         }
+      } while (busyCount && schedWaitPosted(&g_pollSched));
 
-      printf("\nGroup %s\ngroup status:%s; led status: %s\n\n",
-             p_group->groupName, str, colorStr);
+      // Evaluate tasks spawned by fetch of server use groups
+      poolWaitIdle(&g_pool);
+      for (p_server = p_headServer; p_server; p_server = p_server->p_nextServer)
+      {
+         httpConnClearAbort(&p_server->httpConn);
+      }
+      schedMergePosted(&g_pollSched);
+      return;
+   }
 
+   for (idx = 0; idx < groupCount; idx++)
+   {
+      if (!p_reloads[idx].p_newGroup || p_reloads[idx].diff)
+      {
+         httpConnAbort(&p_reloads[idx].p_group->httpConn);
+      }
+   }
+   do
+   {
+      busyCount = 0;
+      for (idx = 0; idx < groupCount; idx++)
+      {
+         GroupInfoT* p_group = p_reloads[idx].p_group;
+         if ((!p_reloads[idx].p_newGroup || p_reloads[idx].diff) &&
+             !schedIsQueued(&p_group->pollTimer))
+         {
+            resumeWaitingFetch(&p_group->ioTimer);
+            busyCount++;
+         }
+      }
+   } while (busyCount && schedWaitPosted(&g_pollSched));
+   for (idx = 0; idx < groupCount; idx++)
+   {
+      if (!p_reloads[idx].p_newGroup || p_reloads[idx].diff)
+      {
+         httpConnClearAbort(&p_reloads[idx].p_group->httpConn);
+      }
    }
 }
 
 //----------------------------------------------------------------------------
-// evaluate Group Status
+// Reload xml file, then apply only what is changed to running groups
+// Unchanged groups keep running, changed groups keep their led status,
+// history of success and state of kept jobs. Running config is kept if new
+// file can not be parsed.
+// Note: it is called by main thread, the only thread which submits tasks
 //----------------------------------------------------------------------------
-void evalGroupStatus(GroupInfoT* p_group)
+void reloadConfig(GroupInfoT** pp_allGroups, JenkinServerT** pp_allServers)
 {
-   p_group->preSta = p_group->curSta;
-   p_group->curSta.isBuilding = false;
-   p_group->curSta.isSuccess = true;
-   p_group->curSta.isThreshold = false;
-   p_group->curSta.isAllDisable = true;
-   JobInfoT* p_job = NULL;
-   bool isJobThreshold;
+   long long startNs = schedNowNs();
+   printf("Reload config file %s\n", g_xmlFile);
 
-   for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
+   GroupInfoT* p_newGroups = NULL;
+   if (!parseXMLFile(g_xmlFile, &p_newGroups))
    {
-      LedInfoT jobLedInfo = ledInfoFromfile(p_job->statusInfoFile);
-      p_group->curSta.isAllDisable = p_group->curSta.isAllDisable &&
-         ((jobLedInfo.color == NO_BUILT) || (jobLedInfo.color == DISABLED));
-      if ((jobLedInfo.color != NO_BUILT) &&
-            (jobLedInfo.color != DISABLED))
+      printf("Can not parse XML file, keep running config\n");
+      while (p_newGroups)
       {
-         p_group->curSta.isSuccess = p_group->curSta.isSuccess &&
-                                     (jobLedInfo.color == BLU_COLOR);
-
-         p_group->curSta.isBuilding = p_group->curSta.isBuilding ||
-                                      jobLedInfo.isAnime;
+         GroupInfoT* p_group = p_newGroups;
+         p_newGroups = p_newGroups->p_nextGroup;
+         freeGroupConfig(p_group);
+      }
+      return;
+   }
 
-         int64 jobTime = timeStampFromFile(p_job->lastBuildInfoFile);
-         int64 curTime = currentTimeStamp();
-         isJobThreshold = (curTime - jobTime) > (int64)p_group->lastBuildThreshold;
-         p_group->curSta.isThreshold = p_group->curSta.isThreshold || isJobThreshold;
+   // Match running groups with groups of new config by name
+   u_int32 groupCount = 0;
+   GroupInfoT* p_group = NULL;
+   for (p_group = *pp_allGroups; p_group; p_group = p_group->p_nextGroup)
+   {
+      groupCount++;
+   }
+   ReloadGroupT* p_reloads = calloc(groupCount ? groupCount : 1, sizeof(ReloadGroupT));
+   u_int32 idx = 0;
+   bool isPinChanged = false;
+   bool isOk = true;
+   for (p_group = *pp_allGroups; p_group; p_group = p_group->p_nextGroup, idx++)
+   {
+      ReloadGroupT* p_reload = &p_reloads[idx];
+      p_reload->p_group = p_group;
+      p_reload->p_newGroup = takeSameGroup(&p_newGroups, p_group->groupName);
+      if (!p_reload->p_newGroup)
+      {
+         isPinChanged = true;
+         continue;
+      }
+      setDefaultPollPolicy(&p_reload->p_newGroup->pollPolicy);
+      p_reload->diff = diffGroupConfig(p_group, p_reload->p_newGroup);
+      if (p_reload->diff & GROUP_LED_CHANGED)
+      {
+         isPinChanged = true;
+      }
+      if ((p_reload->diff & GROUP_SERVER_CHANGED) && isOk)
+      {
+         // Url of new server is checked before anything is changed
+         p_reload->p_newGroup->curlTime = p_group->curlTime;
+         isOk = initGroupConn(p_reload->p_newGroup);
+         p_reload->isConnReady = isOk;
       }
    }
-}
 
-//----------------------------------------------------------------------------
-// assign Group's Led Status
-//----------------------------------------------------------------------------
-void assignGrpLedStatus(GroupInfoT* p_group, LedInfoT ledInfo)
-{
-   pthread_mutex_lock(&p_group->lockLedSta);
-   p_group->ledStatus = ledInfo;
-   pthread_mutex_unlock(&p_group->lockLedSta);
-}
+   // Groups which are left in new config are added
+   u_int32 addedCount = 0;
+   for (p_group = p_newGroups; p_group && isOk; p_group = p_group->p_nextGroup)
+   {
+      isOk = initGroupStuff(p_group);
+      addedCount += isOk;
+      isPinChanged = true;
+   }
 
-//----------------------------------------------------------------------------
-// Evaluate Group's Led Status
-//----------------------------------------------------------------------------
-void evalLedStatus(GroupInfoT* p_group)
-{
-   if (p_group->curSta.isAllDisable)
+   if (!isOk)
    {
-      assignGrpLedStatus(p_group, p_group->stdLed.disable);
+      printf("Can not apply new config, keep running config\n");
+      dropNewConfig(p_reloads, groupCount, p_newGroups, addedCount);
+      return;
    }
-   else
+
+   // Tasks which are running may still use changed groups, wait for them,
+   // tasks of unchanged groups keep running. Hook listener and led thread
+   // are stopped while groups are changed.
+   quiesceReloadGroups(p_reloads, groupCount, *pp_allServers);
+   pthread_mutex_lock(&g_jobIndexLock);
+   pauseLedThread();
+
+   // Pins of new config are requested before anything is changed
+   if (isPinChanged && g_isCtrlRealLed && !updateReloadLed(p_reloads, groupCount, p_newGroups))
+   {
+      printf("Can not request led pins of new config, keep running config\n");
+      resumeLedThread();
+      pthread_mutex_unlock(&g_jobIndexLock);
+      dropNewConfig(p_reloads, groupCount, p_newGroups, addedCount);
+      return;
+   }
+
+   u_int32 removedCount = 0;
+   u_int32 changedCount = 0;
+   u_int32 addedJobs = 0;
+   u_int32 removedJobs = 0;
+   GroupInfoT** pp_tailGroup = pp_allGroups;
+   for (idx = 0; idx < groupCount; idx++)
    {
-      if (p_group->curSta.isBuilding)
+      ReloadGroupT* p_reload = &p_reloads[idx];
+      p_group = p_reload->p_group;
+      if (!p_reload->p_newGroup)
+      {
+         *pp_tailGroup = p_group->p_nextGroup;
+         removeGroup(p_group);
+         removedCount++;
+         continue;
+      }
+      if (p_reload->diff)
       {
-         assignGrpLedStatus(p_group, p_group->stdLed.building);
+         p_reload->needFetch = applyGroupConfig(p_group, p_reload->p_newGroup,
+                                                p_reload->diff, &addedJobs, &removedJobs);
+         changedCount++;
+         if (p_reload->needFetch && !g_isAggregate)
+         {
+            schedAdd(&g_pollSched, &p_group->pollTimer, schedNowNs());
+         }
       }
       else
       {
-         if (p_group->curSta.isSuccess)
+         freeGroupConfig(p_reload->p_newGroup);
+      }
+      pp_tailGroup = &p_group->p_nextGroup;
+   }
+
+   // New groups are put at tail, they are polled now
+   *pp_tailGroup = p_newGroups;
+   long long nowNs = schedNowNs();
+   for (p_group = p_newGroups; p_group; p_group = p_group->p_nextGroup)
+   {
+      initGroupTasks(p_group);
+      schedTimerInit(&p_group->blinkTimer, p_group);
+      redrawGrpLed(p_group);
+      if (hasJobIndex())
+      {
+         JobInfoT* p_job = NULL;
+         for (p_job = p_group->p_allJobs; p_job; p_job = p_job->p_nextJob)
          {
-            if (p_group->curSta.isThreshold)
+            if (!jobIndexAdd(&g_jobIndex, p_job, p_group))
             {
-               assignGrpLedStatus(p_group, p_group->stdLed.threshold);
+               printf("Can not add job %s to index, it is only polled\n", p_job->jobName);
             }
-            else
-            {
-               if (!p_group->preSta.isAllDisable &&
-                   !p_group->preSta.isBuilding   &&
-                   p_group->preSta.isSuccess     &&
-                   !p_group->preSta.isThreshold)
-               {
-                  //Previous status is full success as current status
-                  if (p_group->needToCheckTimeStamp)
-                  {
-                     //Check timestamp to turn off Led
-                     int64 curTime = currentTimeStamp();
-                     if ((curTime - p_group->lastSuccessTimeStamp) >
-                         (int64)p_group->displaySuccessTimeout)
-                     {
-                        assignGrpLedStatus(p_group, p_group->stdLed.successNotShow);
-
-                        // LED is turned off -> don't need to check timestamp anymore
-                        p_group->needToCheckTimeStamp = false;
-                     }
-                  }
-               }
-               else
-               {
-                  //First time full success occur -> Store timestamp
-                  p_group->lastSuccessTimeStamp = currentTimeStamp();
-                  p_group->needToCheckTimeStamp = true;
+         }
+      }
+      if (!g_isAggregate)
+      {
+         schedAdd(&g_pollSched, &p_group->pollTimer, nowNs);
+      }
+   }
 
-                  assignGrpLedStatus(p_group, p_group->stdLed.success);
-               }
-            }
+   if (g_isAggregate)
+   {
+      // Server of group which needs to be fetched is polled now
+      rebuildServerList(*pp_allGroups, pp_allServers);
+      for (idx = 0; idx < groupCount; idx++)
+      {
+         p_group = p_reloads[idx].p_group;
+         if (p_reloads[idx].needFetch && p_group->p_jenkinServer)
+         {
+            p_group->p_jenkinServer->poll.nextPollNs = 0;
          }
-         else
+      }
+      for (p_group = p_newGroups; p_group; p_group = p_group->p_nextGroup)
+      {
+         if (p_group->p_jenkinServer)
+         {
+            p_group->p_jenkinServer->poll.nextPollNs = 0;
+         }
+      }
+      JenkinServerT* p_server = NULL;
+      for (p_server = *pp_allServers; p_server; p_server = p_server->p_nextServer)
+      {
+         if (p_server->poll.nextPollNs == 0)
          {
-            assignGrpLedStatus(p_group, p_group->stdLed.fail);
+            schedAdd(&g_pollSched, &p_server->pollTimer, nowNs);
          }
       }
    }
+
+   resumeLedThread();
+   pthread_mutex_unlock(&g_jobIndexLock);
+   free(p_reloads);
+
+   printf("Config is reloaded: %u groups added, %u removed, %u changed, %u unchanged, "
+          "%u jobs added, %u removed\n",
+          addedCount, removedCount, changedCount,
+          groupCount - removedCount - changedCount, addedJobs, removedJobs);
+   if (g_isVerbose)
+   {
+      printf("Reloading takes %lld us\n", (schedNowNs() - startNs) / 1000);
+   }
 }
 
 //----------------------------------------------------------------------------
-// Build threads to control led for each group'
+// Metric families of PollMetricsT, labeled by group (or server in aggregate mode)
 //----------------------------------------------------------------------------
-bool buildCtrlGrpLedThreads(GroupInfoT* p_headGroup)
+#define POLL_METRIC_FETCH    0
+#define POLL_METRIC_PARSE    1
+#define POLL_METRIC_REQUEST  2
+#define POLL_METRIC_ERROR    3
+#define POLL_METRIC_TIMEOUT  4
+#define POLL_METRIC_COUNT    5
+
+static const char* s_pollFamilies[POLL_METRIC_COUNT][3] =
 {
-   bool areAllOk = true;
-   GroupInfoT* p_group = NULL;
-   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   {"jenkin_fetch_duration_seconds", "histogram", "Time to poll jenkins, requests and parsing"},
+   {"jenkin_parse_duration_seconds", "histogram", "Time in json parser during a poll"},
+   {"jenkin_http_requests_total",    "counter",   "Http requests to jenkins"},
+   {"jenkin_http_errors_total",      "counter",   "Http requests which failed"},
+   {"jenkin_http_timeouts_total",    "counter",   "Http requests which timed out"},
+};
+
+//----------------------------------------------------------------------------
+// Print one sample of poll metric family
+//----------------------------------------------------------------------------
+void writePollMetric(HttpBufferT* p_out, u_int32 family, const char* labelName,
+                     const char* labelValue, const PollMetricsT* p_metrics)
+{
+   const char* name = s_pollFamilies[family][0];
+   switch (family)
    {
-      if (pthread_create(&p_group->ctrlLedThread, NULL, ctrlGrpLedPoll, p_group))
-      {
-         areAllOk = false;
+      case POLL_METRIC_FETCH:
+         metricsPrintHist(p_out, name, labelName, labelValue, &p_metrics->fetch);
+         break;
+      case POLL_METRIC_PARSE:
+         metricsPrintHist(p_out, name, labelName, labelValue, &p_metrics->parse);
+         break;
+      case POLL_METRIC_REQUEST:
+         metricsPrintValue(p_out, name, labelName, labelValue,
+                           metricsLoad(&p_metrics->requestCount));
+         break;
+      case POLL_METRIC_ERROR:
+         metricsPrintValue(p_out, name, labelName, labelValue,
+                           metricsLoad(&p_metrics->errorCount));
+         break;
+      default:
+         metricsPrintValue(p_out, name, labelName, labelValue,
+                           metricsLoad(&p_metrics->timeoutCount));
          break;
-      }
    }
-   return areAllOk;
 }
 
 //----------------------------------------------------------------------------
-// Poll to control all led for group
+// Metric families of BreakerT, labeled by server
 //----------------------------------------------------------------------------
-void* ctrlGrpLedPoll(void *arg)
+#define BREAKER_METRIC_STATE    0
+#define BREAKER_METRIC_RTT      1
+#define BREAKER_METRIC_TIMEOUT  2
+#define BREAKER_METRIC_ERROR    3
+#define BREAKER_METRIC_TRIP     4
+#define BREAKER_METRIC_PROBE    5
+#define BREAKER_METRIC_REJECT   6
+#define BREAKER_METRIC_COUNT    7
+
+static const char* s_breakerFamilies[BREAKER_METRIC_COUNT][3] =
 {
-   GroupInfoT* p_group = (GroupInfoT*)arg;
-   LedInfoT preLedSta;
-   LedInfoT curLedSta;
-   GpioStatusE gpioSta;
-
-   preLedSta.color = NON_COLOR;
-   preLedSta.isAnime = false;
+   {"jenkin_server_breaker_state",         "gauge",   "Breaker: 0 closed, 1 open, 2 probing"},
+   {"jenkin_server_rtt_seconds",           "gauge",   "Smoothed round trip time of requests"},
+   {"jenkin_server_timeout_seconds",       "gauge",   "Timeout of next request to server"},
+   {"jenkin_server_error_ratio",           "gauge",   "Moving average of failed requests"},
+   {"jenkin_server_breaker_trips_total",   "counter", "Server is found unreachable"},
+   {"jenkin_server_breaker_probes_total",  "counter", "Requests which probe unreachable server"},
+   {"jenkin_server_breaker_rejects_total", "counter", "Requests which are not sent to server"},
+};
 
-   while (1)
+//----------------------------------------------------------------------------
+// Print one sample of breaker metric family
+//----------------------------------------------------------------------------
+void writeBreakerMetric(HttpBufferT* p_out, u_int32 family, BreakerT* p_breaker)
+{
+   const char* name = s_breakerFamilies[family][0];
+   double value;
+   pthread_mutex_lock(&p_breaker->lock);
+   switch (family)
    {
-      pthread_mutex_lock(&g_terminateLock);
-      bool tempTerminate = g_terminateAll;
-      pthread_mutex_unlock(&g_terminateLock);
-      if (tempTerminate)
-      {
+      case BREAKER_METRIC_STATE:
+         value = p_breaker->state;
          break;
-      }
+      case BREAKER_METRIC_RTT:
+         value = p_breaker->srttNs / 1e9;
+         break;
+      case BREAKER_METRIC_TIMEOUT:
+         value = p_breaker->timeoutMs / 1e3;
+         break;
+      case BREAKER_METRIC_ERROR:
+         value = p_breaker->errorRate;
+         break;
+      case BREAKER_METRIC_TRIP:
+         value = p_breaker->tripCount;
+         break;
+      case BREAKER_METRIC_PROBE:
+         value = p_breaker->probeCount;
+         break;
+      default:
+         value = p_breaker->rejectCount;
+         break;
+   }
+   pthread_mutex_unlock(&p_breaker->lock);
+   metricsPrintValue(p_out, name, "server", p_breaker->serverName, value);
+}
 
-      pthread_mutex_lock(&p_group->lockLedSta);
-      curLedSta = p_group->ledStatus;
-      pthread_mutex_unlock(&p_group->lockLedSta);
+//----------------------------------------------------------------------------
+// Write all metrics in Prometheus text format, called by metrics thread
+// Groups and servers are not changed by reloading meanwhile
+//----------------------------------------------------------------------------
+void writeAllMetrics(void* p_arg, HttpBufferT* p_out)
+{
+   MetricsSourceT* p_source = (MetricsSourceT*)p_arg;
+   GroupInfoT* p_group = NULL;
+   JenkinServerT* p_server = NULL;
+   u_int32 family;
 
-      // Check if previous Led status and current Led status is the same or not
-      if ((preLedSta.color == curLedSta.color) &&
-          (preLedSta.isAnime == curLedSta.isAnime))
+   pthread_mutex_lock(&g_jobIndexLock);
+   for (family = 0; family < POLL_METRIC_COUNT; family++)
+   {
+      metricsPrintFamily(p_out, s_pollFamilies[family][0], s_pollFamilies[family][1],
+                         s_pollFamilies[family][2]);
+      if (g_isAggregate)
       {
-         if (curLedSta.isAnime)
+         for (p_server = *p_source->pp_allServers; p_server; p_server = p_server->p_nextServer)
          {
-            gpioSta = (gpioSta == ON) ? OF : ON;
-            ledCtrl(curLedSta.color, gpioSta, p_group->gpio, p_group->groupName);
+            writePollMetric(p_out, family, "server", p_server->serverName, &p_server->metrics);
          }
-         else
+      }
+      else
+      {
+         for (p_group = *p_source->pp_allGroups; p_group; p_group = p_group->p_nextGroup)
          {
-            if (g_isVerbose)
-            {
-               char colorStr[20];
-               convert2ColorStr(curLedSta, colorStr, 20);
-               printf("\nGroup %s's LED color: %s , led will not blink and led color is the same as before\n",
-                      p_group->groupName, colorStr);
-            }
+            writePollMetric(p_out, family, "group", p_group->groupName, &p_group->p_metrics->poll);
          }
       }
-      else
+   }
+
+   // Breakers are only appended to list, nothing of list is freed meanwhile
+   for (family = 0; !g_homeDir && (family < BREAKER_METRIC_COUNT); family++)
+   {
+      metricsPrintFamily(p_out, s_breakerFamilies[family][0], s_breakerFamilies[family][1],
+                         s_breakerFamilies[family][2]);
+      BreakerT* p_breaker = NULL;
+      for (p_breaker = __atomic_load_n(&g_breakers, __ATOMIC_ACQUIRE); p_breaker;
+           p_breaker = __atomic_load_n(&p_breaker->p_nextBreaker, __ATOMIC_ACQUIRE))
       {
-         gpioSta = ON;
-         ledCtrl(curLedSta.color, gpioSta, p_group->gpio, p_group->groupName);
-         preLedSta = curLedSta;
+         writeBreakerMetric(p_out, family, p_breaker);
       }
+   }
 
-      sleep(g_ledAnimeTime);
+   metricsPrintFamily(p_out, "jenkin_eval_duration_seconds", "histogram",
+                      "Time to evaluate led status of group");
+   for (p_group = *p_source->pp_allGroups; p_group; p_group = p_group->p_nextGroup)
+   {
+      metricsPrintHist(p_out, "jenkin_eval_duration_seconds", "group", p_group->groupName,
+                       &p_group->p_metrics->eval);
+   }
+   metricsPrintFamily(p_out, "jenkin_evaluations_total", "counter",
+                      "Evaluations of group, skipped ones are not counted");
+   for (p_group = *p_source->pp_allGroups; p_group; p_group = p_group->p_nextGroup)
+   {
+      metricsPrintValue(p_out, "jenkin_evaluations_total", "group", p_group->groupName,
+                        metricsLoad(&p_group->evalCount));
+   }
+   metricsPrintFamily(p_out, "jenkin_evaluations_skipped_total", "counter",
+                      "Evaluations of group which are skipped because nothing is changed");
+   for (p_group = *p_source->pp_allGroups; p_group; p_group = p_group->p_nextGroup)
+   {
+      metricsPrintValue(p_out, "jenkin_evaluations_skipped_total", "group", p_group->groupName,
+                        metricsLoad(&p_group->skipEvalCount));
+   }
+   metricsPrintFamily(p_out, "jenkin_led_latency_seconds", "histogram",
+                      "Time from change of led status of group to led frame");
+   for (p_group = *p_source->pp_allGroups; p_group; p_group = p_group->p_nextGroup)
+   {
+      metricsPrintHist(p_out, "jenkin_led_latency_seconds", "group", p_group->groupName,
+                       &p_group->p_metrics->led);
+   }
+   pthread_mutex_unlock(&g_jobIndexLock);
+
+   if (g_isCtrlRealLed)
+   {
+      const GpioStatsT* p_gpioStats = gpioStats();
+      metricsPrintFamily(p_out, "jenkin_gpio_commits_total", "counter",
+                         "Frames which are written to gpio");
+      metricsPrintValue(p_out, "jenkin_gpio_commits_total", NULL, NULL,
+                        metricsLoad(&p_gpioStats->commitCount));
+      metricsPrintFamily(p_out, "jenkin_gpio_pin_writes_total", "counter",
+                         "Pin values which are written to gpio");
+      metricsPrintValue(p_out, "jenkin_gpio_pin_writes_total", NULL, NULL,
+                        metricsLoad(&p_gpioStats->pinWriteCount));
+      metricsPrintFamily(p_out, "jenkin_gpio_errors_total", "counter",
+                         "Frames which can not be written to gpio");
+      metricsPrintValue(p_out, "jenkin_gpio_errors_total", NULL, NULL,
+                        metricsLoad(&p_gpioStats->errorCount));
+      metricsPrintFamily(p_out, "jenkin_gpio_commit_duration_seconds", "histogram",
+                         "Time to write a frame to gpio");
+      metricsPrintHist(p_out, "jenkin_gpio_commit_duration_seconds", NULL, NULL,
+                       &p_gpioStats->commit);
+   }
+   if (g_isCtrlRealLed && g_pwmHz)
+   {
+      PwmStatsT pwmStats;
+      pwmGetStats(&pwmStats);
+      metricsPrintFamily(p_out, "jenkin_pwm_wakeups_total", "counter",
+                         "Wakeups of pwm thread at period starts and edges");
+      metricsPrintValue(p_out, "jenkin_pwm_wakeups_total", NULL, NULL, pwmStats.wakeCount);
+      metricsPrintFamily(p_out, "jenkin_pwm_overruns_total", "counter",
+                         "Pwm periods which are missed");
+      metricsPrintValue(p_out, "jenkin_pwm_overruns_total", NULL, NULL, pwmStats.overrunCount);
+   }
+   if (g_hookAddr)
+   {
+      metricsPrintFamily(p_out, "jenkin_hook_requests_total", "counter",
+                         "Build notifications which are received");
+      metricsPrintValue(p_out, "jenkin_hook_requests_total", NULL, NULL,
+                        metricsLoad(&g_hook.requestCount));
+      metricsPrintFamily(p_out, "jenkin_hook_bad_requests_total", "counter",
+                         "Build notifications which can not be handled");
+      metricsPrintValue(p_out, "jenkin_hook_bad_requests_total", NULL, NULL,
+                        metricsLoad(&g_hook.badRequestCount));
+   }
+   if (g_homeDir)
+   {
+      metricsPrintFamily(p_out, "jenkin_home_events_total", "counter",
+                         "Inotify events of JENKINS_HOME");
+      metricsPrintValue(p_out, "jenkin_home_events_total", NULL, NULL,
+                        metricsLoad(&g_home.eventCount));
+      metricsPrintFamily(p_out, "jenkin_home_job_changes_total", "counter",
+                         "Jobs which are read again after their files are changed");
+      metricsPrintValue(p_out, "jenkin_home_job_changes_total", NULL, NULL,
+                        metricsLoad(&g_home.jobChangeCount));
    }
-   return 0;
 }
 
 //----------------------------------------------------------------------------
 // Wait until all threads have been stopped
+// Note: tasks which are fetching are finished, queued tasks are dropped
 //----------------------------------------------------------------------------
-void waitAllThreadsStop(GroupInfoT* p_headGroup)
+void waitAllThreadsStop(void)
 {
-   GroupInfoT* p_group = NULL;
-   for (p_group = p_headGroup; p_group; p_group = p_group->p_nextGroup)
+   if (g_metricsAddr)
+   {
+      metricsStop(&g_metrics);
+   }
+   if (g_hookAddr)
    {
-      if (pthread_join(p_group->evalColorThread, NULL) ||
-          pthread_join(p_group->ctrlLedThread, NULL))
+      hookStop(&g_hook);
+      if (g_isVerbose)
       {
-         printf("Can not join threads\n");
-         exit(1);
+         printf("Hook listener: %llu requests, %llu bad requests\n",
+                g_hook.requestCount, g_hook.badRequestCount);
+      }
+   }
+   if (g_homeDir)
+   {
+      homeStop(&g_home);
+      if (g_isVerbose)
+      {
+         printf("JENKINS_HOME watcher: %llu events, %llu job changes\n",
+                g_home.eventCount, g_home.jobChangeCount);
       }
    }
+   // Fetches whose request is in flight are not resumed any more, their
+   // sockets are closed with their groups
+   poolStop(&g_pool);
+
+   if (pthread_join(g_ctrlLedThread, NULL))
+   {
+      printf("Can not join threads\n");
+      exit(1);
+   }
 }
 
 //----------------------------------------------------------------------------
@@ -1460,30 +4518,67 @@ void cleanAllGroupInfo(GroupInfoT* p_headGroup)
    {
       p_tempGroup = p_headGroup;
       p_headGroup = p_headGroup->p_nextGroup;
+      freeGroupInfo(p_tempGroup);
+   }
+}
 
-      // Clean All Jobs in Group
-      JobInfoT* p_headJob = p_tempGroup->p_allJobs;
-      JobInfoT* p_tempJob = NULL;
-      while (p_headJob)
-      {
-         p_tempJob = p_headJob;
-         p_headJob = p_headJob->p_nextJob;
-         free(p_tempJob->jobPath);
-         free(p_tempJob->jobName);
-         free(p_tempJob);
-      }
+//----------------------------------------------------------------------------
+// Free group whose stuff is initialized by initGroupStuff()
+//----------------------------------------------------------------------------
+void freeGroupInfo(GroupInfoT* p_group)
+{
+   free(p_group->p_metrics);
+   free(p_group->p_fetch);
+   httpConnFree(&p_group->httpConn);
+   pthread_mutex_destroy(&p_group->lockJobSta);
+   freeGroupConfig(p_group);
+}
+
+//----------------------------------------------------------------------------
+// Free group which is only parsed from xml file: its strings and jobs are in
+// its arenas, which are freed with the last group that uses them
+//----------------------------------------------------------------------------
+void freeGroupConfig(GroupInfoT* p_group)
+{
+   arenaUnref(p_group->p_configArena);
+   arenaUnref(p_group->p_arena);
+}
+//----------------------------------------------------------------------------
+// Cleanup all jenkin server information
+//----------------------------------------------------------------------------
+void cleanAllServerInfo(JenkinServerT* p_headServer)
+{
+   JenkinServerT* p_tempServer = NULL;
+   while (p_headServer)
+   {
+      p_tempServer = p_headServer;
+      p_headServer = p_headServer->p_nextServer;
+      freeServerInfo(p_tempServer);
+   }
+}
 
-      free(p_tempGroup->groupName);
-      free(p_tempGroup->server.serverName);
-      free(p_tempGroup->server.userName);
-      free(p_tempGroup->server.passWord);
-      pthread_mutex_destroy(&p_tempGroup->lockLedSta);
-      free(p_tempGroup);
+//----------------------------------------------------------------------------
+// Free one jenkin server
+//----------------------------------------------------------------------------
+void freeServerInfo(JenkinServerT* p_server)
+{
+   u_int32 idx;
+   for (idx = 0; idx < p_server->containerCount; idx++)
+   {
+      free(p_server->containerPaths[idx]);
    }
+   free(p_server->containerPaths);
+   free(p_server->serverName);
+   free(p_server->fetch.isFetched);
+   httpConnFree(&p_server->httpConn);
+   free(p_server);
 }
+
 //----------------------------------------------------------------------------
 // Main function
+// Note: microbenchmark links this file with JENKIN_MON_NO_MAIN
 //----------------------------------------------------------------------------
+#ifndef JENKIN_MON_NO_MAIN
 int main(int argc, char *argv[])
 {
    // Parse Argument from command line
@@ -1492,8 +4587,46 @@ int main(int argc, char *argv[])
       printf("usage:\n"
              "default xml config file is /opt/jobsJenkinConfig.xml, if we want to change use -f\n"
              "./jenkin_mon\n"
-             "./jenkin_mon -f configFILE.xml --verbose --realled --daemon\n"
-             "./jenkin_mon -f configFILE.xml -v        -r        -d\n");
+             "./jenkin_mon -f configFILE.xml --verbose --realled --daemon --aggregate\n"
+             "./jenkin_mon -f configFILE.xml -v        -r        -d       -a\n"
+             "gpio backend is sysfs, if we want to change use --gpio sysfs|chardev|ledclass|mock\n"
+             "device of gpio backend can be changed (for testing) by --gpiodev\n"
+             "./jenkin_mon -r --gpio sysfs   --gpiodev /tmp/fakegpio     (default /sys/class/gpio)\n"
+             "./jenkin_mon -r --gpio chardev --gpiodev /dev/gpiochip1    (default /dev/gpiochip0)\n"
+             "./jenkin_mon -r --gpio ledclass --gpiodev /tmp/fakeleds    (default /sys/class/leds)\n"
+             "./jenkin_mon -r --gpio mock    --gpiodev /tmp/ledFrames.log\n"
+             "groups are fetched by one worker per core, if we want to change use --workers\n"
+             "./jenkin_mon --workers 4\n"
+             "jenkins can post build notifications (notification plugin, json, http) to --hook,\n"
+             "then jobs are polled only every 300 s in case a notification is lost,\n"
+             "job is matched by name, host and folder of build url (jenkins url has host of <server>)\n"
+             "hook listens on loopback if only port is given, on all interfaces by *:port,\n"
+             "a token can be required in url of notification (?token=) by --hooktoken\n"
+             "or by environment variable JENKIN_HOOK_TOKEN\n"
+             "./jenkin_mon --hook 8081\n"
+             "./jenkin_mon --hook 192.168.1.10:8081 --hooktoken s3cret\n"
+             "on the jenkins host (or a mirror of it) jobs can be read from JENKINS_HOME by --home,\n"
+             "changes of build.xml, config.xml, nextBuildNumber are watched by inotify, no http\n"
+             "./jenkin_mon --home /var/lib/jenkins\n"
+             "transitions of jobs and groups are appended to a binary log by --history DIR,\n"
+             "it is queried by jenkin_hist, e.g. red time of each group in last 7 days\n"
+             "./jenkin_mon --history /var/lib/jenkin_mon/history\n"
+             "./jenkin_hist -d /var/lib/jenkin_mon/history --from -7d --summary\n"
+             "builds which are already in JENKINS_HOME are indexed to history by jenkin_backfill\n"
+             "before jenkin_mon is started, jobs start from their last indexed build\n"
+             "./jenkin_backfill --home /var/lib/jenkins -d /var/lib/jenkin_mon/history\n"
+             "config file is reloaded on SIGHUP, only changed groups and jobs are touched\n"
+             "kill -HUP <pid of jenkin_mon>\n"
+             "leds can be dimmed and faded by software pwm on any gpio backend, --pwm HZ,\n"
+             "--brightness PERCENT (default 100) and --fade MS (default 300)\n"
+             "./jenkin_mon -r --pwm 200 --brightness 40 --fade 500\n"
+             "latencies and counters are served in Prometheus text format by --metrics,\n"
+             "on [host:]port or unix socket, e.g. curl http://127.0.0.1:9108/metrics\n"
+             "./jenkin_mon --metrics 127.0.0.1:9108\n"
+             "./jenkin_mon --metrics /run/jenkin_mon.sock\n"
+             "timeout of requests follows round trip time of server, a server which does not\n"
+             "answer is probed less and less often and its groups show led_unreachable (cyan)\n"
+             "./jenkin_fake --home ../jenkinJobsExample --drop 100     (server to test it)\n");
       exit(1);
    }
 
@@ -1526,12 +4659,6 @@ int main(int argc, char *argv[])
 		printf("signal() failed: %s", strerror(errno));
 	}
 
-   if (pthread_mutex_init(&g_terminateLock, NULL))
-   {
-      printf("Can not init mutex for terminate flag\n");
-      exit(1);
-   }
-
 	// register SIGTERM handle
 	while (signal(SIGTERM, sig_term) == SIG_ERR) {
 		printf("signal() failed: %s", strerror(errno));
@@ -1542,19 +4669,24 @@ int main(int argc, char *argv[])
 		printf("signal() failed: %s", strerror(errno));
 	}
 
-   GroupInfoT* p_allGroups = NULL;
+	// register SIGHUP handle to reload config file
+	while (signal(SIGHUP, sig_hup) == SIG_ERR) {
+		printf("signal() failed: %s", strerror(errno));
+	}
 
-   // Parse XML file
-   if (!parseXMLFile(g_xmlFile, &p_allGroups))
+   // Transitions are appended to history log from the first evaluation
+   if (g_historyDir && !historyOpen(&g_history, g_historyDir))
    {
-      printf("Can not parse XML file\n");
+      printf("Can not open history log %s\n", g_historyDir);
       exit(1);
    }
 
-   // Build files to store data get from curl commands for each jobs
-   if (!buildJobFiles(p_allGroups))
+   GroupInfoT* p_allGroups = NULL;
+
+   // Parse XML file
+   if (!parseXMLFile(g_xmlFile, &p_allGroups))
    {
-      printf("Can not buildJobFiles\n");
+      printf("Can not parse XML file\n");
       exit(1);
    }
 
@@ -1563,52 +4695,107 @@ int main(int argc, char *argv[])
    // Init Stuff of All Groups database
    initStuffOfAllGroup(p_allGroups);
 
+   // Last builds which are indexed by jenkin_backfill
+   loadBuildIndex(p_allGroups);
+
    // Init all LED of All groups
-   initAllGroupLed(p_allGroups);
+   if (!initAllGroupLed(p_allGroups))
+   {
+      printf("Can not init led\n");
+      exit(1);
+   }
+
+   JenkinServerT* p_allServers = NULL;
+   if (g_isAggregate)
+   {
+      // Build list of jenkin servers, each server will get information of
+      // all jobs by one query, then evaluate Color of its Groups
+      if (!buildServerList(p_allGroups, &p_allServers))
+      {
+         printf("Can not build jenkin server list\n");
+         exit(1);
+      }
+   }
 
-   // Build thread to Evaluate Color for each Group
-   // Each Group will have one thread to Evaluate Group's Color
-   if (!buildEvalGrpColorTheads(p_allGroups))
+   // Build notifications, changes of JENKINS_HOME and aggregated responses
+   // find their jobs by name, index is ready before the first fetch
+   if (hasJobIndex() && !buildJobIndex(p_allGroups, &g_jobIndex))
    {
-      printf("Can not build evalute color theads\n");
+      printf("Can not build job index\n");
+      exit(1);
    }
 
-   // Build thead to control Group's Led
-   // Each Group will have one thread to control its Led
-   if (!buildCtrlGrpLedThreads(p_allGroups))
+   // Build worker pool to fetch and evaluate color of all Groups
+   if (!buildWorkerPool(p_allGroups, p_allServers))
    {
-      printf("Can not build control led threads\n");
+      printf("Can not build worker pool\n");
+      exit(1);
    }
 
-#if 0
-   // DEAD lock occur if we write code in this way
-   // + Assume SIGINT occur when g_terminateLock is locked (this situation will occur very frequently
-   // because main thread executed these line of code almost time)
-   // + Main thread jump to sigterm() function.
-   // + in sigterm() function, we will wait for g_terminateLock is unlock.
-   // + But g_terminateLock can be unlock anymore, because it is locked in main thread itself!
-   // => deadlock
+   // Build thead to control Led of all Groups
+   if (!buildCtrlLedThread(p_allGroups))
+   {
+      printf("Can not build control led thread\n");
+   }
 
-   while (1)
+   // Listen for build notifications, polling is only a safety net then
+   if (g_hookAddr && !g_hookToken)
+   {
+      g_hookToken = getenv("JENKIN_HOOK_TOKEN");
+   }
+   if (g_hookAddr && !hookStart(&g_hook, g_hookAddr, g_hookToken, hookJobEntry, &g_jobIndex))
+   {
+      printf("Can not listen for build notifications\n");
+      exit(1);
+   }
+
+   // Watch files of jobs in JENKINS_HOME, reading them is only a safety net then
+   if (g_homeDir && !homeStart(&g_home, g_homeDir, homeJobEntry, &g_jobIndex))
    {
-      //Main thread will wait until g_terminateAll is true
-      pthread_mutex_lock(&g_terminateLock);
-      bool tempTerminate = g_terminateAll;
-      pthread_mutex_unlock(&g_terminateLock);
-      if (tempTerminate)
+      printf("Can not watch JENKINS_HOME %s\n", g_homeDir);
+      exit(1);
+   }
+
+   // Serve metrics of all groups and servers
+   if (g_metricsAddr)
+   {
+      g_metricsSource.pp_allGroups = &p_allGroups;
+      g_metricsSource.pp_allServers = &p_allServers;
+      if (!metricsStart(&g_metrics, g_metricsAddr, writeAllMetrics, &g_metricsSource))
       {
-         break;
+         printf("Can not serve metrics\n");
+         exit(1);
       }
    }
-#endif
 
-   //Waiting for all evaluated Color Threads and Led Control Threads stop
-   waitAllThreadsStop(p_allGroups);
+   // Main thread submits fetch tasks of Groups until it is terminated
+   dispatchPollTasks(&p_allGroups, &p_allServers);
+
+   //Waiting for all workers and Led Control Thread stop
+   waitAllThreadsStop();
+
+   printEvalCount(p_allGroups);
+
+   // Stop of daemon is recorded, states after it are unknown
+   if (g_historyDir)
+   {
+      historyClose(&g_history);
+   }
 
    // Clean all Group and job database /free data...
    cleanAllGroupInfo(p_allGroups);
-
-   pthread_mutex_destroy(&g_terminateLock);
+   cleanAllServerInfo(p_allServers);
+   breakerFreeAll(&g_breakers);
+   freeJobIndex(&g_jobIndex);
+   if (g_isCtrlRealLed && g_pwmHz)
+   {
+      pwmStop();
+      pwmPrintStats();
+   }
+   gpioCleanup();
+   schedFree(&g_ledSched);
+   schedFree(&g_pollSched);
 
 	return 0;
 }
+#endif
@@ -5,6 +5,18 @@
 #include <string.h>
 #include <pthread.h>
 #include <time.h>
+#include "jenkin_http.h"
+#include "jenkin_json.h"
+#include "jenkin_gpio.h"
+#include "jenkin_sched.h"
+#include "jenkin_pool.h"
+#include "jenkin_hook.h"
+#include "jenkin_home.h"
+#include "jenkin_history.h"
+#include "jenkin_pwm.h"
+#include "jenkin_metrics.h"
+#include "jenkin_arena.h"
+#include "jenkin_breaker.h"
 
 typedef unsigned char u_int8;
 typedef unsigned short u_int16;
@@ -16,15 +28,6 @@ typedef short int16;
 typedef int   int32;
 typedef long long int64;
 
-typedef struct jobInfo
-{
-   struct jobInfo* p_nextJob;
-   char* jobPath;
-   char* jobName;
-   char statusInfoFile[40];
-   char lastBuildInfoFile[40];
-}JobInfoT;
-
 typedef enum color
 {
    NO_BUILT,      // 0
@@ -42,7 +45,8 @@ typedef enum color
 typedef enum gpioStatus
 {
    ON = 0,
-   OF = 1
+   OF = 1,
+   BL = 2   // blink by gpio driver itself
 }GpioStatusE;
 
 typedef struct color2LedInfo
@@ -54,19 +58,7 @@ typedef struct color2LedInfo
    GpioStatusE b;
 }Color2LedInfoT;
 
-Color2LedInfoT C2LInfo[] =
-{
-   {NO_BUILT , "notbuilt", OF, OF, OF},
-   {DISABLED , "disabled", OF, OF, OF},
-   {RED_COLOR, "red"     , ON, OF, OF},
-   {GRE_COLOR, "green"   , OF, ON, OF},
-   {BLU_COLOR, "blue"    , OF, OF, ON},
-   {YEL_COLOR, "yellow"  , ON, ON, OF},
-   {CYA_COLOR, "cyan"    , OF, ON, ON},
-   {MAG_COLOR, "magenta" , ON, OF, ON},
-   {WHI_COLOR, "white"   , ON, ON, ON},
-   {NON_COLOR, "noColor" , OF, OF, OF}
-};
+extern Color2LedInfoT C2LInfo[];
 
 typedef struct ledInfo
 {
@@ -74,6 +66,60 @@ typedef struct ledInfo
    bool isAnime;
 }LedInfoT;
 
+typedef enum buildResult
+{
+   NO_RESULT,           // 0: job is building or does not have any build
+   SUCCESS_RESULT,      // 1
+   UNSTABLE_RESULT,     // 2
+   FAILURE_RESULT,      // 3
+   NOT_BUILT_RESULT,    // 4
+   ABORTED_RESULT       // 5
+}BuildResultE;
+
+typedef struct jobState
+{
+   LedInfoT led;
+   int64 lastBuildTimeStamp;     // in second
+   BuildResultE lastBuildResult;
+   u_int32 lastBuildNumber;      // 0 if it is not known
+   bool isUpdated;               // job is found in last response
+}JobStateT;
+
+//----------------------------------------------------------------
+// Polling policy: building job is polled fast, poll time of other jobs is
+// doubled every time they are polled without change, job is polled again
+// immediately when its state is changed
+//----------------------------------------------------------------
+typedef struct pollPolicy
+{
+   u_int16 buildingTime;         // in second, poll time of building job
+   u_int16 idleTime;             // in second, first poll time of idle job
+   u_int16 maxIdleTime;          // in second, limit of poll time of idle job
+}PollPolicyT;
+
+typedef struct pollState
+{
+   long long nextPollNs;         // CLOCK_MONOTONIC, 0 -> poll now
+   u_int32 delay;                // in second, current poll time
+}PollStateT;
+
+//----------------------------------------------------------------
+// Job lives in arena of config which it is parsed from, jobs of a group are
+// next to each other in arena. State which is changed by every poll comes
+// first, strings are in string zone of arena. Job does not hold reference
+// of arena, its group does.
+//----------------------------------------------------------------
+typedef struct jobInfo
+{
+   struct jobInfo* p_nextJob;
+   JobStateT state;
+   PollStateT poll;
+   u_int32 containerIdx;         // index of container path in jenkin server
+   u_int32 historyId;            // id in history log, 0 if it is not known yet
+   char* jobPath;
+   char* jobName;
+}JobInfoT;
+
 typedef struct groupStatus
 {
    // TODO: should use bit field for this datatype.
@@ -81,8 +127,48 @@ typedef struct groupStatus
    bool isThreshold;
    bool isBuilding;
    bool isSuccess;
+   bool isSuccessTimeout;        // success is shown longer than display_timeout
+   bool isUnreachable;           // breaker of server is open, states of jobs are old
 }GroupStatusT;
 
+// Group status packed into index of led table of group
+#define GROUP_STA_ALL_DISABLE     0x01
+#define GROUP_STA_BUILDING        0x02
+#define GROUP_STA_SUCCESS         0x04
+#define GROUP_STA_THRESHOLD       0x08
+#define GROUP_STA_SUCCESS_TIMEOUT 0x10
+#define GROUP_STA_UNREACHABLE     0x20
+#define GROUP_STA_COUNT           0x40
+
+#define COLOR_BIT(color)          (1u << (color))
+
+//----------------------------------------------------------------
+// Rules to get group status from state of its jobs
+// A status is set if at least quorum percent of counted jobs have it,
+// quorum 0 means at least one job. Jobs whose color is in disableColors
+// are not counted.
+//----------------------------------------------------------------
+//----------------------------------------------------------------
+// Brightness of red, green and blue channel of a color in percent of led
+// brightness, it is used with software pwm only
+//----------------------------------------------------------------
+typedef struct colorLevel
+{
+   u_int8 r;
+   u_int8 g;
+   u_int8 b;
+}ColorLevelT;
+
+typedef struct groupRule
+{
+   u_int16 successColors;        // COLOR_BIT of job colors which are success
+   u_int16 disableColors;        // COLOR_BIT of job colors which are not counted
+   u_int8 successQuorum;         // in percent
+   u_int8 buildingQuorum;        // in percent
+   u_int8 thresholdQuorum;       // in percent
+   ColorLevelT colorLevels[NON_COLOR + 1];   // by color, 100 for channel which is on
+}GroupRuleT;
+
 typedef struct serverInfo
 {
    char* serverName;
@@ -92,8 +178,7 @@ typedef struct serverInfo
 
 typedef struct curlTimeInfo
 {
-   u_int8   maxTime;            // in second
-   u_int8   pollTime;           // in second
+   u_int8   maxTime;            // in second, limit of timeout which breaker of server gives
 }CurlTimeInfoT;
 
 typedef struct ledGPIO
@@ -101,6 +186,9 @@ typedef struct ledGPIO
    u_int8 redLed;
    u_int8 greLed;
    u_int8 bluLed;
+   char* redLedName;    // name of led class device, NULL -> "gpioN"
+   char* greLedName;
+   char* bluLedName;
 }LedGpioT;
 
 typedef struct stdLedSta
@@ -111,24 +199,167 @@ typedef struct stdLedSta
    LedInfoT success;
    LedInfoT successNotShow;
    LedInfoT fail;
+   LedInfoT unreachable;
 }StdLedStaT; //Standard led status base on group status
 
+struct groupInfo;
+
+//----------------------------------------------------------------
+// Result of fetch task which is run (or resumed) one time
+//----------------------------------------------------------------
+typedef enum fetchResult
+{
+   FETCH_WAIT,          // request is in flight, task is resumed by its ioTimer
+   FETCH_OK,            // information is got, groups are evaluated
+   FETCH_FAILED         // nothing is got, target is polled again later
+}FetchResultE;
+
+//----------------------------------------------------------------
+// Request of a fetch task, its response is parsed by json extractor while it
+// is received. Task returns while socket of request is not ready and it is
+// resumed by main thread, so request lives in object which is fetched.
+//----------------------------------------------------------------
+typedef struct fetchRequest
+{
+   JsonExtractorT extractor;
+   long long startNs;            // request is sent
+   long long parseNs;            // time of parsing its response
+   bool isInFlight;              // task resumes request instead of sending a new one
+}FetchRequestT;
+
+//----------------------------------------------------------------
+// Argument of callback which spreads jobs of aggregated response
+//----------------------------------------------------------------
+typedef struct spreadJobArg
+{
+   struct jenkinServer* p_server;
+   u_int32 containerIdx;
+   bool isAnyChanged;
+   bool isAnyBuilding;
+}SpreadJobArgT;
+
+//----------------------------------------------------------------
+// Fetch of jenkin server which is in progress, one request per container
+//----------------------------------------------------------------
+typedef struct serverFetch
+{
+   FetchRequestT request;
+   SpreadJobArgT spreadArg;
+   bool* isFetched;              // by container, only jobs of them can be found missing
+   u_int32 containerIdx;         // container which is fetched
+   long long startNs;
+   long long parseNs;
+   bool isAnyOk;
+   bool isActive;                // fetch is started and it is not finished
+}ServerFetchT;
+
+//----------------------------------------------------------------
+// Jenkin server is shared by all groups which have the same server name.
+// In aggregated mode, each server is asked one time per cycle for each
+// container (root or folder) that has monitored jobs
+//----------------------------------------------------------------
+typedef struct jenkinServer
+{
+   struct jenkinServer* p_nextServer;
+   char* serverName;
+   HttpConnT httpConn;
+   BreakerT* p_breaker;          // shared with groups of server
+   SchedTimerT pollTimer;        // next time to submit fetchTask
+   SchedTimerT ioTimer;          // resumes fetchTask when its socket is ready
+   PoolTaskT fetchTask;
+   ServerFetchT fetch;
+   int pendingEvalCount;         // evaluate tasks of groups that are not done
+   PollPolicyT pollPolicy;       // fastest policy of its groups
+   PollStateT poll;
+   char** containerPaths;
+   u_int32 containerCount;
+   u_int32 groupCount;           // groups which are assigned to server
+   struct groupInfo* p_allGroups;
+   PollMetricsT metrics;         // written by worker which fetches server
+}JenkinServerT;
+
+//----------------------------------------------------------------
+// Metrics of group, they are allocated apart from group because only the
+// worker which writes them and metrics endpoint read them
+//----------------------------------------------------------------
+typedef struct groupMetrics
+{
+   PollMetricsT poll;               // written by worker which fetches group
+   MetricsHistT eval;               // written while lockJobSta is held
+   MetricsHistT led;                // led status change to led frame, led thread
+}GroupMetricsT;
+
+//----------------------------------------------------------------
+// Fetch of group which is in progress, two requests per job. It is allocated
+// apart from group like its metrics, only fetch task uses it.
+//----------------------------------------------------------------
+#define JOB_STEP_NONE         0     // request of job is not sent yet
+#define JOB_STEP_STATUS       1     // <job>/api/json
+#define JOB_STEP_LAST_BUILD   2     // <job>/lastBuild/api/json
+
+typedef struct groupFetch
+{
+   FetchRequestT request;
+   JsonJobEntryT entry;             // of job which is fetched
+   JobInfoT* p_job;                 // job which is fetched or is checked next
+   int jobStep;                     // JOB_STEP_xxx of p_job
+   long long startNs;
+   long long parseNs;
+   bool isAnyPolled;
+   bool isAnyOk;
+   bool isActive;                   // fetch is started and it is not finished
+}GroupFetchT;
+
+//----------------------------------------------------------------
+// Group lives in arena of config which it is parsed from. Its strings and
+// jobs are in arena of the last reloaded config which changes server, leds
+// or jobs of group (p_configArena), or in its own arena if there is none.
+// Group holds a reference of both arenas.
+// Jobs are kept as an array of structs, each job is small and its state
+// is read with its name, jobs of group are next to each other in arena.
+//----------------------------------------------------------------
 typedef struct groupInfo
 {
    struct groupInfo* p_nextGroup;
+   ArenaT* p_arena;
+   ArenaT* p_configArena;           // NULL if strings and jobs are in p_arena
    char* groupName;
    ServerInfoT server;
+   JenkinServerT* p_jenkinServer;
 
-   pthread_t ctrlLedThread;
    LedGpioT gpio;
-   LedInfoT ledStatus;
+   pthread_mutex_t lockJobSta;      // state of jobs, changed by workers and hook listener
+   u_int32 ledWord;                 // packed LedInfoT, it is only accessed atomically
    StdLedStaT stdLed;
-   pthread_mutex_t lockLedSta;
+   GroupRuleT rule;
+   LedInfoT ledTable[GROUP_STA_COUNT];    // led status by packed group status
+   bool isLedChanged;               // group is in list of changed groups, atomic
+   struct groupInfo* p_nextChangedGroup;
+   LedInfoT preLedSta;              // led status that is shown, used by led thread only
+   bool isLedRedraw;                // led is shown again even if status is not changed
+   GpioStatusE gpioSta;
+   SchedTimerT blinkTimer;          // next tick to toggle animated led
 
-   pthread_t evalColorThread;
+   SchedTimerT pollTimer;           // next time to submit fetchTask
+   SchedTimerT ioTimer;             // resumes fetchTask when its socket is ready
+   PoolTaskT fetchTask;
+   PoolTaskT evalTask;
    CurlTimeInfoT curlTime;
+   PollPolicyT pollPolicy;          // group is evaluated every idleTime
+   HttpConnT httpConn;
+   BreakerT* p_breaker;             // health of server, shared by groups of server
    GroupStatusT curSta;
    GroupStatusT preSta;
+   bool isJobChanged;               // some job is changed since last evaluation
+   int64 nextEvalTimeStamp;         // in second, led may change by time only
+   u_int64 evalCount;
+   u_int64 skipEvalCount;
+   u_int32 historyId;               // id in history log, 0 if it is not known yet
+   u_int32 historyWord;             // status and led which are logged last, 0 if none
+
+   GroupMetricsT* p_metrics;        // allocated by initGroupStuff()
+   GroupFetchT* p_fetch;            // allocated by initGroupStuff()
+   long long ledChangedNs;          // led status change which is not shown, atomic
 
    u_int16  displaySuccessTimeout;  // in second
    int64    lastSuccessTimeStamp;   // in second
@@ -139,6 +370,50 @@ typedef struct groupInfo
    JobInfoT* p_allJobs;
 }GroupInfoT;
 
+//----------------------------------------------------------------
+// Hash index of all jobs by job name, to find jobs of build notification
+// Open addressing, job which is monitored by many groups has many entries
+//----------------------------------------------------------------
+typedef struct jobIndexEntry
+{
+   u_int32 hash;
+   JobInfoT* p_job;                 // NULL if slot is empty
+   GroupInfoT* p_group;
+}JobIndexEntryT;
+
+typedef struct jobIndex
+{
+   JobIndexEntryT* p_entries;
+   u_int32 size;                    // power of 2
+   u_int32 count;                   // used slots
+}JobIndexT;
+
+//----------------------------------------------------------------
+// Running group which is matched with group of reloaded config by name
+//----------------------------------------------------------------
+#define GROUP_ATTR_CHANGED    0x01  // poll policy, display timeout, threshold, rules
+#define GROUP_SERVER_CHANGED  0x02  // server, user name, password
+#define GROUP_LED_CHANGED     0x04  // led pins or led names
+#define GROUP_JOBS_CHANGED    0x08  // job list
+
+typedef struct reloadGroup
+{
+   GroupInfoT* p_group;
+   GroupInfoT* p_newGroup;          // NULL if group is removed
+   u_int32 diff;                    // GROUP_xxx_CHANGED bits
+   bool isConnReady;                // connection of new server is initialized
+   bool needFetch;                  // group is fetched now after reloading
+}ReloadGroupT;
+
+//----------------------------------------------------------------
+// Groups and servers which are shown by metrics endpoint
+//----------------------------------------------------------------
+typedef struct metricsSource
+{
+   GroupInfoT** pp_allGroups;
+   JenkinServerT** pp_allServers;
+}MetricsSourceT;
+
 GroupInfoT* getTailGroup(GroupInfoT* p_headGroup);
 
 // Parse argument from command line
@@ -147,43 +422,118 @@ bool parseArgument(int argc, char* argv[]);
 // Parse Group
 bool parseXMLFile(const char* fileName, GroupInfoT** pp_headGroup);
 bool parseGroupAttr(xmlDoc *doc, xmlNode *groupNode, GroupInfoT* p_group);
+bool parseGroupRule(xmlDoc *doc, xmlNode *rulesNode, GroupInfoT* p_group);
+void setDefaultGroupRule(GroupInfoT* p_group);
+void compileGroupRule(GroupInfoT* p_group);
 void printAllGroupInfo(GroupInfoT* p_headGroup);
 void printGroupInfo(GroupInfoT* p_group);
 void initStuffOfAllGroup(GroupInfoT* p_headGroup);
+bool initGroupStuff(GroupInfoT* p_group);
+bool initGroupConn(GroupInfoT* p_group);
+void setDefaultPollPolicy(PollPolicyT* p_policy);
 
 // Parse Job
-bool parseJobsInfo(xmlDoc *doc, xmlNode *jobsNode, JobInfoT** p_headJob);
-bool parseJobAttr(xmlDoc *doc, xmlNode *jobNode, JobInfoT* p_job);
+bool parseJobsInfo(xmlDoc *doc, xmlNode *jobsNode, ArenaT* p_arena, JobInfoT** p_headJob);
+bool parseJobAttr(xmlDoc *doc, xmlNode *jobNode, ArenaT* p_arena, JobInfoT* p_job);
 void printAllJobInfo(JobInfoT* p_jobHead);
 void printJobInfo(JobInfoT* p_job);
 
-// Build Job Files
-bool buildJobFiles(GroupInfoT* p_headGroup);
-
-int64 timeStampFromFile(char* fileName);
 int64 currentTimeStamp(void);
-LedInfoT ledInfoFromfile(char* fileName);
-void colorFromFile(char* fileName, char* colorStr, size_t strSize);
 LedInfoT convert2LedInfo(char* colorStr);
+bool parseLedInfo(const char* colorStr, LedInfoT* p_led);
 void convert2ColorStr(LedInfoT led, char* colorStr, u_int32 strLength);
 char* convertRgb2ColorStr(GpioStatusE r, GpioStatusE g, GpioStatusE b);
 
-void initAllGroupLed(GroupInfoT* p_headGroup);
-void ledCtrl(ColorE color, GpioStatusE gpioState, LedGpioT gpioLed, char* stuffInfoStr);
+bool initAllGroupLed(GroupInfoT* p_headGroup);
+void ledCtrl(ColorE color, GpioStatusE gpioState, LedGpioT gpioLed,
+             const ColorLevelT* p_levels, char* stuffInfoStr);
+void pwmLedPin(unsigned int pin, bool isAnime, u_int32 percent);
+bool ledCanBlink(void);
 
-// Build threads to Evaluate Color for each Group
-bool buildEvalGrpColorTheads(GroupInfoT* p_headGroup);
-void* evalGrpColorPoll(void* arg);
-bool buildCurlCmd(GroupInfoT* p_group, char* curlCommand, u_int32 curlCommandSize);
-bool executeCurlCmd(char* curlCommand);
+// Fetch and evaluate color of groups by tasks of worker pool
+bool buildWorkerPool(GroupInfoT* p_headGroup, JenkinServerT* p_headServer);
+void initGroupTasks(GroupInfoT* p_group);
+void initServerTasks(JenkinServerT* p_server);
+void dispatchPollTasks(GroupInfoT** pp_allGroups, JenkinServerT** pp_allServers);
+void fetchGroupTask(PoolTaskT* p_task, PoolWorkerT* p_worker);
+void evalGroupTask(PoolTaskT* p_task, PoolWorkerT* p_worker);
+FetchResultE fetchGroupInfo(GroupInfoT* p_group);
+HttpProgressE fetchJson(HttpConnT* p_conn, BreakerT* p_breaker, const char* path,
+                        FetchRequestT* p_request, PollMetricsT* p_metrics,
+                        long long* p_parseNs, bool* p_isOk);
+void waitFetch(SchedTimerT* p_ioTimer, HttpConnT* p_conn);
+bool assignJobState(JobInfoT* p_job, const JsonJobEntryT* p_entry);
+bool isJobStateChanged(const JobStateT* p_preState, const JobStateT* p_curState);
+void updatePollState(const PollPolicyT* p_policy, PollStateT* p_poll,
+                     bool isBuilding, bool isChanged, long long nowNs);
+long long nextGroupPollNs(GroupInfoT* p_group);
 void evaluateColor(GroupInfoT* p_group);
 void evalGroupStatus(GroupInfoT* p_group);
+bool isServerUnreachable(const GroupInfoT* p_group);
+bool isJobDisabled(const GroupInfoT* p_group, const JobInfoT* p_job);
+u_int32 packGroupStatus(const GroupStatusT* p_status);
+int64 nextEvalTimeStamp(GroupInfoT* p_group, int64 curTime);
+void printEvalCount(GroupInfoT* p_headGroup);
 void evalLedStatus(GroupInfoT* p_group);
 void assignGrpLedStatus(GroupInfoT* p_group, LedInfoT ledInfo);
+LedInfoT loadGrpLedStatus(GroupInfoT* p_group);
+u_int32 packLedInfo(LedInfoT ledInfo);
+LedInfoT unpackLedInfo(u_int32 ledWord);
+void pushChangedLedGroup(GroupInfoT* p_group);
+GroupInfoT* takeChangedLedGroups(void);
+GroupInfoT* nextChangedLedGroup(GroupInfoT* p_group);
+
+// Build one thread to control led of all groups
+bool buildCtrlLedThread(GroupInfoT* p_headGroup);
+void* ctrlAllLedPoll(void* arg);
+void ctrlGrpLedFrame(GroupInfoT* p_group, GpioStatusE tickSta, long long nextTickNs);
+void redrawGrpLed(GroupInfoT* p_group);
+void pauseLedThread(void);
+void resumeLedThread(void);
+
+// Get information of all jobs from each jenkin server by one aggregated query
+bool buildServerList(GroupInfoT* p_headGroup, JenkinServerT** pp_headServer);
+JenkinServerT* assignGroupServer(GroupInfoT* p_group, JenkinServerT** pp_headServer);
+void resetServerGroups(JenkinServerT* p_headServer);
+void fetchServerTask(PoolTaskT* p_task, PoolWorkerT* p_worker);
+void evalServerGroupTask(PoolTaskT* p_task, PoolWorkerT* p_worker);
+long long nextServerPollNs(JenkinServerT* p_server);
+FetchResultE fetchServerInfo(JenkinServerT* p_server);
+BuildResultE convert2BuildResult(const char* resultStr);
+
+// Update jobs by build notifications which are posted by jenkins
+bool buildJobIndex(GroupInfoT* p_headGroup, JobIndexT* p_index);
+void freeJobIndex(JobIndexT* p_index);
+bool resizeJobIndex(JobIndexT* p_index, u_int32 size);
+bool jobIndexAdd(JobIndexT* p_index, JobInfoT* p_job, GroupInfoT* p_group);
+void jobIndexReplace(JobIndexT* p_index, JobInfoT* p_job, JobInfoT* p_newJob);
+void jobIndexRemove(JobIndexT* p_index, JobInfoT* p_job);
+u_int32 hashJobName(const char* jobName);
+void hookJobEntry(void* p_arg, const JsonJobEntryT* p_entry);
+void logJobHistory(JobInfoT* p_job);
+void logGroupHistory(GroupInfoT* p_group);
+void loadBuildIndex(GroupInfoT* p_headGroup);
+void homeJobEntry(void* p_arg, const char* containerPath, const JsonJobEntryT* p_entry);
+bool assignJobEvent(JobInfoT* p_job, const JsonJobEntryT* p_entry);
+
+// Reload xml file on SIGHUP, only changes are applied to running groups
+void reloadConfig(GroupInfoT** pp_allGroups, JenkinServerT** pp_allServers);
+u_int32 diffGroupConfig(const GroupInfoT* p_group, const GroupInfoT* p_newGroup);
+bool applyGroupConfig(GroupInfoT* p_group, GroupInfoT* p_newGroup, u_int32 diff,
+                      u_int32* p_addedJobs, u_int32* p_removedJobs);
+u_int32 mergeGroupJobs(GroupInfoT* p_group, GroupInfoT* p_newGroup, u_int32* p_removedCount);
+void removeGroup(GroupInfoT* p_group);
+void rebuildServerList(GroupInfoT* p_headGroup, JenkinServerT** pp_headServer);
 
-// Build threads to control led for each group'
-bool buildCtrlGrpLedThreads(GroupInfoT* p_headGroup);
-void* ctrlGrpLedPoll(void* arg);
+// Metrics endpoint
+void writeAllMetrics(void* p_arg, HttpBufferT* p_out);
+void writePollMetric(HttpBufferT* p_out, u_int32 family, const char* labelName,
+                     const char* labelValue, const PollMetricsT* p_metrics);
+void writeBreakerMetric(HttpBufferT* p_out, u_int32 family, BreakerT* p_breaker);
 
-void waitAllThreadsStop(GroupInfoT* p_headGroup);
+void waitAllThreadsStop(void);
 void cleanAllGroupInfo(GroupInfoT* p_headGroup);
+void cleanAllServerInfo(JenkinServerT* p_headServer);
+void freeGroupInfo(GroupInfoT* p_group);
+void freeGroupConfig(GroupInfoT* p_group);
+void freeServerInfo(JenkinServerT* p_server);
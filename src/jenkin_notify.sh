@@ -0,0 +1,31 @@
+#!/bin/sh
+
+# Post build notification as jenkins notification plugin does, to test
+# jenkin_mon --hook
+# usage: ./jenkin_notify.sh JOB PHASE [STATUS] [HOST:PORT]
+#	./jenkin_notify.sh cphw_1 STARTED
+#	./jenkin_notify.sh cphw_1 COMPLETED FAILURE localhost:8081
+
+JOB=$1
+PHASE=$2
+STATUS=${3:-SUCCESS}
+HOOK=${4:-localhost:8081}
+
+if [ -z "$JOB" ] || [ -z "$PHASE" ]; then
+	echo "usage: $0 JOB STARTED|COMPLETED|FINALIZED [SUCCESS|UNSTABLE|FAILURE|ABORTED] [HOST:PORT]"
+	exit 1
+fi
+
+if [ "$PHASE" = "STARTED" ]; then
+	STATUS_FIELD=""
+else
+	STATUS_FIELD="\"status\":\"$STATUS\","
+fi
+
+curl -s -S -X POST -H "Content-Type: application/json" \
+	-d "{\"name\":\"$JOB\",\"url\":\"job/$JOB/\",\"build\":{\"full_url\":\"http://jenkins/job/$JOB/1/\",\"number\":1,\"phase\":\"$PHASE\",$STATUS_FIELD\"url\":\"job/$JOB/1/\"}}" \
+	http://$HOOK/jenkins
+
+exit 0
+
+#End of file
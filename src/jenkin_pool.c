@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include "jenkin_pool.h"
+
+#define POOL_DEQUE_INIT_SIZE 64
+
+//----------------------------------------------------------------------------
+// Number of workers if it is not configured: one per core, but at least 2,
+// so that one worker waiting on network does not stop all other tasks
+//----------------------------------------------------------------------------
+unsigned int poolDefaultWorkers(void)
+{
+   long cores = sysconf(_SC_NPROCESSORS_ONLN);
+   return (cores < 2) ? 2 : (unsigned int)cores;
+}
+
+//----------------------------------------------------------------------------
+// Push task to tail of deque, deque grows if it is full
+//----------------------------------------------------------------------------
+static bool dequePush(PoolDequeT* p_deque, PoolTaskT* p_task)
+{
+   pthread_mutex_lock(&p_deque->lock);
+   if (p_deque->tail - p_deque->head == p_deque->size)
+   {
+      unsigned int newSize = p_deque->size * 2;
+      PoolTaskT** pp_newTasks = malloc(newSize * sizeof(PoolTaskT*));
+      if (!pp_newTasks)
+      {
+         pthread_mutex_unlock(&p_deque->lock);
+         return false;
+      }
+      unsigned int pos;
+      for (pos = p_deque->head; pos != p_deque->tail; pos++)
+      {
+         pp_newTasks[pos & (newSize - 1)] = p_deque->pp_tasks[pos & (p_deque->size - 1)];
+      }
+      free(p_deque->pp_tasks);
+      p_deque->pp_tasks = pp_newTasks;
+      p_deque->size = newSize;
+   }
+   p_deque->pp_tasks[p_deque->tail & (p_deque->size - 1)] = p_task;
+   p_deque->tail++;
+   pthread_mutex_unlock(&p_deque->lock);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Pop newest task from tail of deque, used by owner
+//----------------------------------------------------------------------------
+static PoolTaskT* dequePopTail(PoolDequeT* p_deque)
+{
+   PoolTaskT* p_task = NULL;
+   pthread_mutex_lock(&p_deque->lock);
+   if (p_deque->tail != p_deque->head)
+   {
+      p_deque->tail--;
+      p_task = p_deque->pp_tasks[p_deque->tail & (p_deque->size - 1)];
+   }
+   pthread_mutex_unlock(&p_deque->lock);
+   return p_task;
+}
+
+//----------------------------------------------------------------------------
+// Pop oldest task from head of deque, used by thieves
+//----------------------------------------------------------------------------
+static PoolTaskT* dequePopHead(PoolDequeT* p_deque)
+{
+   PoolTaskT* p_task = NULL;
+   pthread_mutex_lock(&p_deque->lock);
+   if (p_deque->tail != p_deque->head)
+   {
+      p_task = p_deque->pp_tasks[p_deque->head & (p_deque->size - 1)];
+      p_deque->head++;
+   }
+   pthread_mutex_unlock(&p_deque->lock);
+   return p_task;
+}
+
+//----------------------------------------------------------------------------
+// Count queued task and wake up one idle worker
+//----------------------------------------------------------------------------
+static void notifyQueued(PoolT* p_pool)
+{
+   pthread_mutex_lock(&p_pool->lock);
+   p_pool->queuedCount++;
+   pthread_cond_signal(&p_pool->cond);
+   pthread_mutex_unlock(&p_pool->lock);
+}
+
+//----------------------------------------------------------------------------
+// Get next task for worker: its own newest task, else steal oldest task of
+// other workers
+//----------------------------------------------------------------------------
+static PoolTaskT* takeTask(PoolWorkerT* p_worker)
+{
+   PoolT* p_pool = p_worker->p_pool;
+   PoolTaskT* p_task = dequePopTail(&p_worker->deque);
+   unsigned int offset;
+   for (offset = 1; !p_task && (offset < p_pool->workerCount); offset++)
+   {
+      PoolWorkerT* p_victim = &p_pool->p_workers[(p_worker->idx + offset) % p_pool->workerCount];
+      p_task = dequePopHead(&p_victim->deque);
+      if (p_task)
+      {
+         p_worker->stealCount++;
+      }
+   }
+   return p_task;
+}
+
+//----------------------------------------------------------------------------
+// Loop of worker thread
+//----------------------------------------------------------------------------
+static void* workerLoop(void* arg)
+{
+   PoolWorkerT* p_worker = (PoolWorkerT*)arg;
+   PoolT* p_pool = p_worker->p_pool;
+
+   while (1)
+   {
+      PoolTaskT* p_task = takeTask(p_worker);
+
+      pthread_mutex_lock(&p_pool->lock);
+      if (p_task)
+      {
+         p_pool->queuedCount--;
+         p_pool->busyCount++;
+      }
+      else
+      {
+         // queuedCount may be counted before task is pushed, or after it is
+         // taken, so it is only a hint to sleep
+         while ((p_pool->queuedCount <= 0) && !p_pool->isStopped)
+         {
+            pthread_cond_wait(&p_pool->cond, &p_pool->lock);
+         }
+      }
+      bool isStopped = p_pool->isStopped;
+      pthread_mutex_unlock(&p_pool->lock);
+      if (isStopped)
+      {
+         break;
+      }
+
+      if (p_task)
+      {
+         p_task->run(p_task, p_worker);
+         p_worker->runCount++;
+
+         // Tasks which are spawned by this task are counted already
+         pthread_mutex_lock(&p_pool->lock);
+         p_pool->busyCount--;
+         if ((p_pool->busyCount == 0) && (p_pool->queuedCount <= 0))
+         {
+            pthread_cond_broadcast(&p_pool->idleCond);
+         }
+         pthread_mutex_unlock(&p_pool->lock);
+      }
+   }
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Init pool and start its workers
+//----------------------------------------------------------------------------
+bool poolInit(PoolT* p_pool, unsigned int workerCount)
+{
+   memset(p_pool, 0, sizeof(PoolT));
+   pthread_mutex_init(&p_pool->lock, NULL);
+   pthread_cond_init(&p_pool->cond, NULL);
+   pthread_cond_init(&p_pool->idleCond, NULL);
+   p_pool->p_workers = calloc(workerCount, sizeof(PoolWorkerT));
+   if (!p_pool->p_workers)
+   {
+      return false;
+   }
+
+   p_pool->workerCount = workerCount;
+   unsigned int idx;
+   for (idx = 0; idx < workerCount; idx++)
+   {
+      PoolWorkerT* p_worker = &p_pool->p_workers[idx];
+      p_worker->p_pool = p_pool;
+      p_worker->idx = idx;
+      p_worker->deque.size = POOL_DEQUE_INIT_SIZE;
+      p_worker->deque.pp_tasks = malloc(POOL_DEQUE_INIT_SIZE * sizeof(PoolTaskT*));
+      pthread_mutex_init(&p_worker->deque.lock, NULL);
+   }
+   for (idx = 0; idx < workerCount; idx++)
+   {
+      if (pthread_create(&p_pool->p_workers[idx].thread, NULL, workerLoop, &p_pool->p_workers[idx]))
+      {
+         printf("Can not create worker thread\n");
+         poolStop(p_pool);
+         return false;
+      }
+      p_pool->startedCount++;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Queue task from any thread, workers get submitted tasks by round robin
+//----------------------------------------------------------------------------
+bool poolSubmit(PoolT* p_pool, PoolTaskT* p_task)
+{
+   pthread_mutex_lock(&p_pool->lock);
+   PoolWorkerT* p_worker = &p_pool->p_workers[p_pool->nextWorker];
+   p_pool->nextWorker = (p_pool->nextWorker + 1) % p_pool->workerCount;
+   pthread_mutex_unlock(&p_pool->lock);
+
+   if (!dequePush(&p_worker->deque, p_task))
+   {
+      return false;
+   }
+   notifyQueued(p_pool);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Queue task from a running task to deque of its worker, it is run next by
+// this worker unless an idle worker steals it
+//----------------------------------------------------------------------------
+bool poolSpawn(PoolWorkerT* p_worker, PoolTaskT* p_task)
+{
+   if (!dequePush(&p_worker->deque, p_task))
+   {
+      return false;
+   }
+   notifyQueued(p_worker->p_pool);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Wait until all queued tasks and tasks spawned by them are finished
+// Note: caller must not submit tasks meanwhile, and must not be a worker
+//----------------------------------------------------------------------------
+void poolWaitIdle(PoolT* p_pool)
+{
+   pthread_mutex_lock(&p_pool->lock);
+   while (((p_pool->busyCount > 0) || (p_pool->queuedCount > 0)) && !p_pool->isStopped)
+   {
+      pthread_cond_wait(&p_pool->idleCond, &p_pool->lock);
+   }
+   pthread_mutex_unlock(&p_pool->lock);
+}
+
+//----------------------------------------------------------------------------
+// Stop pool: running tasks are finished, queued tasks are dropped
+//----------------------------------------------------------------------------
+void poolStop(PoolT* p_pool)
+{
+   pthread_mutex_lock(&p_pool->lock);
+   p_pool->isStopped = true;
+   pthread_cond_broadcast(&p_pool->cond);
+   pthread_cond_broadcast(&p_pool->idleCond);
+   pthread_mutex_unlock(&p_pool->lock);
+
+   unsigned int idx;
+   for (idx = 0; idx < p_pool->startedCount; idx++)
+   {
+      pthread_join(p_pool->p_workers[idx].thread, NULL);
+   }
+   for (idx = 0; idx < p_pool->workerCount; idx++)
+   {
+      free(p_pool->p_workers[idx].deque.pp_tasks);
+      pthread_mutex_destroy(&p_pool->p_workers[idx].deque.lock);
+   }
+   free(p_pool->p_workers);
+   p_pool->p_workers = NULL;
+   p_pool->workerCount = 0;
+   p_pool->startedCount = 0;
+   pthread_cond_destroy(&p_pool->cond);
+   pthread_cond_destroy(&p_pool->idleCond);
+   pthread_mutex_destroy(&p_pool->lock);
+}
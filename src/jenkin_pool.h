@@ -0,0 +1,68 @@
+#ifndef JENKIN_POOL_H
+#define JENKIN_POOL_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+struct poolWorker;
+
+//----------------------------------------------------------------
+// Task that is run by a worker of pool
+// It is embedded in object that it works on, so that queuing a task does
+// not allocate memory. A task must not be queued again before it is run.
+//----------------------------------------------------------------
+typedef struct poolTask
+{
+   void (*run)(struct poolTask* p_task, struct poolWorker* p_worker);
+   void* p_arg;
+}PoolTaskT;
+
+//----------------------------------------------------------------
+// Double ended queue of a worker
+// Owner pushes and pops at tail (newest task first, its data is still in
+// cache), other workers steal from head (oldest task first)
+//----------------------------------------------------------------
+typedef struct poolDeque
+{
+   PoolTaskT** pp_tasks;
+   unsigned int size;         // power of 2
+   unsigned int head;
+   unsigned int tail;
+   pthread_mutex_t lock;
+}PoolDequeT;
+
+typedef struct poolWorker
+{
+   struct pool* p_pool;
+   unsigned int idx;
+   pthread_t thread;
+   PoolDequeT deque;
+   unsigned long long runCount;
+   unsigned long long stealCount;
+}PoolWorkerT;
+
+//----------------------------------------------------------------
+// Fixed pool of workers with work-stealing queues
+//----------------------------------------------------------------
+typedef struct pool
+{
+   PoolWorkerT* p_workers;
+   unsigned int workerCount;
+   unsigned int startedCount;  // workers whose thread is started
+   unsigned int nextWorker;   // worker that gets next submitted task
+   int queuedCount;           // tasks in all deques
+   int busyCount;             // workers which are running a task
+   bool isStopped;
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+   pthread_cond_t idleCond;   // signaled when no task is queued or running
+}PoolT;
+
+unsigned int poolDefaultWorkers(void);
+bool poolInit(PoolT* p_pool, unsigned int workerCount);
+bool poolSubmit(PoolT* p_pool, PoolTaskT* p_task);
+bool poolSpawn(PoolWorkerT* p_worker, PoolTaskT* p_task);
+void poolWaitIdle(PoolT* p_pool);
+void poolStop(PoolT* p_pool);
+
+#endif
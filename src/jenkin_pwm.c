@@ -0,0 +1,534 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include "jenkin_gpio.h"
+#include "jenkin_pwm.h"
+
+// Breathing curve is sampled at this number of steps per period
+#define PWM_BREATH_STEPS 256
+
+//----------------------------------------------------------------
+// Level of one pin: fade from fromLevel to toLevel, or breathing between
+// 0 and toLevel
+//----------------------------------------------------------------
+typedef struct pwmChannel
+{
+   bool isUsed;
+   unsigned int fromLevel;
+   unsigned int toLevel;
+   long long fadeStartNs;
+   long long fadeNs;                // 0 -> pin is at toLevel
+   long long breathNs;              // period of breathing, 0 -> not breathing
+}PwmChannelT;
+
+//----------------------------------------------------------------
+// Falling edge of a pin in current period
+//----------------------------------------------------------------
+typedef struct pwmEdge
+{
+   unsigned int pin;
+   long long offNs;                 // from start of period
+}PwmEdgeT;
+
+static PwmChannelT s_channels[GPIO_MAX_PIN];
+static unsigned int s_usedPins[GPIO_MAX_PIN];
+static unsigned int s_usedCount = 0;
+static unsigned int s_gamma[PWM_MAX_LEVEL + 1];        // duty of level
+static unsigned int s_breath[PWM_BREATH_STEPS];        // level in 1/PWM_DUTY_SCALE
+static long long s_periodNs = 0;
+static long long s_epochNs = 0;                        // phase of all breathing pins
+
+// Channels and statistics are protected by s_lock, s_cond wakes idle thread
+static pthread_t s_thread;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+static bool s_isStarted = false;
+static bool s_isStopping = false;
+static bool s_isChanged = false;
+static PwmStatsT s_stats;
+
+// Gpio is used by pwm thread while it is held, pins of gpio can be changed
+// by other thread while it holds the lock. Order: s_lock, then s_gpioLock.
+static pthread_mutex_t s_gpioLock = PTHREAD_MUTEX_INITIALIZER;
+
+//----------------------------------------------------------------------------
+// Get monotonic time in nano second
+//----------------------------------------------------------------------------
+static long long pwmNowNs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------------
+// Get cpu time of calling thread in nano second
+//----------------------------------------------------------------------------
+static long long threadCpuNs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------------
+// Build gamma table and breathing curve
+//----------------------------------------------------------------------------
+static void buildTables(void)
+{
+   unsigned int idx;
+   for (idx = 0; idx <= PWM_MAX_LEVEL; idx++)
+   {
+      s_gamma[idx] = (unsigned int)(pow((double)idx / PWM_MAX_LEVEL, PWM_GAMMA) *
+                                    PWM_DUTY_SCALE + 0.5);
+   }
+   for (idx = 0; idx < PWM_BREATH_STEPS; idx++)
+   {
+      // Raised cosine, breathing starts at full level
+      s_breath[idx] = (unsigned int)((1.0 + cos(2.0 * M_PI * idx / PWM_BREATH_STEPS)) / 2.0 *
+                                     PWM_DUTY_SCALE + 0.5);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Get duty of level in 1/PWM_DUTY_SCALE of period
+//----------------------------------------------------------------------------
+unsigned int pwmLevelDuty(unsigned int level)
+{
+   if (!s_gamma[PWM_MAX_LEVEL])
+   {
+      buildTables();
+   }
+   return s_gamma[(level > PWM_MAX_LEVEL) ? PWM_MAX_LEVEL : level];
+}
+
+//----------------------------------------------------------------------------
+// Get level of channel at given time
+// isSteady is false if level is still changing (fading or breathing)
+//----------------------------------------------------------------------------
+static unsigned int channelLevel(const PwmChannelT* p_channel, long long nowNs, bool* p_isSteady)
+{
+   if (p_channel->breathNs)
+   {
+      *p_isSteady = false;
+      long long phaseNs = (nowNs - s_epochNs) % p_channel->breathNs;
+      if (phaseNs < 0)
+      {
+         phaseNs += p_channel->breathNs;
+      }
+      unsigned int step = (unsigned int)(phaseNs * PWM_BREATH_STEPS / p_channel->breathNs);
+      return (unsigned int)((unsigned long long)p_channel->toLevel * s_breath[step] /
+                            PWM_DUTY_SCALE);
+   }
+
+   long long elapsedNs = nowNs - p_channel->fadeStartNs;
+   if ((p_channel->fadeNs == 0) || (elapsedNs >= p_channel->fadeNs))
+   {
+      *p_isSteady = true;
+      return p_channel->toLevel;
+   }
+   *p_isSteady = false;
+   long long delta = (long long)p_channel->toLevel - p_channel->fromLevel;
+   return (unsigned int)(p_channel->fromLevel + delta * elapsedNs / p_channel->fadeNs);
+}
+
+//----------------------------------------------------------------------------
+// Get channel of pin, pin is put to list of used pins at first use
+// Note: s_lock must be held
+//----------------------------------------------------------------------------
+static PwmChannelT* useChannel(unsigned int pin)
+{
+   PwmChannelT* p_channel = &s_channels[pin];
+   if (!p_channel->isUsed)
+   {
+      memset(p_channel, 0, sizeof(PwmChannelT));
+      p_channel->isUsed = true;
+      s_usedPins[s_usedCount++] = pin;
+   }
+   return p_channel;
+}
+
+//----------------------------------------------------------------------------
+// Fade pin from its current level to new level, level is perceptual
+// brightness 0..PWM_MAX_LEVEL, fadeMs 0 changes level at next period
+//----------------------------------------------------------------------------
+void pwmSetLevel(unsigned int pin, unsigned int level, unsigned int fadeMs)
+{
+   if (pin >= GPIO_MAX_PIN)
+   {
+      return;
+   }
+   pthread_mutex_lock(&s_lock);
+   long long nowNs = pwmNowNs();
+   PwmChannelT* p_channel = useChannel(pin);
+   bool isSteady;
+   p_channel->fromLevel = channelLevel(p_channel, nowNs, &isSteady);
+   p_channel->toLevel = (level > PWM_MAX_LEVEL) ? PWM_MAX_LEVEL : level;
+   p_channel->fadeStartNs = nowNs;
+   p_channel->fadeNs = (long long)fadeMs * 1000000LL;
+   p_channel->breathNs = 0;
+   s_isChanged = true;
+   pthread_cond_signal(&s_cond);
+   pthread_mutex_unlock(&s_lock);
+}
+
+//----------------------------------------------------------------------------
+// Let pin breathe between level and off, all breathing pins have the same
+// phase so that they look like one animation
+//----------------------------------------------------------------------------
+void pwmSetBreath(unsigned int pin, unsigned int level, unsigned int periodMs)
+{
+   if ((pin >= GPIO_MAX_PIN) || (periodMs == 0))
+   {
+      return;
+   }
+   pthread_mutex_lock(&s_lock);
+   PwmChannelT* p_channel = useChannel(pin);
+   p_channel->toLevel = (level > PWM_MAX_LEVEL) ? PWM_MAX_LEVEL : level;
+   p_channel->breathNs = (long long)periodMs * 1000000LL;
+   s_isChanged = true;
+   pthread_cond_signal(&s_cond);
+   pthread_mutex_unlock(&s_lock);
+}
+
+//----------------------------------------------------------------------------
+// Stop driving pin, it is not touched by pwm thread any more
+//----------------------------------------------------------------------------
+void pwmReleasePin(unsigned int pin)
+{
+   if (pin >= GPIO_MAX_PIN)
+   {
+      return;
+   }
+   pthread_mutex_lock(&s_lock);
+   if (!s_channels[pin].isUsed)
+   {
+      pthread_mutex_unlock(&s_lock);
+      return;
+   }
+   unsigned int idx;
+   for (idx = 0; idx < s_usedCount; idx++)
+   {
+      if (s_usedPins[idx] == pin)
+      {
+         s_usedPins[idx] = s_usedPins[--s_usedCount];
+         break;
+      }
+   }
+   s_channels[pin].isUsed = false;
+   s_isChanged = true;
+   pthread_cond_signal(&s_cond);
+   pthread_mutex_unlock(&s_lock);
+}
+
+//----------------------------------------------------------------------------
+// Take gpio from pwm thread, it waits until gpio is given back, at most one
+// period. Pins of gpio can be changed meanwhile.
+//----------------------------------------------------------------------------
+void pwmLockGpio(void)
+{
+   pthread_mutex_lock(&s_gpioLock);
+}
+
+//----------------------------------------------------------------------------
+// Give gpio back to pwm thread
+//----------------------------------------------------------------------------
+void pwmUnlockGpio(void)
+{
+   pthread_mutex_unlock(&s_gpioLock);
+}
+
+//----------------------------------------------------------------------------
+// Sleep until absolute deadline, then count jitter of wakeup
+// return time of wakeup
+//----------------------------------------------------------------------------
+static long long sleepUntil(long long deadlineNs, PwmStatsT* p_stats)
+{
+   struct timespec ts;
+   ts.tv_sec = deadlineNs / 1000000000LL;
+   ts.tv_nsec = deadlineNs % 1000000000LL;
+   while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+
+   long long nowNs = pwmNowNs();
+   long long jitterNs = (nowNs > deadlineNs) ? nowNs - deadlineNs : 0;
+   p_stats->wakeCount++;
+   p_stats->jitterSumNs += jitterNs;
+   if (jitterNs > p_stats->jitterMaxNs)
+   {
+      p_stats->jitterMaxNs = jitterNs;
+   }
+   unsigned int bucket = 0;
+   long long jitterUs = jitterNs / 1000;
+   while (jitterUs && (bucket < PWM_JITTER_BUCKETS - 1))
+   {
+      jitterUs >>= 1;
+      bucket++;
+   }
+   p_stats->jitterHist[bucket]++;
+   return nowNs;
+}
+
+//----------------------------------------------------------------------------
+// Add statistics of thread to shared statistics, cpu and run time are
+// counted from last merge
+// Note: s_lock must be held
+//----------------------------------------------------------------------------
+static void mergeStats(PwmStatsT* p_stats, long long* p_lastCpuNs, long long* p_lastRunNs)
+{
+   long long cpuNs = threadCpuNs();
+   long long runNs = pwmNowNs();
+   s_stats.cpuNs += cpuNs - *p_lastCpuNs;
+   s_stats.runNs += runNs - *p_lastRunNs;
+   *p_lastCpuNs = cpuNs;
+   *p_lastRunNs = runNs;
+   s_stats.periodCount += p_stats->periodCount;
+   s_stats.wakeCount += p_stats->wakeCount;
+   s_stats.overrunCount += p_stats->overrunCount;
+   s_stats.jitterSumNs += p_stats->jitterSumNs;
+   if (p_stats->jitterMaxNs > s_stats.jitterMaxNs)
+   {
+      s_stats.jitterMaxNs = p_stats->jitterMaxNs;
+   }
+   unsigned int idx;
+   for (idx = 0; idx < PWM_JITTER_BUCKETS; idx++)
+   {
+      s_stats.jitterHist[idx] += p_stats->jitterHist[idx];
+   }
+   memset(p_stats, 0, sizeof(PwmStatsT));
+}
+
+//----------------------------------------------------------------------------
+// Loop of pwm thread, one iteration is one period
+//----------------------------------------------------------------------------
+static void* pwmLoop(void* arg)
+{
+   PwmEdgeT edges[GPIO_MAX_PIN];
+   PwmStatsT localStats;
+   memset(&localStats, 0, sizeof(localStats));
+   long long lastCpuNs = threadCpuNs();
+   long long lastRunNs = pwmNowNs();
+   long long periodStartNs = lastRunNs;
+
+   pthread_mutex_lock(&s_lock);
+   while (!s_isStopping)
+   {
+      // Get duty of all pins for this period
+      bool isIdle = true;
+      unsigned int edgeCount = 0;
+      unsigned int idx;
+      for (idx = 0; idx < s_usedCount; idx++)
+      {
+         unsigned int pin = s_usedPins[idx];
+         bool isSteady;
+         unsigned int duty = s_gamma[channelLevel(&s_channels[pin], periodStartNs, &isSteady)];
+         if (!isSteady || ((duty > 0) && (duty < PWM_DUTY_SCALE)))
+         {
+            isIdle = false;
+         }
+         edges[edgeCount].pin = pin;
+         edges[edgeCount].offNs = s_periodNs * duty / PWM_DUTY_SCALE;
+         edgeCount++;
+      }
+      s_isChanged = false;
+      mergeStats(&localStats, &lastCpuNs, &lastRunNs);
+
+      if (isIdle)
+      {
+         // Every pin is fully on or off, sleep until a level is changed
+         pthread_mutex_lock(&s_gpioLock);
+         for (idx = 0; idx < edgeCount; idx++)
+         {
+            gpioSetValue(edges[idx].pin, edges[idx].offNs ? 0 : 1);
+         }
+         gpioCommit();
+         pthread_mutex_unlock(&s_gpioLock);
+         while (!s_isChanged && !s_isStopping)
+         {
+            pthread_cond_wait(&s_cond, &s_lock);
+         }
+         periodStartNs = pwmNowNs();
+         continue;
+      }
+      pthread_mutex_unlock(&s_lock);
+
+      // Sort falling edges by time, few pins -> insertion sort
+      for (idx = 1; idx < edgeCount; idx++)
+      {
+         PwmEdgeT edge = edges[idx];
+         unsigned int pos = idx;
+         while ((pos > 0) && (edges[pos - 1].offNs > edge.offNs))
+         {
+            edges[pos] = edges[pos - 1];
+            pos--;
+         }
+         edges[pos] = edge;
+      }
+
+      // Rising edge of all pins which are on in this period (led is active low)
+      pthread_mutex_lock(&s_gpioLock);
+      for (idx = 0; idx < edgeCount; idx++)
+      {
+         gpioSetValue(edges[idx].pin, edges[idx].offNs ? 0 : 1);
+      }
+      gpioCommit();
+
+      // Falling edges, pins which are on in whole period are not touched
+      idx = 0;
+      while ((idx < edgeCount) && (edges[idx].offNs == 0))
+      {
+         idx++;
+      }
+      while ((idx < edgeCount) && (edges[idx].offNs < s_periodNs))
+      {
+         long long deadlineNs = periodStartNs + edges[idx].offNs;
+         sleepUntil(deadlineNs, &localStats);
+         while ((idx < edgeCount) && (edges[idx].offNs < s_periodNs) &&
+                (periodStartNs + edges[idx].offNs <= deadlineNs + PWM_MIN_EDGE_NS))
+         {
+            gpioSetValue(edges[idx].pin, 1);
+            idx++;
+         }
+         gpioCommit();
+      }
+      pthread_mutex_unlock(&s_gpioLock);
+
+      localStats.periodCount++;
+      periodStartNs += s_periodNs;
+      long long nowNs = sleepUntil(periodStartNs, &localStats);
+      if (nowNs - periodStartNs > s_periodNs)
+      {
+         // Thread was not run for more than one period, start again from now
+         localStats.overrunCount++;
+         periodStartNs = nowNs;
+      }
+      pthread_mutex_lock(&s_lock);
+   }
+
+   mergeStats(&localStats, &lastCpuNs, &lastRunNs);
+   pthread_mutex_unlock(&s_lock);
+   return 0;
+}
+
+//----------------------------------------------------------------------------
+// Start pwm thread with given frequency, all pins are not used until their
+// level is set
+//----------------------------------------------------------------------------
+bool pwmStart(unsigned int hz)
+{
+   if (s_isStarted || (hz == 0))
+   {
+      return s_isStarted;
+   }
+   buildTables();
+   pthread_mutex_lock(&s_lock);
+   unsigned int idx;
+   for (idx = 0; idx < s_usedCount; idx++)
+   {
+      s_channels[s_usedPins[idx]].isUsed = false;
+   }
+   s_usedCount = 0;
+   s_periodNs = 1000000000LL / hz;
+   if (s_epochNs == 0)
+   {
+      s_epochNs = pwmNowNs();
+   }
+   s_stats.hz = hz;
+   s_isStopping = false;
+   s_isChanged = false;
+   pthread_mutex_unlock(&s_lock);
+
+   if (pthread_create(&s_thread, NULL, pwmLoop, NULL))
+   {
+      printf("Can not create pwm thread\n");
+      return false;
+   }
+
+   // Real time priority keeps jitter low, it needs privilege
+   struct sched_param param;
+   memset(&param, 0, sizeof(param));
+   param.sched_priority = 1;
+   s_stats.isRealTime = (pthread_setschedparam(s_thread, SCHED_FIFO, &param) == 0);
+   s_isStarted = true;
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Stop pwm thread, pins keep their last value
+//----------------------------------------------------------------------------
+void pwmStop(void)
+{
+   if (!s_isStarted)
+   {
+      return;
+   }
+   pthread_mutex_lock(&s_lock);
+   s_isStopping = true;
+   pthread_cond_signal(&s_cond);
+   pthread_mutex_unlock(&s_lock);
+   pthread_join(s_thread, NULL);
+   s_isStarted = false;
+}
+
+//----------------------------------------------------------------------------
+// Get copy of statistics
+//----------------------------------------------------------------------------
+void pwmGetStats(PwmStatsT* p_stats)
+{
+   pthread_mutex_lock(&s_lock);
+   *p_stats = s_stats;
+   pthread_mutex_unlock(&s_lock);
+}
+
+//----------------------------------------------------------------------------
+// Clear statistics, pwm thread counts again from now
+//----------------------------------------------------------------------------
+void pwmResetStats(void)
+{
+   pthread_mutex_lock(&s_lock);
+   unsigned int hz = s_stats.hz;
+   bool isRealTime = s_stats.isRealTime;
+   memset(&s_stats, 0, sizeof(s_stats));
+   s_stats.hz = hz;
+   s_stats.isRealTime = isRealTime;
+   pthread_mutex_unlock(&s_lock);
+}
+
+//----------------------------------------------------------------------------
+// Get upper bound of jitter of given percent of wakeups, in micro second
+//----------------------------------------------------------------------------
+unsigned int pwmJitterPercentileUs(const PwmStatsT* p_stats, unsigned int percent)
+{
+   unsigned long long limit = (p_stats->wakeCount * percent + 99) / 100;
+   unsigned long long count = 0;
+   unsigned int bucket;
+   for (bucket = 0; bucket < PWM_JITTER_BUCKETS - 1; bucket++)
+   {
+      count += p_stats->jitterHist[bucket];
+      if (count >= limit)
+      {
+         break;
+      }
+   }
+   return 1u << bucket;
+}
+
+//----------------------------------------------------------------------------
+// Print cpu budget and jitter of pwm thread
+//----------------------------------------------------------------------------
+void pwmPrintStats(void)
+{
+   PwmStatsT stats;
+   pwmGetStats(&stats);
+   printf("pwm %u Hz%s: %llu periods, %llu wakeups, %llu overruns, "
+          "jitter avg %lld us, p99 < %u us, max %lld us, cpu %.3f%%\n",
+          stats.hz, stats.isRealTime ? " (SCHED_FIFO)" : "",
+          stats.periodCount, stats.wakeCount, stats.overrunCount,
+          stats.wakeCount ? stats.jitterSumNs / (long long)stats.wakeCount / 1000 : 0,
+          pwmJitterPercentileUs(&stats, 99), stats.jitterMaxNs / 1000,
+          stats.runNs ? 100.0 * stats.cpuNs / stats.runNs : 0.0);
+}
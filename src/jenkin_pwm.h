@@ -0,0 +1,61 @@
+#ifndef JENKIN_PWM_H
+#define JENKIN_PWM_H
+
+#include <stdbool.h>
+
+// Brightness level is perceptual (before gamma correction)
+#define PWM_MAX_LEVEL     255
+#define PWM_GAMMA         2.2
+
+// Duty of a level is given in 1/PWM_DUTY_SCALE of period
+#define PWM_DUTY_SCALE    65536
+
+// Edges of pins that are closer than this are written in one frame
+#define PWM_MIN_EDGE_NS   20000
+
+// Jitter histogram: bucket N counts wakeups with jitter < 2^N us
+#define PWM_JITTER_BUCKETS 16
+
+//----------------------------------------------------------------
+// Statistics of pwm thread
+//----------------------------------------------------------------
+typedef struct pwmStats
+{
+   unsigned int hz;
+   bool isRealTime;                 // thread runs with SCHED_FIFO
+   unsigned long long periodCount;
+   unsigned long long wakeCount;    // wakeups at period starts and edges
+   unsigned long long overrunCount; // periods which are missed
+   long long jitterSumNs;           // wakeup time - deadline
+   long long jitterMaxNs;
+   unsigned long long jitterHist[PWM_JITTER_BUCKETS];
+   long long cpuNs;                 // cpu time of pwm thread
+   long long runNs;                 // time while pwm thread is started
+}PwmStatsT;
+
+//----------------------------------------------------------------
+// Software pwm engine for led pins of gpio driver
+// One thread owns gpio after pwmStart(): at start of each period it turns
+// on pins whose duty is not 0, then sleeps to absolute deadline of each
+// falling edge and turns pins off, so it wakes up at most once per distinct
+// duty. Levels are gamma corrected, changes of level are faded linearly
+// in perceptual space and breathing pins share one phase. Thread does not
+// wake up at all when every pin is fully on or fully off.
+// Pins must be requested and gpio must be started before pwmStart().
+// Level of a pin can be set by any thread. Pins of gpio can be changed while
+// pwm thread runs if gpio is taken by pwmLockGpio().
+//----------------------------------------------------------------
+bool pwmStart(unsigned int hz);
+void pwmStop(void);
+void pwmSetLevel(unsigned int pin, unsigned int level, unsigned int fadeMs);
+void pwmSetBreath(unsigned int pin, unsigned int level, unsigned int periodMs);
+void pwmReleasePin(unsigned int pin);
+void pwmLockGpio(void);
+void pwmUnlockGpio(void);
+unsigned int pwmLevelDuty(unsigned int level);
+void pwmGetStats(PwmStatsT* p_stats);
+void pwmResetStats(void);
+unsigned int pwmJitterPercentileUs(const PwmStatsT* p_stats, unsigned int percent);
+void pwmPrintStats(void);
+
+#endif
@@ -0,0 +1,225 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "jenkin_scan.h"
+
+//----------------------------------------------------------------------------
+// Find field which is not found yet and whose name is the name of start tag
+// p points to '<' of tag, p_close points to its '>'
+// return NULL if tag is not a field
+//----------------------------------------------------------------------------
+static XmlFieldT* findField(XmlScanT* p_scan, const char* p, const char* p_close)
+{
+   int idx;
+   for (idx = 0; idx < p_scan->fieldCount; idx++)
+   {
+      XmlFieldT* p_field = &p_scan->p_fields[idx];
+      size_t nameLen = strlen(p_field->name);
+      if (!p_field->isFound && ((size_t)(p_close - p - 1) >= nameLen) &&
+          !memcmp(p + 1, p_field->name, nameLen) &&
+          ((p[1 + nameLen] == '>') || (p[1 + nameLen] == '/') ||
+           isspace((unsigned char)p[1 + nameLen])))
+      {
+         return p_field;
+      }
+   }
+   return NULL;
+}
+
+//----------------------------------------------------------------------------
+// Set value of field to text of element, trimmed and cut to size of value
+//----------------------------------------------------------------------------
+static void setFieldValue(XmlFieldT* p_field, const char* p_text, const char* p_textEnd)
+{
+   while ((p_text < p_textEnd) && isspace((unsigned char)*p_text))
+   {
+      p_text++;
+   }
+   while ((p_textEnd > p_text) && isspace((unsigned char)p_textEnd[-1]))
+   {
+      p_textEnd--;
+   }
+   size_t textLen = p_textEnd - p_text;
+   if (textLen >= p_field->valueSize)
+   {
+      textLen = p_field->valueSize - 1;
+   }
+   memcpy(p_field->value, p_text, textLen);
+   p_field->value[textLen] = 0;
+   p_field->isFound = true;
+}
+
+//----------------------------------------------------------------------------
+// Scan chunk of file for children of root element. Markup or text which is
+// not complete at end of chunk is left for the next chunk, unless it is end
+// of file or nothing is scanned yet from a full buffer (then a long tag is
+// skipped and a long text is cut).
+// return number of bytes which are scanned
+//----------------------------------------------------------------------------
+static size_t scanChunk(XmlScanT* p_scan, const char* data, size_t len, bool isEnd, bool isFull)
+{
+   const char* p_end = data + len;
+   const char* p = data;
+   while ((p < p_end) && (p_scan->foundCount < p_scan->fieldCount))
+   {
+      bool canWait = !isEnd && (!isFull || (p > data));
+      if (p_scan->skipUntil)
+      {
+         size_t termLen = strlen(p_scan->skipUntil);
+         const char* p_term = memmem(p, p_end - p, p_scan->skipUntil, termLen);
+         bool isTag = !strcmp(p_scan->skipUntil, ">");
+         if (!p_term)
+         {
+            // Tail may be start of terminator, the last char of long tag is
+            // kept to see if it is an empty element
+            size_t keepLen = isTag ? 1 : termLen - 1;
+            if ((size_t)(p_end - p) < keepLen)
+            {
+               keepLen = p_end - p;
+            }
+            return isEnd ? len : len - keepLen;
+         }
+         if (isTag && (p_term[-1] != '/'))
+         {
+            p_scan->depth++;
+         }
+         p_scan->skipUntil = NULL;
+         p = p_term + termLen;
+         continue;
+      }
+
+      p = memchr(p, '<', p_end - p);
+      if (!p)
+      {
+         // Text between elements is not needed
+         return len;
+      }
+      if ((p_end - p < 9) && canWait)
+      {
+         return p - data;
+      }
+      if (p_end - p < 2)
+      {
+         return len;
+      }
+      if ((p_end - p >= 4) && !memcmp(p, "<!--", 4))
+      {
+         p_scan->skipUntil = "-->";
+         p += 4;
+         continue;
+      }
+      if ((p_end - p >= 9) && !memcmp(p, "<![CDATA[", 9))
+      {
+         p_scan->skipUntil = "]]>";
+         p += 9;
+         continue;
+      }
+      const char* p_close = memchr(p, '>', p_end - p);
+      if (!p_close)
+      {
+         if (canWait)
+         {
+            return p - data;
+         }
+         p_scan->skipUntil = ">";
+         p++;
+         continue;
+      }
+      if ((p[1] == '?') || (p[1] == '!'))
+      {
+         p = p_close + 1;
+         continue;
+      }
+      if (p[1] == '/')
+      {
+         p_scan->depth--;
+         p = p_close + 1;
+         continue;
+      }
+
+      bool isEmpty = (p_close[-1] == '/');
+      XmlFieldT* p_field = (p_scan->depth == 1) ? findField(p_scan, p, p_close) : NULL;
+      if (p_field)
+      {
+         const char* p_text = p_close + 1;
+         const char* p_textEnd = isEmpty ? p_text : memchr(p_text, '<', p_end - p_text);
+         if (!p_textEnd)
+         {
+            if (canWait)
+            {
+               return p - data;
+            }
+            p_textEnd = p_end;
+         }
+         setFieldValue(p_field, p_text, p_textEnd);
+         p_scan->foundCount++;
+      }
+      if (!isEmpty)
+      {
+         p_scan->depth++;
+      }
+      p = p_close + 1;
+   }
+   return p - data;
+}
+
+//----------------------------------------------------------------------------
+// Get text of children of root element of xml file, e.g. <result> of
+//    <build><actions>...</actions><result>SUCCESS</result></build>
+// Elements with the same name deeper in tree (in <actions>) are skipped.
+// File is read by chunks of SCAN_BUF_SIZE and reading stops when all
+// fields are found, so a build.xml with huge test report costs no more
+// memory than a small one.
+// This is not a full xml parser, it only walks over tags, that is enough
+// for files which are written by jenkins and does not touch libxml2 which
+// is cleaned up by reloading config in other thread.
+// return false if file can not be opened
+//----------------------------------------------------------------------------
+bool scanXmlFile(const char* path, XmlFieldT* p_fields, int fieldCount)
+{
+   int idx;
+   for (idx = 0; idx < fieldCount; idx++)
+   {
+      p_fields[idx].value[0] = 0;
+      p_fields[idx].isFound = false;
+   }
+   int fd = open(path, O_RDONLY | O_CLOEXEC);
+   if (fd < 0)
+   {
+      return false;
+   }
+
+   XmlScanT scan;
+   memset(&scan, 0, sizeof(scan));
+   scan.p_fields = p_fields;
+   scan.fieldCount = fieldCount;
+   char buf[SCAN_BUF_SIZE];
+   size_t len = 0;
+   bool isEnd = false;
+   while (!isEnd && (scan.foundCount < fieldCount))
+   {
+      ssize_t n = read(fd, buf + len, sizeof(buf) - len);
+      if ((n < 0) && (errno == EINTR))
+      {
+         continue;
+      }
+      if (n > 0)
+      {
+         len += n;
+      }
+      isEnd = (n <= 0);
+
+      // A full buffer is always scanned in part at least, so it has room
+      // for the next read
+      size_t scanLen = scanChunk(&scan, buf, len, isEnd, len == sizeof(buf));
+      memmove(buf, buf + scanLen, len - scanLen);
+      len -= scanLen;
+   }
+   close(fd);
+   return true;
+}
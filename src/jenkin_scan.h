@@ -0,0 +1,37 @@
+#ifndef JENKIN_SCAN_H
+#define JENKIN_SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Size of buffer which file is read by, it is on stack of caller.
+// Text of a field must fit in it, longer text is cut.
+#define SCAN_BUF_SIZE (16 * 1024)
+
+//----------------------------------------------------------------
+// Child of root element of xml file which is searched by scanXmlFile(),
+// value is "" if element is not found
+//----------------------------------------------------------------
+typedef struct xmlField
+{
+   const char* name;
+   char* value;
+   size_t valueSize;
+   bool isFound;
+}XmlFieldT;
+
+//----------------------------------------------------------------
+// State of scanning which is kept between chunks of file
+//----------------------------------------------------------------
+typedef struct xmlScan
+{
+   XmlFieldT* p_fields;
+   int fieldCount;
+   int foundCount;
+   int depth;
+   const char* skipUntil;           // end of comment or cdata which is skipped
+}XmlScanT;
+
+bool scanXmlFile(const char* path, XmlFieldT* p_fields, int fieldCount);
+
+#endif
@@ -0,0 +1,419 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include "jenkin_sched.h"
+
+//----------------------------------------------------------------------------
+// Get monotonic time in nano second
+//----------------------------------------------------------------------------
+long long schedNowNs(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------------
+// Create timerfd, eventfd and epoll of scheduler
+// Own fds are told from watched fds by their data in epoll, which points to
+// the fd in scheduler instead of a timer
+//----------------------------------------------------------------------------
+bool schedInit(SchedulerT* p_sched)
+{
+   memset(p_sched, 0, sizeof(SchedulerT));
+   pthread_mutex_init(&p_sched->postLock, NULL);
+   p_sched->wakeFd = -1;
+   p_sched->epollFd = -1;
+   p_sched->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+   if (p_sched->timerFd < 0)
+   {
+      printf("Can not create timerfd: %s\n", strerror(errno));
+      return false;
+   }
+   p_sched->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   if (p_sched->wakeFd < 0)
+   {
+      printf("Can not create eventfd: %s\n", strerror(errno));
+      schedFree(p_sched);
+      return false;
+   }
+
+   struct epoll_event timerEvent;
+   struct epoll_event wakeEvent;
+   memset(&timerEvent, 0, sizeof(timerEvent));
+   memset(&wakeEvent, 0, sizeof(wakeEvent));
+   timerEvent.events = EPOLLIN;
+   timerEvent.data.ptr = &p_sched->timerFd;
+   wakeEvent.events = EPOLLIN;
+   wakeEvent.data.ptr = &p_sched->wakeFd;
+   p_sched->epollFd = epoll_create1(EPOLL_CLOEXEC);
+   if ((p_sched->epollFd < 0) ||
+       epoll_ctl(p_sched->epollFd, EPOLL_CTL_ADD, p_sched->timerFd, &timerEvent) ||
+       epoll_ctl(p_sched->epollFd, EPOLL_CTL_ADD, p_sched->wakeFd, &wakeEvent))
+   {
+      printf("Can not create epoll of scheduler: %s\n", strerror(errno));
+      schedFree(p_sched);
+      return false;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Free scheduler, timers in queue are not touched
+//----------------------------------------------------------------------------
+void schedFree(SchedulerT* p_sched)
+{
+   if (p_sched->timerFd >= 0)
+   {
+      close(p_sched->timerFd);
+   }
+   if (p_sched->wakeFd >= 0)
+   {
+      close(p_sched->wakeFd);
+   }
+   if (p_sched->epollFd >= 0)
+   {
+      close(p_sched->epollFd);
+   }
+   free(p_sched->pp_heap);
+   p_sched->pp_heap = NULL;
+   p_sched->count = 0;
+   p_sched->size = 0;
+   p_sched->armedNs = 0;
+   p_sched->timerFd = -1;
+   p_sched->wakeFd = -1;
+   p_sched->epollFd = -1;
+   p_sched->p_posted = NULL;
+}
+
+//----------------------------------------------------------------------------
+// Init timer which is not queued
+//----------------------------------------------------------------------------
+void schedTimerInit(SchedTimerT* p_timer, void* p_arg)
+{
+   p_timer->deadlineNs = 0;
+   p_timer->heapIdx = -1;
+   p_timer->p_arg = p_arg;
+   p_timer->p_nextPosted = NULL;
+   p_timer->postedNs = 0;
+   p_timer->isPosted = false;
+}
+
+//----------------------------------------------------------------------------
+// Put timer to its position in heap
+//----------------------------------------------------------------------------
+static void heapSet(SchedulerT* p_sched, unsigned int idx, SchedTimerT* p_timer)
+{
+   p_sched->pp_heap[idx] = p_timer;
+   p_timer->heapIdx = idx;
+}
+
+//----------------------------------------------------------------------------
+// Move timer up until its parent has earlier deadline
+//----------------------------------------------------------------------------
+static void heapUp(SchedulerT* p_sched, unsigned int idx)
+{
+   SchedTimerT* p_timer = p_sched->pp_heap[idx];
+   while (idx > 0)
+   {
+      unsigned int parent = (idx - 1) / 2;
+      if (p_sched->pp_heap[parent]->deadlineNs <= p_timer->deadlineNs)
+      {
+         break;
+      }
+      heapSet(p_sched, idx, p_sched->pp_heap[parent]);
+      idx = parent;
+   }
+   heapSet(p_sched, idx, p_timer);
+}
+
+//----------------------------------------------------------------------------
+// Move timer down until its children have later deadline
+//----------------------------------------------------------------------------
+static void heapDown(SchedulerT* p_sched, unsigned int idx)
+{
+   SchedTimerT* p_timer = p_sched->pp_heap[idx];
+   while (1)
+   {
+      unsigned int child = idx * 2 + 1;
+      if (child >= p_sched->count)
+      {
+         break;
+      }
+      if ((child + 1 < p_sched->count) &&
+          (p_sched->pp_heap[child + 1]->deadlineNs < p_sched->pp_heap[child]->deadlineNs))
+      {
+         child++;
+      }
+      if (p_timer->deadlineNs <= p_sched->pp_heap[child]->deadlineNs)
+      {
+         break;
+      }
+      heapSet(p_sched, idx, p_sched->pp_heap[child]);
+      idx = child;
+   }
+   heapSet(p_sched, idx, p_timer);
+}
+
+//----------------------------------------------------------------------------
+// Add timer to queue, or move it if it is queued already
+//----------------------------------------------------------------------------
+bool schedAdd(SchedulerT* p_sched, SchedTimerT* p_timer, long long deadlineNs)
+{
+   if (p_timer->heapIdx >= 0)
+   {
+      p_timer->deadlineNs = deadlineNs;
+      heapUp(p_sched, p_timer->heapIdx);
+      heapDown(p_sched, p_timer->heapIdx);
+      return true;
+   }
+
+   if (p_sched->count == p_sched->size)
+   {
+      unsigned int newSize = p_sched->size ? p_sched->size * 2 : 16;
+      SchedTimerT** pp_newHeap = realloc(p_sched->pp_heap, newSize * sizeof(SchedTimerT*));
+      if (!pp_newHeap)
+      {
+         return false;
+      }
+      p_sched->pp_heap = pp_newHeap;
+      p_sched->size = newSize;
+   }
+   p_timer->deadlineNs = deadlineNs;
+   heapSet(p_sched, p_sched->count++, p_timer);
+   heapUp(p_sched, p_timer->heapIdx);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Check that timer is in queue, a timer which is popped is not queued until
+// it is added or posted (and merged) again
+// Note: only thread of scheduler may call it
+//----------------------------------------------------------------------------
+bool schedIsQueued(const SchedTimerT* p_timer)
+{
+   return p_timer->heapIdx >= 0;
+}
+
+//----------------------------------------------------------------------------
+// Remove timer from queue if it is queued
+//----------------------------------------------------------------------------
+void schedRemove(SchedulerT* p_sched, SchedTimerT* p_timer)
+{
+   if (p_timer->heapIdx < 0)
+   {
+      return;
+   }
+   unsigned int idx = p_timer->heapIdx;
+   p_timer->heapIdx = -1;
+   p_sched->count--;
+   if (idx < p_sched->count)
+   {
+      // Last timer fills the hole, then it is moved to its position
+      SchedTimerT* p_lastTimer = p_sched->pp_heap[p_sched->count];
+      heapSet(p_sched, idx, p_lastTimer);
+      heapUp(p_sched, idx);
+      heapDown(p_sched, p_lastTimer->heapIdx);
+   }
+}
+
+//----------------------------------------------------------------------------
+// Take one timer whose deadline is passed, NULL if there is no such timer
+//----------------------------------------------------------------------------
+SchedTimerT* schedPopExpired(SchedulerT* p_sched, long long nowNs)
+{
+   if ((p_sched->count == 0) || (p_sched->pp_heap[0]->deadlineNs > nowNs))
+   {
+      return NULL;
+   }
+   SchedTimerT* p_timer = p_sched->pp_heap[0];
+   schedRemove(p_sched, p_timer);
+   return p_timer;
+}
+
+//----------------------------------------------------------------------------
+// Move timers which are posted by other threads to queue
+//----------------------------------------------------------------------------
+void schedMergePosted(SchedulerT* p_sched)
+{
+   pthread_mutex_lock(&p_sched->postLock);
+   SchedTimerT* p_timer = p_sched->p_posted;
+   p_sched->p_posted = NULL;
+   while (p_timer)
+   {
+      SchedTimerT* p_nextTimer = p_timer->p_nextPosted;
+      p_timer->isPosted = false;
+      schedAdd(p_sched, p_timer, p_timer->postedNs);
+      p_timer = p_nextTimer;
+   }
+   pthread_mutex_unlock(&p_sched->postLock);
+}
+
+//----------------------------------------------------------------------------
+// Arm timerfd with earliest deadline, then wait until deadline is passed,
+// a watched fd is ready or schedWake() is called
+// Timer whose fd is ready is expired now if it is queued. Timer which is
+// popped already (by its deadline) ignores the event, its owner finds the
+// fd ready anyway.
+//----------------------------------------------------------------------------
+bool schedWait(SchedulerT* p_sched)
+{
+   schedMergePosted(p_sched);
+
+   long long deadlineNs = p_sched->count ? p_sched->pp_heap[0]->deadlineNs : 0;
+   if (deadlineNs != p_sched->armedNs)
+   {
+      // Zero it_value disarms timer
+      struct itimerspec spec;
+      memset(&spec, 0, sizeof(spec));
+      spec.it_value.tv_sec = deadlineNs / 1000000000LL;
+      spec.it_value.tv_nsec = deadlineNs % 1000000000LL;
+      if (timerfd_settime(p_sched->timerFd, TFD_TIMER_ABSTIME, &spec, NULL) == -1)
+      {
+         printf("Can not set timerfd: %s\n", strerror(errno));
+         return false;
+      }
+      p_sched->armedNs = deadlineNs;
+   }
+
+   struct epoll_event events[SCHED_MAX_EVENTS];
+   int eventCount = epoll_wait(p_sched->epollFd, events, SCHED_MAX_EVENTS, -1);
+   if ((eventCount == -1) && (errno != EINTR))
+   {
+      printf("Can not wait for scheduler: %s\n", strerror(errno));
+      return false;
+   }
+
+   // Timer is posted together with its fd, it is in queue now if its fd is
+   // ready
+   schedMergePosted(p_sched);
+
+   long long nowNs = schedNowNs();
+   uint64_t counter;
+   int idx;
+   for (idx = 0; idx < eventCount; idx++)
+   {
+      void* p_data = events[idx].data.ptr;
+      if (p_data == &p_sched->timerFd)
+      {
+         if (read(p_sched->timerFd, &counter, sizeof(counter)) == sizeof(counter))
+         {
+            // Timer is expired, it is disarmed
+            p_sched->armedNs = 0;
+         }
+      }
+      else if (p_data == &p_sched->wakeFd)
+      {
+         ssize_t ret = read(p_sched->wakeFd, &counter, sizeof(counter));
+         (void)ret;
+      }
+      else if (schedIsQueued((SchedTimerT*)p_data))
+      {
+         schedAdd(p_sched, (SchedTimerT*)p_data, nowNs);
+      }
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Wait until schedWake() is called (e.g. a timer is posted), then move
+// posted timers to queue. Deadlines are not waited for, expired timers stay
+// in queue until they are popped.
+//----------------------------------------------------------------------------
+bool schedWaitPosted(SchedulerT* p_sched)
+{
+   struct pollfd fds[1];
+   fds[0].fd = p_sched->wakeFd;
+   fds[0].events = POLLIN;
+   if ((poll(fds, 1, -1) == -1) && (errno != EINTR))
+   {
+      printf("Can not poll scheduler: %s\n", strerror(errno));
+      return false;
+   }
+
+   uint64_t counter;
+   if (fds[0].revents & POLLIN)
+   {
+      ssize_t ret = read(p_sched->wakeFd, &counter, sizeof(counter));
+      (void)ret;
+   }
+   schedMergePosted(p_sched);
+   return true;
+}
+
+//----------------------------------------------------------------------------
+// Add timer to queue from other thread, timer is moved to queue when
+// scheduler thread calls schedWait()
+//----------------------------------------------------------------------------
+void schedPost(SchedulerT* p_sched, SchedTimerT* p_timer, long long deadlineNs)
+{
+   pthread_mutex_lock(&p_sched->postLock);
+   if (!p_timer->isPosted)
+   {
+      p_timer->isPosted = true;
+      p_timer->p_nextPosted = p_sched->p_posted;
+      p_sched->p_posted = p_timer;
+   }
+   p_timer->postedNs = deadlineNs;
+   pthread_mutex_unlock(&p_sched->postLock);
+   schedWake(p_sched);
+}
+
+//----------------------------------------------------------------------------
+// Post timer from other thread like schedPost(), timer is also expired when
+// fd is ready for events (POLLIN, POLLOUT), e.g. socket of a request which is
+// in flight. Fd is watched once, until it is ready or it is closed, so owner
+// of timer posts it again to wait for the next events.
+// Fd is watched while post lock is held, thread of scheduler can not pop
+// timer before that, so owner must not touch fd after this function.
+//----------------------------------------------------------------------------
+bool schedPostWait(SchedulerT* p_sched, SchedTimerT* p_timer, long long deadlineNs,
+                   int fd, short events)
+{
+   struct epoll_event event;
+   memset(&event, 0, sizeof(event));
+   event.events = EPOLLONESHOT | ((events & POLLIN) ? EPOLLIN : 0) |
+                  ((events & POLLOUT) ? EPOLLOUT : 0);
+   event.data.ptr = p_timer;
+
+   pthread_mutex_lock(&p_sched->postLock);
+   bool isWatched = !epoll_ctl(p_sched->epollFd, EPOLL_CTL_MOD, fd, &event) ||
+                    ((errno == ENOENT) && !epoll_ctl(p_sched->epollFd, EPOLL_CTL_ADD, fd, &event));
+   int watchErr = errno;
+   if (!p_timer->isPosted)
+   {
+      p_timer->isPosted = true;
+      p_timer->p_nextPosted = p_sched->p_posted;
+      p_sched->p_posted = p_timer;
+   }
+   p_timer->postedNs = deadlineNs;
+   pthread_mutex_unlock(&p_sched->postLock);
+   schedWake(p_sched);
+
+   if (!isWatched)
+   {
+      printf("Can not watch fd %d: %s\n", fd, strerror(watchErr));
+   }
+   return isWatched;
+}
+
+//----------------------------------------------------------------------------
+// Wake scheduler thread up, this function is async-signal-safe
+//----------------------------------------------------------------------------
+void schedWake(SchedulerT* p_sched)
+{
+   if (p_sched->wakeFd >= 0)
+   {
+      uint64_t one = 1;
+      ssize_t ret = write(p_sched->wakeFd, &one, sizeof(one));
+      (void)ret;
+   }
+}
@@ -0,0 +1,69 @@
+#ifndef JENKIN_SCHED_H
+#define JENKIN_SCHED_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+//----------------------------------------------------------------
+// Timer that is put into deadline queue of scheduler
+// It is embedded in object that needs to be woken up at deadline
+//----------------------------------------------------------------
+typedef struct schedTimer
+{
+   long long deadlineNs;      // CLOCK_MONOTONIC
+   int heapIdx;               // -1 if timer is not queued
+   void* p_arg;
+
+   // Timer that is posted by other threads, protected by postLock
+   struct schedTimer* p_nextPosted;
+   long long postedNs;
+   bool isPosted;
+}SchedTimerT;
+
+//----------------------------------------------------------------
+// Scheduler for one thread
+// Timers are kept in a min-heap ordered by deadline, one timerfd is armed
+// with the earliest deadline, and an eventfd wakes the thread up when
+// something is changed by other threads. Thread does not wake up at all if
+// the queue is empty and nobody calls schedWake().
+// Other threads must not touch the queue, they use schedPost() to add timer,
+// posted timers are moved to the queue by schedWait().
+// A timer may also watch a fd (schedPostWait()), it is expired as soon as
+// fd is ready, so that thread of scheduler waits for sockets of other
+// threads in the same epoll.
+//----------------------------------------------------------------
+typedef struct scheduler
+{
+   SchedTimerT** pp_heap;
+   unsigned int count;
+   unsigned int size;
+   long long armedNs;         // deadline of timerfd, 0 if it is disarmed
+   int timerFd;
+   int wakeFd;
+   int epollFd;               // timerfd, eventfd and fds which are watched by timers
+   pthread_mutex_t postLock;
+   SchedTimerT* p_posted;
+}SchedulerT;
+
+#define SCHED_INITIALIZER {NULL, 0, 0, 0, -1, -1, -1, PTHREAD_MUTEX_INITIALIZER, NULL}
+
+// Events which are got from epoll by one wait of scheduler
+#define SCHED_MAX_EVENTS 64
+
+bool schedInit(SchedulerT* p_sched);
+void schedFree(SchedulerT* p_sched);
+void schedTimerInit(SchedTimerT* p_timer, void* p_arg);
+bool schedAdd(SchedulerT* p_sched, SchedTimerT* p_timer, long long deadlineNs);
+void schedRemove(SchedulerT* p_sched, SchedTimerT* p_timer);
+bool schedIsQueued(const SchedTimerT* p_timer);
+SchedTimerT* schedPopExpired(SchedulerT* p_sched, long long nowNs);
+void schedMergePosted(SchedulerT* p_sched);
+bool schedWait(SchedulerT* p_sched);
+bool schedWaitPosted(SchedulerT* p_sched);
+void schedPost(SchedulerT* p_sched, SchedTimerT* p_timer, long long deadlineNs);
+bool schedPostWait(SchedulerT* p_sched, SchedTimerT* p_timer, long long deadlineNs,
+                   int fd, short events);
+void schedWake(SchedulerT* p_sched);
+long long schedNowNs(void);
+
+#endif